@@ -0,0 +1,93 @@
+/*
+   Copyright 2021 Bloomberg Finance L.P.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#ifndef INCLUDED_KEYCMP_H
+#define INCLUDED_KEYCMP_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/*
+ * memcmp() for index keys.  Ondisk keys are big-endian, tag-packed and
+ * usually only a few dozen bytes long, which is too short for the library
+ * memcmp() to earn back its call and length dispatch.  Keys up to
+ * KEYCMP_INLINE_MAX bytes are compared inline, 16 bytes at a time with SSE2
+ * (part of the x86-64 baseline, so no cpu dispatch needed) and 8 bytes at a
+ * time elsewhere.  Longer keys go to memcmp(), which already picks the widest
+ * vector instructions the cpu has at runtime.  Only the sign of the result
+ * is meaningful.
+ */
+#define KEYCMP_INLINE_MAX 64
+
+static inline int comdb2_keycmp(const void *a, const void *b, size_t len)
+{
+    const uint8_t *p = a;
+    const uint8_t *q = b;
+
+    if (len > KEYCMP_INLINE_MAX)
+        return memcmp(a, b, len);
+
+#if defined(__SSE2__)
+    for (; len >= 16; p += 16, q += 16, len -= 16) {
+        __m128i x = _mm_loadu_si128((const __m128i *)p);
+        __m128i y = _mm_loadu_si128((const __m128i *)q);
+        unsigned diff = _mm_movemask_epi8(_mm_cmpeq_epi8(x, y)) ^ 0xffff;
+        if (diff) {
+            int i = __builtin_ctz(diff);
+            return (int)p[i] - (int)q[i];
+        }
+    }
+#endif
+    for (; len >= 8; p += 8, q += 8, len -= 8) {
+        uint64_t x, y;
+        memcpy(&x, p, sizeof(x));
+        memcpy(&y, q, sizeof(y));
+        if (x != y) {
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+            x = __builtin_bswap64(x);
+            y = __builtin_bswap64(y);
+#endif
+            return x < y ? -1 : 1;
+        }
+    }
+    if (len >= 4) {
+        uint32_t x, y;
+        memcpy(&x, p, sizeof(x));
+        memcpy(&y, q, sizeof(y));
+        if (x != y) {
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+            x = __builtin_bswap32(x);
+            y = __builtin_bswap32(y);
+#endif
+            return x < y ? -1 : 1;
+        }
+        p += 4;
+        q += 4;
+        len -= 4;
+    }
+    for (; len; ++p, ++q, --len) {
+        if (*p != *q)
+            return (int)*p - (int)*q;
+    }
+    return 0;
+}
+
+#endif /* INCLUDED_KEYCMP_H */
@@ -137,6 +137,15 @@ DEF_ATTR(COMMITDELAYMAX, commitdelaymax, QUANTITY, 0,
          "on startup with a very busy system.")
 DEF_ATTR(SCATTERKEYS, scatterkeys, BOOLEAN, 0, "")
 DEF_ATTR(SNAPISOL, snapisol, BOOLEAN, 0, NULL)
+DEF_ATTR(SERIAL_INDEX, serial_index, BOOLEAN, 0,
+         "Validate serializable read-sets against an in-memory index of "
+         "recently committed keys instead of scanning the log.")
+DEF_ATTR(SERIAL_INDEX_WINDOW_SECS, serial_index_window_secs, SECS, 60,
+         "How long committed keys stay in the serializable index.  Older "
+         "readers fall back to the log scan.")
+DEF_ATTR(SERIAL_INDEX_MAX_KEYS, serial_index_max_keys, QUANTITY, 1000000,
+         "Maximum number of keys in the serializable index, and per "
+         "transaction; the oldest keys are dropped first.")
 DEF_ATTR(LOWDISKTHRESHOLD, lowdiskthreshold, PERCENT, 95,
          "Sets the low headroom threshold (percent of filesystem full) above "
          "which Comdb2 will start removing logs against set policy.")
@@ -534,6 +543,9 @@ DEF_ATTR(
     "Don't cache query plans for statements with foreign table references.")
 DEF_ATTR(FDB_SQLSTATS_CACHE_LOCK_WAITTIME_NSEC,
          fdb_sqlstats_cache_waittime_nsec, QUANTITY, 1000, NULL)
+DEF_ATTR(LOGICAL_RECOVERY_THREADS, logical_recovery_threads, QUANTITY, 1,
+         "Number of threads that abort outstanding logical transactions "
+         "during rowlocks recovery on the master.")
 DEF_ATTR(PRIVATE_BLKSEQ_CACHESZ, private_blkseq_cachesz, BYTES, 4194304,
          "Cache size of the blkseq table.")
 DEF_ATTR(PRIVATE_BLKSEQ_MAXAGE, private_blkseq_maxage, SECS, 600,
@@ -544,6 +556,11 @@ DEF_ATTR_2(PRIVATE_BLKSEQ_STRIPES, private_blkseq_stripes, QUANTITY, 8,
            "Number of stripes for the blkseq table.", 0, dtastripe_verify, 0)
 DEF_ATTR(PRIVATE_BLKSEQ_ENABLED, private_blkseq_enabled, BOOLEAN, 1,
          "Sets whether dupe detection is enabled.")
+DEF_ATTR(PRIVATE_BLKSEQ_FILTER_BITS, private_blkseq_filter_bits, QUANTITY,
+         1048576,
+         "Size in bits of the Bloom filter in front of each blkseq tree, "
+         "rounded up to a power of two; 0 disables the filter.  Takes effect "
+         "when the blkseq tables next roll.")
 DEF_ATTR(PRIVATE_BLKSEQ_CLOSE_WARN_TIME, private_blkseq_close_warn_time,
          BOOLEAN, 100,
          "Warn when it takes longer than this many MS to roll a blkseq table.")
@@ -49,6 +49,7 @@
 
 extern void berkdb_dumptrans(DB_ENV *);
 extern int __db_panic(DB_ENV *dbenv, int err);
+extern void __bam_keycmp_bench(DB *dbp, int iterations);
 
 pthread_key_t bdb_key;
 pthread_key_t lock_key;
@@ -680,6 +681,21 @@ int bdb_get_first_index_length(bdb_state_type *bdb_state, int ixnum,
     return rc;
 }
 
+/* Replay the pages of every index of a table through memcmp and
+ * comdb2_keycmp, see __bam_keycmp_bench */
+void bdb_keycmp_bench(bdb_state_type *bdb_state, int iterations)
+{
+    int ixnum;
+
+    if (bdb_state->bdbtype != BDBTYPE_TABLE)
+        return;
+
+    BDB_READLOCK("bdb_keycmp_bench");
+    for (ixnum = 0; ixnum < bdb_state->numix; ixnum++)
+        __bam_keycmp_bench(bdb_state->dbp_ix[ixnum], iterations);
+    BDB_RELLOCK();
+}
+
 void bdb_start_request(bdb_state_type *bdb_state)
 {
     BDB_READLOCK("bdb_start_request");
@@ -140,6 +140,9 @@ struct bdb_queue_stats {
 
     unsigned n_logical_gets;
     unsigned n_physical_gets;
+
+    unsigned n_batch_gets;  /* bdb_queue_get_batch calls that found items */
+    unsigned n_batch_items; /* items they returned */
 };
 
 /* Forward declare, this is defined in thread_stats.h */
@@ -932,6 +935,16 @@ int bdb_queue_get(bdb_state_type *bdb_state, tran_type *tran, int consumer,
                   size_t *fnddtaoff, struct bdb_queue_cursor *fndcursor,
                   long long *seq, int *bdberr);
 
+/* Like bdb_queue_get, but reads up to max items in one cursor pass.  fnds,
+ * fndcursors and seqs (optional) must have room for max entries; *nfnd is
+ * set to the number found and each fnds[i] must be freed by the caller.
+ * Only queuedb queues support batches (BDBERR_BADARGS otherwise). */
+int bdb_queue_get_batch(bdb_state_type *bdb_state, tran_type *tran,
+                        int consumer, const struct bdb_queue_cursor *prevcursor,
+                        int max, struct bdb_queue_found **fnds,
+                        struct bdb_queue_cursor *fndcursors, long long *seqs,
+                        int *nfnd, int *bdberr);
+
 /* Get the genid of a queue item that was retrieved by bdb_queue_get() */
 unsigned long long bdb_queue_item_genid(const struct bdb_queue_found *dta);
 
@@ -1195,7 +1208,11 @@ int bdb_add_data_with_rrn(bdb_state_type *bdb_state, void *dta, int rrn,
 int bdb_zap_freerec(bdb_state_type *bdb_handle, int *bdberr);
 
 /* temptables */
-enum { BDB_TEMP_TABLE_DONT_USE_INMEM = 1 };
+enum {
+    BDB_TEMP_TABLE_DONT_USE_INMEM = 1,
+    /* start as an in-memory array, spill to a btree when it grows */
+    BDB_TEMP_TABLE_USE_INMEM = 2
+};
 struct temp_table;
 struct temp_cursor;
 struct temp_table *bdb_temp_table_create(bdb_state_type *bdb_state,
@@ -1318,6 +1335,7 @@ int bdb_fstdumpdta_sendsz(bdb_state_type *bdb_state, SBUF2 *sb,
  * schema, but it catches a lot of problems easily. */
 int bdb_get_first_data_length(bdb_state_type *bdb_state, int *bdberr);
 int bdb_get_first_index_length(bdb_state_type *, int ixnum, int *bdberr);
+void bdb_keycmp_bench(bdb_state_type *bdb_state, int iterations);
 void bdb_start_request(bdb_state_type *bdb_state);
 void bdb_end_request(bdb_state_type *bdb_state);
 void bdb_start_exclusive_request(bdb_state_type *bdb_state);
@@ -2053,6 +2071,7 @@ int llmeta_set_last_analyze_epoch(uint64_t value);
 int bdb_osql_serial_check(bdb_state_type *bdb_state, void *ranges,
                           unsigned int *file, unsigned int *offset,
                           int regop_only);
+void bdb_serial_index_stats(bdb_state_type *bdb_state);
 
 int llmeta_set_tablename_alias(void *ptran, const char *tablename_alias,
                                const char *url, char **errstr);
@@ -2072,6 +2091,7 @@ int bdb_blkseq_find(bdb_state_type *bdb_state, tran_type *tran, void *key,
 void bdb_blkseq_dumpall(bdb_state_type *bdb_state);
 int bdb_recover_blkseq(bdb_state_type *bdb_state);
 int bdb_blkseq_dumplogs(bdb_state_type *bdb_state);
+void bdb_blkseq_filter_stats(bdb_state_type *bdb_state);
 int bdb_blkseq_can_delete_log(bdb_state_type *bdb_state, int lognum);
 void bdb_blkseq_for_each(bdb_state_type *bdb_state, void *arg,
                          void (*func)(int, int, void *, void *, void *,
@@ -2285,6 +2305,24 @@ typedef struct repl_wait_and_net_use {
 } repl_wait_and_net_use_t;
 repl_wait_and_net_use_t *bdb_get_repl_wait_and_net_stats(bdb_state_type *bdb_state, int *pnnodes);
 
+/* Return the commit pacer's view of each replicant. */
+typedef struct rep_pace_stat {
+    char *host;
+    char *lsn;
+    char *state;
+    int64_t lag_bytes;
+    double apply_rate;   /* bytes/sec */
+    double wait_ms;
+    double allowed_rate; /* master bytes/sec this node can keep up with */
+    int64_t limiting;
+    double master_rate;
+    int64_t commit_interval_us;
+    int64_t paced_commits;
+    char *decision;
+} rep_pace_stat_t;
+int bdb_rep_pace_stats(rep_pace_stat_t **stats, int *nstats);
+void bdb_rep_pace_stats_free(rep_pace_stat_t *stats, int nstats);
+
 
 struct cluster_info {
     char *host;
@@ -42,6 +42,87 @@ static int bdb_blkseq_update_lsn_locked(bdb_state_type *bdb_state,
 
 extern int gbl_is_physical_replicant;
 
+#define BLKSEQ_FILTER_HASHES 4
+
+static uint64_t blkseq_filter_hash(const uint8_t *key, int len)
+{
+    /* FNV-1a; the stripe is the xor of the key bytes, so the filter needs a
+     * hash that is independent of it */
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (int i = 0; i < len; i++) {
+        h ^= key[i];
+        h *= 0x100000001b3ULL;
+    }
+    return h;
+}
+
+static void blkseq_filter_alloc(struct blkseq_filter *f, int i, int nbits)
+{
+    uint32_t sz = 64;
+
+    f->bits[i] = NULL;
+    f->mask[i] = 0;
+    f->nkeys[i] = 0;
+    if (nbits <= 0)
+        return;
+    while (sz < nbits && sz < (1U << 31))
+        sz <<= 1;
+    f->bits[i] = calloc(sz / 64, sizeof(uint64_t));
+    if (f->bits[i] == NULL) {
+        logmsg(LOGMSG_ERROR, "%s: can't allocate %u bit filter\n", __func__,
+               sz);
+        return;
+    }
+    f->mask[i] = sz - 1;
+}
+
+static void blkseq_filter_add(struct blkseq_filter *f, int i, uint64_t h)
+{
+    uint32_t h1 = (uint32_t)h, h2 = (uint32_t)(h >> 32) | 1;
+
+    if (f->bits[i] == NULL)
+        return;
+    for (int k = 0; k < BLKSEQ_FILTER_HASHES; k++) {
+        uint32_t bit = (h1 + k * h2) & f->mask[i];
+        f->bits[i][bit >> 6] |= 1ULL << (bit & 63);
+    }
+    f->nkeys[i]++;
+}
+
+/* Returns 0 if the key is definitely not in tree i. */
+static int blkseq_filter_maybe(const struct blkseq_filter *f, int i,
+                               uint64_t h)
+{
+    uint32_t h1 = (uint32_t)h, h2 = (uint32_t)(h >> 32) | 1;
+
+    if (f->bits[i] == NULL)
+        return 1;
+    for (int k = 0; k < BLKSEQ_FILTER_HASHES; k++) {
+        uint32_t bit = (h1 + k * h2) & f->mask[i];
+        if (!(f->bits[i][bit >> 6] & (1ULL << (bit & 63))))
+            return 0;
+    }
+    return 1;
+}
+
+/* Account for a key that was in neither tree. */
+static void blkseq_filter_miss(struct blkseq_filter *f, int searched)
+{
+    if (f->bits[0] == NULL && f->bits[1] == NULL)
+        return;
+    f->lookups++;
+    if (searched)
+        f->falsepos++;
+    else
+        f->skipped++;
+}
+
+static void blkseq_filter_hit(struct blkseq_filter *f)
+{
+    if (f->bits[0] != NULL || f->bits[1] != NULL)
+        f->lookups++;
+}
+
 static DB *create_blkseq(bdb_state_type *bdb_state, int stripe, int num)
 {
     char fname[1024];
@@ -93,6 +174,7 @@ void bdb_cleanup_private_blkseq(bdb_state_type *bdb_state)
             for (int i = 0; i < 2; i++) {
                 DB *to_be_deleted = bdb_state->blkseq[i][stripe];
                 to_be_deleted->close(to_be_deleted, DB_NOSYNC);
+                free(bdb_state->blkseq_filter[stripe].bits[i]);
             }
 
             env->close(env, 0);
@@ -125,6 +207,10 @@ void bdb_cleanup_private_blkseq(bdb_state_type *bdb_state)
         free(bdb_state->blkseq_last_lsn[1]);
         bdb_state->blkseq_last_lsn[1] = NULL;
     }
+    if (bdb_state->blkseq_filter) {
+        free(bdb_state->blkseq_filter);
+        bdb_state->blkseq_filter = NULL;
+    }
 }
 
 int bdb_create_private_blkseq(bdb_state_type *bdb_state)
@@ -143,6 +229,7 @@ int bdb_create_private_blkseq(bdb_state_type *bdb_state)
     bdb_state->blkseq_last_lsn[1] = malloc(nstripes * sizeof(DB_LSN));
 
     bdb_state->blkseq_log_list = malloc(nstripes * sizeof(listc_t));
+    bdb_state->blkseq_filter = calloc(nstripes, sizeof(struct blkseq_filter));
 
     for (int stripe = 0; stripe < nstripes; stripe++) {
         rc = db_env_create(&env, 0);
@@ -174,6 +261,8 @@ int bdb_create_private_blkseq(bdb_state_type *bdb_state)
             if (bdb_state->blkseq[i][stripe] == NULL)
                 return -1;
             bzero(&bdb_state->blkseq_last_lsn[i][stripe], sizeof(DB_LSN));
+            blkseq_filter_alloc(&bdb_state->blkseq_filter[stripe], i,
+                                bdb_state->attr->private_blkseq_filter_bits);
         }
         listc_init(&bdb_state->blkseq_log_list[stripe],
                    offsetof(struct seen_blkseq, lnk));
@@ -236,6 +325,9 @@ int bdb_blkseq_recover(DB_ENV *dbenv, u_int32_t rectype, llog_blkseq_args *args,
                 NULL, &args->key,
                 &args->data, DB_NOOVERWRITE);
         if (rc == 0) {
+            blkseq_filter_add(&bdb_state->blkseq_filter[stripe], 0,
+                              blkseq_filter_hash(args->key.data,
+                                                 args->key.size));
             bdb_state->blkseq_last_lsn[0][stripe] = *lsn;
             rc = bdb_blkseq_update_lsn_locked(bdb_state, args->time, *lsn,
                     stripe);
@@ -248,7 +340,8 @@ int bdb_blkseq_recover(DB_ENV *dbenv, u_int32_t rectype, llog_blkseq_args *args,
             // printf("applied ");
     }
     /* turns out we do need to back these out after all, since otherwise parent
-     * transaction aborts look like replays, and we silently drop updates. */
+     * transaction aborts look like replays, and we silently drop updates.
+     * The filters keep the key; it just costs a btree search until the roll. */
     else if (op == DB_TXN_BACKWARD_ROLL || op == DB_TXN_ABORT) {
         stripe =
             get_stripe(bdb_state, (uint8_t *)args->key.data, args->key.size);
@@ -309,19 +402,27 @@ int bdb_blkseq_find(bdb_state_type *bdb_state, tran_type *tran, void *key,
                     int klen, void **dtaout, int *lenout)
 {
     DBT dkey = {0}, ddata = {0};
-    int rc;
+    struct blkseq_filter *filter;
+    uint64_t h;
+    int rc, searched = 0;
     uint8_t stripe;
     ddata.flags = DB_DBT_REALLOC;
     if (!bdb_state->attr->private_blkseq_enabled)
         return IX_EMPTY;
     stripe = get_stripe(bdb_state, (uint8_t *)key, klen);
+    h = blkseq_filter_hash(key, klen);
     Pthread_mutex_lock(&bdb_state->blkseq_lk[stripe]);
+    filter = &bdb_state->blkseq_filter[stripe];
     dkey.data = key;
     dkey.size = klen;
     for (int i = 0; i < 2; i++) {
+        if (!blkseq_filter_maybe(filter, i, h))
+            continue;
+        searched = 1;
         rc = bdb_state->blkseq[i][stripe]->get(bdb_state->blkseq[i][stripe],
                                                NULL, &dkey, &ddata, 0);
         if (rc == 0) {
+            blkseq_filter_hit(filter);
             if (dtaout)
                 *dtaout = ddata.data;
             if (lenout)
@@ -333,6 +434,7 @@ int bdb_blkseq_find(bdb_state_type *bdb_state, tran_type *tran, void *key,
             return IX_ACCESS;
         }
     }
+    blkseq_filter_miss(filter, searched);
     Pthread_mutex_unlock(&bdb_state->blkseq_lk[stripe]);
     return IX_NOTFND;
 }
@@ -343,9 +445,11 @@ int bdb_blkseq_insert(bdb_state_type *bdb_state, tran_type *tran, void *key,
 {
     DBT dkey = {0}, ddata = {0};
     DB_LSN lsn;
+    struct blkseq_filter *filter;
+    uint64_t h;
     int now;
     // int *k;
-    int rc;
+    int rc, searched = 0;
     uint8_t stripe;
 
     if (!bdb_state->attr->private_blkseq_enabled)
@@ -356,8 +460,10 @@ int bdb_blkseq_insert(bdb_state_type *bdb_state, tran_type *tran, void *key,
     // k = (int*) key;
     // printf("inserting %x %x %x\n", k[0], k[1], k[2]);
     stripe = get_stripe(bdb_state, (uint8_t *)key, klen);
+    h = blkseq_filter_hash(key, klen);
 
     Pthread_mutex_lock(&bdb_state->blkseq_lk[stripe]);
+    filter = &bdb_state->blkseq_filter[stripe];
     dkey.data = key;
     dkey.size = klen;
     ddata.data = data;
@@ -366,9 +472,13 @@ int bdb_blkseq_insert(bdb_state_type *bdb_state, tran_type *tran, void *key,
     now = comdb2_time_epoch();
 
     for (int i = 0; i < 2; i++) {
+        if (!blkseq_filter_maybe(filter, i, h))
+            continue;
+        searched = 1;
         rc = bdb_state->blkseq[i][stripe]->get(bdb_state->blkseq[i][stripe],
                                                NULL, &dkey, &ddata, 0);
         if (rc == 0) {
+            blkseq_filter_hit(filter);
             if (dtaout)
                 *dtaout = ddata.data;
             if (lenout)
@@ -384,6 +494,7 @@ int bdb_blkseq_insert(bdb_state_type *bdb_state, tran_type *tran, void *key,
     }
 
     /* not found in either tree - put it in the first */
+    blkseq_filter_miss(filter, searched);
 
     rc = bdb_state->blkseq[0][stripe]->put(bdb_state->blkseq[0][stripe], NULL,
                                            &dkey, &ddata, DB_NOOVERWRITE);
@@ -392,6 +503,7 @@ int bdb_blkseq_insert(bdb_state_type *bdb_state, tran_type *tran, void *key,
         Pthread_mutex_unlock(&bdb_state->blkseq_lk[stripe]);
         return BDBERR_MISC;
     }
+    blkseq_filter_add(filter, 0, h);
 
     /* succeded in updating local table, log the update if transactional
      * (recovery isn't) */
@@ -419,6 +531,7 @@ int bdb_blkseq_clean(bdb_state_type *bdb_state, uint8_t stripe)
     time_t now, last;
     DB *to_be_deleted;
     DB *newdb;
+    struct blkseq_filter *filter;
     char *oldname = NULL;
     int rc = 0;
     DB_ENV *env;
@@ -479,6 +592,14 @@ int bdb_blkseq_clean(bdb_state_type *bdb_state, uint8_t stripe)
     bdb_state->blkseq[0][stripe] = newdb;
     bdb_state->blkseq_last_lsn[1][stripe] = bdb_state->blkseq_last_lsn[0][stripe];
 
+    /* the filters age out with their trees */
+    filter = &bdb_state->blkseq_filter[stripe];
+    free(filter->bits[1]);
+    filter->bits[1] = filter->bits[0];
+    filter->mask[1] = filter->mask[0];
+    filter->nkeys[1] = filter->nkeys[0];
+    blkseq_filter_alloc(filter, 0, bdb_state->attr->private_blkseq_filter_bits);
+
     bdb_state->blkseq_last_roll_time = now;
 
     /* Clean up the old blkseq file. Get its name, close it, delete it. */
@@ -778,6 +899,32 @@ int bdb_blkseq_dumplogs(bdb_state_type *bdb_state)
     return 0;
 }
 
+void bdb_blkseq_filter_stats(bdb_state_type *bdb_state)
+{
+    uint64_t lookups = 0, skipped = 0, falsepos = 0;
+
+    for (int stripe = 0; stripe < bdb_state->pvt_blkseq_stripes; stripe++) {
+        struct blkseq_filter *f = &bdb_state->blkseq_filter[stripe];
+        Pthread_mutex_lock(&bdb_state->blkseq_lk[stripe]);
+        logmsg(LOGMSG_USER,
+               "stripe %d filter bits %u/%u keys %u/%u lookups %" PRIu64
+               " skipped %" PRIu64 " false positives %" PRIu64 "\n",
+               stripe, f->bits[0] ? f->mask[0] + 1 : 0,
+               f->bits[1] ? f->mask[1] + 1 : 0, f->nkeys[0], f->nkeys[1],
+               f->lookups, f->skipped, f->falsepos);
+        lookups += f->lookups;
+        skipped += f->skipped;
+        falsepos += f->falsepos;
+        Pthread_mutex_unlock(&bdb_state->blkseq_lk[stripe]);
+    }
+    logmsg(LOGMSG_USER,
+           "blkseq filter: %" PRIu64 " lookups, %.2f%% answered without a "
+           "btree search, %.2f%% false positives among new keys\n",
+           lookups, lookups ? 100.0 * skipped / lookups : 0.0,
+           (skipped + falsepos) ? 100.0 * falsepos / (skipped + falsepos)
+                                : 0.0);
+}
+
 int bdb_blkseq_can_delete_log(bdb_state_type *bdb_state, int lognum)
 {
     struct seen_blkseq *logseq, *logseqtmp;
@@ -467,6 +467,15 @@ struct tran_tag {
     /* Newsi pglogs queue hash */
     hash_t *pglogs_queue_hash;
     u_int32_t flags;
+
+    /* Keys written under this transaction, for the serializable index */
+    uint8_t *serial_keys;
+    size_t serial_keys_used;
+    size_t serial_keys_alloc;
+    int serial_nkeys;
+    struct serial_bucket *serial_bucket;
+    signed char serial_untracked;
+    signed char serial_published;
 };
 
 struct seqnum_t {
@@ -790,6 +799,20 @@ struct seen_blkseq {
     LINKC_T(struct seen_blkseq) lnk;
 };
 
+/* Bloom filter in front of the two blkseq trees of a stripe.  Most lookups
+ * are for cnonces that were never seen, and the filter answers those without
+ * a btree search.  Keys are only ever added; a filter is dropped together
+ * with its tree when bdb_blkseq_clean rolls the stripe.  Protected by the
+ * stripe's blkseq_lk. */
+struct blkseq_filter {
+    uint64_t *bits[2]; /* one filter per blkseq tree, NULL if disabled */
+    uint32_t mask[2];  /* number of bits - 1, a power of two */
+    uint32_t nkeys[2];
+    uint64_t lookups;  /* finds and inserts that consulted the filter */
+    uint64_t skipped;  /* answered "not seen" without a btree search */
+    uint64_t falsepos; /* filter said maybe, the btrees said no */
+};
+
 struct temp_table;
 
 struct sc_redo_lsn {
@@ -1035,6 +1058,7 @@ struct bdb_state_tag {
     time_t blkseq_last_roll_time;
     DB_LSN *blkseq_last_lsn[2];
     listc_t *blkseq_log_list;
+    struct blkseq_filter *blkseq_filter;
     int pvt_blkseq_stripes;
     uint32_t genid_format;
 
@@ -1386,6 +1410,13 @@ int bdb_llog_rowlocks_bench(bdb_state_type *bdb_state, tran_type *tran, int op,
                             void *payload, int paylen);
 
 int bdb_llog_commit(bdb_state_type *bdb_state, tran_type *tran, int isabort);
+
+void bdb_serial_index_track(bdb_state_type *bdb_state, tran_type *tran,
+                            const char *table, int ixnum, const void *key,
+                            int keylen);
+void bdb_serial_index_publish(bdb_state_type *bdb_state, tran_type *tran);
+void bdb_serial_index_finish(bdb_state_type *bdb_state, tran_type *tran,
+                             DB_LSN *lsn);
 int bdb_save_row_int(bdb_state_type *bdb_state_in, DB_TXN *txnid, char table[],
                      unsigned long long genid);
 
@@ -1849,6 +1880,8 @@ int berkdb_commit_logical(DB_ENV *dbenv, void *state, uint64_t ltranid,
 void send_coherency_leases(bdb_state_type *bdb_state, int lease_time,
                            int *do_add);
 
+void bdb_rep_pace_update(bdb_state_type *bdb_state);
+
 int has_low_headroom(const char *path, int threshold, int debug);
 
 const char *deadlock_policy_str(u_int32_t policy);
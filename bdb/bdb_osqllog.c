@@ -28,6 +28,7 @@
 #include <fsnapf.h>
 #include <bdb_osqllog.h>
 #include <bdb_osqltrn.h>
+#include <bdb_osqlundo.h>
 #include <bdb_int.h>
 #include <bdb_osqlcur.h>
 #include <flibc.h>
@@ -2898,7 +2899,7 @@ static int bdb_osql_log_try_run_optimized(bdb_cursor_impl_t *cur,
         logdta.flags = DB_DBT_REALLOC;
 
         /* Retrieve the logfile. */
-        rc = curlog->get(curlog, &rec->lsn, &logdta, DB_SET);
+        rc = bdb_osql_undo_log_get(cur->state, curlog, &rec->lsn, &logdta);
         if (!rc) {
             LOGCOPY_32(&rectype, logdta.data);
         } else {
@@ -3096,7 +3097,7 @@ int bdb_osql_update_shadows_with_pglogs(bdb_cursor_impl_t *cur, DB_LSN lsn,
     }
 
     /* get log */
-    rc = logcur->get(logcur, &lsn, &logdta, DB_SET);
+    rc = bdb_osql_undo_log_get(bdb_state, logcur, &lsn, &logdta);
     if (rc) {
         logmsg(LOGMSG_ERROR, "%s:%d %s log_cur->get(%u:%u) rc %d\n", __FILE__,
                 __LINE__, __func__, lsn.file, lsn.offset, rc);
@@ -3442,7 +3443,7 @@ static int bdb_osql_log_run_unoptimized(bdb_cursor_impl_t *cur, DB_LOGC *curlog,
     if (inlogdta == NULL) {
         bzero(&logdta, sizeof(logdta));
         logdta.flags = DB_DBT_REALLOC;
-        rc = curlog->get(curlog, &rec->lsn, &logdta, DB_SET);
+        rc = bdb_osql_undo_log_get(bdb_state, curlog, &rec->lsn, &logdta);
         if (!rc)
             LOGCOPY_32(&rectype, logdta.data);
         else {
@@ -4084,6 +4085,11 @@ static int bdb_osql_log_get_optim_data_int(bdb_state_type *bdb_state,
     *row = NULL;
     *rowlen = 0;
 
+    /* another snapshot session may have rebuilt this version already */
+    if (bdb_osql_undo_get_row(lsn, addcur ? sizeof(bdb_osql_log_addc_ptr_t) : 0,
+                              row, rowlen) == 0)
+        return 0;
+
     /* retrieve a log cursor */
     rc = bdb_state->dbenv->log_cursor(bdb_state->dbenv, &curlog, 0);
     if (rc) {
@@ -4095,7 +4101,7 @@ static int bdb_osql_log_get_optim_data_int(bdb_state_type *bdb_state,
 
     bzero(&logdta, sizeof(logdta));
     logdta.flags = DB_DBT_REALLOC;
-    rc = curlog->get(curlog, lsn, &logdta, DB_SET);
+    rc = bdb_osql_undo_log_get(bdb_state, curlog, lsn, &logdta);
     if (!rc)
         LOGCOPY_32(&rectype, logdta.data);
     else {
@@ -4141,6 +4147,7 @@ static int bdb_osql_log_get_optim_data_int(bdb_state_type *bdb_state,
             goto done;
         }
 
+        bdb_osql_undo_put_row(bdb_state, lsn, ptr, del_dta->dtalen);
         free(del_dta);
 
         /* Set row. */
@@ -4195,6 +4202,7 @@ static int bdb_osql_log_get_optim_data_int(bdb_state_type *bdb_state,
             free(upd_dta);
             goto done;
         }
+        bdb_osql_undo_put_row(bdb_state, lsn, ptr, upd_dta->old_dta_len);
         free(upd_dta);
 
         /* Set row. */
@@ -38,6 +38,7 @@
 #include "bdb_osqllog.h"
 #include "bdb_osqlbkfill.h"
 #include "bdb_osqlcur.h"
+#include "bdb_osqlundo.h"
 #include "locks.h"
 #include "locks_wrap.h"
 
@@ -545,6 +546,7 @@ int bdb_osql_trn_unregister(bdb_osql_trn_t *trn, int *bdberr)
 {
 
     int rc = 0;
+    int empty;
 
     Pthread_mutex_lock(&trn_repo_mtx);
 
@@ -554,8 +556,13 @@ int bdb_osql_trn_unregister(bdb_osql_trn_t *trn, int *bdberr)
     }
 
     listc_rfl(&trn_repo->trns, trn);
+    empty = (trn_repo->trns.count == 0);
     Pthread_mutex_unlock(&trn_repo_mtx);
 
+    /* no snapshot left to reuse any of the cached undo work */
+    if (empty)
+        bdb_osql_undo_clear();
+
     /*
     fprintf( stderr, "%d %s:%d UNregistered %p\n",
           pthread_self(), __FILE__, __LINE__, trn->shadow_tran);
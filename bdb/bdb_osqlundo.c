@@ -0,0 +1,293 @@
+/*
+   Copyright 2021 Bloomberg Finance L.P.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <stddef.h>
+#include <pthread.h>
+
+#include <list.h>
+#include <plhash.h>
+#include <locks_wrap.h>
+#include <logmsg.h>
+
+#include <build/db.h>
+#include <build/db_int.h>
+#include <dbinc/log.h>
+
+#include "bdb_int.h"
+#include "bdb_osqltrn.h"
+#include "bdb_osqlundo.h"
+
+/* run the garbage collection every this many new entries */
+#define UNDO_GC_PERIOD 1024
+
+int gbl_snapshot_undo_cache = 1;
+int gbl_snapshot_undo_cache_max_mb = 64;
+
+/**
+ * The cached work for the undo record logged at "lsn": the record and,
+ * once a snapshot cursor needed it, the row image that record undoes
+ *
+ */
+typedef struct bdb_osql_undo {
+    DB_LSN lsn;
+    void *rec;
+    int reclen;
+    void *row;
+    int rowlen;
+    LINKC_T(struct bdb_osql_undo) lnk;
+} bdb_osql_undo_t;
+
+static struct {
+    pthread_mutex_t mtx;
+    hash_t *hash;                     /* lsn -> entry */
+    LISTC_T(bdb_osql_undo_t) entries; /* insertion order */
+    size_t bytes;
+    unsigned puts;
+    unsigned long long rec_hits;   /* log reads saved */
+    unsigned long long rec_misses; /* log reads done */
+    unsigned long long row_hits;   /* row rebuilds saved */
+    unsigned long long row_misses; /* row rebuilds done */
+    unsigned long long dropped;
+} undo_cache = {.mtx = PTHREAD_MUTEX_INITIALIZER};
+
+static size_t undo_max_bytes(void)
+{
+    return (size_t)gbl_snapshot_undo_cache_max_mb * 1024 * 1024;
+}
+
+static void undo_free(bdb_osql_undo_t *v)
+{
+    undo_cache.bytes -= v->reclen + v->rowlen;
+    free(v->rec);
+    free(v->row);
+    free(v);
+}
+
+static void undo_remove(bdb_osql_undo_t *v)
+{
+    hash_del(undo_cache.hash, v);
+    listc_rfl(&undo_cache.entries, v);
+    undo_free(v);
+}
+
+/* Return the entry for lsn, creating it if needed; call with mtx held */
+static bdb_osql_undo_t *undo_get(DB_LSN *lsn, int create)
+{
+    bdb_osql_undo_t *v;
+
+    if (undo_cache.hash == NULL) {
+        if (!create)
+            return NULL;
+        undo_cache.hash = hash_init_o(offsetof(bdb_osql_undo_t, lsn),
+                                      sizeof(DB_LSN));
+        listc_init(&undo_cache.entries, offsetof(bdb_osql_undo_t, lnk));
+    }
+
+    if ((v = hash_find(undo_cache.hash, lsn)) != NULL || !create)
+        return v;
+
+    if ((v = calloc(1, sizeof(bdb_osql_undo_t))) == NULL)
+        return NULL;
+    v->lsn = *lsn;
+    hash_add(undo_cache.hash, v);
+    listc_abl(&undo_cache.entries, v);
+    return v;
+}
+
+/* Keep a copy of the record or row undone at lsn, if there is room */
+static void undo_put(bdb_state_type *bdb_state, DB_LSN *lsn, int is_row,
+                     const void *buf, int len)
+{
+    bdb_osql_undo_t *v;
+    void *copy;
+    int gc;
+
+    Pthread_mutex_lock(&undo_cache.mtx);
+    gc = (++undo_cache.puts % UNDO_GC_PERIOD) == 0;
+    Pthread_mutex_unlock(&undo_cache.mtx);
+
+    if (gc)
+        bdb_osql_undo_gc(bdb_state);
+
+    if ((copy = malloc(len)) == NULL)
+        return;
+    memcpy(copy, buf, len);
+
+    Pthread_mutex_lock(&undo_cache.mtx);
+    if (undo_cache.bytes + len > undo_max_bytes() ||
+        (v = undo_get(lsn, 1)) == NULL || (is_row ? v->row : v->rec) != NULL) {
+        /* full, or another session got here first */
+        Pthread_mutex_unlock(&undo_cache.mtx);
+        free(copy);
+        return;
+    }
+    if (is_row) {
+        v->row = copy;
+        v->rowlen = len;
+    } else {
+        v->rec = copy;
+        v->reclen = len;
+    }
+    undo_cache.bytes += len;
+    Pthread_mutex_unlock(&undo_cache.mtx);
+}
+
+int bdb_osql_undo_log_get(bdb_state_type *bdb_state, DB_LOGC *curlog,
+                          DB_LSN *lsn, DBT *logdta)
+{
+    bdb_osql_undo_t *v;
+    void *data;
+    int rc;
+
+    assert(logdta->flags & DB_DBT_REALLOC);
+
+    if (gbl_snapshot_undo_cache) {
+        Pthread_mutex_lock(&undo_cache.mtx);
+        if ((v = undo_get(lsn, 0)) != NULL && v->rec != NULL &&
+            (data = realloc(logdta->data, v->reclen)) != NULL) {
+            memcpy(data, v->rec, v->reclen);
+            logdta->data = data;
+            logdta->size = v->reclen;
+            undo_cache.rec_hits++;
+            Pthread_mutex_unlock(&undo_cache.mtx);
+            return 0;
+        }
+        undo_cache.rec_misses++;
+        Pthread_mutex_unlock(&undo_cache.mtx);
+    }
+
+    rc = curlog->get(curlog, lsn, logdta, DB_SET);
+
+    if (rc == 0 && gbl_snapshot_undo_cache)
+        undo_put(bdb_state, lsn, 0, logdta->data, logdta->size);
+
+    return rc;
+}
+
+int bdb_osql_undo_get_row(DB_LSN *lsn, int hdrlen, void **row, int *rowlen)
+{
+    bdb_osql_undo_t *v;
+    char *buf;
+
+    if (!gbl_snapshot_undo_cache)
+        return 1;
+
+    Pthread_mutex_lock(&undo_cache.mtx);
+    if ((v = undo_get(lsn, 0)) == NULL || v->row == NULL ||
+        (buf = malloc(hdrlen + v->rowlen)) == NULL) {
+        undo_cache.row_misses++;
+        Pthread_mutex_unlock(&undo_cache.mtx);
+        return 1;
+    }
+    memcpy(buf + hdrlen, v->row, v->rowlen);
+    *row = buf;
+    *rowlen = hdrlen + v->rowlen;
+    undo_cache.row_hits++;
+    Pthread_mutex_unlock(&undo_cache.mtx);
+
+    return 0;
+}
+
+void bdb_osql_undo_put_row(bdb_state_type *bdb_state, DB_LSN *lsn,
+                           const void *row, int rowlen)
+{
+    if (gbl_snapshot_undo_cache)
+        undo_put(bdb_state, lsn, 1, row, rowlen);
+}
+
+/**
+ * A snapshot transaction never undoes a record logged before the oldest
+ * transaction that was active when it started; bdb_oldest_active_lsn()
+ * is the low watermark over all of them.
+ *
+ */
+void bdb_osql_undo_gc(bdb_state_type *bdb_state)
+{
+    bdb_osql_undo_t *v, *tmp;
+    DB_LSN lwm;
+
+    bdb_oldest_active_lsn(bdb_state, &lwm);
+
+    Pthread_mutex_lock(&undo_cache.mtx);
+    if (undo_cache.hash) {
+        LISTC_FOR_EACH_SAFE(&undo_cache.entries, v, tmp, lnk)
+        {
+            if (log_compare(&v->lsn, &lwm) < 0) {
+                undo_remove(v);
+                undo_cache.dropped++;
+            }
+        }
+    }
+    Pthread_mutex_unlock(&undo_cache.mtx);
+}
+
+void bdb_osql_undo_truncate(DB_LSN *lsn)
+{
+    bdb_osql_undo_t *v, *tmp;
+
+    Pthread_mutex_lock(&undo_cache.mtx);
+    if (undo_cache.hash) {
+        LISTC_FOR_EACH_SAFE(&undo_cache.entries, v, tmp, lnk)
+        {
+            if (log_compare(&v->lsn, lsn) >= 0)
+                undo_remove(v);
+        }
+    }
+    Pthread_mutex_unlock(&undo_cache.mtx);
+}
+
+void bdb_osql_undo_clear(void)
+{
+    bdb_osql_undo_t *v, *tmp;
+
+    Pthread_mutex_lock(&undo_cache.mtx);
+    if (undo_cache.hash) {
+        LISTC_FOR_EACH_SAFE(&undo_cache.entries, v, tmp, lnk)
+        {
+            undo_remove(v);
+            undo_cache.dropped++;
+        }
+    }
+    Pthread_mutex_unlock(&undo_cache.mtx);
+}
+
+static double undo_pct(unsigned long long hits, unsigned long long misses)
+{
+    return hits + misses ? 100.0 * hits / (hits + misses) : 0;
+}
+
+void bdb_osql_undo_stat(void)
+{
+    Pthread_mutex_lock(&undo_cache.mtx);
+    logmsg(LOGMSG_USER,
+           "snapshot undo cache is %s: %d records, %zu bytes (max %d mb), "
+           "%llu collected\n",
+           gbl_snapshot_undo_cache ? "ENABLED" : "DISABLED",
+           undo_cache.hash ? undo_cache.entries.count : 0, undo_cache.bytes,
+           gbl_snapshot_undo_cache_max_mb, undo_cache.dropped);
+    logmsg(LOGMSG_USER,
+           "  undo record log reads: %llu saved, %llu done (%.1f%% saved)\n",
+           undo_cache.rec_hits, undo_cache.rec_misses,
+           undo_pct(undo_cache.rec_hits, undo_cache.rec_misses));
+    logmsg(LOGMSG_USER,
+           "  undo row rebuilds: %llu saved, %llu done (%.1f%% saved)\n",
+           undo_cache.row_hits, undo_cache.row_misses,
+           undo_pct(undo_cache.row_hits, undo_cache.row_misses));
+    Pthread_mutex_unlock(&undo_cache.mtx);
+}
@@ -0,0 +1,89 @@
+/*
+   Copyright 2021 Bloomberg Finance L.P.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+/**
+ *  Snapisol/Serial sql support: an lsn-keyed cache of undo work
+ *
+ *  This is not a version store: snapshot cursors still find the versions
+ *  they need by walking the log (parse_log_for_shadows and the pglogs
+ *  queues) and still copy each one into their own shadow tables.  What is
+ *  cached are the two steps of that walk whose result only depends on
+ *  the lsn of an undo record: fetching the record from the log, and
+ *  rebuilding the row image it undoes.  The first session to do either
+ *  keeps the result here and other sessions copy it from memory.
+ *
+ *  With N snapshot sessions undoing the same record, N-1 of the log reads
+ *  and N-1 of the row rebuilds are saved; a lone snapshot session saves
+ *  nothing.  "bdb_osql_undo_stat" reports the fractions actually saved.
+ *  Entries older than the oldest active transaction are dropped.
+ *
+ */
+#ifndef _BDB_OSQL_UNDO_H_
+#define _BDB_OSQL_UNDO_H_
+
+#include <build/db.h>
+
+struct bdb_state_tag;
+
+/**
+ * Retrieve the undo record at "lsn", like curlog->get(DB_SET)
+ * "logdta" must be DB_DBT_REALLOC; returns curlog->get's rcode
+ *
+ */
+int bdb_osql_undo_log_get(struct bdb_state_tag *bdb_state, DB_LOGC *curlog,
+                          DB_LSN *lsn, DBT *logdta);
+
+/**
+ * Retrieve the row image undone by the record at "lsn"
+ * The returned buffer has "hdrlen" spare bytes in front of the row
+ * Returns 0 if found, 1 if the row is not cached
+ *
+ */
+int bdb_osql_undo_get_row(DB_LSN *lsn, int hdrlen, void **row, int *rowlen);
+
+/**
+ * Store the row image undone by the record at "lsn"
+ *
+ */
+void bdb_osql_undo_put_row(struct bdb_state_tag *bdb_state, DB_LSN *lsn,
+                           const void *row, int rowlen);
+
+/**
+ * Drop the entries no snapshot transaction can read anymore
+ *
+ */
+void bdb_osql_undo_gc(struct bdb_state_tag *bdb_state);
+
+/**
+ * Drop every entry at or past "lsn"; called when the log is truncated
+ *
+ */
+void bdb_osql_undo_truncate(DB_LSN *lsn);
+
+/**
+ * Drop all entries
+ *
+ */
+void bdb_osql_undo_clear(void);
+
+/**
+ * Print the undo cache statistics, including the fraction of log
+ * reads and row rebuilds it saved
+ *
+ */
+void bdb_osql_undo_stat(void);
+
+#endif
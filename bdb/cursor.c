@@ -88,6 +88,7 @@ as long as there was a successful move in the past
 #include "bdb_osqlcur.h"
 #include "bdb_osqllog.h"
 #include "bdb_osqltrn.h"
+#include "bdb_osqlundo.h"
 #include <dlfcn.h>
 #include <list.h>
 #include <plhash.h>
@@ -2008,6 +2009,7 @@ int truncate_asof_pglogs(bdb_state_type *bdb_state, int file, int offset)
     struct commit_list *lcommit;
     int del_log = file + 1;
     extern int gbl_snapisol;
+    bdb_osql_undo_truncate(&lsn);
     if (!gbl_new_snapisol || !gbl_snapisol || !logfile_pglogs_repo_ready)
         return 0;
     bdb_clean_pglogs_queues(bdb_state, lsn, 1);
@@ -143,6 +143,39 @@ static void txn_stats(FILE *out, bdb_state_type *bdb_state)
     free(stats);
 }
 
+/* Upper bound of the log2 bucket holding the pct'th percentile sample. */
+static u_int64_t log_hist_percentile(const u_int64_t *hist, int pct)
+{
+    u_int64_t total = 0, seen = 0;
+    int i;
+
+    for (i = 0; i < DB_LOG_HIST_BUCKETS; i++)
+        total += hist[i];
+    if (total == 0)
+        return 0;
+    for (i = 0; i < DB_LOG_HIST_BUCKETS; i++) {
+        seen += hist[i];
+        if (seen * 100 >= total * pct)
+            break;
+    }
+    return ((u_int64_t)2 << i) - 1;
+}
+
+static void prn_log_hist(FILE *out, const char *name, const u_int64_t *hist)
+{
+    int i;
+
+    logmsgf(LOGMSG_USER, out, "%s: p50 %" PRIu64 " p90 %" PRIu64 " p99 %" PRIu64 "\n",
+            name, log_hist_percentile(hist, 50), log_hist_percentile(hist, 90),
+            log_hist_percentile(hist, 99));
+    for (i = 0; i < DB_LOG_HIST_BUCKETS; i++) {
+        if (hist[i] == 0)
+            continue;
+        logmsgf(LOGMSG_USER, out, "  <= %-10" PRIu64 " %" PRIu64 "\n",
+                ((u_int64_t)2 << i) - 1, hist[i]);
+    }
+}
+
 static void log_stats(FILE *out, bdb_state_type *bdb_state)
 {
     DB_LOG_STAT *stats;
@@ -189,6 +222,12 @@ static void log_stats(FILE *out, bdb_state_type *bdb_state)
         prn_stat(st_inline_writes);
     }
 
+    prn_log_hist(out, "st_fsync_us", stats->st_fsync_us_hist);
+    if (bdb_state->dbenv->attr.log_group_commit) {
+        prn_stat(st_gc_flushes);
+        prn_log_hist(out, "st_gc_batch", stats->st_gc_batch_hist);
+    }
+
     free(stats);
 }
 
@@ -351,7 +390,7 @@ static void rep_stats(FILE *out, bdb_state_type *bdb_state)
     char str[80];
     extern int64_t gbl_rep_trans_parallel, gbl_rep_trans_serial,
         gbl_rep_trans_deadlocked, gbl_rep_trans_inline,
-        gbl_rep_rowlocks_multifile;
+        gbl_rep_rowlocks_multifile, gbl_rep_trans_pgdep;
 
     bdb_state->dbenv->rep_stat(bdb_state->dbenv, &stats, 0);
 
@@ -407,6 +446,8 @@ static void rep_stats(FILE *out, bdb_state_type *bdb_state)
             gbl_rep_trans_inline);
     logmsgf(LOGMSG_USER, out, "txn multifile rowlocks: %" PRId64 "\n",
             gbl_rep_rowlocks_multifile);
+    logmsgf(LOGMSG_USER, out, "txn page-parallel: %" PRId64 "\n",
+            gbl_rep_trans_pgdep);
     logmsgf(LOGMSG_USER, out, "txn deadlocked: %" PRId64 "\n",
             gbl_rep_trans_deadlocked);
     prn_lstat(lc_cache_hits);
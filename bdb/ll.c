@@ -248,6 +248,8 @@ int ll_dta_add(bdb_state_type *bdb_state, unsigned long long genid, DB *dbp,
                 &parent->last_logical_lsn, NULL);
             if (iirc)
                 abort();
+            bdb_serial_index_track(bdb_state, parent, bdb_state->name, -2,
+                                   NULL, 0);
 
             iirc = bdb_state->dbenv->lock_update_tracked_writelocks_lsn(
                 bdb_state->dbenv, tran->tid, tran->tid->txnid,
@@ -459,6 +461,8 @@ int ll_dta_del(bdb_state_type *bdb_state, tran_type *tran, int rrn,
                                          dtastripe, dta_out_si.size, NULL);
             if (iirc)
                 abort();
+            bdb_serial_index_track(bdb_state, parent, bdb_state->name, -2,
+                                   NULL, 0);
 
             iirc = bdb_state->dbenv->lock_update_tracked_writelocks_lsn(
                 bdb_state->dbenv, tran->tid, tran->tid->txnid,
@@ -618,6 +622,8 @@ int ll_key_del(bdb_state_type *bdb_state, tran_type *tran, int ixnum, void *key,
                 &parent->last_logical_lsn, NULL, keylen, *payloadsz);
             if (iirc)
                 abort();
+            bdb_serial_index_track(bdb_state, parent, bdb_state->name, ixnum,
+                                   dbt_key.data, dbt_key.size);
 
             iirc = bdb_state->dbenv->lock_update_tracked_writelocks_lsn(
                 bdb_state->dbenv, tran->tid, tran->tid->txnid,
@@ -791,6 +797,9 @@ int ll_key_upd(bdb_state_type *bdb_state, tran_type *tran, char *table_name,
                     &parent->last_logical_lsn, 0, &dbt_tbl, oldgenid, genid,
                     parent->logical_tranid, &parent->last_logical_lsn, ixnum,
                     &dbt_key, dtalen);
+                if (!iirc)
+                    bdb_serial_index_track(bdb_state, parent, bdb_state->name,
+                                           ixnum, dbt_key.data, dbt_key.size);
 
                 /*
                 DB_LSN crp = parent->last_logical_lsn;
@@ -877,6 +886,8 @@ int ll_key_add(bdb_state_type *bdb_state, unsigned long long ingenid,
                 &parent->last_logical_lsn, dbt_key->size, dbt_data->size);
             if (iirc)
                 abort();
+            bdb_serial_index_track(bdb_state, parent, bdb_state->name, ixnum,
+                                   dbt_key->data, dbt_key->size);
 
             iirc = bdb_state->dbenv->lock_update_tracked_writelocks_lsn(
                 bdb_state->dbenv, tran->tid, tran->tid->txnid,
@@ -1370,6 +1381,9 @@ static int ll_dta_upd_int(bdb_state_type *bdb_state, int rrn,
                 0, &dbt_tbl, oldgenid, *newgenid, parent->logical_tranid,
                 &parent->last_logical_lsn, dtafile, dtastripe, NULL, NULL,
                 old_dta_out_lcl.size);
+            if (!iirc)
+                bdb_serial_index_track(bdb_state, parent, bdb_state->name, -2,
+                                       NULL, 0);
 
             /*
             fprintf( stderr, "%s:%d upd ix LLSN %d:%d -> %d:%d\n",
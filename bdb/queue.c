@@ -1744,6 +1744,27 @@ int bdb_queue_get(bdb_state_type *bdb_state, tran_type *tran, int consumer,
     return rc;
 }
 
+int bdb_queue_get_batch(bdb_state_type *bdb_state, tran_type *tran,
+                        int consumer, const struct bdb_queue_cursor *prevcursor,
+                        int max, struct bdb_queue_found **fnds,
+                        struct bdb_queue_cursor *fndcursors, long long *seqs,
+                        int *nfnd, int *bdberr)
+{
+    int rc;
+
+    *nfnd = 0;
+    if (bdb_state->bdbtype != BDBTYPE_QUEUEDB) {
+        *bdberr = BDBERR_BADARGS;
+        return -1;
+    }
+    BDB_READLOCK("bdb_queue_get_batch");
+    rc = bdb_queuedb_get_batch(bdb_state, tran, consumer, prevcursor, max,
+                               fnds, fndcursors, seqs, nfnd, bdberr);
+    BDB_RELLOCK();
+
+    return rc;
+}
+
 static int bdb_queue_consume_int(bdb_state_type *bdb_state, tran_type *intran,
                                  int consumer, const void *prevfnd, int *bdberr)
 {
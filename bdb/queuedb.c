@@ -922,6 +922,41 @@ int bdb_queuedb_dump(bdb_state_type *bdb_state, FILE *out, int *bdberr)
     return 0;
 }
 
+/* Decode the header of a queue item in place.  Returns -1 if the item is
+ * malformed. */
+static int queuedb_unpack_found(bdb_state_type *bdb_state, DBT *dbt_data,
+                                long long *seq, size_t *data_offset)
+{
+    uint8_t *p_buf = dbt_data->data;
+    uint8_t *p_buf_end = p_buf + dbt_data->size;
+
+    if (dbt_data->size < sizeof(struct bdb_queue_found)) {
+        logmsg(LOGMSG_ERROR, "%s: invalid queue entry size %d in queue %s\n",
+                __func__, dbt_data->size, bdb_state->name);
+        return -1;
+    }
+
+    if (bdb_state->ondisk_header) {
+        struct bdb_queue_found_seq qfnd_odh;
+        p_buf = (uint8_t *)queue_found_seq_get(&qfnd_odh, p_buf, p_buf_end);
+        memcpy(dbt_data->data, &qfnd_odh, sizeof(qfnd_odh));
+        *seq = qfnd_odh.seq;
+        *data_offset = qfnd_odh.data_offset;
+    } else {
+        struct bdb_queue_found qfnd;
+        p_buf = (uint8_t *)queue_found_get(&qfnd, p_buf, p_buf_end);
+        memcpy(dbt_data->data, &qfnd, sizeof(qfnd));
+        *seq = 0;
+        *data_offset = qfnd.data_offset;
+    }
+    if (p_buf == NULL) {
+        logmsg(LOGMSG_ERROR, "%s: can't decode header size %u in queue %s\n",
+               __func__, dbt_data->size, bdb_state->name);
+        return -1;
+    }
+    return 0;
+}
+
 static int bdb_queuedb_get_int(bdb_state_type *bdb_state, tran_type *tran, DB *db, int consumer,
                                const struct bdb_queue_cursor *prevcursor, struct bdb_queue_found **fnd,
                                size_t *fnddtalen, size_t *fnddtaoff, struct bdb_queue_cursor *fndcursor,
@@ -1094,31 +1129,7 @@ static int bdb_queuedb_get_int(bdb_state_type *bdb_state, tran_type *tran, DB *d
     }
 
     /* made this far? massage the data and return it. */
-    p_buf = dbt_data.data;
-    p_buf_end = p_buf + dbt_data.size;
-    if (dbt_data.size < sizeof(struct bdb_queue_found)) {
-        logmsg(LOGMSG_ERROR, "%s: invalid queue entry size %d in queue %s\n",
-                __func__, dbt_data.size, bdb_state->name);
-        *bdberr = BDBERR_MISC; /* ... */
-        rc = -1;
-        goto done;
-    }
-
-    if (bdb_state->ondisk_header) {
-        struct bdb_queue_found_seq qfnd_odh;
-        p_buf = (uint8_t *)queue_found_seq_get(&qfnd_odh, p_buf, p_buf_end);
-        memcpy(dbt_data.data, &qfnd_odh, sizeof(qfnd_odh));
-        sequence = qfnd_odh.seq;
-        data_offset = qfnd_odh.data_offset;
-    } else {
-        struct bdb_queue_found qfnd;
-        p_buf = (uint8_t *)queue_found_get(&qfnd, p_buf, p_buf_end);
-        memcpy(dbt_data.data, &qfnd, sizeof(qfnd));
-        data_offset = qfnd.data_offset;
-    }
-    if (p_buf == NULL) {
-        logmsg(LOGMSG_ERROR, "%s: can't decode header size %u in queue %s\n",
-               __func__, dbt_data.size, bdb_state->name);
+    if (queuedb_unpack_found(bdb_state, &dbt_data, &sequence, &data_offset)) {
         *bdberr = BDBERR_MISC; /* ... */
         rc = -1;
         goto done;
@@ -1205,6 +1216,176 @@ int bdb_queuedb_get(bdb_state_type *bdb_state, tran_type *tran, int consumer,
     return rc;
 }
 
+/*
+ * Read up to max items for consumer, starting after prevcursor, with one
+ * cursor.  Stops early at the end of the consumer's items or on a
+ * deadlock once something has been read.
+ */
+static int bdb_queuedb_get_batch_int(bdb_state_type *bdb_state,
+                                     tran_type *tran, DB *db, int consumer,
+                                     const struct bdb_queue_cursor *prevcursor,
+                                     int max, struct bdb_queue_found **fnds,
+                                     struct bdb_queue_cursor *fndcursors,
+                                     long long *seqs, int *nfnd, int *bdberr)
+{
+    struct queuedb_key k, fndk;
+    DBT dbt_key = {0}, dbt_data = {0};
+    DBC *dbcp = NULL;
+    uint8_t ver = 0;
+    uint8_t key[QUEUEDB_KEY_LEN] = {0};
+    uint8_t *p_buf;
+    size_t data_offset;
+    long long sequence;
+    int rc, n = 0, flags = DB_SET_RANGE;
+    struct bdb_queue_priv *qstate = bdb_state->qpriv;
+
+    *nfnd = 0;
+    if (db == NULL) { // trigger dropped?
+        *bdberr = BDBERR_BADARGS;
+        return -1;
+    }
+
+    rc = db->cursor(db, NULL, &dbcp, 0);
+    if (rc) {
+        *bdberr = BDBERR_MISC;
+        return -1;
+    }
+    if (tran) {
+        dbcp->c_replace_lockid(dbcp, tran->tid->txnid);
+    }
+
+    k.consumer = consumer;
+    k.genid = prevcursor ? prevcursor->genid : 0;
+    queuedb_key_put(&k, key, key + QUEUEDB_KEY_LEN);
+    dbt_key.data = key;
+    dbt_key.size = QUEUEDB_KEY_LEN;
+    dbt_key.flags = dbt_data.flags = DB_DBT_REALLOC;
+
+    qstate->stats.n_physical_gets++;
+    while (n < max) {
+        rc = bdb_cget_unpack(bdb_state, dbcp, &dbt_key, &dbt_data, &ver,
+                             flags);
+        flags = DB_NEXT;
+        if (rc == DB_NOTFOUND)
+            break;
+        if (rc == DB_LOCK_DEADLOCK) {
+            qstate->stats.n_get_deadlocks++;
+            if (n == 0) {
+                *bdberr = BDBERR_DEADLOCK;
+                rc = -1;
+                goto done;
+            }
+            break;
+        }
+        if (rc) {
+            logmsg(LOGMSG_ERROR, "%s %s get rc %d\n", __func__,
+                   bdb_state->name, rc);
+            *bdberr = BDBERR_MISC;
+            rc = -1;
+            goto done;
+        }
+
+        p_buf = queuedb_key_get(&fndk, dbt_key.data,
+                                (uint8_t *)dbt_key.data + dbt_key.size);
+        if (p_buf == NULL || fndk.consumer != consumer)
+            break;
+        /* the previous item, not consumed yet */
+        if (n == 0 && prevcursor && prevcursor->genid != 0 &&
+            fndk.genid == prevcursor->genid)
+            continue;
+
+        if (queuedb_unpack_found(bdb_state, &dbt_data, &sequence,
+                                 &data_offset)) {
+            *bdberr = BDBERR_MISC;
+            rc = -1;
+            goto done;
+        }
+        fnds[n] = dbt_data.data;
+        dbt_data.data = NULL;
+        if (seqs)
+            seqs[n] = sequence;
+        fndcursors[n].genid = fndk.genid;
+        fndcursors[n].recno = 0;
+        fndcursors[n].reserved = 0;
+        n++;
+    }
+
+    *nfnd = n;
+    if (n == 0) {
+        qstate->stats.n_get_not_founds++;
+        *bdberr = BDBERR_FETCH_DTA;
+        rc = -1;
+    } else {
+        qstate->stats.n_batch_gets++;
+        qstate->stats.n_batch_items += n;
+        *bdberr = BDBERR_NOERROR;
+        rc = 0;
+    }
+
+done:
+    if (rc && n > 0) {
+        for (int i = 0; i < n; i++)
+            free(fnds[i]);
+        *nfnd = 0;
+    }
+    if (dbcp) {
+        int crc = dbcp->c_close(dbcp);
+        if (crc && rc == 0) {
+            logmsg(LOGMSG_ERROR, "%s: c_close berk rc %d\n", __func__, crc);
+            for (int i = 0; i < n; i++)
+                free(fnds[i]);
+            *nfnd = 0;
+            *bdberr = (crc == DB_LOCK_DEADLOCK) ? BDBERR_DEADLOCK : BDBERR_MISC;
+            rc = -1;
+        }
+    }
+    if (dbt_key.data && dbt_key.data != key)
+        free(dbt_key.data);
+    if (dbt_data.data)
+        free(dbt_data.data);
+    return rc;
+}
+
+int bdb_queuedb_get_batch(bdb_state_type *bdb_state, tran_type *tran,
+                          int consumer,
+                          const struct bdb_queue_cursor *prevcursor, int max,
+                          struct bdb_queue_found **fnds,
+                          struct bdb_queue_cursor *fndcursors,
+                          long long *seqs, int *nfnd, int *bdberr)
+{
+    int rc = bdb_lock_table_read(bdb_state, tran);
+    *nfnd = 0;
+    if (rc == DB_LOCK_DEADLOCK) {
+        *bdberr = BDBERR_DEADLOCK;
+        struct bdb_queue_priv *qstate = bdb_state->qpriv;
+        qstate->stats.n_get_deadlocks++;
+        return -1;
+    } else if (rc != 0) {
+        logmsg(LOGMSG_ERROR, "%s: queuedb %s error getting tablelock %d\n",
+               __func__, bdb_state->name, rc);
+        *bdberr = BDBERR_MISC;
+        return -1;
+    }
+
+    DB *db = BDB_QUEUEDB_GET_DBP_ZERO(bdb_state);
+    assert(db != NULL);
+    *bdberr = 0;
+
+    /* Same order as bdb_queuedb_get: file #1 only once #0 is drained */
+    rc = bdb_queuedb_get_batch_int(bdb_state, tran, db, consumer, prevcursor,
+                                   max, fnds, fndcursors, seqs, nfnd, bdberr);
+    if ((rc == -1) && (*bdberr == BDBERR_FETCH_DTA)) {
+        db = BDB_QUEUEDB_GET_DBP_ONE(bdb_state);
+        if (db != NULL) {
+            *bdberr = 0;
+            rc = bdb_queuedb_get_batch_int(bdb_state, tran, db, consumer,
+                                           prevcursor, max, fnds, fndcursors,
+                                           seqs, nfnd, bdberr);
+        }
+    }
+    return rc;
+}
+
 static int bdb_queuedb_consume_int(bdb_state_type *bdb_state, DB *db,
                                    tran_type *tran, int consumer,
                                    const struct bdb_queue_found *fnd,
@@ -47,6 +47,7 @@
 #include <compat.h>
 #include "str0.h"
 #include <thrman.h>
+#include <comdb2_atomic.h>
 
 #define REP_PRI 100     /* we are all equal in the eyes of god */
 #define REPTIME 3000000 /* default 3 second timeout on election */
@@ -684,6 +685,334 @@ static int throttle_updates_incoherent_nodes(bdb_state_type *bdb_state,
     return ret;
 }
 
+/*
+ * Commit pacing.  Rather than waiting for a replicant to fall far enough
+ * behind to be made incoherent (and then delaying every commit by a fixed
+ * commitdelay), the master samples how fast each coherent replicant is
+ * applying the log and how long commits wait for it, and spaces its own
+ * commits out just enough that the slowest one stays within
+ * gbl_rep_pace_target_lag bytes and gbl_rep_pace_target_wait_ms.
+ */
+int gbl_rep_pace = 0;
+int gbl_rep_pace_target_lag = 1048576;
+int gbl_rep_pace_target_wait_ms = 50;
+int gbl_rep_pace_min_pct = 10;
+int gbl_rep_pace_trace = 0;
+
+/* sample no more often than this */
+#define REP_PACE_MIN_SAMPLE_US 100000
+/* never space commits further apart than this */
+#define REP_PACE_MAX_INTERVAL_US 100000
+/* below this, pacing is switched off */
+#define REP_PACE_MIN_INTERVAL_US 10
+
+struct rep_pace_node {
+    const char *host;
+    DB_LSN lsn;
+    int state;           /* 0 coherent, 1 incoherent, 2 catching up */
+    int limiting;        /* this node set the commit rate */
+    int64_t lag;         /* bytes behind the master */
+    double apply_rate;   /* bytes/sec, smoothed */
+    double wait_ms;      /* avg commit wait over 10 seconds */
+    double allowed_rate; /* master bytes/sec this node can keep up with */
+};
+
+static struct {
+    pthread_mutex_t lk;
+    int64_t last_us;
+    DB_LSN master_lsn;
+    uint64_t commits;
+    uint64_t last_commits;
+    uint64_t paced;
+    double master_rate;
+    double bytes_per_commit;
+    int64_t interval_us;
+    int64_t next_us;
+    const char *decision;
+    int nnodes;
+    struct rep_pace_node nodes[REPMAX];
+} rep_pace = {.lk = PTHREAD_MUTEX_INITIALIZER, .decision = "off"};
+
+static inline double rep_pace_ewma(double avg, double sample)
+{
+    return avg ? (avg + sample) / 2 : sample;
+}
+
+static struct rep_pace_node *rep_pace_node_get(const char *host)
+{
+    int i;
+    for (i = 0; i < rep_pace.nnodes; i++) {
+        if (rep_pace.nodes[i].host == host)
+            return &rep_pace.nodes[i];
+    }
+    if (rep_pace.nnodes == REPMAX)
+        return NULL;
+    memset(&rep_pace.nodes[i], 0, sizeof(struct rep_pace_node));
+    rep_pace.nodes[i].host = host;
+    rep_pace.nnodes++;
+    return &rep_pace.nodes[i];
+}
+
+static void rep_pace_reset(void)
+{
+    rep_pace.last_us = 0;
+    rep_pace.interval_us = 0;
+    rep_pace.master_rate = 0;
+    rep_pace.bytes_per_commit = 0;
+    rep_pace.nnodes = 0;
+    rep_pace.decision = "off";
+}
+
+/* Called by the master for every commit record it writes */
+void bdb_rep_pace_commit(void *arg)
+{
+    int64_t interval, now, slot;
+
+    if (!gbl_rep_pace)
+        return;
+
+    ATOMIC_ADD64(rep_pace.commits, 1);
+
+    if ((interval = rep_pace.interval_us) == 0)
+        return;
+
+    /* Hand out commit slots interval_us apart; an idle master earns no
+     * credit, so there is no burst after a quiet period */
+    Pthread_mutex_lock(&rep_pace.lk);
+    now = comdb2_time_epochus();
+    slot = rep_pace.next_us > now ? rep_pace.next_us : now;
+    rep_pace.next_us = slot + interval;
+    if (slot > now)
+        rep_pace.paced++;
+    Pthread_mutex_unlock(&rep_pace.lk);
+
+    if (slot > now)
+        usleep(slot - now);
+}
+
+/* Sample the replicants and recompute the commit interval; called
+ * periodically on the master */
+void bdb_rep_pace_update(bdb_state_type *bdb_state)
+{
+    const char *hostlist[REPMAX];
+    const char *limiting = NULL;
+    struct rep_pace_node *n;
+    DB_LSN master_lsn;
+    uint64_t commits;
+    int64_t now, interval;
+    double secs, produced, limit, floor;
+    int count, i;
+
+    if (bdb_state->parent)
+        bdb_state = bdb_state->parent;
+
+    Pthread_mutex_lock(&rep_pace.lk);
+
+    if (!gbl_rep_pace ||
+        bdb_state->repinfo->master_host != bdb_state->repinfo->myhost) {
+        if (rep_pace.last_us)
+            rep_pace_reset();
+        Pthread_mutex_unlock(&rep_pace.lk);
+        return;
+    }
+
+    now = comdb2_time_epochus();
+    if (rep_pace.last_us && now - rep_pace.last_us < REP_PACE_MIN_SAMPLE_US) {
+        Pthread_mutex_unlock(&rep_pace.lk);
+        return;
+    }
+
+    get_my_lsn(bdb_state, &master_lsn);
+    commits = ATOMIC_LOAD64(rep_pace.commits);
+
+    if (rep_pace.last_us == 0) {
+        rep_pace.last_us = now;
+        rep_pace.master_lsn = master_lsn;
+        rep_pace.last_commits = commits;
+        rep_pace.decision = "hold";
+        Pthread_mutex_unlock(&rep_pace.lk);
+        return;
+    }
+
+    secs = (now - rep_pace.last_us) / 1000000.0;
+    produced = log_compare(&master_lsn, &rep_pace.master_lsn) > 0
+                   ? subtract_lsn(bdb_state, &master_lsn, &rep_pace.master_lsn)
+                   : 0;
+    rep_pace.master_rate = rep_pace_ewma(rep_pace.master_rate, produced / secs);
+    if (commits > rep_pace.last_commits && produced > 0)
+        rep_pace.bytes_per_commit =
+            rep_pace_ewma(rep_pace.bytes_per_commit,
+                          produced / (commits - rep_pace.last_commits));
+    rep_pace.last_us = now;
+    rep_pace.master_lsn = master_lsn;
+    rep_pace.last_commits = commits;
+
+    /* forget the nodes that went away */
+    count = net_get_all_nodes_connected(bdb_state->repinfo->netinfo, hostlist);
+    for (i = 0; i < rep_pace.nnodes;) {
+        int j;
+        for (j = 0; j < count; j++) {
+            if (hostlist[j] == rep_pace.nodes[i].host)
+                break;
+        }
+        if (j == count)
+            rep_pace.nodes[i] = rep_pace.nodes[--rep_pace.nnodes];
+        else
+            i++;
+    }
+
+    limit = 0;
+    for (i = 0; i < count; i++) {
+        DB_LSN lsn;
+        double wait_ms = 0;
+        int node_ix = nodeix(hostlist[i]);
+
+        if ((n = rep_pace_node_get(hostlist[i])) == NULL)
+            break;
+        n->limiting = 0;
+        n->allowed_rate = 0;
+
+        Pthread_mutex_lock(&(bdb_state->seqnum_info->lock));
+        lsn = bdb_state->seqnum_info->seqnums[node_ix].lsn;
+        if (bdb_state->seqnum_info->time_10seconds &&
+            bdb_state->seqnum_info->time_10seconds[node_ix])
+            wait_ms =
+                averager_avg(bdb_state->seqnum_info->time_10seconds[node_ix]);
+        Pthread_mutex_unlock(&(bdb_state->seqnum_info->lock));
+
+        if (lsn.file == INT_MAX) {
+            n->state = 2;
+            continue;
+        }
+        n->lag = log_compare(&master_lsn, &lsn) > 0
+                     ? subtract_lsn(bdb_state, &master_lsn, &lsn)
+                     : 0;
+        if (n->lsn.file && log_compare(&lsn, &n->lsn) > 0)
+            n->apply_rate = rep_pace_ewma(
+                n->apply_rate, subtract_lsn(bdb_state, &lsn, &n->lsn) / secs);
+        else if (n->lsn.file)
+            n->apply_rate = rep_pace_ewma(n->apply_rate, 0);
+        n->lsn = lsn;
+        n->wait_ms = wait_ms;
+
+        /* Incoherent nodes catch up on their own and do not hold back
+         * commits; throttle_updates_incoherent_nodes() still applies */
+        if (is_incoherent(bdb_state, hostlist[i])) {
+            n->state = 1;
+            continue;
+        }
+        n->state = 0;
+
+        /* Keep up with this node, and close whatever gap there is to the
+         * target lag over the next second */
+        n->allowed_rate =
+            n->apply_rate + (double)(gbl_rep_pace_target_lag - n->lag);
+        if (gbl_rep_pace_target_wait_ms > 0 &&
+            n->wait_ms > gbl_rep_pace_target_wait_ms &&
+            rep_pace.master_rate * gbl_rep_pace_target_wait_ms / n->wait_ms <
+                n->allowed_rate)
+            n->allowed_rate =
+                rep_pace.master_rate * gbl_rep_pace_target_wait_ms / n->wait_ms;
+
+        if (limiting == NULL || n->allowed_rate < limit) {
+            limiting = n->host;
+            limit = n->allowed_rate;
+        }
+    }
+
+    interval = rep_pace.interval_us;
+    if (limiting == NULL || limit >= rep_pace.master_rate ||
+        rep_pace.bytes_per_commit == 0) {
+        /* everyone is keeping up: back off gradually */
+        interval /= 2;
+        rep_pace.decision = interval ? "loosen" : "hold";
+    } else {
+        floor = rep_pace.master_rate * gbl_rep_pace_min_pct / 100;
+        if (limit < floor)
+            limit = floor;
+        if (limit <= 0) {
+            interval = REP_PACE_MAX_INTERVAL_US;
+        } else {
+            interval = 1000000 * rep_pace.bytes_per_commit / limit;
+            /* don't more than double at a time, to avoid overshooting */
+            if (interval > 2 * rep_pace.interval_us && rep_pace.interval_us)
+                interval = 2 * rep_pace.interval_us;
+        }
+        rep_pace.decision = "tighten";
+        for (i = 0; i < rep_pace.nnodes; i++) {
+            if (rep_pace.nodes[i].host == limiting)
+                rep_pace.nodes[i].limiting = 1;
+        }
+    }
+    if (interval > REP_PACE_MAX_INTERVAL_US)
+        interval = REP_PACE_MAX_INTERVAL_US;
+    if (interval < REP_PACE_MIN_INTERVAL_US)
+        interval = 0;
+
+    if (gbl_rep_pace_trace && interval != rep_pace.interval_us) {
+        logmsg(LOGMSG_USER,
+               "%s %s: commit interval %" PRId64 "us -> %" PRId64
+               "us, master %.0f bytes/sec, limited by %s at %.0f bytes/sec\n",
+               __func__, rep_pace.decision, rep_pace.interval_us, interval,
+               rep_pace.master_rate, limiting ? limiting : "none", limit);
+    }
+    rep_pace.interval_us = interval;
+
+    Pthread_mutex_unlock(&rep_pace.lk);
+}
+
+int bdb_rep_pace_stats(rep_pace_stat_t **stats, int *nstats)
+{
+    static const char *states[] = {"coherent", "incoherent", "catching up"};
+    rep_pace_stat_t *s;
+    char lsn[LSN_TEXT_WIDTH];
+    int i;
+
+    *stats = NULL;
+    *nstats = 0;
+
+    Pthread_mutex_lock(&rep_pace.lk);
+    if (rep_pace.nnodes == 0) {
+        Pthread_mutex_unlock(&rep_pace.lk);
+        return 0;
+    }
+    if ((s = calloc(rep_pace.nnodes, sizeof(rep_pace_stat_t))) == NULL) {
+        Pthread_mutex_unlock(&rep_pace.lk);
+        return -1;
+    }
+    for (i = 0; i < rep_pace.nnodes; i++) {
+        struct rep_pace_node *n = &rep_pace.nodes[i];
+        snprintf(lsn, sizeof(lsn), "{%u:%u}", n->lsn.file, n->lsn.offset);
+        s[i].host = strdup(n->host);
+        s[i].lsn = strdup(lsn);
+        s[i].state = strdup(states[n->state]);
+        s[i].lag_bytes = n->lag;
+        s[i].apply_rate = n->apply_rate;
+        s[i].wait_ms = n->wait_ms;
+        s[i].allowed_rate = n->allowed_rate;
+        s[i].limiting = n->limiting;
+        s[i].master_rate = rep_pace.master_rate;
+        s[i].commit_interval_us = rep_pace.interval_us;
+        s[i].paced_commits = rep_pace.paced;
+        s[i].decision = strdup(rep_pace.decision);
+    }
+    *nstats = rep_pace.nnodes;
+    Pthread_mutex_unlock(&rep_pace.lk);
+    *stats = s;
+    return 0;
+}
+
+void bdb_rep_pace_stats_free(rep_pace_stat_t *stats, int nstats)
+{
+    for (int i = 0; i < nstats; i++) {
+        free(stats[i].host);
+        free(stats[i].lsn);
+        free(stats[i].state);
+        free(stats[i].decision);
+    }
+    free(stats);
+}
+
 extern int gbl_rowlocks;
 
 static unsigned long long callcount = 0;
@@ -4864,6 +5193,45 @@ int enqueue_touch_page(DB_MPOOLFILE *mpf, db_pgno_t pgno)
     return rc;
 }
 
+static void touch_pages_pp(struct thdpool *pool, void *work, void *thddata,
+                           int op)
+{
+    touch_pgs *pgs = work;
+
+    switch (op) {
+    case THD_RUN:
+        __memp_prefetch(pgs->mpf, pgs->pgnos, pgs->npgnos);
+        break;
+    }
+    free(work);
+}
+
+/* With io_uring on, one job reads the whole batch with one submission
+ * instead of handing every page to its own prefault thread. */
+int enqueue_touch_pages(DB_MPOOLFILE *mpf, db_pgno_t *pgnos, int npgnos)
+{
+    touch_pgs *work;
+    int i, rc;
+
+    if (!mpf->dbenv->attr.iouring_enabled || npgnos < 2) {
+        for (i = 0, rc = 0; i < npgnos && rc == 0; i++)
+            rc = enqueue_touch_page(mpf, pgnos[i]);
+        return rc;
+    }
+
+    work = malloc(offsetof(touch_pgs, pgnos) + npgnos * sizeof(db_pgno_t));
+    if (work == NULL)
+        return ENOMEM;
+    work->mpf = mpf;
+    work->npgnos = npgnos;
+    memcpy(work->pgnos, pgnos, npgnos * sizeof(db_pgno_t));
+    rc = thdpool_enqueue(gbl_udppfault_thdpool, touch_pages_pp, work, 0, NULL,
+                         0);
+    if (rc)
+        free(work);
+    return rc;
+}
+
 static void udppfault_do_work_pp(struct thdpool *pool, void *work,
                                  void *thddata, int op)
 {
@@ -5056,6 +5424,15 @@ static int berkdb_receive_rtn_int(void *ack_handle, void *usr_ptr,
         break;
 
     case USER_TYPE_COMMITDELAYMORE:
+        /* the pacer owns the commit rate */
+        if (gbl_rep_pace) {
+            if (gbl_commit_delay_trace)
+                logmsg(LOGMSG_USER,
+                       "--- ignoring commitdelaymore req from node %s, "
+                       "commits are paced\n",
+                       from_node);
+            break;
+        }
         if (bdb_state->attr->commitdelay == 0)
             bdb_state->attr->commitdelay = 1;
         else
@@ -5359,7 +5736,8 @@ void *watcher_thread(void *arg)
                 if (is_incoherent(bdb_state, hostlist[i]))
                     num_skipped++;
 
-            if (num_skipped >= bdb_state->attr->toomanyskipped) {
+            if (num_skipped >= bdb_state->attr->toomanyskipped &&
+                !gbl_rep_pace) {
                 /* too many guys being skipped, let's take drastic measures!
                  * delay ourselves */
                 if (bdb_state->attr->commitdelay <
@@ -5378,6 +5756,8 @@ void *watcher_thread(void *arg)
                 }
             }
 
+            bdb_rep_pace_update(bdb_state);
+
             if (bdb_state->attr->track_replication_times) {
                 int now;
                 now = comdb2_time_epochms();
@@ -1745,6 +1745,143 @@ static int cancel_all_logical_transactions(bdb_state_type *bdb_state)
     return 0;
 }
 
+/* Outstanding logical transactions hold disjoint row locks, so the master
+ * can undo them independently.  Workers take the next transaction off the
+ * list and abort it; progress is the share of the transactions' log span
+ * that has been undone. */
+struct logical_recovery {
+    bdb_state_type *bdb_state;
+    DB_LTRAN *ltranlist;
+    tran_type **bdb_tran;
+    u_int32_t ltrancount;
+    u_int32_t lg_max;
+    pthread_mutex_t lk;
+    u_int32_t next;
+    u_int32_t ndone;
+    u_int64_t span;
+    u_int64_t covered;
+    int start;
+    int last_report;
+    int rc;
+};
+
+static u_int64_t ltran_span(struct logical_recovery *lr, int i)
+{
+    DB_LSN *b = &lr->ltranlist[i].begin_lsn, *e = &lr->ltranlist[i].last_lsn;
+    u_int64_t begin = (u_int64_t)b->file * lr->lg_max + b->offset;
+    u_int64_t end = (u_int64_t)e->file * lr->lg_max + e->offset;
+
+    /* every transaction counts for something, even a one-record one */
+    return end > begin ? end - begin : 1;
+}
+
+static void logical_recovery_work(struct logical_recovery *lr)
+{
+    bdb_state_type *bdb_state = lr->bdb_state;
+    int i, rc, bdberr, now;
+
+    Pthread_mutex_lock(&lr->lk);
+    while (lr->rc == 0 && lr->next < lr->ltrancount) {
+        i = lr->next++;
+        Pthread_mutex_unlock(&lr->lk);
+
+        /* the commit path finds the master transaction through this key */
+        Pthread_setspecific(bdb_state->seqnum_info->key, lr->bdb_tran[i]);
+        rc = bdb_tran_abort(bdb_state, lr->bdb_tran[i], &bdberr);
+
+        Pthread_mutex_lock(&lr->lk);
+        if (rc) {
+            logmsg(LOGMSG_ERROR, "abort abort rc %d bdberr %d\n", rc, bdberr);
+            if (lr->rc == 0)
+                lr->rc = rc;
+            break;
+        }
+        lr->ndone++;
+        lr->covered += ltran_span(lr, i);
+        now = comdb2_time_epochms();
+        if (lr->ndone == lr->ltrancount || now - lr->last_report >= 1000) {
+            logmsg(LOGMSG_USER,
+                   "logical recovery %.1f%% of log range, %u of %u "
+                   "transactions, %d ms\n",
+                   100.0 * lr->covered / lr->span, lr->ndone, lr->ltrancount,
+                   now - lr->start);
+            lr->last_report = now;
+        }
+    }
+    Pthread_mutex_unlock(&lr->lk);
+}
+
+static void *logical_recovery_thd(void *arg)
+{
+    struct logical_recovery *lr = arg;
+
+    bdb_thread_event(lr->bdb_state, BDBTHR_EVENT_START_RDWR);
+    logical_recovery_work(lr);
+    bdb_thread_event(lr->bdb_state, BDBTHR_EVENT_DONE_RDWR);
+    return NULL;
+}
+
+static int abort_recovered_transactions(bdb_state_type *bdb_state,
+                                        DB_LTRAN *ltranlist,
+                                        tran_type **bdb_tran,
+                                        u_int32_t ltrancount)
+{
+    struct logical_recovery lr = {0};
+    pthread_attr_t attr;
+    pthread_t *tids;
+    int nthreads, started = 0;
+
+    lr.bdb_state = bdb_state;
+    lr.ltranlist = ltranlist;
+    lr.bdb_tran = bdb_tran;
+    lr.ltrancount = ltrancount;
+    if (bdb_state->dbenv->get_lg_max(bdb_state->dbenv, &lr.lg_max) != 0 ||
+        lr.lg_max == 0)
+        lr.lg_max = 1 << 30;
+    for (int i = 0; i < ltrancount; i++)
+        lr.span += ltran_span(&lr, i);
+    lr.start = lr.last_report = comdb2_time_epochms();
+    Pthread_mutex_init(&lr.lk, NULL);
+
+    nthreads = bdb_state->attr->logical_recovery_threads;
+    if (nthreads > ltrancount)
+        nthreads = ltrancount;
+
+    /* one thread: undo them here, one after the other */
+    if (nthreads <= 1) {
+        logical_recovery_work(&lr);
+        goto out;
+    }
+
+    tids = alloca(nthreads * sizeof(pthread_t));
+    Pthread_attr_init(&attr);
+    Pthread_attr_setstacksize(&attr, 1024 * 1024);
+    for (int i = 0; i < nthreads; i++) {
+        if (pthread_create(&tids[i], &attr, logical_recovery_thd, &lr) != 0) {
+            logmsg(LOGMSG_ERROR, "%s: can't start recovery thread %d\n",
+                   __func__, i);
+            break;
+        }
+        started++;
+    }
+    Pthread_attr_destroy(&attr);
+
+    /* whatever the threads didn't get to runs here */
+    if (started < nthreads)
+        logical_recovery_work(&lr);
+    for (int i = 0; i < started; i++)
+        Pthread_join(tids[i], NULL);
+
+out:
+    logmsg(LOGMSG_USER,
+           "logical recovery aborted %u transactions with %d threads in %d "
+           "ms\n",
+           lr.ndone, nthreads > 1 ? started : 1,
+           comdb2_time_epochms() - lr.start);
+    Pthread_mutex_destroy(&lr.lk);
+    return lr.rc;
+}
+
 int llmeta_open(void);
 
 /* XXX
@@ -1825,13 +1962,13 @@ int bdb_run_logical_recovery(bdb_state_type *bdb_state, int is_replicant)
         bdb_tran[i]->last_logical_lsn = ll_lsn;
         bdb_tran[i]->last_physical_commit_lsn = ll_lsn;
         bdb_tran[i]->begin_lsn = ltranlist[i].begin_lsn;
-        rc = bdb_tran_abort(bdb_state, bdb_tran[i], &bdberr);
-        if (rc) {
-            logmsg(LOGMSG_ERROR, "abort abort rc %d bdberr %d\n", rc, bdberr);
-            goto done;
-        }
     }
 
+    rc = abort_recovered_transactions(bdb_state, ltranlist, bdb_tran,
+                                      ltrancount);
+    if (rc)
+        goto done;
+
     bdb_state->dbenv->ltran_count(bdb_state->dbenv, &ltrancount);
     assert(0 == ltrancount);
 
@@ -2863,6 +3000,8 @@ int bdb_llog_add_ix_lk(bdb_state_type *bdb_state, tran_type *tran, int ix,
         dtalen);
     if (rc)
         return rc;
+    bdb_serial_index_track(bdb_state, tran->logical_tran, bdb_state->name, ix,
+                           key->data, key->size);
     return 0;
 }
 
@@ -2883,6 +3022,9 @@ int bdb_llog_del_dta_lk(bdb_state_type *bdb_state, tran_type *tran,
         &dbt_table, genid, tran->logical_tran->logical_tranid,
         &tran->logical_tran->last_logical_lsn, dtafile, dtastripe,
         dbt_data->size);
+    if (rc == 0)
+        bdb_serial_index_track(bdb_state, tran->logical_tran, bdb_state->name,
+                               -2, NULL, 0);
 
     return rc;
 }
@@ -2910,6 +3052,9 @@ int bdb_llog_del_ix_lk(bdb_state_type *bdb_state, tran_type *tran, int ixnum,
         parent->dbenv, tran->tid, &tran->logical_tran->last_logical_lsn, 0,
         &dbt_table, genid, ixnum, tran->logical_tran->logical_tranid, &lsn,
         dbt_key->size, payloadsz);
+    if (rc == 0)
+        bdb_serial_index_track(bdb_state, tran->logical_tran, bdb_state->name,
+                               ixnum, dbt_key->data, dbt_key->size);
 
     return rc;
 }
@@ -2941,6 +3086,9 @@ int bdb_llog_add_dta_lk(bdb_state_type *bdb_state, tran_type *tran,
                                   &tran->logical_tran->last_logical_lsn, 0,
                                   &dbt_tbl, dtafile, dtastripe, genid,
                                   tran->logical_tran->logical_tranid, &lsn);
+    if (rc == 0)
+        bdb_serial_index_track(bdb_state, tran->logical_tran, bdb_state->name,
+                               -2, NULL, 0);
     return rc;
 }
 
@@ -3041,6 +3189,8 @@ int bdb_llog_upd_dta_lk(bdb_state_type *bdb_state, tran_type *tran,
         &lsn, dtafile, dtastripe, dbt_olddta->size);
     if (rc)
         return rc;
+    bdb_serial_index_track(bdb_state, tran->logical_tran, bdb_state->name, -2,
+                           NULL, 0);
 
     return 0;
 }
@@ -3657,6 +3807,9 @@ int bdb_llog_upd_ix_lk(bdb_state_type *bdb_state, tran_type *tran,
         bdb_state->dbenv, tran->tid, &tran->logical_tran->last_logical_lsn, 0,
         &dbt_table, oldgenid, newgenid, tran->logical_tran->logical_tranid,
         &lsn, ix, &dbt_key, dtalen);
+    if (rc == 0)
+        bdb_serial_index_track(bdb_state, tran->logical_tran, table_name, ix,
+                               key, keylen);
 
     return rc;
 }
@@ -25,6 +25,8 @@
 #include <pthread.h>
 #include <assert.h>
 #include <strings.h>
+#include <stddef.h>
+#include <inttypes.h>
 
 #include <list.h>
 #include <fsnapf.h>
@@ -51,6 +53,10 @@
 
 #include <llog_auto.h>
 #include <llog_ext.h>
+#include <plhash.h>
+#include <epochlib.h>
+#include <logmsg.h>
+#include "locks_wrap.h"
 
 int serial_check_this_txn(bdb_state_type *bdb_state, DB_LSN lsn, void *ranges)
 {
@@ -564,12 +570,482 @@ done:
     return rc;
 }
 
+/*
+ * Serializable index: the keys written by recently committed transactions,
+ * in time buckets, so that read-set validation does not have to walk the
+ * log and reconstruct keys for every transaction committed since the
+ * reader started.
+ *
+ * Each logical write records its table, index and key on the top-level
+ * transaction.  The keys go into the newest bucket as soon as the logical
+ * commit record is written, marked pending, and take the regop lsn once the
+ * physical commit returns.  A pending key is always checked; a finished key
+ * is checked if its lsn is at or after the reader's lsn, as in the log scan.
+ * Anything at or before serial_index.from may be missing, so readers that
+ * started there fall back to the log scan.
+ */
+
+#define SERIAL_INDEX_NBUCKETS 8
+
+struct serial_keyval {
+    int len;
+    uint8_t data[1]; /* table name, '\0', int ixnum, key */
+};
+
+struct serial_key {
+    DB_LSN lsn;   /* latest regop lsn of a finished writer */
+    int npending; /* writers that have not physically committed yet */
+    struct serial_keyval kv;
+};
+
+struct serial_bucket {
+    hash_t *keys;
+    int start; /* epoch seconds when the bucket was opened */
+    int nkeys;
+    int npending;
+    int refs;    /* readers scanning the bucket outside the lock */
+    int dropped; /* out of the window; the last reader frees it */
+    DB_LSN maxlsn;
+};
+
+static struct {
+    pthread_mutex_t lk;
+    struct serial_bucket *buckets[SERIAL_INDEX_NBUCKETS]; /* newest first */
+    int nbuckets;
+    int nkeys;
+    int valid;
+    int nuntracked; /* committing writers whose keys we don't have */
+    uint32_t gen;
+    DB_LSN from;
+    uint64_t probes;
+    uint64_t fallbacks;
+    uint64_t conflicts;
+} serial_index = {.lk = PTHREAD_MUTEX_INITIALIZER};
+
+static unsigned int serial_key_hash(const void *key, int len)
+{
+    const struct serial_keyval *kv = key;
+    return hash_default_fixedwidth(kv->data, kv->len);
+}
+
+static int serial_key_cmp(const void *key1, const void *key2, int len)
+{
+    const struct serial_keyval *kv1 = key1, *kv2 = key2;
+    if (kv1->len != kv2->len)
+        return kv1->len - kv2->len;
+    return memcmp(kv1->data, kv2->data, kv1->len);
+}
+
+static void serial_bucket_free(struct serial_bucket *b)
+{
+    struct serial_key *k;
+    void *ent;
+    unsigned int bkt;
+
+    for (k = hash_first(b->keys, &ent, &bkt); k;
+         k = hash_next(b->keys, &ent, &bkt))
+        free(k);
+    hash_clear(b->keys);
+    hash_free(b->keys);
+    free(b);
+}
+
+/* Drop the oldest bucket; the keys it held are no longer covered. */
+static int serial_index_drop_oldest(void)
+{
+    struct serial_bucket *b;
+
+    if (serial_index.nbuckets == 0)
+        return 1;
+    b = serial_index.buckets[serial_index.nbuckets - 1];
+    if (b->npending)
+        return 1;
+    if (log_compare(&b->maxlsn, &serial_index.from) > 0)
+        serial_index.from = b->maxlsn;
+    serial_index.nkeys -= b->nkeys;
+    serial_index.buckets[--serial_index.nbuckets] = NULL;
+    if (b->refs)
+        b->dropped = 1;
+    else
+        serial_bucket_free(b);
+    return 0;
+}
+
+/* Called with serial_index.lk held.  Returns 1 if the index is usable. */
+static int serial_index_refresh(bdb_state_type *bdb_state)
+{
+    int now, window;
+    uint32_t gen = 0;
+
+    if (!bdb_state->attr->serial_index) {
+        if (serial_index.valid) {
+            while (serial_index_drop_oldest() == 0)
+                ;
+            serial_index.valid = 0;
+        }
+        return 0;
+    }
+
+    /* Writes made under another master never went through here. */
+    bdb_state->dbenv->get_rep_gen(bdb_state->dbenv, &gen);
+    if (!serial_index.valid || gen != serial_index.gen) {
+        while (serial_index_drop_oldest() == 0)
+            ;
+        __log_txn_lsn(bdb_state->dbenv, &serial_index.from, NULL, NULL);
+        serial_index.gen = gen;
+        serial_index.valid = 1;
+    }
+
+    now = comdb2_time_epoch();
+    window = bdb_state->attr->serial_index_window_secs;
+    while (serial_index.nbuckets > 0 &&
+           (serial_index.buckets[serial_index.nbuckets - 1]->start <
+                now - window ||
+            serial_index.nkeys > bdb_state->attr->serial_index_max_keys)) {
+        if (serial_index_drop_oldest())
+            break;
+    }
+    return 1;
+}
+
+static struct serial_bucket *serial_index_bucket(bdb_state_type *bdb_state)
+{
+    struct serial_bucket *b;
+    int now, span;
+
+    now = comdb2_time_epoch();
+    span = bdb_state->attr->serial_index_window_secs / SERIAL_INDEX_NBUCKETS;
+    if (span < 1)
+        span = 1;
+
+    if (serial_index.nbuckets > 0 &&
+        now - serial_index.buckets[0]->start < span)
+        return serial_index.buckets[0];
+
+    if (serial_index.nbuckets == SERIAL_INDEX_NBUCKETS &&
+        serial_index_drop_oldest())
+        return serial_index.buckets[0];
+
+    b = calloc(1, sizeof(struct serial_bucket));
+    if (b == NULL)
+        return NULL;
+    b->keys = hash_init_user(serial_key_hash, serial_key_cmp,
+                             offsetof(struct serial_key, kv), 0);
+    if (b->keys == NULL) {
+        free(b);
+        return NULL;
+    }
+    b->start = now;
+    memmove(&serial_index.buckets[1], &serial_index.buckets[0],
+            sizeof(struct serial_bucket *) * serial_index.nbuckets);
+    serial_index.buckets[0] = b;
+    serial_index.nbuckets++;
+    return b;
+}
+
+/* Remember a logical write of tran, the top-level transaction. */
+void bdb_serial_index_track(bdb_state_type *bdb_state, tran_type *tran,
+                            const char *table, int ixnum, const void *key,
+                            int keylen)
+{
+    bdb_state_type *env = bdb_state->parent ? bdb_state->parent : bdb_state;
+    int tbllen, len;
+    size_t need;
+    uint8_t *p;
+
+    if (tran->serial_untracked)
+        return;
+    if (!env->attr->serial_index ||
+        tran->serial_nkeys >= env->attr->serial_index_max_keys)
+        goto untracked;
+
+    tbllen = strlen(table) + 1;
+    len = tbllen + sizeof(int) + keylen;
+    need = tran->serial_keys_used + sizeof(int) + len;
+    if (need > tran->serial_keys_alloc) {
+        size_t sz = tran->serial_keys_alloc ? tran->serial_keys_alloc : 1024;
+        while (sz < need)
+            sz *= 2;
+        p = realloc(tran->serial_keys, sz);
+        if (p == NULL)
+            goto untracked;
+        tran->serial_keys = p;
+        tran->serial_keys_alloc = sz;
+    }
+
+    p = tran->serial_keys + tran->serial_keys_used;
+    memcpy(p, &len, sizeof(int));
+    p += sizeof(int);
+    memcpy(p, table, tbllen);
+    p += tbllen;
+    memcpy(p, &ixnum, sizeof(int));
+    p += sizeof(int);
+    if (keylen)
+        memcpy(p, key, keylen);
+    tran->serial_keys_used = need;
+    tran->serial_nkeys++;
+    return;
+
+untracked:
+    tran->serial_untracked = 1;
+    free(tran->serial_keys);
+    tran->serial_keys = NULL;
+    tran->serial_keys_used = tran->serial_keys_alloc = 0;
+}
+
+/* Called once the logical commit record of tran is in the log. */
+void bdb_serial_index_publish(bdb_state_type *bdb_state, tran_type *tran)
+{
+    struct serial_bucket *b;
+    struct serial_key *k;
+    struct serial_keyval *kv;
+    size_t off, failed;
+    int len;
+
+    if (tran->serial_nkeys == 0 && !tran->serial_untracked)
+        return;
+    if (bdb_state->parent)
+        bdb_state = bdb_state->parent;
+
+    Pthread_mutex_lock(&serial_index.lk);
+    if (!serial_index_refresh(bdb_state))
+        goto done;
+
+    if (!tran->serial_untracked &&
+        (b = serial_index_bucket(bdb_state)) != NULL) {
+        for (off = 0; off < tran->serial_keys_used;
+             off += sizeof(int) + len) {
+            kv = (struct serial_keyval *)(tran->serial_keys + off);
+            memcpy(&len, &kv->len, sizeof(int));
+            if ((k = hash_find(b->keys, kv)) == NULL) {
+                k = calloc(1, offsetof(struct serial_key, kv.data) + len);
+                if (k == NULL)
+                    break;
+                k->kv.len = len;
+                memcpy(k->kv.data, kv->data, len);
+                hash_add(b->keys, k);
+                b->nkeys++;
+                serial_index.nkeys++;
+            }
+            k->npending++;
+            b->npending++;
+        }
+        if (off == tran->serial_keys_used) {
+            tran->serial_bucket = b;
+            goto done;
+        }
+        /* Out of memory: undo what we added and treat it as untracked. */
+        failed = off;
+        for (len = 0, off = 0; off < failed; off += sizeof(int) + len) {
+            kv = (struct serial_keyval *)(tran->serial_keys + off);
+            memcpy(&len, &kv->len, sizeof(int));
+            if ((k = hash_find(b->keys, kv)) == NULL)
+                break;
+            k->npending--;
+            b->npending--;
+        }
+    }
+    tran->serial_untracked = 1;
+    serial_index.nuntracked++;
+
+done:
+    tran->serial_published = serial_index.valid;
+    Pthread_mutex_unlock(&serial_index.lk);
+}
+
+/*
+ * Called after the physical commit of tran with its regop lsn, or with NULL
+ * if tran is going away without one.  Frees the tracked keys.
+ */
+void bdb_serial_index_finish(bdb_state_type *bdb_state, tran_type *tran,
+                             DB_LSN *lsn)
+{
+    struct serial_bucket *b;
+    struct serial_key *k;
+    struct serial_keyval *kv;
+    DB_LSN end;
+    size_t off;
+    int len;
+
+    if (!tran->serial_published)
+        goto out;
+    if (bdb_state->parent)
+        bdb_state = bdb_state->parent;
+
+    Pthread_mutex_lock(&serial_index.lk);
+    if (lsn == NULL) {
+        __log_txn_lsn(bdb_state->dbenv, &end, NULL, NULL);
+        lsn = &end;
+    }
+    if (tran->serial_untracked) {
+        serial_index.nuntracked--;
+        if (log_compare(lsn, &serial_index.from) > 0)
+            serial_index.from = *lsn;
+    } else if ((b = tran->serial_bucket) != NULL) {
+        for (off = 0; off < tran->serial_keys_used;
+             off += sizeof(int) + len) {
+            kv = (struct serial_keyval *)(tran->serial_keys + off);
+            memcpy(&len, &kv->len, sizeof(int));
+            if ((k = hash_find(b->keys, kv)) == NULL)
+                continue;
+            k->npending--;
+            b->npending--;
+            if (log_compare(lsn, &k->lsn) > 0)
+                k->lsn = *lsn;
+        }
+        if (log_compare(lsn, &b->maxlsn) > 0)
+            b->maxlsn = *lsn;
+    }
+    Pthread_mutex_unlock(&serial_index.lk);
+
+out:
+    free(tran->serial_keys);
+    tran->serial_keys = NULL;
+    tran->serial_keys_used = tran->serial_keys_alloc = 0;
+    tran->serial_nkeys = 0;
+    tran->serial_bucket = NULL;
+    tran->serial_published = 0;
+    tran->serial_untracked = 0;
+}
+
+/*
+ * Same contract as osql_serial_check, answered from the index.  Returns -1
+ * if the index does not cover everything committed since the given lsn.
+ *
+ * The keys to check are picked out under serial_index.lk, but checked
+ * against the read set after it is dropped, so a large window does not hold
+ * up committing writers.  The buckets they live in are pinned meanwhile;
+ * a key's table, index and value never change once it is in a bucket.
+ */
+static int serial_index_check(bdb_state_type *bdb_state, void *ranges,
+                              unsigned int *file, unsigned int *offset,
+                              int regop_only)
+{
+    struct serial_bucket *b, *pinned[SERIAL_INDEX_NBUCKETS];
+    struct serial_key *k, **keys = NULL, **newkeys;
+    DB_LSN start, curlsn;
+    void *ent;
+    unsigned int bkt;
+    char *tbl;
+    int i, ixnum, tbllen, npinned = 0, nkeys = 0, maxkeys = 0, rc = 0;
+
+    start.file = *file;
+    start.offset = *offset;
+
+    Pthread_mutex_lock(&serial_index.lk);
+    serial_index.probes++;
+    if (!serial_index_refresh(bdb_state) || serial_index.nuntracked ||
+        log_compare(&start, &serial_index.from) <= 0) {
+        serial_index.fallbacks++;
+        Pthread_mutex_unlock(&serial_index.lk);
+        return -1;
+    }
+
+    __log_txn_lsn(bdb_state->dbenv, &curlsn, NULL, NULL);
+    if (!regop_only) {
+        *file = curlsn.file;
+        *offset = curlsn.offset;
+    }
+
+    for (i = 0; i < serial_index.nbuckets && rc == 0; i++) {
+        b = serial_index.buckets[i];
+        if (b->npending == 0 && log_compare(&b->maxlsn, &start) < 0)
+            continue;
+        for (k = hash_first(b->keys, &ent, &bkt); k;
+             k = hash_next(b->keys, &ent, &bkt)) {
+            if (k->npending == 0 && log_compare(&k->lsn, &start) < 0)
+                continue;
+            if (regop_only) {
+                rc = 1;
+                break;
+            }
+            if (nkeys == maxkeys) {
+                maxkeys = maxkeys ? maxkeys * 2 : 256;
+                newkeys = realloc(keys, maxkeys * sizeof(struct serial_key *));
+                if (newkeys == NULL) {
+                    rc = -1;
+                    break;
+                }
+                keys = newkeys;
+            }
+            keys[nkeys++] = k;
+        }
+        if (nkeys > 0 && (npinned == 0 || pinned[npinned - 1] != b)) {
+            b->refs++;
+            pinned[npinned++] = b;
+        }
+    }
+    if (rc < 0)
+        serial_index.fallbacks++;
+    Pthread_mutex_unlock(&serial_index.lk);
+
+    for (i = 0; i < nkeys && rc == 0; i++) {
+        k = keys[i];
+        tbl = (char *)k->kv.data;
+        tbllen = strlen(tbl) + 1;
+        memcpy(&ixnum, k->kv.data + tbllen, sizeof(int));
+        if (k->kv.len > tbllen + sizeof(int))
+            rc = bdb_state->callback->serialcheck_rtn(
+                tbl, ixnum, k->kv.data + tbllen + sizeof(int),
+                k->kv.len - tbllen - sizeof(int), ranges);
+        else
+            rc = bdb_state->callback->serialcheck_rtn(tbl, ixnum, NULL, 0,
+                                                      ranges);
+    }
+    free(keys);
+
+    if (npinned == 0 && !(rc > 0 && !regop_only))
+        return rc;
+
+    Pthread_mutex_lock(&serial_index.lk);
+    for (i = 0; i < npinned; i++) {
+        b = pinned[i];
+        if (--b->refs == 0 && b->dropped)
+            serial_bucket_free(b);
+    }
+    if (rc > 0 && !regop_only)
+        serial_index.conflicts++;
+    Pthread_mutex_unlock(&serial_index.lk);
+    return rc;
+}
+
+void bdb_serial_index_stats(bdb_state_type *bdb_state)
+{
+    int i;
+
+    Pthread_mutex_lock(&serial_index.lk);
+    logmsg(LOGMSG_USER,
+           "serial index: %s, %d buckets, %d keys, from %u:%u, %d untracked "
+           "in flight\n",
+           serial_index.valid ? "valid" : "invalid", serial_index.nbuckets,
+           serial_index.nkeys, serial_index.from.file,
+           serial_index.from.offset, serial_index.nuntracked);
+    logmsg(LOGMSG_USER,
+           "serial index: probes %" PRIu64 " fallbacks %" PRIu64
+           " conflicts %" PRIu64 "\n",
+           serial_index.probes, serial_index.fallbacks,
+           serial_index.conflicts);
+    for (i = 0; i < serial_index.nbuckets; i++) {
+        struct serial_bucket *b = serial_index.buckets[i];
+        logmsg(LOGMSG_USER,
+               "  bucket %d: opened %d keys %d pending %d maxlsn %u:%u\n", i,
+               b->start, b->nkeys, b->npending, b->maxlsn.file,
+               b->maxlsn.offset);
+    }
+    Pthread_mutex_unlock(&serial_index.lk);
+}
+
 int bdb_osql_serial_check(bdb_state_type *bdb_state, void *ranges,
                           unsigned int *file, unsigned int *offset,
                           int regop_only)
 {
+    int rc;
+
     if (!ranges)
         return 0;
+    rc = serial_index_check(bdb_state, ranges, file, offset, regop_only);
+    if (rc >= 0)
+        return rc;
     return osql_serial_check(bdb_state, ranges, file, offset,
                              serial_check_this_txn, regop_only);
 }
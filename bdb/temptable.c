@@ -30,6 +30,7 @@
 #include <net.h>
 #include <sbuf2.h>
 #include "bdb_int.h"
+#include <keycmp.h>
 #include <list.h>
 #include <plhash.h>
 #include <sys/time.h>
@@ -150,6 +151,9 @@ struct temp_cursor {
     int ind;
     int keymalloclen;
     int datamalloclen;
+    /* the row under the cursor was deleted; the next DB_NEXT returns the row
+       now at `ind' (array) or under the berkdb cursor (spilled array) */
+    int arr_deleted;
 };
 
 typedef struct arr_elem {
@@ -159,6 +163,18 @@ typedef struct arr_elem {
     uint8_t *dta;
 } arr_elem_t;
 
+/* Keys and payloads of a temparray are carved out of a list of chunks that
+   are only released as a whole (truncate, spill or destroy), instead of one
+   malloc per element. Oversized rows get a chunk of their own. */
+typedef struct arr_chunk {
+    struct arr_chunk *next;
+    size_t used;
+    size_t cap;
+    uint8_t buf[];
+} arr_chunk_t;
+
+enum { ARR_CHUNK_MIN = 4096, ARR_CHUNK_MAX = 262144 };
+
 #define COPY_KV_TO_CUR(c)                                                      \
     do {                                                                       \
         arr_elem_t *elem = &(c)->tbl->elements[(c)->ind];                      \
@@ -223,6 +239,11 @@ struct temp_table {
     unsigned long long inmemsz;
     unsigned long long cachesz;
     arr_elem_t *elements;
+    arr_chunk_t *arena;
+    unsigned long long arenasz;
+    /* temparray that behaves like a btree temptable: an equal key replaces
+       the row, and a find past the end lands on the last row */
+    int btree_semantics;
 };
 
 enum { TMPTBL_PRIORITY, TMPTBL_WAIT };
@@ -262,6 +283,73 @@ hash_t *bdb_temp_table_histhash_init(void)
 static int bdb_temp_table_init_temp_db(bdb_state_type *bdb_state,
                                        struct temp_table *tbl, int *bdberr);
 
+static uint8_t *arr_alloc(struct temp_table *tbl, size_t len)
+{
+    arr_chunk_t *chunk = tbl->arena;
+    uint8_t *p;
+
+    len = (len + 7) & ~(size_t)7;
+    if (chunk == NULL || chunk->cap - chunk->used < len) {
+        size_t cap = chunk ? chunk->cap * 2 : ARR_CHUNK_MIN;
+        if (cap > ARR_CHUNK_MAX)
+            cap = ARR_CHUNK_MAX;
+        if (cap < len)
+            cap = len;
+        arr_chunk_t *n = malloc(offsetof(arr_chunk_t, buf) + cap);
+        if (n == NULL)
+            return NULL;
+        n->cap = cap;
+        n->used = 0;
+        if (chunk && cap == len) {
+            /* dedicated chunk; keep carving from the current one */
+            n->next = chunk->next;
+            chunk->next = n;
+        } else {
+            n->next = chunk;
+            tbl->arena = n;
+        }
+        tbl->arenasz += cap;
+        chunk = n;
+    }
+    p = chunk->buf + chunk->used;
+    chunk->used += len;
+    return p;
+}
+
+static void arr_release(struct temp_table *tbl)
+{
+    arr_chunk_t *chunk = tbl->arena, *next;
+    while (chunk) {
+        next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+    tbl->arena = NULL;
+    tbl->arenasz = 0;
+    tbl->inmemsz = 0;
+}
+
+/* keep the other cursors of a temparray on their rows after `ind' gained or
+   lost an element */
+static void arr_adjust_cursors(struct temp_table *tbl, struct temp_cursor *self,
+                               int ind, int inserted)
+{
+    struct temp_cursor *c;
+    LISTC_FOR_EACH(&tbl->cursors, c, lnk)
+    {
+        if (c == self || !c->valid)
+            continue;
+        if (inserted) {
+            if (c->ind > ind || (c->ind == ind && !c->arr_deleted))
+                ++c->ind;
+        } else if (c->ind > ind) {
+            --c->ind;
+        } else if (c->ind == ind) {
+            c->arr_deleted = 1;
+        }
+    }
+}
+
 static int create_temp_db_env(bdb_state_type *bdb_state, struct temp_table *tbl,
                               int *bdberr)
 {
@@ -366,18 +454,15 @@ static int bdb_array_copy_to_temp_db(bdb_state_type *bdb_state,
         }
     }
 
-    for (ii = 0; ii != nents; ++ii) {
-        elem = &tbl->elements[ii];
-        free(elem->key);
-    }
-    tbl->inmemsz = 0;
+    arr_release(tbl);
     tbl->num_mem_entries = nents;
 
     /* its now a btree! */
     tbl->temp_table_type = TEMP_TABLE_TYPE_BTREE;
 
-    /* Reset all the cursors for this table.
-       For now don't care about position. */
+    /* Reset all the cursors for this table. Cursors that are on a row are
+       moved to the same row of the btree, so a scan that is inserting into
+       its own table carries on where it was. */
     LISTC_FOR_EACH(&tbl->cursors, cur, lnk)
     {
         rc = tbl->tmpdb->cursor(tbl->tmpdb, NULL, &cur->cur, 0);
@@ -389,9 +474,39 @@ static int bdb_array_copy_to_temp_db(bdb_state_type *bdb_state,
             goto done;
         }
 
+        if (cur->valid && cur->key) {
+            bzero(&dbt_key, sizeof(DBT));
+            bzero(&dbt_data, sizeof(DBT));
+            dbt_key.data = cur->key;
+            dbt_key.size = cur->keylen;
+            dbt_data.flags = DB_DBT_MALLOC;
+            rc = cur->cur->c_get(cur->cur, &dbt_key, &dbt_data,
+                                 cur->arr_deleted ? DB_SET_RANGE : DB_SET);
+            if (rc == DB_NOTFOUND && cur->arr_deleted) {
+                /* deleted row was the last one */
+                cur->arr_deleted = 0;
+                dbt_key.flags = DB_DBT_MALLOC;
+                rc = cur->cur->c_get(cur->cur, &dbt_key, &dbt_data, DB_LAST);
+                if (rc == 0)
+                    free(dbt_key.data);
+            }
+            if (rc == 0) {
+                free(dbt_data.data);
+                /* cur->key and cur->data are our own copies of the row; the
+                   btree code frees them on the next move */
+                continue;
+            }
+            rc = 0;
+            cur->valid = 0;
+            cur->arr_deleted = 0;
+        }
+
         /* New cursor does not point to any data */
+        free(cur->key);
+        free(cur->data);
         cur->key = cur->data = NULL;
         cur->keylen = cur->datalen = 0;
+        cur->keymalloclen = cur->datamalloclen = 0;
     }
 
 done:
@@ -803,6 +918,7 @@ static struct temp_table *bdb_temp_table_create_type(bdb_state_type *bdb_state,
         table->num_mem_entries = 0;
         table->cmpfunc = key_memcmp;
         table->temp_table_type = temp_table_type;
+        table->btree_semantics = 0;
     }
 
     return table;
@@ -811,11 +927,23 @@ static struct temp_table *bdb_temp_table_create_type(bdb_state_type *bdb_state,
 struct temp_table *bdb_temp_table_create_flags(bdb_state_type *bdb_state,
                                                int flags, int *bdberr)
 {
+    struct temp_table *tbl;
     int temptype;
 
-    temptype = TEMP_TABLE_TYPE_BTREE;
+    if ((flags & BDB_TEMP_TABLE_USE_INMEM) &&
+        !(flags & BDB_TEMP_TABLE_DONT_USE_INMEM))
+        temptype = TEMP_TABLE_TYPE_ARRAY;
+    else
+        temptype = TEMP_TABLE_TYPE_BTREE;
+
+    tbl = bdb_temp_table_create_type(bdb_state, temptype, bdberr);
+
+    /* starts as a sorted array in memory, and only builds a berkdb
+       environment if it outgrows temptable_mem_threshold/cachesz */
+    if (tbl && temptype == TEMP_TABLE_TYPE_ARRAY)
+        tbl->btree_semantics = 1;
 
-    return bdb_temp_table_create_type(bdb_state, temptype, bdberr);
+    return tbl;
 }
 
 struct temp_table *bdb_temp_table_create(bdb_state_type *bdb_state, int *bdberr)
@@ -951,16 +1079,15 @@ int bdb_temp_table_update(bdb_state_type *bdb_state, struct temp_cursor *cur,
     }
 
     if (cur->tbl->temp_table_type == TEMP_TABLE_TYPE_ARRAY) {
-        if (!cur->valid)
+        if (!cur->valid || cur->arr_deleted)
             return -1;
 
-        /* Free the existing elements and update the memory footprint. */
+        /* Update the memory footprint; the old row stays in the arena. */
         elem = &cur->tbl->elements[cur->ind];
-        free(elem->key);
         cur->tbl->inmemsz -= (elem->keylen + elem->dtalen);
 
-        /* malloc and copy */
-        keycopy = malloc(keylen + dtalen);
+        /* allocate and copy */
+        keycopy = arr_alloc(cur->tbl, keylen + dtalen);
         if (keycopy == NULL)
             return -1;
         dtacopy = keycopy + keylen;
@@ -973,6 +1100,8 @@ int bdb_temp_table_update(bdb_state_type *bdb_state, struct temp_cursor *cur,
         elem->dtalen = dtalen;
         elem->dta = dtacopy;
         cur->tbl->inmemsz += (elem->keylen + elem->dtalen);
+        COPY_KV_TO_CUR(cur);
+        return 0;
     }
 
     REOPEN_CURSOR(cur);
@@ -1125,6 +1254,7 @@ static int bdb_temp_table_first_last(bdb_state_type *bdb_state,
         }
 
         cur->ind = (how == DB_LAST) ? (arrlen - 1) : 0;
+        cur->arr_deleted = 0;
         COPY_KV_TO_CUR(cur);
         return 0;
     }
@@ -1148,6 +1278,7 @@ static int bdb_temp_table_first_last(bdb_state_type *bdb_state,
     }
     cur->valid = 0;
     dkey.flags = ddata.flags = DB_DBT_MALLOC;
+    cur->arr_deleted = 0;
     rc = cur->cur->c_get(cur->cur, &dkey, &ddata, how);
     if (rc == DB_NOTFOUND)
         return IX_EMPTY;
@@ -1216,8 +1347,13 @@ static int bdb_temp_table_next_prev_norewind(bdb_state_type *bdb_state,
     }
 
     if (cur->tbl->temp_table_type == TEMP_TABLE_TYPE_ARRAY) {
-        if ((how == DB_NEXT && ++cur->ind >= cur->tbl->num_mem_entries) ||
-            (how == DB_PREV && --cur->ind < 0)) {
+        /* after a delete `ind' already is on the next row */
+        if (how == DB_NEXT && !cur->arr_deleted)
+            ++cur->ind;
+        else if (how == DB_PREV)
+            --cur->ind;
+        cur->arr_deleted = 0;
+        if (cur->ind >= cur->tbl->num_mem_entries || cur->ind < 0) {
             cur->valid = 0;
             return IX_PASTEOF;
         }
@@ -1234,6 +1370,12 @@ static int bdb_temp_table_next_prev_norewind(bdb_state_type *bdb_state,
     memset(&ddata, 0, sizeof(DBT));
 
     ddata.flags = dkey.flags = DB_DBT_MALLOC;
+    if (cur->arr_deleted) {
+        /* spilled while on a deleted array row; already on the next one */
+        if (how == DB_NEXT)
+            how = DB_CURRENT;
+        cur->arr_deleted = 0;
+    }
     rc = cur->cur->c_get(cur->cur, &dkey, &ddata, how);
     if (rc == DB_NOTFOUND)
         return IX_PASTEOF;
@@ -1450,8 +1592,7 @@ int bdb_temp_table_truncate(bdb_state_type *bdb_state, struct temp_table *tbl,
 {
     if (tbl == NULL)
         return 0;
-    int rc = 0, ii = 0;
-    arr_elem_t *elem;
+    int rc = 0;
 
     switch (tbl->temp_table_type) {
     case TEMP_TABLE_TYPE_LIST: {
@@ -1485,11 +1626,7 @@ int bdb_temp_table_truncate(bdb_state_type *bdb_state, struct temp_table *tbl,
         break;
 
     case TEMP_TABLE_TYPE_ARRAY:
-        for (; ii != tbl->num_mem_entries; ++ii) {
-            elem = &tbl->elements[ii];
-            free(elem->key);
-        }
-        tbl->inmemsz = 0;
+        arr_release(tbl);
         tbl->num_mem_entries = 0;
         break;
 
@@ -1625,8 +1762,7 @@ int bdb_temp_table_destroy_lru(struct temp_table *tbl,
                                int *bdberr)
 {
     DB_MPOOL_STAT *tmp;
-    int rc, ii;
-    arr_elem_t *elem;
+    int rc;
 
     rc = 0;
 
@@ -1723,10 +1859,7 @@ int bdb_temp_table_destroy_lru(struct temp_table *tbl,
     } break;
 
     case TEMP_TABLE_TYPE_ARRAY:
-        for (ii = 0; ii != tbl->num_mem_entries; ++ii) {
-            elem = &tbl->elements[ii];
-            free(elem->key);
-        }
+        arr_release(tbl);
         break;
 
     case TEMP_TABLE_TYPE_BTREE:
@@ -1793,12 +1926,18 @@ int bdb_temp_table_delete(bdb_state_type *bdb_state, struct temp_cursor *cur,
     }
 
     if (cur->tbl->temp_table_type == TEMP_TABLE_TYPE_ARRAY) {
+        if (cur->arr_deleted) {
+            rc = -1;
+            goto done;
+        }
         elem = &cur->tbl->elements[cur->ind];
-        free(elem->key);
         --cur->tbl->num_mem_entries;
         cur->tbl->inmemsz -= (elem->keylen + elem->dtalen);
         memmove(elem, elem + 1,
                 sizeof(arr_elem_t) * (cur->tbl->num_mem_entries - cur->ind));
+        /* like a berkdb cursor, stay on the hole until the next move */
+        cur->arr_deleted = 1;
+        arr_adjust_cursors(cur->tbl, cur, cur->ind, 0);
         rc = 0;
         goto done;
     }
@@ -1922,11 +2061,17 @@ int bdb_temp_table_find(bdb_state_type *bdb_state, struct temp_cursor *cur,
         hi = cur->tbl->num_mem_entries - 1;
         found = -1;
         cmpfn = cur->tbl->cmpfunc;
+        cur->arr_deleted = 0;
 
         while (lo <= hi) {
             mid = (lo + hi) >> 1;
             elem = &cur->tbl->elements[mid];
-            cmp = cmpfn(NULL, elem->keylen, elem->key, keylen, key);
+            /* same convention as temp_table_compare() for unpacked keys */
+            if (unpacked)
+                cmp = cmpfn(NULL, elem->keylen, elem->key, -1, unpacked);
+            else
+                cmp = cmpfn(cur->tbl->usermem, elem->keylen, elem->key,
+                            keylen, key);
 
             if (cmp < 0)
                 lo = mid + 1;
@@ -1942,7 +2087,10 @@ int bdb_temp_table_find(bdb_state_type *bdb_state, struct temp_cursor *cur,
             cur->ind = found;
         else if (lo < cur->tbl->num_mem_entries)
             cur->ind = lo;
-        else {
+        else if (cur->tbl->btree_semantics) {
+            /* find anything at all if possible, as the btree does */
+            cur->ind = cur->tbl->num_mem_entries - 1;
+        } else {
             cur->valid = 0;
             return IX_NOTFND;
         }
@@ -1962,6 +2110,7 @@ int bdb_temp_table_find(bdb_state_type *bdb_state, struct temp_cursor *cur,
     dkey.size = keylen;
     dkey.app_data = unpacked;
     cur->valid = 0;
+    cur->arr_deleted = 0;
     rc = cur->cur->c_get(cur->cur, &dkey, &ddata, DB_SET_RANGE);
     if (rc == DB_NOTFOUND) {
         rc = bdb_temp_table_last(bdb_state, cur, bdberr);
@@ -2077,11 +2226,13 @@ int bdb_temp_table_find_exact(bdb_state_type *bdb_state,
         hi = cur->tbl->num_mem_entries - 1;
         found = -1;
         cmpfn = cur->tbl->cmpfunc;
+        cur->arr_deleted = 0;
 
         while (lo <= hi) {
             mid = (lo + hi) >> 1;
             elem = &cur->tbl->elements[mid];
-            cmp = cmpfn(NULL, elem->keylen, elem->key, keylen, key);
+            cmp = cmpfn(cur->tbl->usermem, elem->keylen, elem->key, keylen,
+                        key);
 
             if (cmp < 0)
                 lo = mid + 1;
@@ -2118,6 +2269,7 @@ int bdb_temp_table_find_exact(bdb_state_type *bdb_state,
     dkey.size = keylen;
 
     cur->valid = 0;
+    cur->arr_deleted = 0;
     rc = cur->cur->c_get(cur->cur, &dkey, &ddata, DB_SET);
 
     if (rc == DB_NOTFOUND) {
@@ -2164,7 +2316,7 @@ static int key_memcmp(void *_, int key1len, const void *key1, int key2len,
     int len;
     int rc;
     len = (key1len < key2len) ? key1len : key2len;
-    rc = memcmp(key1, key2, len);
+    rc = comdb2_keycmp(key1, key2, len);
     if (rc == 0) {
         if (key1len == key2len)
             rc = 0;
@@ -2413,7 +2565,7 @@ static int bdb_temp_table_insert_put(bdb_state_type *bdb_state,
            If 1 or more elements of the same key already exist,
            insert it after the last one of those elements. */
 
-        keycopy = malloc(keylen + dtalen);
+        keycopy = arr_alloc(tbl, keylen + dtalen);
         if (keycopy == NULL)
             return -1;
         dtacopy = keycopy + keylen;
@@ -2428,13 +2580,23 @@ static int bdb_temp_table_insert_put(bdb_state_type *bdb_state,
             while (lo <= hi) {
                 mid = (lo + hi) >> 1;
                 elem = &tbl->elements[mid];
-                cmp = cmpfn(NULL, elem->keylen, elem->key, keylen, key);
+                cmp = cmpfn(tbl->usermem, elem->keylen, elem->key, keylen,
+                            key);
 
                 if (cmp < 0)
                     lo = mid + 1;
                 else if (cmp > 0)
                     hi = mid - 1;
-                else
+                else if (tbl->btree_semantics) {
+                    /* a btree put overwrites the row */
+                    tbl->inmemsz -= (elem->keylen + elem->dtalen);
+                    elem->keylen = keylen;
+                    elem->key = keycopy;
+                    elem->dtalen = dtalen;
+                    elem->dta = dtacopy;
+                    tbl->inmemsz += (keylen + dtalen);
+                    goto check_spill;
+                } else
                     lo = mid + 1;
             }
 
@@ -2451,9 +2613,13 @@ static int bdb_temp_table_insert_put(bdb_state_type *bdb_state,
 
         ++tbl->num_mem_entries;
         tbl->inmemsz += (keylen + dtalen);
+        arr_adjust_cursors(tbl, NULL, lo, 1);
 
+    check_spill:
+        /* replaced and deleted rows stay in the arena until the array is
+           truncated, so bound that too */
         if (tbl->num_mem_entries == tbl->max_mem_entries ||
-            tbl->inmemsz > tbl->cachesz) {
+            tbl->inmemsz > tbl->cachesz || tbl->arenasz > 2 * tbl->cachesz) {
             gbl_temptable_spills++;
             rc = bdb_array_copy_to_temp_db(bdb_state, tbl, bdberr);
             if (unlikely(rc)) {
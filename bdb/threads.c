@@ -273,6 +273,7 @@ void *coherency_lease_thread(void *arg)
         }
         if (repinfo->master_host == repinfo->myhost) {
             send_coherency_leases(bdb_state, lease_time, &inc_wait);
+            bdb_rep_pace_update(bdb_state);
 
             if (bdb_state->attr->durable_lsns) {
                 /* See if master has written a durable LSN */
@@ -1625,6 +1625,8 @@ int bdb_tran_commit_with_seqnum_int(bdb_state_type *bdb_state, tran_type *tran,
             }
 
             if (!isabort) {
+                bdb_serial_index_publish(bdb_state, tran);
+
                 /* hookup locals one too */
                 iirc = update_shadows_beforecommit(
                     bdb_state, &tran->last_logical_lsn, NULL, 1);
@@ -1663,6 +1665,8 @@ int bdb_tran_commit_with_seqnum_int(bdb_state_type *bdb_state, tran_type *tran,
             outrc = -1;
             goto cleanup;
         } else {
+            bdb_serial_index_finish(bdb_state, tran, &lsn);
+
             /* successful physical commit, lets increment our seqnum */
             Pthread_mutex_lock(&(bdb_state->seqnum_info->lock));
             /* dont let our global lsn go backwards */
@@ -1885,6 +1889,8 @@ int bdb_tran_commit_with_seqnum_int(bdb_state_type *bdb_state, tran_type *tran,
                 outrc = -1;
                 goto cleanup;
             }
+            if (!needed_to_abort)
+                bdb_serial_index_publish(bdb_state, tran);
         }
 
 /* Don't think I need this - can just abort the logical transaction
@@ -1939,6 +1945,7 @@ int bdb_tran_commit_with_seqnum_int(bdb_state_type *bdb_state, tran_type *tran,
                 goto cleanup;
             }
             lsn = tran->last_regop_lsn;
+            bdb_serial_index_finish(bdb_state, tran, &lsn);
         }
 
         assert(NULL == tran->tid);
@@ -2098,6 +2105,8 @@ cleanup:
     if (tran->bkfill_txn_list)
         free(tran->bkfill_txn_list);
 
+    bdb_serial_index_finish(bdb_state, tran, NULL);
+
     free(tran);
 
     return outrc;
@@ -2393,6 +2402,8 @@ cleanup:
     if (tran->bkfill_txn_list)
         free(tran->bkfill_txn_list);
 
+    bdb_serial_index_finish(bdb_state, tran, NULL);
+
     free(tran);
     return outrc;
 }
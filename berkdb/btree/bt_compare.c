@@ -56,6 +56,7 @@ static const char revid[] = "$Id: bt_compare.c,v 11.18 2003/01/08 04:00:56 bosti
 #include "dbinc/btree.h"
 
 #include <btree/bt_prefix.h>
+#include <keycmp.h>
 
 /*
  * __bam_cmp --
@@ -186,7 +187,7 @@ __bam_defcmp(dbp, a, b)
 
 	len = a->size > b->size ? b->size : a->size;
 
-	rc = memcmp(a->data, b->data, len);
+	rc = comdb2_keycmp(a->data, b->data, len);
 	if (rc == 0)
 		return ((long)a->size - (long)b->size);
 	else
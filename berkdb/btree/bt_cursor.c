@@ -1699,6 +1699,8 @@ __bam_c_destroy(dbc)
 	/* Discard the structures. */
 	if (cp->sp != cp->stack)
 		__os_free(dbc->dbp->dbenv, cp->sp);
+	if (cp->keycache != NULL)
+		__bam_keycache_free(dbc->dbp->dbenv, cp->keycache);
 
 	__os_free(dbc->dbp->dbenv, cp);
 	btpf_free((btpf **) & dbc->pf);
@@ -0,0 +1,246 @@
+/*
+   Copyright 2021 Bloomberg Finance L.P.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+/*
+ * Replays the btree pages of an open file through the page binary search,
+ * once with memcmp() and once with comdb2_keycmp(), and reports the time
+ * per probe.  Keys are copied out of the live pages, so key widths and
+ * prefixes are whatever the table really has.  Each page is only locked
+ * while its keys are copied.
+ */
+
+#include "db_config.h"
+
+#include <sys/types.h>
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "db_int.h"
+#include "dbinc/db_page.h"
+#include "dbinc/btree.h"
+#include "dbinc/lock.h"
+#include "dbinc/mp.h"
+#include <btree/bt_prefix.h>
+#include <keycmp.h>
+#include <logmsg.h>
+
+typedef int (*keycmp_fn)(const void *, const void *, size_t);
+
+struct bench_key {
+	const uint8_t *data;
+	size_t len;
+};
+
+static int
+libc_memcmp(const void *a, const void *b, size_t len)
+{
+	return memcmp(a, b, len);
+}
+
+static int64_t
+now_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/* Same search as __bam_search: find each page key among the page keys. */
+static int64_t
+search_page(const struct bench_key *keys, int nkeys, keycmp_fn cmpf,
+    int64_t *probes)
+{
+	int i, base, lim, indx, cmp;
+	size_t len;
+	int64_t found = 0;
+
+	for (i = 0; i < nkeys; ++i) {
+		for (base = 0, lim = nkeys; lim != 0; lim >>= 1) {
+			indx = base + (lim >> 1);
+			++(*probes);
+			len = keys[i].len < keys[indx].len ? keys[i].len :
+			    keys[indx].len;
+			cmp = cmpf(keys[i].data, keys[indx].data, len);
+			if (cmp == 0)
+				cmp = (long)keys[i].len - (long)keys[indx].len;
+			if (cmp == 0) {
+				found += indx;
+				break;
+			}
+			if (cmp > 0) {
+				base = indx + 1;
+				--lim;
+			}
+		}
+	}
+	return found;
+}
+
+/*
+ * Copy the keys of a btree page into arena.  Prefix-compressed leaf keys
+ * are expanded; overflow keys are skipped.
+ */
+static int
+collect_keys(DB *dbp, PAGE *h, struct bench_key *keys, uint8_t *arena,
+    size_t arenasz)
+{
+	uint8_t *end = arena + arenasz;
+	uint8_t buf[KEYBUF];
+	BKEYDATA *bk;
+	BINTERNAL *bi;
+	db_indx_t i;
+	int nkeys = 0;
+
+	switch (TYPE(h)) {
+	case P_LBTREE:
+		for (i = 0; i < NUM_ENT(h); i += P_INDX) {
+			bk = GET_BKEYDATA(dbp, h, i);
+			if (B_TYPE(bk) == B_OVERFLOW)
+				continue;
+			bk_decompress(dbp, h, &bk, buf, KEYBUF);
+			if (arena + bk->len > end)
+				break;
+			memcpy(arena, bk->data, bk->len);
+			keys[nkeys].data = arena;
+			keys[nkeys].len = bk->len;
+			arena += bk->len;
+			++nkeys;
+		}
+		break;
+	case P_IBTREE:
+		/* The first key on an internal page is never compared. */
+		for (i = 1; i < NUM_ENT(h); ++i) {
+			bi = GET_BINTERNAL(dbp, h, i);
+			if (B_TYPE(bi) == B_OVERFLOW)
+				continue;
+			if (arena + bi->len > end)
+				break;
+			memcpy(arena, bi->data, bi->len);
+			keys[nkeys].data = arena;
+			keys[nkeys].len = bi->len;
+			arena += bi->len;
+			++nkeys;
+		}
+		break;
+	}
+	return nkeys;
+}
+
+/*
+ * __bam_keycmp_bench --
+ *	Time memcmp against comdb2_keycmp on every btree page of dbp.
+ *
+ * PUBLIC: void __bam_keycmp_bench __P((DB *, int));
+ */
+void
+__bam_keycmp_bench(dbp, iterations)
+	DB *dbp;
+	int iterations;
+{
+	DBC *dbc;
+	DB_LOCK lock;
+	DB_MPOOLFILE *mpf;
+	PAGE *h;
+	db_pgno_t pgno, last;
+	struct bench_key *keys;
+	uint8_t *arena;
+	int64_t start, pages, nkeys_total, probes, memcmp_ns, keycmp_ns, sink;
+	int64_t n;
+	int it, nkeys, ret, t_ret;
+
+	if (iterations <= 0)
+		iterations = 100;
+
+	if (dbp->type != DB_BTREE) {
+		logmsg(LOGMSG_ERROR, "keycmpbench> %s is not a btree\n",
+		    dbp->fname);
+		return;
+	}
+
+	keys = malloc(sizeof(struct bench_key) *
+	    (dbp->pgsize / sizeof(db_indx_t)));
+	arena = malloc(dbp->pgsize * 4);
+	if (keys == NULL || arena == NULL) {
+		logmsg(LOGMSG_ERROR, "keycmpbench> out of memory\n");
+		goto done;
+	}
+	if ((ret = __db_cursor(dbp, NULL, &dbc, 0)) != 0) {
+		logmsg(LOGMSG_ERROR, "keycmpbench> %s cursor error=%d\n",
+		    dbp->fname, ret);
+		goto done;
+	}
+
+	mpf = dbp->mpf;
+	__memp_last_pgno(mpf, &last);
+	pages = nkeys_total = probes = memcmp_ns = keycmp_ns = sink = 0;
+
+	for (pgno = 1; pgno <= last; ++pgno) {
+		if ((ret = __db_lget(dbc, 0, pgno, DB_LOCK_READ, 0, &lock)) !=
+		    0)
+			break;
+		if ((ret = __memp_fget(mpf, &pgno, 0, &h)) != 0) {
+			__LPUT(dbc, lock);
+			break;
+		}
+		nkeys = collect_keys(dbp, h, keys, arena, dbp->pgsize * 4);
+		ret = __memp_fput(mpf, h, 0);
+		__LPUT(dbc, lock);
+		if (ret != 0)
+			break;
+		if (nkeys < 2)
+			continue;
+
+		start = now_ns();
+		for (it = 0; it < iterations; ++it)
+			sink += search_page(keys, nkeys, libc_memcmp, &probes);
+		memcmp_ns += now_ns() - start;
+
+		n = 0;
+		start = now_ns();
+		for (it = 0; it < iterations; ++it)
+			sink -= search_page(keys, nkeys, comdb2_keycmp, &n);
+		keycmp_ns += now_ns() - start;
+
+		++pages;
+		nkeys_total += nkeys;
+	}
+	if (ret != 0)
+		logmsg(LOGMSG_ERROR, "keycmpbench> %s page %" PRIu32
+		    " error=%d\n", dbp->fname, pgno, ret);
+	if ((t_ret = __db_c_close(dbc)) != 0 && ret == 0)
+		ret = t_ret;
+
+	/* Both passes have to land on the same entries. */
+	if (sink != 0)
+		logmsg(LOGMSG_ERROR,
+		    "keycmpbench> %s: memcmp and comdb2_keycmp disagree\n",
+		    dbp->fname);
+
+	logmsg(LOGMSG_USER, "keycmpbench> %s pgsize %" PRIu32 " pages %"
+	    PRId64 " keys %" PRId64 " probes %" PRId64
+	    " memcmp-ns %.2f keycmp-ns %.2f speedup %.2fx\n", dbp->fname,
+	    dbp->pgsize, pages, nkeys_total, probes,
+	    probes ? (double)memcmp_ns / probes : 0,
+	    probes ? (double)keycmp_ns / probes : 0,
+	    keycmp_ns > 0 ? (double)memcmp_ns / keycmp_ns : 0);
+
+done:
+	free(keys);
+	free(arena);
+}
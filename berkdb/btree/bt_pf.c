@@ -38,6 +38,7 @@ void start_loading_async_cb(btpf_job * job);
 static inline int advance_on_tree(DBC *dbc);
 
 #define LOAD(mpf,x) enqueue_touch_page(mpf, x);
+#define LOAD_BATCH(mpf,pgnos,n) enqueue_touch_pages(mpf, pgnos, n);
 
 #define LOAD_SYNC(mpf,x,page) {                                                     \
     __memp_fget(mpf, &x, DB_MPOOL_PFGET, &page);                                    \
@@ -635,6 +636,7 @@ page_load_f(btpf * pf, DBC *dbc)
 	db_indx_t p_cnt = 0;
 	db_indx_t c = 0;
 	db_indx_t i;
+	db_pgno_t *pgnos;
 
 	while (1) {
 		if ((ret = advance_on_tree(dbc)) != 0)
@@ -656,15 +658,24 @@ page_load_f(btpf * pf, DBC *dbc)
 		p_cnt = pf->maxindx[1] - pf->curindx[1];
 		p_cnt = p_cnt > pf->wndw - c ? pf->wndw - c : p_cnt;
 
+		/* Queue this parent's children as one batch if we can. */
+		pgnos = p_cnt > 0 ? malloc(p_cnt * sizeof(db_pgno_t)) : NULL;
 		for (i = 0; i < p_cnt; i++)
 		{
 			t_pgno = GET_BINTERNAL(dbp, h, pf->curindx[1] + i)->pgno;
 #if BTPF_DEBUG  
 			fprintf(stderr, "LOADING: %u from:%u indx:%d of:%d real:%d\n", t_pgno, pgno, pf->curindx[1] + i, pf->maxindx[1], h->entries );
 #endif
-			LOAD(mpf, t_pgno);
+			if (pgnos)
+				pgnos[i] = t_pgno;
+			else
+				LOAD(mpf, t_pgno);
 
 		}
+		if (pgnos) {
+			LOAD_BATCH(mpf, pgnos, p_cnt);
+			free(pgnos);
+		}
 
 		c += p_cnt;
 		pf->curindx[1] += p_cnt;
@@ -717,6 +728,8 @@ page_load_b(btpf * pf, DBC *dbc)
 	db_indx_t p_cnt = 0;
 	db_indx_t c = 0;
 	db_indx_t i;
+	db_pgno_t *pgnos;
+	int npgnos;
 
 	while (1) {
 		if ((ret = advanceb_on_tree(dbc)) != 0)
@@ -736,6 +749,9 @@ page_load_b(btpf * pf, DBC *dbc)
 		}
 
 		p_cnt = pf->curindx[1] > pf->wndw - c ? pf->curindx[1] - pf->wndw - c : 0;
+		/* Queue this parent's children as one batch if we can. */
+		pgnos = malloc((pf->curindx[1] - p_cnt + 1) * sizeof(db_pgno_t));
+		npgnos = 0;
 		for (i = pf->curindx[1] ; i >= p_cnt ; i--) {
 			if (pf->maxindx[1] == 0)
 				break;
@@ -745,11 +761,19 @@ page_load_b(btpf * pf, DBC *dbc)
 #if BTPF_DEBUG  
 			fprintf(stderr, "LOADING: %u from:%u indx:%d of:%d real:%d\n", t_pgno, pgno, i, pf->maxindx[1], h->entries );
 #endif            
-			LOAD(mpf,t_pgno);
+			if (pgnos)
+				pgnos[npgnos++] = t_pgno;
+			else
+				LOAD(mpf,t_pgno);
 
 			if (i == 0)
 				break; // it's an unsigned type it overflows and loop forever otherwise
 		}
+		if (pgnos) {
+			if (npgnos > 0)
+				LOAD_BATCH(mpf, pgnos, npgnos);
+			free(pgnos);
+		}
 		pf->tr_page = t_pgno;
 		c += (pf->curindx[1] - p_cnt);
 		pf->curindx[1] = p_cnt;
@@ -986,6 +986,174 @@ pfx_bulk_page(DBC *dbc, uint8_t * np, int32_t *offp, uint32_t space)
 	return 0;
 }
 
+/*
+ * Decode every compressed item of leaf page pg into buf, parsing the page
+ * prefix once.  Items start 8-byte aligned.  Returns 0, or 1 if buf is too
+ * small, or -1 if an item doesn't decode.
+ */
+static int
+pfx_decode_page(DB *dbp, PAGE *pg, uint8_t *buf, uint32_t bufsz,
+    uint32_t *off, db_indx_t *len)
+{
+	db_indx_t i, n = NUM_ENT(pg), sz;
+	uint32_t used = 0, cur, room, l;
+	pfx_t *pfx = pgpfx(dbp, pg, alloca(KEYBUF), KEYBUF);
+
+	if (pfx == NULL)
+		return -1;
+
+	for (i = 0; i < n; ++i) {
+		BKEYDATA *bk = GET_BKEYDATA(dbp, pg, i);
+
+		if (B_TYPE(bk) != B_KEYDATA || (!B_PISSET(bk) && !B_RISSET(bk))) {
+			len[i] = BAM_KC_RAW;
+			continue;
+		}
+
+		cur = ALIGN(used, sizeof(uint64_t));
+		if (cur >= bufsz)
+			return 1;
+		room = bufsz - cur;
+		l = 0;
+
+		if (B_PISSET(bk)) {
+			if (pfx->npfx > room)
+				return 1;
+			memcpy(buf + cur, pfx->pfx, pfx->npfx);
+			l += pfx->npfx;
+		}
+
+		/* jdecompress fails the same way on short space or bad rle */
+		if (jdecompress(bk, buf + cur + l,
+			(room - l) > KEYBUF ? KEYBUF : room - l, &sz) != 0)
+			return (room - l) > KEYBUF ? -1 : 1;
+		l += sz;
+
+		if (B_PISSET(bk) && pfx->nsfx) {
+			if (l + pfx->nsfx > room)
+				return 1;
+			memcpy(buf + cur + l, pfx->sfx, pfx->nsfx);
+			l += pfx->nsfx;
+		}
+
+		off[i] = cur;
+		len[i] = l;
+		used = cur + l;
+	}
+	return 0;
+}
+
+// PUBLIC: void __bam_keycache_free __P((DB_ENV *, BAM_KEYCACHE *));
+void
+__bam_keycache_free(DB_ENV *dbenv, BAM_KEYCACHE *kc)
+{
+	if (kc->mem)
+		__os_free(dbenv, kc->mem);
+	if (kc->off)
+		__os_free(dbenv, kc->off);
+	if (kc->len)
+		__os_free(dbenv, kc->len);
+	__os_free(dbenv, kc);
+}
+
+static int
+bam_keycache_fill(DBC *dbc, BAM_KEYCACHE *kc, PAGE *pg)
+{
+	DB *dbp = dbc->dbp;
+	DB_ENV *dbenv = dbp->dbenv;
+	db_indx_t n = NUM_ENT(pg);
+	uint32_t sz;
+	int ret;
+
+	kc->valid = 0;
+	if (n > kc->nslots) {
+		if ((ret = __os_realloc(dbenv, n * sizeof(*kc->off),
+			    &kc->off)) != 0 ||
+		    (ret = __os_realloc(dbenv, n * sizeof(*kc->len),
+			    &kc->len)) != 0)
+			return ret;
+		kc->nslots = n;
+	}
+	if (kc->bufsz == 0)
+		kc->bufsz = dbp->pgsize * 2;
+
+	for (;;) {
+		if (kc->mem == NULL) {
+			/* Keep the decoded keys cache-line aligned. */
+			if ((ret = __os_malloc(dbenv, kc->bufsz + 63,
+				    &kc->mem)) != 0)
+				return ret;
+			kc->buf = (uint8_t *)ALIGN((uintptr_t)kc->mem, 64);
+		}
+		ret = pfx_decode_page(dbp, pg, kc->buf, kc->bufsz, kc->off,
+		    kc->len);
+		if (ret <= 0)
+			break;
+		/* A page of long rle-packed keys may need more room. */
+		sz = kc->bufsz * 2;
+		if (sz > 64 * dbp->pgsize)
+			return -1;
+		__os_free(dbenv, kc->mem);
+		kc->mem = NULL;
+		kc->bufsz = sz;
+	}
+	if (ret != 0)
+		return ret;
+
+	kc->mpf = dbp->mpf;
+	kc->pgno = PGNO(pg);
+	kc->lsn = LSN(pg);
+	kc->nent = n;
+	kc->hoffset = HOFFSET(pg);
+	kc->valid = 1;
+	return 0;
+}
+
+/*
+ * __bam_keycache_ret --
+ *	__db_ret for a btree cursor.  With bulk_key_decode on, the first item
+ *	fetched from a prefix-compressed leaf page decodes the page's items
+ *	into the cursor's key cache in one pass, and later fetches from that
+ *	page copy straight out of it.
+ *
+ * PUBLIC: int __bam_keycache_ret __P((DBC *,
+ * PUBLIC:    PAGE *, u_int32_t, DBT *, void **, u_int32_t *));
+ */
+int
+__bam_keycache_ret(DBC *dbc, PAGE *pg, u_int32_t indx, DBT *dbt, void **memp,
+    u_int32_t *memsize)
+{
+	BTREE_CURSOR *cp = (BTREE_CURSOR *)dbc->internal;
+	DB *dbp = dbc->dbp;
+	DB_ENV *dbenv = dbp->dbenv;
+	BAM_KEYCACHE *kc;
+
+	if (!dbenv->attr.bulk_key_decode || dbc->dbtype != DB_BTREE ||
+	    TYPE(pg) != P_LBTREE || !IS_PREFIX(pg) ||
+	    F_ISSET(dbp, DB_AM_NOT_DURABLE))
+		return __db_ret(dbp, pg, indx, dbt, memp, memsize);
+
+	if ((kc = cp->keycache) == NULL) {
+		if (__os_calloc(dbenv, 1, sizeof(BAM_KEYCACHE), &kc) != 0)
+			return __db_ret(dbp, pg, indx, dbt, memp, memsize);
+		cp->keycache = kc;
+	}
+
+	/* Same page, unchanged since we decoded it? */
+	if (!kc->valid || kc->mpf != dbp->mpf || kc->pgno != PGNO(pg) ||
+	    log_compare(&kc->lsn, &LSN(pg)) != 0 || kc->nent != NUM_ENT(pg) ||
+	    kc->hoffset != HOFFSET(pg)) {
+		if (bam_keycache_fill(dbc, kc, pg) != 0)
+			return __db_ret(dbp, pg, indx, dbt, memp, memsize);
+	}
+
+	if (indx >= kc->nent || kc->len[indx] == BAM_KC_RAW)
+		return __db_ret(dbp, pg, indx, dbt, memp, memsize);
+
+	return __db_retcopy(dbenv, dbt, kc->buf + kc->off[indx],
+	    kc->len[indx], memp, memsize);
+}
+
 void
 prefix_tocpu(DB *dbp, PAGE *page)
 {
@@ -65,6 +65,7 @@ static const char revid[] = "$Id: bt_search.c,v 11.47 2003/06/30 17:19:35 bostic
 #include <btree/bt_cache.h>
 
 #include <btree/bt_pf.h>
+#include <keycmp.h>
 
 
 #include <stdbool.h>
@@ -126,7 +127,7 @@ __bam_cmp_inline(dbp, dbt, h, indx, func, cmpp, buf)
 				int len;
 				len = dbt->size > pg_dbt.size ? pg_dbt.size
 				    : dbt->size;
-				*cmpp = memcmp(dbt->data, pg_dbt.data, len);
+				*cmpp = comdb2_keycmp(dbt->data, pg_dbt.data, len);
 				if (unlikely(*cmpp == 0))
 					*cmpp =
 					    ((long)dbt->size -
@@ -173,7 +174,7 @@ __bam_cmp_inline(dbp, dbt, h, indx, func, cmpp, buf)
 
 				len = dbt->size > pg_dbt.size ? pg_dbt.size
 				    : dbt->size;
-				*cmpp = memcmp(dbt->data, pg_dbt.data, len);
+				*cmpp = comdb2_keycmp(dbt->data, pg_dbt.data, len);
 				if (unlikely((*cmpp == 0)))
 					*cmpp = ((long)dbt->size -
 					    (long)pg_dbt.size);
@@ -597,6 +598,17 @@ got_pg:func = t->bt_compare;
 		    lim >>= 1) {
 			indx = base + ((lim >> 1) * adjust);
 
+			/*
+			 * Start pulling in both candidates for the next probe
+			 * while we compare against this one.
+			 */
+			if (lim > 3) {
+				__builtin_prefetch(P_ENTRY(dbp, h,
+				    base + ((lim >> 2) * adjust)));
+				__builtin_prefetch(P_ENTRY(dbp, h,
+				    indx + adjust + (((lim - 1) >> 2) * adjust)));
+			}
+
 			if ((ret =
 				__bam_cmp_inline(dbp, key, h, indx, func, &cmp,
 				    buf)) != 0)
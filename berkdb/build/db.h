@@ -713,6 +713,12 @@ struct __db_log_stat {
 	u_int32_t st_ondisk_get;	/* On-disk log_get. */
 	u_int32_t st_inmem_trav;	/* Mem-log steps for partial reads. */
 	u_int32_t st_wrap_copy;		/* Count of wrapped copies. */
+	u_int32_t st_gc_flushes;	/* Group-commit flusher syncs. */
+#define	DB_LOG_HIST_BUCKETS	24	/* Bucket i holds [2^i, 2^(i+1)). */
+	u_int64_t st_gc_batch_hist[DB_LOG_HIST_BUCKETS];
+					/* Commits released per group flush. */
+	u_int64_t st_fsync_us_hist[DB_LOG_HIST_BUCKETS];
+					/* Log fsync latency in usecs. */
 };
 
 /*******************************************************
@@ -2898,6 +2904,7 @@ struct __recovery_processor {
 	unsigned long long context;
 	u_int32_t lockid;
 	struct __recovery_queue **recovery_queues;
+	struct __rep_pgdep *pgdep;	/* Page-level apply state. */
 	void *txninfo;
 	LSN_COLLECTION lc;
 	pool_t *recpool;
@@ -2954,6 +2961,8 @@ int berkdb_verify_lsn_written_to_disk(DB_ENV *dbenv, DB_LSN *lsn,
 
 u_int32_t file_id_for_recovery_record(DB_ENV *env, DB_LSN *lsn,
 	int rectype, DBT *dbt);
+#define	RECOVERY_RECORD_MAXPAGES	4
+int pages_for_recovery_record(int rectype, DBT *dbt, db_pgno_t *pgnos);
 
 int __rep_get_master(DB_ENV *dbenv, char **master, u_int32_t *gen, u_int32_t *egen);
 int __rep_get_eid(DB_ENV *dbenv,char **eid);
@@ -2986,7 +2995,14 @@ typedef struct {
 	db_pgno_t pgno;
 } touch_pg;
 
+typedef struct {
+	DB_MPOOLFILE *mpf;
+	int npgnos;
+	db_pgno_t pgnos[1];
+} touch_pgs;
+
 int enqueue_touch_page(DB_MPOOLFILE *mpf, db_pgno_t pgno);
+int enqueue_touch_pages(DB_MPOOLFILE *mpf, db_pgno_t *pgnos, int npgnos);
 void touch_page(DB_MPOOLFILE *mpf, db_pgno_t pgno);
 
 //#############################################
@@ -403,6 +403,100 @@ file_id_for_recovery_record(DB_ENV *env, DB_LSN *lsn, int rectype, DBT *dbt)
 	return fileid;
 }
 
+/*
+ * Offsets of the page arguments of the records handled below, again taken
+ * from the autogenerated read routines: type + txnid + prev_lsn, then the
+ * record's own arguments.
+ */
+#define	RR_HDR	(sizeof(u_int32_t) + sizeof(u_int32_t) + sizeof(DB_LSN))
+#define	RR_U32	sizeof(u_int32_t)
+#define	RR_LSN	sizeof(DB_LSN)
+
+/*
+ * pages_for_recovery_record --
+ *	Fill pgnos with the pages of the record's file that applying it
+ *	modifies and return how many there are, at most
+ *	RECOVERY_RECORD_MAXPAGES.  Return -1 if the record isn't confined to a
+ *	known set of pages (file ops, txn records, cursor adjustments, ...).
+ */
+int
+pages_for_recovery_record(int rectype, DBT *dbt, db_pgno_t *pgnos)
+{
+	u_int8_t *bp = dbt->data;
+	db_pgno_t pgno;
+	int n = 0;
+
+#define	RR_PAGE(off) do {						\
+	LOGCOPY_32(&pgno, bp + (off));					\
+	pgnos[n++] = pgno;						\
+} while (0)
+	/* Sibling and root links are PGNO_INVALID when there is none. */
+#define	RR_LINK(off) do {						\
+	LOGCOPY_32(&pgno, bp + (off));					\
+	if (pgno != PGNO_INVALID)					\
+		pgnos[n++] = pgno;					\
+} while (0)
+
+	switch (rectype) {
+	case DB___bam_adj:
+	case DB___bam_cadjust:
+	case DB___bam_cdel:
+	case DB___bam_repl:
+	case DB___bam_prefix:
+	case DB___db_ovref:
+		/* fileid, pgno */
+		RR_PAGE(RR_HDR + RR_U32);
+		break;
+	case DB___db_addrem:
+		/* opcode, fileid, pgno */
+		RR_PAGE(RR_HDR + 2 * RR_U32);
+		break;
+	case DB___db_big:
+		/* opcode, fileid, pgno, prev_pgno, next_pgno */
+		RR_PAGE(RR_HDR + 2 * RR_U32);
+		RR_LINK(RR_HDR + 3 * RR_U32);
+		RR_LINK(RR_HDR + 4 * RR_U32);
+		break;
+	case DB___db_relink:
+		/* opcode, fileid, pgno, lsn, prev, lsn_prev, next */
+		RR_PAGE(RR_HDR + 2 * RR_U32);
+		RR_LINK(RR_HDR + 3 * RR_U32 + RR_LSN);
+		RR_LINK(RR_HDR + 4 * RR_U32 + 2 * RR_LSN);
+		break;
+	case DB___db_pg_alloc:
+		/* fileid, meta_lsn, meta_pgno, page_lsn, pgno */
+		RR_PAGE(RR_HDR + RR_U32 + RR_LSN);
+		RR_PAGE(RR_HDR + 2 * RR_U32 + 2 * RR_LSN);
+		break;
+	case DB___db_pg_free:
+		/* fileid, pgno, meta_lsn, meta_pgno */
+		RR_PAGE(RR_HDR + RR_U32);
+		RR_PAGE(RR_HDR + 2 * RR_U32 + RR_LSN);
+		break;
+	case DB___bam_root:
+		/* fileid, meta_pgno, root_pgno */
+		RR_PAGE(RR_HDR + RR_U32);
+		RR_PAGE(RR_HDR + 2 * RR_U32);
+		break;
+	case DB___bam_split:
+		/*
+		 * fileid, left, llsn, right, rlsn, indx, npgno, nlsn,
+		 * root_pgno
+		 */
+		RR_PAGE(RR_HDR + RR_U32);
+		RR_PAGE(RR_HDR + 2 * RR_U32 + RR_LSN);
+		RR_LINK(RR_HDR + 4 * RR_U32 + 2 * RR_LSN);
+		RR_LINK(RR_HDR + 5 * RR_U32 + 3 * RR_LSN);
+		break;
+	default:
+		return (-1);
+	}
+#undef	RR_PAGE
+#undef	RR_LINK
+
+	return (n);
+}
+
 /*
  * __db_dispatch --
  *
@@ -189,6 +189,28 @@ struct __epg {
 
 #include <pthread.h>
 
+/*
+ * Decoded items of one prefix-compressed leaf page (comdb2 addition).  Item
+ * i is len[i] bytes at buf + off[i]; items stored uncompressed have len[i]
+ * BAM_KC_RAW and are read from the page.  The cache stays valid while the
+ * page keeps its LSN.
+ */
+#define	BAM_KC_RAW	0xffff
+typedef struct __bam_keycache {
+	DB_MPOOLFILE *mpf;
+	db_pgno_t pgno;
+	DB_LSN lsn;
+	db_indx_t nent;
+	db_indx_t hoffset;
+	int valid;
+	u_int32_t nslots;	/* Size of off and len. */
+	u_int32_t *off;
+	db_indx_t *len;
+	u_int32_t bufsz;
+	u_int8_t *buf;		/* 64-byte aligned, within mem. */
+	void *mem;
+} BAM_KEYCACHE;
+
 /* Btree/Recno cursor. */
 struct __cursor {
 	/* struct __dbc_internal */
@@ -234,6 +256,7 @@ struct __cursor {
 #define	C_RENUMBER	0x0004	/* Tree records are mutable. */
 	u_int32_t flags;
 	DB_LSN pagelsn;
+	BAM_KEYCACHE *keycache;	/* Decoded leaf page, see __bam_keycache_ret. */
 };
 
 /* comdb2 addition */
@@ -29,6 +29,8 @@ BERK_DEF_ATTR(check_applied_lsns_fatal, "Abort if check_applied_lsns fails", BER
 BERK_DEF_ATTR(check_applied_lsns_debug, "Lots of verbose trace for debugging applied LSNs.", BERK_ATTR_TYPE_BOOLEAN, 0)
 BERK_DEF_ATTR(sgio_enabled, "Do scatter gather I/O", BERK_ATTR_TYPE_BOOLEAN, 0)
 BERK_DEF_ATTR(sgio_max, "Max scatter gather I/O to do at one time", BERK_ATTR_TYPE_INTEGER, 10 * MEGABYTE)
+BERK_DEF_ATTR(iouring_enabled, "Use io_uring for batched page reads and writes", BERK_ATTR_TYPE_BOOLEAN, 0)
+BERK_DEF_ATTR(iouring_depth, "Submission queue depth of the per-thread io_uring", BERK_ATTR_TYPE_INTEGER, 64)
 BERK_DEF_ATTR(btpf_enabled, "Enables index pages read ahead", BERK_ATTR_TYPE_BOOLEAN, 0)
 BERK_DEF_ATTR(btpf_wndw_min, "Minimum number of pages read ahead", BERK_ATTR_TYPE_INTEGER, 100 )
 BERK_DEF_ATTR(btpf_wndw_max, "Maximum number of pages read ahead", BERK_ATTR_TYPE_INTEGER, 1000 )
@@ -58,7 +60,12 @@ BERK_DEF_ATTR(latch_poll_us, "Poll latch this many microseconds before retrying"
 BERK_DEF_ATTR(latch_max_poll, "Poll latch this many times before returning deadlock", BERK_ATTR_TYPE_INTEGER, 5)
 BERK_DEF_ATTR(latch_timed_mutex, "Use a timed mutex", BERK_ATTR_TYPE_BOOLEAN, 1)
 BERK_DEF_ATTR(log_cursor_cache, "Cache log cursors", BERK_ATTR_TYPE_BOOLEAN, 0)
+BERK_DEF_ATTR(bulk_key_decode, "Cursors decode a whole prefix-compressed leaf page at once", BERK_ATTR_TYPE_BOOLEAN, 0)
+BERK_DEF_ATTR(log_group_commit, "Release durable commits from a dedicated log flusher by LSN watermark", BERK_ATTR_TYPE_BOOLEAN, 0)
 BERK_DEF_ATTR(recovery_processor_poll_interval_us, "Recovery processor wakes this often to check workers", BERK_ATTR_TYPE_INTEGER, 1000)
+BERK_DEF_ATTR(rep_pgdep_apply, "Apply large replicated transactions in parallel by page dependencies", BERK_ATTR_TYPE_BOOLEAN, 0)
+BERK_DEF_ATTR(rep_pgdep_min_records, "Log records a transaction needs before it is applied by page dependencies", BERK_ATTR_TYPE_INTEGER, 256)
+BERK_DEF_ATTR(rep_pgdep_workers, "Threads applying one transaction by page dependencies", BERK_ATTR_TYPE_INTEGER, 4)
 BERK_DEF_ATTR(lsnerr_logflush, "Flush log on lsn error", BERK_ATTR_TYPE_BOOLEAN, 1)
 BERK_DEF_ATTR(tracked_locklist_init, "Initial allocation count for tracked locks", BERK_ATTR_TYPE_INTEGER, 10)
 /* This is a placeholder for now */
@@ -253,6 +253,13 @@ struct __mpoolfile {
 	int32_t	  no_backing_file;	/* Never open a backing file. */
 	int32_t	  unlink_on_close;	/* Unlink file on last close. */
 
+	/*
+	 * Bumped after every page write.  A page __memp_prefetch read
+	 * outside the pool is only installed if no write happened since;
+	 * like file_written, only whether it changed matters.
+	 */
+	u_int32_t write_gen;
+
 	/*
 	 * We do not protect the statistics in "stat" because of the cost of
 	 * the mutex in the get/put routines.  There is a chance that a count
@@ -79,6 +79,22 @@ struct __fh_t {
 	u_int8_t flags;
 };
 
+/*
+ * One request in a batch handed to __os_uring_io: nobufs consecutive pages
+ * starting at pgno.  If link is set the next request in the batch doesn't
+ * start until this one is done.
+ */
+typedef struct __db_uring_io {
+	int	  op;			/* DB_IO_READ or DB_IO_WRITE */
+	DB_FH	 *fhp;
+	db_pgno_t pgno;
+	size_t	  pagesize;
+	u_int8_t **bufs;
+	u_int32_t nobufs;
+	int	  link;
+	size_t	  nio;			/* Bytes transferred (out). */
+} DB_URING_IO;
+
 #if defined(__cplusplus)
 }
 #endif
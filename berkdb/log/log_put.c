@@ -45,11 +45,13 @@ static const char revid[] = "$Id: log_put.c,v 11.145 2003/09/13 19:20:39 bostic
 #include "logmsg.h"
 #include <locks_wrap.h>
 #include <poll.h>
+#include <epochlib.h>
 
 extern unsigned long long get_commit_context(const void *, uint32_t generation);
 extern int bdb_update_startlwm_berk(void *statearg, unsigned long long ltranid,
     DB_LSN *firstlsn);
 extern int bdb_commitdelay(void *arg);
+extern void bdb_rep_pace_commit(void *arg);
 extern int bdb_push_pglogs_commit(void *in_bdb_state, DB_LSN commit_lsn, 
 	uint32_t generation, unsigned long long ltranid, int push);
 
@@ -60,6 +62,7 @@ static int __log_fill __P((DB_LOG *, DB_LSN *, void *, u_int32_t));
 static int __log_fill_segments __P((DB_LOG *, DB_LSN *, DB_LSN *, void *,
 	u_int32_t));
 static int __log_flush_commit __P((DB_ENV *, const DB_LSN *, u_int32_t));
+static int __log_group_commit __P((DB_ENV *, const DB_LSN *));
 static int __log_newfh __P((DB_LOG *));
 static int __log_put_next __P((DB_ENV *,
 	DB_LSN *, u_int64_t *, DBT *, const DBT *, HDR *, DB_LSN *, int,
@@ -74,6 +77,28 @@ static pthread_t log_write_td = 0;
 static int log_write_td_should_stop = 0;
 static DB_LOG *log_write_dblp = NULL;
 
+/*
+ * Group commit.  Durable committers publish their commit LSN in
+ * log_gc_want and sleep until the flusher thread moves log_gc_durable
+ * past it.  The flusher drops the region lock for the fsync, so the next
+ * batch keeps appending to the log buffer while the previous one syncs.
+ * A failed flush is handed to the committers that were waiting when it
+ * started (log_gc_failed/log_gc_fail_ret); only a panic sticks in
+ * log_gc_ret.
+ */
+static pthread_mutex_t log_gc_lk = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t log_gc_cond = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t log_gc_done = PTHREAD_COND_INITIALIZER;
+static pthread_once_t log_gc_once = PTHREAD_ONCE_INIT;
+static DB_LOG *log_gc_dblp = NULL;
+static DB_LSN log_gc_want;
+static DB_LSN log_gc_durable;
+static u_int32_t log_gc_batch;
+static u_int64_t log_gc_started;
+static u_int64_t log_gc_failed;
+static int log_gc_fail_ret;
+static int log_gc_ret;
+
 int __db_debug_log(DB_ENV *, DB_TXN *, DB_LSN *, u_int32_t, const DBT *,
     int32_t, const DBT *, const DBT *, u_int32_t);
 
@@ -356,7 +381,16 @@ __log_put_int_int(dbenv, lsnp, contextp, udbt, flags, off_context, usr_ptr)
 	 * If a flush is not needed, see if WRITE_NOSYNC was set and we
 	 * need to write out the log buffer.
 	 */
-	if (LF_ISSET(DB_FLUSH | DB_LOG_WRNOSYNC)) {
+	if (LF_ISSET(DB_FLUSH) && !LF_ISSET(DB_LOG_CHKPNT) &&
+	    dbenv->attr.log_group_commit) {
+		/* The flusher syncs for us; don't hold the region meanwhile. */
+		if (lock_held) {
+			R_UNLOCK(dbenv, &dblp->reginfo);
+			lock_held = 0;
+		}
+		if ((ret = __log_group_commit(dbenv, &lsn)) != 0)
+			goto panic_check;
+	} else if (LF_ISSET(DB_FLUSH | DB_LOG_WRNOSYNC)) {
 		if (!lock_held) {
 			R_LOCK(dbenv, &dblp->reginfo);
 			lock_held = 1;
@@ -410,6 +444,9 @@ err:
 		}
 	}
 
+	if (ret == 0 && IS_REP_MASTER(dbenv) && is_commit_record(rectype))
+		bdb_rep_pace_commit(dbenv->app_private);
+
 	/*
 	 * If auto-remove is set and we switched files, remove unnecessary
 	 * log files.
@@ -1288,6 +1325,155 @@ __log_lwr_lsn(dblp)
 	}
 }
 
+/* Count a sample in a log2 histogram; region lock held. */
+static inline void
+__log_hist_add(hist, val)
+	u_int64_t *hist;
+	u_int64_t val;
+{
+	int b;
+
+	b = val > 1 ? 63 - __builtin_clzll(val) : 0;
+	if (b >= DB_LOG_HIST_BUCKETS)
+		b = DB_LOG_HIST_BUCKETS - 1;
+	++hist[b];
+}
+
+/*
+ * __log_group_commit_td --
+ *	Flush the log up to the highest LSN a committer is waiting on, then
+ *	release every waiter below the new sync point.
+ */
+static void *
+__log_group_commit_td(arg)
+	void *arg;
+{
+	DB_ENV *dbenv;
+	DB_LOG *dblp;
+	DB_LSN want, durable;
+	LOG *lp;
+	u_int64_t round;
+	u_int32_t batch;
+	int ret;
+
+	dblp = (DB_LOG *)arg;
+	dbenv = dblp->dbenv;
+	lp = dblp->reginfo.primary;
+
+	Pthread_mutex_lock(&log_gc_lk);
+	for (;;) {
+		while (log_gc_batch == 0)
+			Pthread_cond_wait(&log_gc_cond, &log_gc_lk);
+		want = log_gc_want;
+		batch = log_gc_batch;
+		log_gc_batch = 0;
+		round = ++log_gc_started;
+		Pthread_mutex_unlock(&log_gc_lk);
+
+		/*
+		 * __log_flush_int writes the whole in-memory buffer, so
+		 * this also covers anything appended after the waiters we
+		 * counted; whoever arrives during the fsync rides the next
+		 * flush.
+		 */
+		R_LOCK(dbenv, &dblp->reginfo);
+		ret = __log_flush_int(dblp, &want, 1);
+		durable = lp->s_lsn;
+		if (ret == 0) {
+			++lp->stat.st_gc_flushes;
+			__log_hist_add(lp->stat.st_gc_batch_hist, batch);
+		}
+		R_UNLOCK(dbenv, &dblp->reginfo);
+
+		Pthread_mutex_lock(&log_gc_lk);
+		if (ret == 0) {
+			if (log_compare(&log_gc_durable, &durable) < 0)
+				log_gc_durable = durable;
+		} else if (IS_REP_MASTER(dbenv)) {
+			/*
+			 * The commit records are already on the replicants;
+			 * a master that can't make them durable has to panic.
+			 */
+			log_gc_ret = __db_panic(dbenv, ret);
+		} else {
+			/*
+			 * Fail this round's waiters, as __log_flush_commit
+			 * would; later committers get a fresh attempt.
+			 */
+			log_gc_failed = round;
+			log_gc_fail_ret = ret;
+		}
+		Pthread_cond_broadcast(&log_gc_done);
+		if (log_gc_ret != 0)
+			break;
+	}
+	Pthread_mutex_unlock(&log_gc_lk);
+	return NULL;
+}
+
+static void
+__log_group_commit_init(void)
+{
+	pthread_t tid;
+	int ret;
+
+	if ((ret = pthread_create(&tid, NULL, __log_group_commit_td,
+	    log_gc_dblp)) != 0) {
+		DB_ENV *dbenv = log_gc_dblp->dbenv;
+		__db_err(dbenv,
+		    "DB_ENV->log_group_commit_init: error creating pthread");
+		ret = __db_panic(dbenv, ret);
+		return;
+	}
+	pthread_detach(tid);
+}
+
+/*
+ * __log_group_commit --
+ *	Wait until the record at lsnp is on disk.  Called without the region
+ *	lock; the flusher thread does the sync.
+ */
+static int
+__log_group_commit(dbenv, lsnp)
+	DB_ENV *dbenv;
+	const DB_LSN *lsnp;
+{
+	DB_LOG *dblp;
+	LOG *lp;
+	u_int64_t seen;
+	int ret;
+
+	dblp = dbenv->lg_handle;
+	lp = dblp->reginfo.primary;
+
+	/* Same unlocked test as __log_flush_int: s_lsn only moves forward. */
+	if (log_compare(&lp->s_lsn, lsnp) > 0)
+		return (0);
+
+	log_gc_dblp = dblp;
+	pthread_once(&log_gc_once, __log_group_commit_init);
+
+	Pthread_mutex_lock(&log_gc_lk);
+	if (log_compare(&log_gc_want, lsnp) < 0)
+		log_gc_want = *lsnp;
+	++log_gc_batch;
+	/* Only a round that starts after this point covers our record. */
+	seen = log_gc_started;
+	Pthread_cond_signal(&log_gc_cond);
+	while (log_gc_ret == 0 && log_gc_failed <= seen &&
+	    log_compare(&log_gc_durable, lsnp) <= 0)
+		Pthread_cond_wait(&log_gc_done, &log_gc_lk);
+	if (log_compare(&log_gc_durable, lsnp) > 0)
+		ret = 0;
+	else if (log_gc_ret != 0)
+		ret = log_gc_ret;
+	else
+		ret = log_gc_fail_ret;
+	Pthread_mutex_unlock(&log_gc_lk);
+
+	return (ret);
+}
+
 /*
  * __log_flush_int --
  *	Write all records less than or equal to the specified LSN; internal
@@ -1311,6 +1497,7 @@ __log_flush_int(dblp, lsnp, release)
 	DB_MUTEX *flush_mutexp;
 	LOG *lp;
 	u_int32_t ncommit, w_off, listcnt;
+	u_int64_t fsync_us;
 	int do_flush, first, ret, wrote_inmem;
 
 	dbenv = dblp->dbenv;
@@ -1538,6 +1725,7 @@ flush:	MUTEX_LOCK(dbenv, flush_mutexp);
 		R_UNLOCK(dbenv, &dblp->reginfo);
 
 	/* Sync all writes to disk. */
+	fsync_us = comdb2_time_epochus();
 	if ((ret = __os_fsync(dbenv, dblp->lfhp)) != 0) {
 		MUTEX_UNLOCK(dbenv, flush_mutexp);
 		if (release)
@@ -1554,6 +1742,7 @@ flush:	MUTEX_LOCK(dbenv, flush_mutexp);
 	 * we can move up to write point since the first lsn is not
 	 * set for the new buffer.
 	 */
+	fsync_us = comdb2_time_epochus() - fsync_us;
 	lp->s_lsn = s_lsn;
 
 	/*
@@ -1570,6 +1759,7 @@ flush:	MUTEX_LOCK(dbenv, flush_mutexp);
 
 	lp->in_flush--;
 	++lp->stat.st_scount;
+	__log_hist_add(lp->stat.st_fsync_us_hist, fsync_us);
 
 	/*
 	 * How many flush calls (usually commits) did this call actually sync?
@@ -51,6 +51,20 @@ __P((DB_ENV *, DB_MPOOLFILE *, DB_MPOOL_HASH *, BH *, int));
 static int __memp_pgwrite_multi
 __P((DB_ENV *, DB_MPOOLFILE *, DB_MPOOL_HASH **, BH **, int, int));
 
+/*
+ * A page that __memp_prefetch has already read for this thread.  When
+ * __memp_pgread is asked for it, it copies the data instead of reading
+ * the page again -- unless the file was written since the read started
+ * (write_gen moved): the page may have been faulted in, changed, flushed
+ * and evicted in the meantime, and the staged image would be stale.
+ */
+static __thread struct {
+	DB_MPOOLFILE *dbmfp;
+	db_pgno_t pgno;
+	u_int32_t write_gen;
+	u_int8_t *buf;
+} staged_page;
+
 /*
  * __memp_bhwrite --
  *	Write the page associated with a given buffer header.
@@ -436,7 +450,11 @@ __memp_pgread(dbmfp, hp, bhp, can_create, is_recovery_page)
 	 * them now, we create them when the pages have to be flushed.
 	 */
 	nr = 0;
-	if (dbmfp->fhp != NULL)
+	if (staged_page.dbmfp == dbmfp && staged_page.pgno == bhp->pgno &&
+	    staged_page.write_gen == mfp->write_gen) {
+		memcpy(bhp->buf, staged_page.buf, pagesize);
+		nr = pagesize;
+	} else if (dbmfp->fhp != NULL)
 		if ((ret = __os_io(dbenv, DB_IO_READ,
 		    dbmfp->fhp, bhp->pgno, pagesize, bhp->buf, &nr)) != 0)
 			goto err;
@@ -703,6 +721,106 @@ berkdb_verify_lsn_written_to_disk(DB_ENV *dbenv, DB_LSN *lsn,
 	return 0;
 }
 
+/*
+ * __memp_prefetch --
+ *	Bring a set of pages of a file into the buffer pool.  The pages that
+ *	aren't already cached are read as one batch (see __os_uring_io) and
+ *	then installed through __memp_fget, which takes the data we already
+ *	have rather than reading each page again.
+ *
+ * PUBLIC: int __memp_prefetch __P((DB_MPOOLFILE *, db_pgno_t *, int));
+ */
+int
+__memp_prefetch(dbmfp, pgnos, npgnos)
+	DB_MPOOLFILE *dbmfp;
+	db_pgno_t *pgnos;
+	int npgnos;
+{
+	DB_ENV *dbenv;
+	DB_URING_IO *ios;
+	PAGE *h;
+	u_int8_t *bufs, **bparray;
+	void *raw;
+	size_t pagesize;
+	db_pgno_t pgno;
+	u_int32_t write_gen;
+	int i, nios, ret;
+
+	dbenv = dbmfp->dbenv;
+	pagesize = dbmfp->mfp->stat.st_pagesize;
+	ios = NULL;
+	raw = NULL;
+	bparray = NULL;
+
+	if (dbmfp->fhp == NULL || npgnos < 2)
+		goto touch;
+
+	if ((ret = __os_calloc(dbenv, npgnos, sizeof(DB_URING_IO), &ios)) != 0 ||
+	    (ret = __os_malloc(dbenv, npgnos * sizeof(u_int8_t *),
+	    &bparray)) != 0)
+		goto touch;
+	if ((ret = __os_malloc(dbenv, npgnos * pagesize + 4096, &raw)) != 0)
+		goto touch;
+	/* Aligned, in case the file is open for direct I/O. */
+	bufs = (u_int8_t *)(((uintptr_t)raw + 4095) & ~(uintptr_t)4095);
+
+	/* Before probing: a write from here on may race with our reads. */
+	write_gen = dbmfp->mfp->write_gen;
+
+	for (i = 0, nios = 0; i < npgnos; ++i) {
+		pgno = pgnos[i];
+		if ((ret = __memp_fget(dbmfp, &pgno, DB_MPOOL_PROBE, &h)) == 0) {
+			(void)__memp_fput(dbmfp, h, 0);
+			continue;
+		}
+		if (ret != DB_FIRST_MISS)
+			continue;
+		bparray[nios] = bufs + nios * pagesize;
+		ios[nios].op = DB_IO_READ;
+		ios[nios].fhp = dbmfp->fhp;
+		ios[nios].pgno = pgno;
+		ios[nios].pagesize = pagesize;
+		ios[nios].bufs = &bparray[nios];
+		ios[nios].nobufs = 1;
+		++nios;
+	}
+
+	if ((ret = __os_uring_io(dbenv, ios, nios)) != 0)
+		goto touch;
+
+	for (i = 0; i < nios; ++i) {
+		if (ios[i].nio != pagesize)
+			continue;
+		pgno = ios[i].pgno;
+		staged_page.dbmfp = dbmfp;
+		staged_page.pgno = pgno;
+		staged_page.write_gen = write_gen;
+		staged_page.buf = bparray[i];
+		ret = __memp_fget(dbmfp, &pgno, DB_MPOOL_PFGET, &h);
+		staged_page.dbmfp = NULL;
+		if (ret == 0)
+			(void)__memp_fput(dbmfp, h, DB_MPOOL_PFPUT);
+	}
+	ret = 0;
+	goto done;
+
+	/* Couldn't batch: fault the pages in one at a time. */
+touch:	for (i = 0; i < npgnos; ++i) {
+		pgno = pgnos[i];
+		if (__memp_fget(dbmfp, &pgno, DB_MPOOL_PFGET, &h) == 0)
+			(void)__memp_fput(dbmfp, h, DB_MPOOL_PFPUT);
+	}
+	ret = 0;
+
+done:	if (ios != NULL)
+		__os_free(dbenv, ios);
+	if (bparray != NULL)
+		__os_free(dbenv, bparray);
+	if (raw != NULL)
+		__os_free(dbenv, raw);
+	return (ret);
+}
+
 /*
  * __memp_pgwrite --
  *	Write a page to a file.
@@ -752,6 +870,7 @@ __memp_pgwrite_multi(dbenv, dbmfp, hps, bhps, numpages, wrrec)
 	DB_MPOOL_HASH *hp;
 	BH *bhp = NULL;
 	u_int8_t **bparray;
+	DB_URING_IO *recios;
 	size_t nw;
 	int *callpgin, *reclk;
 	DB_MPOOL *dbmp;
@@ -762,6 +881,7 @@ __memp_pgwrite_multi(dbenv, dbmfp, hps, bhps, numpages, wrrec)
 	mfp = dbmfp == NULL ? NULL : dbmfp->mfp;
 	ret = 0;
 	idx = -1;
+	recios = NULL;
 
 	/* We should at least have one one buffer to write out. */
 	DB_ASSERT(numpages >= 1 && bhps[0] != NULL && hps[0] != NULL);
@@ -938,11 +1058,17 @@ __memp_pgwrite_multi(dbenv, dbmfp, hps, bhps, numpages, wrrec)
 		}
 	}
 
-	/* Recovery-page logging.  */
-	for (i = 0; i < numpages; i++) {
-		bhp = bhps[i];
+	/*
+	 * Recovery-page logging.  The copies go to scattered slots in the
+	 * recovery file, so send them down as one batch.
+	 */
+	if (wrrec && dbenv->mp_recovery_pages > 0) {
+		if ((ret = __os_calloc(dbenv, numpages, sizeof(DB_URING_IO),
+		    &recios)) != 0)
+			goto err;
+		for (i = 0; i < numpages; i++) {
+			bhp = bhps[i];
 
-		if (wrrec && dbenv->mp_recovery_pages > 0) {
 			/* Meta page is always at idx 0. */
 			if (0 == bhp->pgno)
 				idx = 0;
@@ -961,16 +1087,20 @@ __memp_pgwrite_multi(dbenv, dbmfp, hps, bhps, numpages, wrrec)
 			/* Hack in case we're writing out the meta page. */
 			reclk[i] = idx + 1;
 
-			ret = __os_io(dbenv, DB_IO_WRITE, dbmfp->recp,
-			    idx, mfp->stat.st_pagesize, bhp->buf, &nw);
-			if (ret != 0) {
-				__db_err(dbenv,
-				    "%s: write failed for "
-				    "recovery page %lu to %lu",
-				    __memp_fn(dbmfp), (u_long) bhp->pgno,
-				    (u_long) idx);
-				goto err;
-			}
+			recios[i].op = DB_IO_WRITE;
+			recios[i].fhp = dbmfp->recp;
+			recios[i].pgno = idx;
+			recios[i].pagesize = mfp->stat.st_pagesize;
+			bparray[i] = bhp->buf;
+			recios[i].bufs = &bparray[i];
+			recios[i].nobufs = 1;
+		}
+		if ((ret = __os_uring_io(dbenv, recios, numpages)) != 0) {
+			__db_err(dbenv,
+			    "%s: write failed for recovery pages of %lu-%lu",
+			    __memp_fn(dbmfp), (u_long)bhps[0]->pgno,
+			    (u_long)bhps[numpages - 1]->pgno);
+			goto err;
 		}
 	}
 
@@ -1020,6 +1150,7 @@ __memp_pgwrite_multi(dbenv, dbmfp, hps, bhps, numpages, wrrec)
 		__os_fsync(dbenv, dbmfp->fhp);
 
 	mfp->file_written = 1;
+	mfp->write_gen++;
 	mfp->stat.st_page_out += numpages;
 	mfp->stat.st_rw_merges += numpages - 1;
 
@@ -1092,6 +1223,8 @@ file_dead:
 	__os_free(dbenv, callpgin);
 	__os_free(dbenv, reclk);
 	__os_free(dbenv, bparray);
+	if (recios != NULL)
+		__os_free(dbenv, recios);
 
 	return (ret);
 }
@@ -0,0 +1,414 @@
+/*
+ * Batched page I/O through io_uring.
+ *
+ * Each thread that asks for batched I/O gets its own ring, so submission
+ * and completion need no locking.  The rings are created lazily and torn
+ * down when the thread exits.  If the kernel doesn't support io_uring (or
+ * it is disabled by seccomp, as in many containers) we note that once and
+ * every request goes through the ordinary __os_io/__os_iov path instead.
+ * Requests that fail or come back short are also retried on that path, so
+ * callers see the same results, errors and retries they always did.
+ */
+
+#include "db_config.h"
+
+#ifndef NO_SYSTEM_INCLUDES
+#include <sys/types.h>
+#include <sys/uio.h>
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+#endif /* NO_SYSTEM_INCLUDES */
+
+#include "db_int.h"
+#include "logmsg.h"
+#include "locks_wrap.h"
+
+/* Older kernels and libcs have neither the syscall nor the header. */
+#if defined(__linux__) && defined(__NR_io_uring_setup)
+#if defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define HAVE_IO_URING 1
+#endif
+#else
+#define HAVE_IO_URING 1
+#endif
+#endif
+
+#ifdef HAVE_IO_URING
+#include <linux/io_uring.h>
+#endif
+
+#ifdef HAVE_IO_URING
+
+struct uring {
+	int fd;
+	unsigned entries;
+
+	unsigned *sq_head;
+	unsigned *sq_tail;
+	unsigned *sq_mask;
+	unsigned *sq_array;
+	struct io_uring_sqe *sqes;
+
+	unsigned *cq_head;
+	unsigned *cq_tail;
+	unsigned *cq_mask;
+	struct io_uring_cqe *cqes;
+
+	void *sq_ptr;
+	size_t sq_len;
+	void *cq_ptr;
+	size_t cq_len;
+	size_t sqes_len;
+};
+
+static pthread_key_t uring_key;
+static pthread_once_t uring_once = PTHREAD_ONCE_INIT;
+static int uring_unavailable;
+
+static void
+uring_close(struct uring *r)
+{
+	if (r->sqes != NULL && r->sqes != MAP_FAILED)
+		munmap(r->sqes, r->sqes_len);
+	if (r->cq_ptr != NULL && r->cq_ptr != MAP_FAILED &&
+	    r->cq_ptr != r->sq_ptr)
+		munmap(r->cq_ptr, r->cq_len);
+	if (r->sq_ptr != NULL && r->sq_ptr != MAP_FAILED)
+		munmap(r->sq_ptr, r->sq_len);
+	if (r->fd >= 0)
+		close(r->fd);
+	free(r);
+}
+
+static void
+uring_destroy(void *p)
+{
+	uring_close(p);
+}
+
+static void
+uring_init_once(void)
+{
+	Pthread_key_create(&uring_key, uring_destroy);
+}
+
+static struct uring *
+uring_open(unsigned entries)
+{
+	struct io_uring_params p;
+	struct uring *r;
+	u_int8_t *sq, *cq;
+
+	if ((r = calloc(1, sizeof(*r))) == NULL)
+		return (NULL);
+
+	memset(&p, 0, sizeof(p));
+	r->fd = (int)syscall(__NR_io_uring_setup, entries, &p);
+	if (r->fd < 0) {
+		free(r);
+		return (NULL);
+	}
+	r->entries = p.sq_entries;
+
+	r->sq_len = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+	r->cq_len = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+#ifdef IORING_FEAT_SINGLE_MMAP
+	if (p.features & IORING_FEAT_SINGLE_MMAP) {
+		if (r->cq_len > r->sq_len)
+			r->sq_len = r->cq_len;
+		r->cq_len = r->sq_len;
+	}
+#endif
+	r->sq_ptr = mmap(NULL, r->sq_len, PROT_READ | PROT_WRITE,
+	    MAP_SHARED | MAP_POPULATE, r->fd, IORING_OFF_SQ_RING);
+	if (r->sq_ptr == MAP_FAILED)
+		goto err;
+#ifdef IORING_FEAT_SINGLE_MMAP
+	if (p.features & IORING_FEAT_SINGLE_MMAP)
+		r->cq_ptr = r->sq_ptr;
+	else
+#endif
+	{
+		r->cq_ptr = mmap(NULL, r->cq_len, PROT_READ | PROT_WRITE,
+		    MAP_SHARED | MAP_POPULATE, r->fd, IORING_OFF_CQ_RING);
+		if (r->cq_ptr == MAP_FAILED)
+			goto err;
+	}
+	r->sqes_len = p.sq_entries * sizeof(struct io_uring_sqe);
+	r->sqes = mmap(NULL, r->sqes_len, PROT_READ | PROT_WRITE,
+	    MAP_SHARED | MAP_POPULATE, r->fd, IORING_OFF_SQES);
+	if (r->sqes == MAP_FAILED)
+		goto err;
+
+	sq = r->sq_ptr;
+	r->sq_head = (unsigned *)(sq + p.sq_off.head);
+	r->sq_tail = (unsigned *)(sq + p.sq_off.tail);
+	r->sq_mask = (unsigned *)(sq + p.sq_off.ring_mask);
+	r->sq_array = (unsigned *)(sq + p.sq_off.array);
+
+	cq = r->cq_ptr;
+	r->cq_head = (unsigned *)(cq + p.cq_off.head);
+	r->cq_tail = (unsigned *)(cq + p.cq_off.tail);
+	r->cq_mask = (unsigned *)(cq + p.cq_off.ring_mask);
+	r->cqes = (struct io_uring_cqe *)(cq + p.cq_off.cqes);
+
+	return (r);
+
+err:	uring_close(r);
+	return (NULL);
+}
+
+static struct uring *
+uring_get(DB_ENV *dbenv)
+{
+	struct uring *r;
+	int depth;
+
+	if (uring_unavailable)
+		return (NULL);
+
+	pthread_once(&uring_once, uring_init_once);
+	if ((r = pthread_getspecific(uring_key)) != NULL)
+		return (r);
+
+	depth = dbenv->attr.iouring_depth;
+	if (depth < 1)
+		depth = 1;
+	else if (depth > 4096)
+		depth = 4096;
+
+	if ((r = uring_open((unsigned)depth)) == NULL) {
+		int err = errno;
+
+		/*
+		 * The kernel won't give us a ring; there's no point in
+		 * asking again from every thread.
+		 */
+		if (err == ENOSYS || err == EPERM || err == EACCES) {
+			uring_unavailable = 1;
+			logmsg(LOGMSG_WARN,
+			    "io_uring unavailable (%s), using pread/pwrite\n",
+			    strerror(err));
+		}
+		return (NULL);
+	}
+	Pthread_setspecific(uring_key, r);
+	return (r);
+}
+
+/* Can this request go to the kernel as is? */
+static int
+uring_can_submit(DB_ENV *dbenv, DB_URING_IO *io)
+{
+	u_int32_t i;
+
+	COMPQUIET(dbenv, NULL);
+
+	if (io->op == DB_IO_READ && DB_GLOBAL(j_read) != NULL)
+		return (0);
+	if (io->op == DB_IO_WRITE && DB_GLOBAL(j_write) != NULL)
+		return (0);
+	if (io->nobufs > IOV_MAX)
+		return (0);
+	/* O_DIRECT needs aligned buffers; the sync path bounces them. */
+	if (F_ISSET(io->fhp, DB_FH_DIRECT)) {
+		for (i = 0; i < io->nobufs; ++i)
+			if (((uintptr_t)io->bufs[i] & 511) != 0)
+				return (0);
+	}
+	return (1);
+}
+
+/*
+ * Submit up to n requests starting at ios and wait for all of them.
+ * Returns how many were submitted; each one's nio is filled in, or left at
+ * -1 if it has to be redone synchronously.
+ */
+static int
+uring_submit_wait(DB_ENV *dbenv, struct uring *r, DB_URING_IO *ios, int n,
+    struct iovec *iov)
+{
+	struct io_uring_sqe *sqe;
+	struct io_uring_cqe *cqe;
+	DB_URING_IO *io;
+	unsigned head, start, tail, idx;
+	u_int32_t j;
+	int i, nsub, ndone, ret;
+
+	if ((unsigned)n > r->entries)
+		n = r->entries;
+
+	tail = *r->sq_tail;
+	for (i = 0, nsub = 0; i < n; ++i) {
+		io = &ios[i];
+		io->nio = (size_t)-1;
+		if (!uring_can_submit(dbenv, io)) {
+			/*
+			 * Stop at the first request we can't send so a
+			 * linked chain isn't reordered around it.
+			 */
+			if (nsub == 0)
+				return (0);
+			break;
+		}
+		for (j = 0; j < io->nobufs; ++j) {
+			iov[j].iov_base = io->bufs[j];
+			iov[j].iov_len = io->pagesize;
+		}
+
+		idx = tail & *r->sq_mask;
+		sqe = &r->sqes[idx];
+		memset(sqe, 0, sizeof(*sqe));
+		sqe->opcode = io->op == DB_IO_READ ?
+		    IORING_OP_READV : IORING_OP_WRITEV;
+		sqe->fd = io->fhp->fd;
+		sqe->off = (u_int64_t)io->pgno * io->pagesize;
+		sqe->addr = (u_int64_t)(uintptr_t)iov;
+		sqe->len = io->nobufs;
+		sqe->user_data = (u_int64_t)i;
+		if (io->link && i < n - 1)
+			sqe->flags |= IOSQE_IO_LINK;
+		r->sq_array[idx] = idx;
+
+		iov += io->nobufs;
+		++tail;
+		++nsub;
+	}
+	/* A chain can't end on a request we're not submitting. */
+	if (nsub > 0)
+		r->sqes[(tail - 1) & *r->sq_mask].flags &= ~IOSQE_IO_LINK;
+	start = *r->sq_tail;
+	__atomic_store_n(r->sq_tail, tail, __ATOMIC_RELEASE);
+
+	ndone = 0;
+	ret = (int)syscall(__NR_io_uring_enter, r->fd, nsub, nsub,
+	    IORING_ENTER_GETEVENTS, NULL, 0);
+	if (ret < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+		/*
+		 * Take back whatever the kernel didn't consume (we don't use
+		 * SQPOLL, so it only reads the ring inside io_uring_enter)
+		 * and send it down the synchronous path.
+		 */
+		__db_err(dbenv, "io_uring_enter: %s", strerror(errno));
+		head = __atomic_load_n(r->sq_head, __ATOMIC_ACQUIRE);
+		__atomic_store_n(r->sq_tail, head, __ATOMIC_RELEASE);
+		nsub = head - start;
+	}
+	while (ndone < nsub) {
+		head = *r->cq_head;
+		while (head != __atomic_load_n(r->cq_tail, __ATOMIC_ACQUIRE)) {
+			cqe = &r->cqes[head & *r->cq_mask];
+			io = &ios[cqe->user_data];
+			io->nio = cqe->res < 0 ? (size_t)-1 : (size_t)cqe->res;
+			++head;
+			++ndone;
+		}
+		__atomic_store_n(r->cq_head, head, __ATOMIC_RELEASE);
+		if (ndone == nsub)
+			break;
+		if (syscall(__NR_io_uring_enter, r->fd,
+		    tail - __atomic_load_n(r->sq_head, __ATOMIC_ACQUIRE), 1,
+		    IORING_ENTER_GETEVENTS, NULL, 0) < 0 &&
+		    errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+			/*
+			 * The kernel still owns our buffers and we can't
+			 * wait for it to give them back.
+			 */
+			logmsg(LOGMSG_FATAL, "io_uring_enter wait: %s\n",
+			    strerror(errno));
+			abort();
+		}
+	}
+	return (nsub);
+}
+
+#endif /* HAVE_IO_URING */
+
+static int
+uring_io_sync(DB_ENV *dbenv, DB_URING_IO *io)
+{
+	if (io->nobufs == 1)
+		return (__os_io(dbenv, io->op, io->fhp, io->pgno,
+		    io->pagesize, io->bufs[0], &io->nio));
+	return (__os_iov(dbenv, io->op, io->fhp, io->pgno, io->pagesize,
+	    io->bufs, io->nobufs, &io->nio));
+}
+
+/*
+ * __os_uring_io --
+ *	Perform a batch of page reads and writes.  With the iouring_enabled
+ *	attribute set, the whole batch is handed to the kernel at once and
+ *	waited for together; requests marked link don't start until the one
+ *	before them has finished.  Otherwise each request is done in turn
+ *	with __os_io/__os_iov.  Short or failed transfers are redone on the
+ *	synchronous path, and the first error from there is returned.
+ *
+ * PUBLIC: int __os_uring_io __P((DB_ENV *, DB_URING_IO *, int));
+ */
+int
+__os_uring_io(dbenv, ios, nios)
+	DB_ENV *dbenv;
+	DB_URING_IO *ios;
+	int nios;
+{
+	DB_URING_IO *io;
+	int i, ret, t_ret;
+#ifdef HAVE_IO_URING
+	struct uring *r;
+	struct iovec *iov;
+	size_t want;
+	u_int32_t niov;
+	int nsub;
+#endif
+
+	ret = 0;
+	i = 0;
+
+#ifdef HAVE_IO_URING
+	if (dbenv->attr.iouring_enabled && nios > 1 &&
+	    (r = uring_get(dbenv)) != NULL) {
+		for (niov = 0, i = 0; i < nios; ++i)
+			niov += ios[i].nobufs;
+		if ((iov = malloc(niov * sizeof(struct iovec))) == NULL)
+			goto sync;
+
+		for (i = 0; i < nios;) {
+			if (ios[i].op == DB_IO_WRITE)
+				__checkpoint_verify(dbenv);
+			if ((nsub = uring_submit_wait(dbenv, r, &ios[i],
+			    nios - i, iov)) == 0)
+				break;
+			for (; nsub > 0; --nsub, ++i) {
+				io = &ios[i];
+				want = io->pagesize * io->nobufs;
+				/*
+				 * A short read is how a missing page looks;
+				 * let __os_io report it the usual way.
+				 */
+				if (io->nio != want &&
+				    (t_ret = uring_io_sync(dbenv, io)) != 0 &&
+				    ret == 0)
+					ret = t_ret;
+			}
+		}
+		free(iov);
+	}
+sync:
+#endif
+	for (; i < nios; ++i) {
+		io = &ios[i];
+		if ((t_ret = uring_io_sync(dbenv, io)) != 0 && ret == 0)
+			ret = t_ret;
+	}
+	return (ret);
+}
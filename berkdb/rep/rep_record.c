@@ -3836,17 +3836,89 @@ size_t __dbenv_get_log_header_size(DB_ENV* dbenv)
 // TODO(NC): rename it to lockerid
 u_int32_t gbl_rep_lockid;
 
+/*
+ * Apply one record of a transaction being processed by rp.  Records that
+ * weren't cached are read through *logcp, which is opened on first use.
+ */
+static void
+__rep_apply_recovery_record(dbenv, rp, rr, logcp, tmpdbt)
+	DB_ENV *dbenv;
+	struct __recovery_processor *rp;
+	struct __recovery_record *rr;
+	DB_LOGC **logcp;
+	DBT *tmpdbt;
+{
+	DBT *dbt;
+	u_int32_t rectype;
+	int rc;
+
+	if (rr->logdbt.data == NULL) {
+		if (*logcp == NULL) {
+			if (__log_cursor(dbenv, logcp)) {
+				__db_err(dbenv,
+					"worker can't get log cursor while processing %u:%u\n",
+					rr->lsn.file, rr->lsn.offset);
+				abort();
+			}
+			bzero(tmpdbt, sizeof(DBT));
+			tmpdbt->flags = DB_DBT_REALLOC;
+		}
+		if ((rc = __log_c_get(*logcp, &rr->lsn, tmpdbt, DB_SET))) {
+			__db_err(dbenv, "worker can't get lsn %u:%u\n",
+				rr->lsn.file, rr->lsn.offset);
+			abort();
+		}
+		dbt = tmpdbt;
+	} else
+		dbt = &rr->logdbt;
+
+	LOGCOPY_32(&rectype, dbt->data);
+
+	/* Map the txnid to the context */
+	dbt->app_data = &rp->context;
+	if (dispatch_rectype(rectype)) {
+		rc = __db_dispatch(dbenv, dbenv->recover_dtab,
+			dbenv->recover_dtab_size, dbt, &rr->lsn,
+			DB_TXN_APPLY, rp->txninfo);
+	} else
+		rc = 0;
+
+	/* TODO: what do I do on an error? */
+	if (rc) {
+		__db_err(dbenv, "transaction failed at %lu:%lu rc=%d",
+			(u_long)rr->lsn.file, (u_long)rr->lsn.offset, rc);
+		/* and now? */
+		abort();
+	}
+}
+
+static void
+__rep_close_recovery_cursor(dbenv, logc, tmpdbt)
+	DB_ENV *dbenv;
+	DB_LOGC *logc;
+	DBT *tmpdbt;
+{
+	int rc;
+
+	if (logc) {
+		if (tmpdbt->data)
+			free(tmpdbt->data);
+		if ((rc = __log_c_close(logc))) {
+			__db_err(dbenv, "__log_c_close rc %d\n", rc);
+			abort();
+		}
+	}
+}
+
 static void
 worker_thd(struct thdpool *pool, void *work, void *thddata, int op)
 {
 	struct __recovery_processor *rp;
 	struct __recovery_queue *rq;
 	struct __recovery_record *rr;
-	int rc;
 	DB_ENV *dbenv;
 	DB_LOGC *logc = NULL;
 	DBT tmpdbt;
-	u_int32_t rectype;
 	int recnum = 0;
 	LISTC_T(struct recovery_record) q;
 
@@ -3863,53 +3935,7 @@ worker_thd(struct thdpool *pool, void *work, void *thddata, int op)
 
 	while (rr) {
 		recnum++;
-		if (rr->logdbt.data == NULL) {
-			if (logc == NULL) {
-				if (__log_cursor(dbenv, &logc)) {
-					__db_err(dbenv,
-						"worker can't get log cursor while processing %u:%u\n",
-						rr->lsn.file, rr->lsn.offset);
-					abort();
-				}
-				bzero(&tmpdbt, sizeof(DBT));
-				tmpdbt.flags = DB_DBT_REALLOC;
-			}
-			if ((rc = __log_c_get(logc, &rr->lsn, &tmpdbt, DB_SET))) {
-				__db_err(dbenv, "worker can't get lsn %u:%u\n",
-					rr->lsn.file, rr->lsn.offset);
-				abort();
-			}
-			LOGCOPY_32(&rectype, tmpdbt.data);
-			tmpdbt.app_data = &rp->context;
-
-			/* Map the txnid to the context */
-			if (dispatch_rectype(rectype)) {
-				rc = __db_dispatch(dbenv, dbenv->recover_dtab,
-					dbenv->recover_dtab_size, &tmpdbt, &rr->lsn,
-					DB_TXN_APPLY, rq->processor->txninfo);
-			} else
-				rc = 0;
-		} else {
-
-			LOGCOPY_32(&rectype, rr->logdbt.data);
-
-			rr->logdbt.app_data = &rp->context;
-			if (dispatch_rectype(rectype)) {
-				rc = __db_dispatch(dbenv, dbenv->recover_dtab,
-					dbenv->recover_dtab_size, &rr->logdbt,
-					&rr->lsn, DB_TXN_APPLY,
-					rq->processor->txninfo);
-			} else
-				rc = 0;
-		}
-
-		/* TODO: what do I do on an error? */
-		if (rc) {
-			__db_err(dbenv, "transaction failed at %lu:%lu rc=%d",
-				(u_long)rr->lsn.file, (u_long)rr->lsn.offset, rc);
-			/* and now? */
-			abort();
-		}
+		__rep_apply_recovery_record(dbenv, rp, rr, &logc, &tmpdbt);
 
 		/* mempool? */
 		listc_abl(&q, rr);
@@ -3917,14 +3943,7 @@ worker_thd(struct thdpool *pool, void *work, void *thddata, int op)
 		rr = listc_rtl(&rq->records);
 	}
 
-	if (logc) {
-		if (tmpdbt.data)
-			free(tmpdbt.data);
-		if ((rc = __log_c_close(logc))) {
-			__db_err(dbenv, "__log_c_close rc %d\n", rc);
-			abort();
-		}
-	}
+	__rep_close_recovery_cursor(dbenv, logc, &tmpdbt);
 
 	Pthread_mutex_lock(&rq->processor->lk);
 	rr = listc_rtl(&q);
@@ -3941,6 +3960,340 @@ worker_thd(struct thdpool *pool, void *work, void *thddata, int op)
 	Pthread_mutex_unlock(&rq->processor->lk);
 }
 
+/*
+ * Page-level apply.  Every record of a large transaction becomes a node in a
+ * dependency graph as the processor reads it: the record waits for the
+ * previous record that touched each of its pages, so records on disjoint
+ * pages go to different workers while records on the same page keep their
+ * log order.  Records that aren't confined to known pages are barriers:
+ * they wait for everything before them, and everything after waits for
+ * them.  The processor still commits only after the whole graph is applied,
+ * so commit order is unchanged.
+ *
+ * Unlike the per-file queues, this runs records of one file concurrently.
+ * That is safe because pages_for_recovery_record only lists records whose
+ * redo touches nothing of the file but the pages it returns: allocations,
+ * frees and root changes list the meta page, so free-list and root updates
+ * stay in log order, and the shared handle state they reach (the dbreg
+ * table, the mpool file and its last_pgno) is already latched for the
+ * workers that apply different files in parallel.  Everything else --
+ * dbreg registration, file ops, cursor adjustments, logical records without
+ * a preceding physical record -- is a barrier, which orders it against
+ * every record of every file, a stronger edge than per-file order.
+ */
+struct __rep_pgdep_node {
+	struct __recovery_record *rr;
+	int npreds;		/* Predecessors not yet applied. */
+	int succ;		/* First outgoing edge, or -1. */
+};
+
+struct __rep_pgdep_edge {
+	int to;
+	int next;
+};
+
+struct __rep_pgdep_slot {
+	u_int64_t key;		/* fileid << 32 | pgno */
+	u_int32_t gen;		/* Slot is live if this is pd->gen. */
+	int last;		/* Last record that touched the page. */
+};
+
+struct __rep_pgdep {
+	struct __rep_pgdep_node *nodes;
+	int nnodes, maxnodes;
+	struct __rep_pgdep_edge *edges;
+	int nedges, maxedges;
+	struct __rep_pgdep_slot *slots;
+	u_int32_t nslots;	/* Power of two. */
+	u_int32_t nused;
+	u_int32_t gen;
+	int *ready;
+	int rhead, rtail;
+	int applied;
+	int barrier;		/* Last barrier record, or -1. */
+	int lastfileid;		/* Pages of the last physical record. */
+	int nlastpg;
+	db_pgno_t lastpg[RECOVERY_RECORD_MAXPAGES];
+	pthread_cond_t cond;	/* Records became ready; uses rp->lk. */
+};
+
+int64_t gbl_rep_trans_pgdep = 0;
+
+static inline int logical_start_commit(int rectype);
+static inline int logical_record_file_affinity(int rectype);
+
+static struct __rep_pgdep_slot *
+__rep_pgdep_slot(pd, key)
+	struct __rep_pgdep *pd;
+	u_int64_t key;
+{
+	struct __rep_pgdep_slot *slots, *sl;
+	u_int32_t i, n, h;
+
+	if ((pd->nused + 1) * 2 > pd->nslots) {
+		slots = pd->slots;
+		n = pd->nslots;
+		pd->nslots = n ? n * 2 : 1024;
+		pd->slots = calloc(pd->nslots, sizeof(*pd->slots));
+		if (pd->slots == NULL)
+			abort();
+		pd->nused = 0;
+		for (i = 0; i < n; i++) {
+			if (slots[i].gen != pd->gen)
+				continue;
+			sl = __rep_pgdep_slot(pd, slots[i].key);
+			sl->last = slots[i].last;
+		}
+		free(slots);
+	}
+
+	h = (u_int32_t)((key * 0x9E3779B97F4A7C15ULL) >> 32);
+	for (i = h & (pd->nslots - 1);; i = (i + 1) & (pd->nslots - 1)) {
+		sl = &pd->slots[i];
+		if (sl->gen != pd->gen) {
+			sl->key = key;
+			sl->gen = pd->gen;
+			sl->last = -1;
+			pd->nused++;
+			return sl;
+		}
+		if (sl->key == key)
+			return sl;
+	}
+}
+
+static void
+__rep_pgdep_edge(pd, from, to)
+	struct __rep_pgdep *pd;
+	int from, to;
+{
+	if (pd->nedges == pd->maxedges) {
+		pd->maxedges = pd->maxedges ? pd->maxedges * 2 : 4096;
+		pd->edges = realloc(pd->edges,
+		    pd->maxedges * sizeof(*pd->edges));
+		if (pd->edges == NULL)
+			abort();
+	}
+	pd->edges[pd->nedges].to = to;
+	pd->edges[pd->nedges].next = pd->nodes[from].succ;
+	pd->nodes[from].succ = pd->nedges++;
+	pd->nodes[to].npreds++;
+}
+
+static void
+__rep_pgdep_reset(rp, nrecs)
+	struct __recovery_processor *rp;
+	int nrecs;
+{
+	struct __rep_pgdep *pd;
+
+	if ((pd = rp->pgdep) == NULL) {
+		if ((pd = calloc(1, sizeof(*pd))) == NULL)
+			abort();
+		Pthread_cond_init(&pd->cond, NULL);
+		rp->pgdep = pd;
+	}
+	if (nrecs > pd->maxnodes) {
+		pd->maxnodes = nrecs;
+		free(pd->nodes);
+		free(pd->ready);
+		pd->nodes = malloc(nrecs * sizeof(*pd->nodes));
+		pd->ready = malloc(nrecs * sizeof(*pd->ready));
+		if (pd->nodes == NULL || pd->ready == NULL)
+			abort();
+	}
+	pd->nnodes = pd->nedges = 0;
+	pd->rhead = pd->rtail = pd->applied = 0;
+	pd->barrier = -1;
+	pd->nlastpg = 0;
+	/* Start with no live slots. */
+	if (++pd->gen == 0) {
+		if (pd->slots)
+			memset(pd->slots, 0, pd->nslots * sizeof(*pd->slots));
+		pd->gen = 1;
+	}
+	pd->nused = 0;
+}
+
+/* Add the next record of the transaction to the graph. */
+static void
+__rep_pgdep_add(rp, rr, rectype, fileid, dbt)
+	struct __recovery_processor *rp;
+	struct __recovery_record *rr;
+	u_int32_t rectype;
+	int fileid;
+	DBT *dbt;
+{
+	struct __rep_pgdep *pd;
+	struct __rep_pgdep_slot *sl;
+	db_pgno_t pgnos[RECOVERY_RECORD_MAXPAGES];
+	int preds[RECOVERY_RECORD_MAXPAGES];
+	int i, j, n, npgs, npreds;
+
+	pd = rp->pgdep;
+	n = pd->nnodes++;
+	pd->nodes[n].rr = rr;
+	pd->nodes[n].npreds = 0;
+	pd->nodes[n].succ = -1;
+
+	npgs = logical_start_commit(rectype) ? -1 :
+	    pages_for_recovery_record(rectype, dbt, pgnos);
+	if (npgs > 0) {
+		pd->lastfileid = fileid;
+		pd->nlastpg = npgs;
+		memcpy(pd->lastpg, pgnos, npgs * sizeof(db_pgno_t));
+	} else if (npgs < 0 && pd->nlastpg > 0 &&
+	    logical_record_file_affinity(rectype)) {
+		/* Logical follows physical: order it with those pages. */
+		fileid = pd->lastfileid;
+		npgs = pd->nlastpg;
+		memcpy(pgnos, pd->lastpg, npgs * sizeof(db_pgno_t));
+	}
+
+	if (npgs < 0) {
+		/*
+		 * Wait for everything since the last barrier, and for the last
+		 * barrier itself: when it is the previous record the loop
+		 * below adds nothing.
+		 */
+		if (pd->barrier >= 0)
+			__rep_pgdep_edge(pd, pd->barrier, n);
+		for (i = pd->barrier + 1; i < n; i++)
+			__rep_pgdep_edge(pd, i, n);
+		pd->barrier = n;
+		pd->nlastpg = 0;
+		if (++pd->gen == 0) {
+			if (pd->slots)
+				memset(pd->slots, 0,
+				    pd->nslots * sizeof(*pd->slots));
+			pd->gen = 1;
+		}
+		pd->nused = 0;
+		return;
+	}
+
+	for (i = npreds = 0; i < npgs; i++) {
+		sl = __rep_pgdep_slot(pd,
+		    ((u_int64_t)(u_int32_t)fileid << 32) | pgnos[i]);
+		if (sl->last >= 0) {
+			for (j = 0; j < npreds && preds[j] != sl->last; j++)
+				;
+			if (j == npreds)
+				preds[npreds++] = sl->last;
+		}
+		sl->last = n;
+	}
+	for (i = 0; i < npreds; i++)
+		__rep_pgdep_edge(pd, preds[i], n);
+
+	/* Anything with a predecessor already follows the barrier. */
+	if (npreds == 0 && pd->barrier >= 0)
+		__rep_pgdep_edge(pd, pd->barrier, n);
+}
+
+/* Apply ready records until the whole graph is applied. */
+static void
+__rep_pgdep_work(rp)
+	struct __recovery_processor *rp;
+{
+	struct __rep_pgdep *pd;
+	DB_ENV *dbenv;
+	DB_LOGC *logc = NULL;
+	DBT tmpdbt;
+	int e, n, to, woke;
+
+	pd = rp->pgdep;
+	dbenv = rp->dbenv;
+
+	Pthread_mutex_lock(&rp->lk);
+	for (;;) {
+		while (pd->rhead == pd->rtail && pd->applied < pd->nnodes)
+			Pthread_cond_wait(&pd->cond, &rp->lk);
+		if (pd->applied == pd->nnodes)
+			break;
+		n = pd->ready[pd->rhead++];
+		Pthread_mutex_unlock(&rp->lk);
+
+		__rep_apply_recovery_record(dbenv, rp, pd->nodes[n].rr,
+		    &logc, &tmpdbt);
+
+		Pthread_mutex_lock(&rp->lk);
+		pd->applied++;
+		for (woke = 0, e = pd->nodes[n].succ; e != -1;
+		    e = pd->edges[e].next) {
+			to = pd->edges[e].to;
+			if (--pd->nodes[to].npreds == 0) {
+				pd->ready[pd->rtail++] = to;
+				woke++;
+			}
+		}
+		if (pd->applied == pd->nnodes || woke > 1)
+			Pthread_cond_broadcast(&pd->cond);
+		else if (woke)
+			Pthread_cond_signal(&pd->cond);
+	}
+	Pthread_mutex_unlock(&rp->lk);
+
+	__rep_close_recovery_cursor(dbenv, logc, &tmpdbt);
+}
+
+static void
+__rep_pgdep_worker_thd(struct thdpool *pool, void *work, void *thddata, int op)
+{
+	struct __recovery_processor *rp;
+
+	rp = (struct __recovery_processor *)work;
+	__rep_pgdep_work(rp);
+
+	Pthread_mutex_lock(&rp->lk);
+	rp->num_busy_workers--;
+	Pthread_cond_signal(&rp->wait);
+	Pthread_mutex_unlock(&rp->lk);
+}
+
+/*
+ * Apply the graph built by __rep_pgdep_add with up to rep_pgdep_workers
+ * threads, the processor being one of them.
+ */
+static void
+__rep_pgdep_apply(rp)
+	struct __recovery_processor *rp;
+{
+	struct __rep_pgdep *pd;
+	DB_ENV *dbenv;
+	int i, nhelpers;
+
+	pd = rp->pgdep;
+	dbenv = rp->dbenv;
+
+	for (i = 0; i < pd->nnodes; i++) {
+		if (pd->nodes[i].npreds == 0)
+			pd->ready[pd->rtail++] = i;
+	}
+
+	nhelpers = dbenv->attr.rep_pgdep_workers - 1;
+	if (nhelpers > pd->nnodes - 1)
+		nhelpers = pd->nnodes - 1;
+	if (nhelpers < 0)
+		nhelpers = 0;
+
+	rp->num_busy_workers = nhelpers;
+	for (i = 0; i < nhelpers; i++)
+		thdpool_enqueue(dbenv->recovery_workers,
+		    __rep_pgdep_worker_thd, rp, 0, NULL, 0);
+
+	__rep_pgdep_work(rp);
+
+	Pthread_mutex_lock(&rp->lk);
+	while (rp->num_busy_workers)
+		Pthread_cond_wait(&rp->wait, &rp->lk);
+	for (i = 0; i < pd->nnodes; i++)
+		pool_relablk(rp->recpool, pd->nodes[i].rr);
+	Pthread_mutex_unlock(&rp->lk);
+
+	gbl_rep_trans_pgdep++;
+}
+
 /* note: must be called under the dbenv->recover_lk lock */
 void
 in_order_commit_check(DB_LSN *lsn)
@@ -4010,6 +4363,8 @@ processor_thd(struct thdpool *pool, void *work, void *thddata, int op)
 	DB_LOCK prev_lsn_lk;
 	int i;
 	int inline_worker;
+	int use_pgdep;
+	DBT *recdbt;
 	int polltm;
 	DB_LOGC *logc = NULL;
 	DB_ENV *dbenv;
@@ -4100,9 +4455,17 @@ processor_thd(struct thdpool *pool, void *work, void *thddata, int op)
 	if ((ret = __log_cursor(dbenv, &logc)) != 0)
 		goto err;
 
-	/* First, bucket records per queue. */
+	/*
+	 * First, bucket records per queue, or per page for large
+	 * transactions.
+	 */
 	data_dbt.flags = DB_DBT_REALLOC;
 
+	use_pgdep = dbenv->attr.rep_pgdep_apply &&
+	    rp->lc.nlsns >= dbenv->attr.rep_pgdep_min_records;
+	if (use_pgdep)
+		__rep_pgdep_reset(rp, rp->lc.nlsns);
+
 	for (i = 0; i < rp->lc.nlsns; i++) {
 		int fileid;
 		u_int32_t rectype;
@@ -4119,15 +4482,24 @@ processor_thd(struct thdpool *pool, void *work, void *thddata, int op)
 					(u_long)lsnp->file, (u_long)lsnp->offset);
 				goto err;
 			}
-			LOGCOPY_32(&rectype, data_dbt.data);
-			fileid =
-				(int)file_id_for_recovery_record(dbenv, NULL,
-				rectype, &data_dbt);
-		} else {
-			LOGCOPY_32(&rectype, rp->lc.array[i].rec.data);
-			fileid =
-				(int)file_id_for_recovery_record(dbenv, NULL,
-				rectype, &rp->lc.array[i].rec);
+			recdbt = &data_dbt;
+		} else
+			recdbt = &rp->lc.array[i].rec;
+
+		LOGCOPY_32(&rectype, recdbt->data);
+		fileid = (int)file_id_for_recovery_record(dbenv, NULL,
+			rectype, recdbt);
+
+		if (use_pgdep) {
+			rr = pool_getablk(rp->recpool);
+			if (rp->lc.array[i].rec.data)
+				rr->logdbt = rp->lc.array[i].rec;
+			else
+				rr->logdbt.data = NULL;
+			rr->lsn = *lsnp;
+			rr->fileid = fileid;
+			__rep_pgdep_add(rp, rr, rectype, fileid, recdbt);
+			continue;
 		}
 
 		if (fileid >= 0) {
@@ -4178,6 +4550,11 @@ processor_thd(struct thdpool *pool, void *work, void *thddata, int op)
 		listc_abl(&rp->recovery_queues[fileid]->records, rr);
 	}
 
+	if (use_pgdep) {
+		__rep_pgdep_apply(rp);
+		goto applied;
+	}
+
 	if ((dbenv->flags & DB_ENV_ROWLOCKS) && listc_size(&queues) > 1) {
 		gbl_rep_rowlocks_multifile++;
 	}
@@ -4274,6 +4651,7 @@ processor_thd(struct thdpool *pool, void *work, void *thddata, int op)
 	}
 #endif
 
+applied:
 	/* TODO: when we're convinced that lsn_chain is overkill, nix it */
 	if (dbenv->lsn_chain) {
 		bzero(&lock_prev_lsn_dbt, sizeof(DBT));
@@ -34,12 +34,14 @@
 #include <limits.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
 
 #include "cdb2api.h"
 
 #include "sqlquery.pb-c.h"
 #include "sqlresponse.pb-c.h"
 #include <fcntl.h>
+#include <lz4.h>
 
 /*
 *******************************************************************************
@@ -161,6 +163,14 @@ static pthread_mutex_t cdb2_cfg_lock = PTHREAD_MUTEX_INITIALIZER;
 #define CDB2_ALLOW_PMUX_ROUTE_DEFAULT 0
 static int cdb2_allow_pmux_route = CDB2_ALLOW_PMUX_ROUTE_DEFAULT;
 
+#define CDB2_ROW_BLOCKS_DEFAULT 1
+static int cdb2_row_blocks = CDB2_ROW_BLOCKS_DEFAULT;
+
+/* Process-wide ROW_BLOCK counters, see cdb2_get_row_block_stats() */
+static long long cdb2_row_blocks_read;
+static long long cdb2_row_block_bytes_saved;
+static long long cdb2_row_block_decompress_us;
+
 static int _PID; /* ONE-TIME */
 static int _MACHINE_ID; /* ONE-TIME */
 static char *_ARGV0; /* ONE-TIME */
@@ -296,6 +306,7 @@ static void reset_the_configuration(void)
     cdb2_tcpbufsz = CDB2_TCPBUFSZ_DEFAULT;
 
     cdb2_allow_pmux_route = CDB2_ALLOW_PMUX_ROUTE_DEFAULT;
+    cdb2_row_blocks = CDB2_ROW_BLOCKS_DEFAULT;
     cdb2cfg_override = CDB2CFG_OVERRIDE_DEFAULT;
 
 #if WITH_SSL
@@ -1047,6 +1058,11 @@ struct cdb2_hndl {
     int protobuf_offset;
     int protobuf_used_sysmalloc;
     ProtobufCAllocator allocator;
+    // Inflated ROW_BLOCK response whose rows are being handed out
+    uint8_t *row_block;
+    int row_block_cap;
+    int row_block_len;
+    int row_block_off;
 };
 
 static void *cdb2_protobuf_alloc(void *allocator_data, size_t size)
@@ -1435,6 +1451,15 @@ static void read_comdb2db_cfg(cdb2_hndl_tp *hndl, SBUF2 *s,
                         cdb2_allow_pmux_route = 0;
                     }
                 }
+            } else if (strcasecmp("row_blocks", tok) == 0) {
+                tok = strtok_r(NULL, " :,", &last);
+                if (tok) {
+                    if (strncasecmp(tok, "true", 4) == 0) {
+                        cdb2_row_blocks = 1;
+                    } else {
+                        cdb2_row_blocks = 0;
+                    }
+                }
             } else if (strcasecmp("install_static_libs_v2", tok) == 0 ||
                        strcasecmp("enable_static_libs", tok) == 0) {
                 if (cdb2_install != NULL)
@@ -1715,7 +1740,67 @@ struct sockpool_msg_vers0 {
     char typestr[48];
 };
 
-enum { SOCKPOOL_DONATE = 0, SOCKPOOL_REQUEST = 1 };
+enum {
+    SOCKPOOL_DONATE = 0,
+    SOCKPOOL_REQUEST = 1,
+    SOCKPOOL_REQUEST_BATCH = 3
+};
+
+enum { SOCKPOOL_REQ_CLAIMED = 1 };
+
+#define SOCKPOOL_MAX_BATCH 32
+
+/* Mirrors the table cdb2sockpool advertises its pooled sockets in; see
+ * sockpool_p.h for the layout and rules. */
+#define SOCKPOOL_SHM_DIR_SUFFIX ".d"
+#define SOCKPOOL_SHM_NAME "/shm"
+#define SOCKPOOL_SHM_MAGIC 0x53504d31
+#define SOCKPOOL_SHM_SLOTS 1024
+#define SOCKPOOL_SHM_PROBES 16
+#define SOCKPOOL_SHM_TYPESTR 64
+#define SOCKPOOL_SHM_HEARTBEAT_SECS 5
+
+struct sockpool_shm_slot {
+    char typestr[SOCKPOOL_SHM_TYPESTR];
+    int inuse;
+    int idle;
+    int claimed;
+    int claim_time;
+};
+
+struct sockpool_shm {
+    unsigned magic;
+    unsigned nslots;
+    int heartbeat;
+    int overflow;
+    struct sockpool_shm_slot slots[SOCKPOOL_SHM_SLOTS];
+};
+
+static struct sockpool_shm *sockpool_shm = NULL;
+static ino_t sockpool_shm_ino;
+static time_t sockpool_shm_check_time;
+
+/* Sockets handed to us by a batch request beyond the one we asked for,
+ * kept for other threads of this process for a short while and then given
+ * back to sockpool. */
+#define SOCKPOOL_STASH_MAX 16
+#define SOCKPOOL_STASH_SECS 1
+#define SOCKPOOL_STASH_TTL 10 /* what newsql_disconnect donates with */
+
+struct sockpool_stash_ent {
+    char typestr[SOCKPOOL_SHM_TYPESTR];
+    int fd;
+    int dbnum;
+    time_t stash_time;
+};
+
+static struct sockpool_stash_ent sockpool_stash[SOCKPOOL_STASH_MAX];
+static int sockpool_stash_count = 0;
+static pid_t sockpool_stash_pid;
+
+/* Number of threads waiting on a sockpool reply.  More than one of them
+ * means it's worth asking for a batch. */
+static int sockpool_inflight = 0;
 
 static int open_sockpool_ll(void)
 {
@@ -1768,6 +1853,145 @@ static int open_sockpool_ll(void)
     return fd;
 }
 
+/* The sockpool mutex must be locked at this point */
+static struct sockpool_shm *sockpool_shm_get(void)
+{
+    struct sockpool_shm *shm = sockpool_shm;
+    time_t now = time(NULL);
+    char path[sizeof(((struct sockaddr_sun *)0)->sun_path) +
+              sizeof(SOCKPOOL_SHM_DIR_SUFFIX) + sizeof(SOCKPOOL_SHM_NAME)];
+    struct stat st;
+    void *p;
+    int fd;
+
+    if (shm && shm->magic == SOCKPOOL_SHM_MAGIC &&
+        now - shm->heartbeat <= SOCKPOOL_SHM_HEARTBEAT_SECS)
+        return shm;
+
+    /* Look for a (re)started server at most once a second. */
+    if (now == sockpool_shm_check_time)
+        return NULL;
+    sockpool_shm_check_time = now;
+
+    snprintf(path, sizeof(path), "%s%s%s",
+             SOCKPOOL_OTHER_NAME ? SOCKPOOL_OTHER_NAME : SOCKPOOL_SOCKET_NAME,
+             SOCKPOOL_SHM_DIR_SUFFIX, SOCKPOOL_SHM_NAME);
+    if ((fd = open(path, O_RDWR | O_NOFOLLOW)) == -1)
+        return NULL;
+    /* cdb2sockpool only makes it accessible to its own user */
+    if (fstat(fd, &st) == -1 || !S_ISREG(st.st_mode) ||
+        (st.st_mode & (S_IRWXG | S_IRWXO)) ||
+        st.st_size < sizeof(struct sockpool_shm) ||
+        (shm && st.st_ino == sockpool_shm_ino)) {
+        close(fd);
+        return NULL;
+    }
+    p = mmap(NULL, sizeof(struct sockpool_shm), PROT_READ | PROT_WRITE,
+             MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED)
+        return NULL;
+    shm = p;
+    if (shm->magic != SOCKPOOL_SHM_MAGIC || shm->nslots != SOCKPOOL_SHM_SLOTS ||
+        now - shm->heartbeat > SOCKPOOL_SHM_HEARTBEAT_SECS) {
+        munmap(p, sizeof(struct sockpool_shm));
+        return NULL;
+    }
+    /* Other threads may still be reading a previous server's table, so that
+     * one stays mapped. */
+    sockpool_shm = shm;
+    sockpool_shm_ino = st.st_ino;
+    return shm;
+}
+
+/* Returns the slot sockpool keeps for typestr, or NULL.  *known is set if
+ * the absence of a slot means sockpool holds nothing for typestr. */
+static struct sockpool_shm_slot *sockpool_shm_slot(struct sockpool_shm *shm,
+                                                   const char *typestr,
+                                                   int *known)
+{
+    struct sockpool_shm_slot *slot;
+    unsigned h = 2166136261u;
+    const char *c;
+    int i;
+
+    *known = 0;
+    if (strlen(typestr) >= SOCKPOOL_SHM_TYPESTR)
+        return NULL;
+    for (c = typestr; *c; c++)
+        h = (h ^ (unsigned char)*c) * 16777619u;
+    for (i = 0; i < SOCKPOOL_SHM_PROBES; i++) {
+        slot = &shm->slots[(h + i) % SOCKPOOL_SHM_SLOTS];
+        if (!slot->inuse)
+            break;
+        if (strncmp(slot->typestr, typestr, SOCKPOOL_SHM_TYPESTR) == 0)
+            return slot;
+    }
+    *known = !shm->overflow;
+    return NULL;
+}
+
+/* Claim up to want of the sockets sockpool advertises for this slot.
+ * Returns how many were claimed; 0 means sockpool has none to give. */
+static int sockpool_shm_claim(struct sockpool_shm_slot *slot, int want)
+{
+    int idle, claimed, n;
+    do {
+        claimed = slot->claimed;
+        idle = slot->idle;
+        n = idle - claimed;
+        if (n <= 0)
+            return 0;
+        if (n > want)
+            n = want;
+    } while (!__sync_bool_compare_and_swap(&slot->claimed, claimed,
+                                           claimed + n));
+    slot->claim_time = time(NULL);
+    return n;
+}
+
+/* The sockpool mutex must be locked at this point */
+static int sockpool_stash_take(const char *typestr)
+{
+    int i, fd;
+    for (i = 0; i < sockpool_stash_count; i++) {
+        if (strcmp(sockpool_stash[i].typestr, typestr) == 0) {
+            fd = sockpool_stash[i].fd;
+            sockpool_stash[i] = sockpool_stash[--sockpool_stash_count];
+            return fd;
+        }
+    }
+    return -1;
+}
+
+/* The sockpool mutex must be locked at this point.  Moves stashed sockets
+ * that nobody picked up into out, to be donated back once the mutex is
+ * released.  A forked child drops its copies of the parent's. */
+static int sockpool_stash_expire(struct sockpool_stash_ent *out)
+{
+    time_t now;
+    int i, n = 0;
+
+    if (sockpool_stash_count == 0)
+        return 0;
+    if (sockpool_stash_pid != getpid()) {
+        for (i = 0; i < sockpool_stash_count; i++)
+            close(sockpool_stash[i].fd);
+        sockpool_stash_count = 0;
+        return 0;
+    }
+    now = time(NULL);
+    for (i = 0; i < sockpool_stash_count;) {
+        if (now - sockpool_stash[i].stash_time >= SOCKPOOL_STASH_SECS) {
+            out[n++] = sockpool_stash[i];
+            sockpool_stash[i] = sockpool_stash[--sockpool_stash_count];
+        } else {
+            i++;
+        }
+    }
+    return n;
+}
+
 void cdb2_enable_sockpool()
 {
     pthread_mutex_lock(&cdb2_sockpool_mutex);
@@ -1872,32 +2096,69 @@ static void sockpool_remove_fd(int fd)
     }
 }
 
-// cdb2_socket_pool_get_ll: low-level
-static int cdb2_socket_pool_get_ll(const char *typestr, int dbnum, int *port)
+void cdb2_socket_pool_donate_ext(const char *typestr, int fd, int ttl,
+                                 int dbnum);
+
+static void sockpool_stash_donate(struct sockpool_stash_ent *ents, int n)
 {
-    int sockpool_fd = -1;
-    int enabled = 0;
-    int sp_generation = -1;
-    int fd = -1;
+    for (int i = 0; i < n; i++)
+        cdb2_socket_pool_donate_ext(ents[i].typestr, ents[i].fd,
+                                    SOCKPOOL_STASH_TTL, ents[i].dbnum);
+}
 
-    pthread_mutex_lock(&cdb2_sockpool_mutex);
-    if (sockpool_enabled == 0) {
-        time_t current_time = time(NULL);
-        /* Check every 10 seconds. */
-        if ((current_time - sockpool_fail_time) > 10) {
-            sockpool_enabled = 1;
+/* Read the replies to a batch request: one per socket, ending early with one
+ * that carries none.  The first socket goes to *pfd, the rest are stashed. */
+static int sockpool_recv_batch(int sockpool_fd, const char *typestr, int dbnum,
+                               int count, int *pfd)
+{
+    struct sockpool_msg_vers0 msg;
+    struct sockpool_stash_ent extra[SOCKPOOL_MAX_BATCH];
+    int i, fd, first = -1, nextra = 0;
+    int rc = PASSFD_SUCCESS;
+
+    for (i = 0; i < count; i++) {
+        fd = -1;
+        errno = 0;
+        rc = recv_fd(sockpool_fd, &msg, sizeof(msg), &fd);
+        if (rc != PASSFD_SUCCESS) {
+            fprintf(stderr, "%s: recv_fd rc %d errno %d %s\n", __func__, rc,
+                    errno, strerror(errno));
+            break;
         }
+        if (fd == -1)
+            break;
+        if (first == -1) {
+            first = fd;
+            continue;
+        }
+        strcpy(extra[nextra].typestr, typestr);
+        extra[nextra].fd = fd;
+        extra[nextra].dbnum = dbnum;
+        extra[nextra].stash_time = time(NULL);
+        nextra++;
     }
-    enabled = sockpool_enabled;
-    if (enabled == 1) {
-        sp_generation = sockpool_generation;
-        sockpool_fd = sockpool_get_from_pool();
-    }
+
+    pthread_mutex_lock(&cdb2_sockpool_mutex);
+    if (sockpool_stash_count == 0)
+        sockpool_stash_pid = getpid();
+    for (i = 0; i < nextra && sockpool_stash_count < SOCKPOOL_STASH_MAX; i++)
+        sockpool_stash[sockpool_stash_count++] = extra[i];
     pthread_mutex_unlock(&cdb2_sockpool_mutex);
+    sockpool_stash_donate(extra + i, nextra - i);
 
-    if (enabled != 1) {
-        return -1;
+    if (rc != PASSFD_SUCCESS && first != -1) {
+        close(first);
+        first = -1;
     }
+    *pfd = first;
+    return rc;
+}
+
+static int cdb2_socket_pool_request(const char *typestr, int dbnum, int *port,
+                                    int sockpool_fd, int sp_generation,
+                                    int count, int claimed)
+{
+    int fd = -1;
 
     if (sockpool_fd == -1) {
         sockpool_fd = open_sockpool_ll();
@@ -1928,7 +2189,9 @@ static int cdb2_socket_pool_get_ll(const char *typestr, int dbnum, int *port)
         return -1;
     }
     /* Please may I have a file descriptor */
-    msg.request = SOCKPOOL_REQUEST;
+    msg.request = count > 1 ? SOCKPOOL_REQUEST_BATCH : SOCKPOOL_REQUEST;
+    msg.padding[0] = claimed ? SOCKPOOL_REQ_CLAIMED : 0;
+    msg.padding[1] = count > 1 ? count : 0;
     msg.dbnum = dbnum;
     strncpy(msg.typestr, typestr, sizeof(msg.typestr) - 1);
 
@@ -1948,7 +2211,11 @@ static int cdb2_socket_pool_get_ll(const char *typestr, int dbnum, int *port)
     /* Read reply from server.  It can legitimately not send
      * us a file descriptor. */
     errno = 0;
-    rc = recv_fd(sockpool_fd, &msg, sizeof(msg), &fd);
+    if (count > 1) {
+        rc = sockpool_recv_batch(sockpool_fd, typestr, dbnum, count, &fd);
+    } else {
+        rc = recv_fd(sockpool_fd, &msg, sizeof(msg), &fd);
+    }
     if (rc != PASSFD_SUCCESS) {
         fprintf(stderr, "%s: recv_fd rc %d errno %d %s\n", __func__, rc, errno,
                 strerror(errno));
@@ -1982,6 +2249,74 @@ static int cdb2_socket_pool_get_ll(const char *typestr, int dbnum, int *port)
     return fd;
 }
 
+// cdb2_socket_pool_get_ll: low-level
+static int cdb2_socket_pool_get_ll(const char *typestr, int dbnum, int *port)
+{
+    int sockpool_fd = -1;
+    int enabled = 0;
+    int sp_generation = -1;
+    int fd = -1;
+    int count = 1, claimed = 0;
+    int nexpired = 0;
+    struct sockpool_stash_ent expired[SOCKPOOL_STASH_MAX];
+
+    pthread_mutex_lock(&cdb2_sockpool_mutex);
+    if (sockpool_enabled == 0) {
+        time_t current_time = time(NULL);
+        /* Check every 10 seconds. */
+        if ((current_time - sockpool_fail_time) > 10) {
+            sockpool_enabled = 1;
+        }
+    }
+    enabled = sockpool_enabled;
+    if (enabled == 1) {
+        nexpired = sockpool_stash_expire(expired);
+        fd = sockpool_stash_take(typestr);
+    }
+    if (enabled == 1 && fd == -1) {
+        /* Ask sockpool's shared memory before asking sockpool: if it has
+         * nothing for us there is no point in the round trip. */
+        struct sockpool_shm *shm = sockpool_shm_get();
+        if (shm) {
+            struct sockpool_shm_slot *slot = NULL;
+            int known = 0;
+            struct sockpool_msg_vers0 msg;
+            /* longer ones are never sent to sockpool */
+            if (strlen(typestr) < sizeof(msg.typestr))
+                slot = sockpool_shm_slot(shm, typestr, &known);
+            if (slot) {
+                count = sockpool_inflight + 1;
+                if (count > SOCKPOOL_MAX_BATCH)
+                    count = SOCKPOOL_MAX_BATCH;
+                count = sockpool_shm_claim(slot, count);
+                claimed = count > 0;
+            } else if (known) {
+                count = 0;
+            }
+        }
+        if (count > 0) {
+            sp_generation = sockpool_generation;
+            sockpool_fd = sockpool_get_from_pool();
+            sockpool_inflight++;
+        }
+    }
+    pthread_mutex_unlock(&cdb2_sockpool_mutex);
+
+    sockpool_stash_donate(expired, nexpired);
+
+    if (enabled != 1 || fd != -1 || count == 0) {
+        return fd;
+    }
+
+    fd = cdb2_socket_pool_request(typestr, dbnum, port, sockpool_fd,
+                                  sp_generation, count, claimed);
+
+    pthread_mutex_lock(&cdb2_sockpool_mutex);
+    sockpool_inflight--;
+    pthread_mutex_unlock(&cdb2_sockpool_mutex);
+    return fd;
+}
+
 /* Get the file descriptor of a socket matching the given type string from
  * the pool.  Returns -1 if none is available or the file descriptor on
  * success. */
@@ -2744,6 +3079,8 @@ static int cdb2_convert_error_code(int rc)
 
 static void clear_responses(cdb2_hndl_tp *hndl)
 {
+    hndl->row_block_len = hndl->row_block_off = 0;
+
     if (hndl->lastresponse) {
         if (hndl->protobuf_used_sysmalloc)
             cdb2__sqlresponse__free_unpacked(hndl->lastresponse,
@@ -2917,8 +3254,11 @@ static int cdb2_send_query(cdb2_hndl_tp *hndl, cdb2_hndl_tp *event_hndl,
     /* Request server to send back row data flat, instead of storing it in
        a nested data structure. This helps reduce server's memory footprint. */
     features[n_features++] = CDB2_CLIENT_FEATURES__FLAT_COL_VALS;
-
     if (hndl) { 
+        /* Let the server batch (and compress) rows into ROW_BLOCK responses.
+           Not for the comdb2db lookup, which reads rows one at a time. */
+        if (cdb2_row_blocks)
+            features[n_features++] = CDB2_CLIENT_FEATURES__ROW_BLOCKS;
         features[n_features++] = CDB2_CLIENT_FEATURES__ALLOW_MASTER_DBINFO;
         if ((hndl->flags & CDB2_DIRECT_CPU) ||
             (retries_done >= (hndl->num_hosts * 2 - 1) && hndl->master ==
@@ -3089,8 +3429,77 @@ static int retry_queries_and_skip(cdb2_hndl_tp *hndl, int num_retry,
         return (rcode);                                                        \
     } while (0)
 
+/* Inflate a ROW_BLOCK response into hndl->row_block. Rows are then handed
+   out by cdb2_next_block_row() as if they had been read off the socket. */
+static int cdb2_inflate_row_block(cdb2_hndl_tp *hndl, CDB2SQLRESPONSE *resp)
+{
+    if (!resp->has_row_block || !resp->has_row_block_rawlen ||
+        resp->row_block_rawlen < 0)
+        return -1;
+    int rawlen = resp->row_block_rawlen;
+    if (hndl->row_block_cap < rawlen) {
+        uint8_t *blk = realloc(hndl->row_block, rawlen);
+        if (blk == NULL)
+            return -1;
+        hndl->row_block = blk;
+        hndl->row_block_cap = rawlen;
+    }
+    if (resp->has_row_block_codec &&
+        resp->row_block_codec == CDB2_ROW_BLOCK_CODEC__ROW_BLOCK_LZ4) {
+        struct timeval start, end;
+        gettimeofday(&start, NULL);
+        int rc = LZ4_decompress_safe((const char *)resp->row_block.data,
+                                     (char *)hndl->row_block,
+                                     resp->row_block.len, rawlen);
+        gettimeofday(&end, NULL);
+        if (rc != rawlen)
+            return -1;
+        __sync_add_and_fetch(&cdb2_row_block_decompress_us,
+                             (end.tv_sec - start.tv_sec) * 1000000LL +
+                                 (end.tv_usec - start.tv_usec));
+        __sync_add_and_fetch(&cdb2_row_block_bytes_saved,
+                             rawlen - (long long)resp->row_block.len);
+    } else {
+        if (resp->row_block.len != rawlen)
+            return -1;
+        memcpy(hndl->row_block, resp->row_block.data, rawlen);
+    }
+    __sync_add_and_fetch(&cdb2_row_blocks_read, 1);
+    hndl->row_block_len = rawlen;
+    hndl->row_block_off = 0;
+    return 0;
+}
+
+static int cdb2_next_block_row(cdb2_hndl_tp *hndl, uint8_t **buf, int *len)
+{
+    uint32_t rowlen;
+    if (hndl->row_block_len - hndl->row_block_off < (int)sizeof(rowlen))
+        return -1;
+    memcpy(&rowlen, hndl->row_block + hndl->row_block_off, sizeof(rowlen));
+    rowlen = ntohl(rowlen);
+    hndl->row_block_off += sizeof(rowlen);
+    if (rowlen > (uint32_t)(hndl->row_block_len - hndl->row_block_off))
+        return -1;
+    *buf = hndl->row_block + hndl->row_block_off;
+    *len = rowlen;
+    hndl->row_block_off += rowlen;
+    return 0;
+}
+
+void cdb2_get_row_block_stats(long long *blocks, long long *bytes_saved,
+                              long long *decompress_us)
+{
+    if (blocks)
+        *blocks = __sync_add_and_fetch(&cdb2_row_blocks_read, 0);
+    if (bytes_saved)
+        *bytes_saved = __sync_add_and_fetch(&cdb2_row_block_bytes_saved, 0);
+    if (decompress_us)
+        *decompress_us = __sync_add_and_fetch(&cdb2_row_block_decompress_us, 0);
+}
+
 static int cdb2_next_record_int(cdb2_hndl_tp *hndl, int shouldretry)
 {
+    uint8_t *buf;
     int len;
     int rc;
     int num_retry = 0;
@@ -3121,12 +3530,25 @@ retry_next_record:
         }
     }
 
+    if (hndl->row_block_off < hndl->row_block_len) {
+        if (cdb2_next_block_row(hndl, &buf, &len)) {
+            newsql_disconnect(hndl, hndl->sb, __LINE__);
+            sprintf(hndl->errstr, "%s: Malformed row block from server",
+                    __func__);
+            PRINT_AND_RETURN_OK(-1);
+        }
+        goto unpack;
+    }
+
     rc = cdb2_read_record(hndl, &hndl->last_buf, &len, NULL);
     if (rc) {
         newsql_disconnect(hndl, hndl->sb, __LINE__);
         sprintf(hndl->errstr, "%s: Timeout while reading response from server",
                 __func__);
     retry:
+        /* The server skips the rows we have returned, which does not include
+           whatever is left of the current row block. */
+        hndl->row_block_len = hndl->row_block_off = 0;
         debugprint("retry: shouldretry=%d, snapshot_file=%d, num_retry=%d\n",
                    shouldretry, hndl->snapshot_file, num_retry);
         if (shouldretry && hndl->snapshot_file && num_retry < hndl->max_retries) {
@@ -3161,7 +3583,9 @@ retry_next_record:
         sprintf(hndl->errstr, "%s: No response from server", __func__);
         PRINT_AND_RETURN_OK(-1);
     }
+    buf = hndl->last_buf;
 
+unpack:
     /* free previous response */
     if (hndl->lastresponse) {
         if (hndl->protobuf_used_sysmalloc)
@@ -3170,11 +3594,20 @@ retry_next_record:
         hndl->protobuf_offset = 0;
     }
 
-    hndl->lastresponse =
-        cdb2__sqlresponse__unpack(&hndl->allocator, len, hndl->last_buf);
+    hndl->lastresponse = cdb2__sqlresponse__unpack(&hndl->allocator, len, buf);
     debugprint("hndl->lastresponse->response_type=%d\n",
                hndl->lastresponse->response_type);
 
+    if (hndl->lastresponse->response_type == RESPONSE_TYPE__ROW_BLOCK) {
+        if (cdb2_inflate_row_block(hndl, hndl->lastresponse)) {
+            newsql_disconnect(hndl, hndl->sb, __LINE__);
+            sprintf(hndl->errstr, "%s: Malformed row block from server",
+                    __func__);
+            PRINT_AND_RETURN_OK(-1);
+        }
+        goto retry_next_record;
+    }
+
     if (hndl->lastresponse->snapshot_info &&
         hndl->lastresponse->snapshot_info->file) {
         hndl->snapshot_file = hndl->lastresponse->snapshot_info->file;
@@ -3420,6 +3853,7 @@ int cdb2_close(cdb2_hndl_tp *hndl)
 
     if (hndl->protobuf_data)
         free(hndl->protobuf_data);
+    free(hndl->row_block);
 
     if (hndl->num_set_commands) {
         while (hndl->num_set_commands) {
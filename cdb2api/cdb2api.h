@@ -252,6 +252,11 @@ int cdb2_is_ssl_encrypted(cdb2_hndl_tp *hndl);
 
 int cdb2_clear_ack(cdb2_hndl_tp *hndl);
 
+/* Process-wide count of ROW_BLOCK responses read, bytes they saved on the
+   wire, and microseconds spent inflating them. */
+void cdb2_get_row_block_stats(long long *blocks, long long *bytes_saved,
+                              long long *decompress_us);
+
 typedef enum cdb2_event_ctrl {
     CDB2_OVERWRITE_RETURN_VALUE = 1,
     CDB2_AS_HANDLE_SPECIFIC_ARG = 1 << 1
@@ -783,6 +783,14 @@ int64_t gbl_temptable_created;
 int64_t gbl_temptable_create_reqs;
 int64_t gbl_temptable_spills;
 
+/* Rows per newsql ROW_BLOCK response; 0 sends every row on its own */
+int gbl_newsql_row_block_rows = 0;
+/* Send a partial row block once its oldest row has waited this long */
+int gbl_newsql_row_block_max_ms = 100;
+int64_t gbl_newsql_row_blocks;
+int64_t gbl_newsql_row_block_bytes_saved;
+int64_t gbl_newsql_row_block_compress_us;
+
 int gbl_osql_odh_blob = 1;
 
 int gbl_clean_exit_on_sigterm = 1;
@@ -1816,6 +1816,7 @@ int clnt_stats_init(void);
 int sqlpool_init(void);
 int schema_init(void);
 int osqlpfthdpool_init(void);
+void osql_page_prefault_release(int **iq_step_ix);
 int init_opcode_handlers();
 void toblock_init(void);
 int mach_class_init(void);
@@ -2521,6 +2522,9 @@ int dbq_consume(struct ireq *iq, void *trans, int consumer,
 int dbq_consume_genid(struct ireq *, void *trans, int consumer, const genid_t);
 int dbq_get(struct ireq *iq, int consumer, const struct bdb_queue_cursor *prev, struct bdb_queue_found **fnddta,
             size_t *fnddtalen, size_t *fnddtaoff, struct bdb_queue_cursor *fnd, long long *seq, uint32_t lockid);
+int dbq_get_batch(struct ireq *iq, int consumer, const struct bdb_queue_cursor *prev, int max,
+                  struct bdb_queue_found **fnds, struct bdb_queue_cursor *fndcursors, long long *seqs, int *nfnd,
+                  uint32_t lockid);
 void dbq_get_item_info(const struct bdb_queue_found *fnd, size_t *dtaoff, size_t *dtalen);
 unsigned long long dbq_item_genid(const struct bdb_queue_found *dta);
 typedef int (*dbq_walk_callback_t)(int consumern, size_t item_length,
@@ -2721,7 +2725,10 @@ enum {
                               1 << 9,
     RECFLAGS_IN_CASCADE = 1 << 10,
     RECFLAGS_DONT_LOCK_TBL = 1 << 11,
-    RECFLAGS_MAX = 1 << 11
+    /* queue index keys in the thread's deferred table; the caller inserts
+     * them in key order with process_defered_table() before committing */
+    RECFLAGS_DEFER_KEYS = 1 << 12,
+    RECFLAGS_MAX = 1 << 12
 };
 
 /* flag codes */
@@ -3568,6 +3575,13 @@ extern int64_t gbl_temptable_created;
 extern int64_t gbl_temptable_create_reqs;
 extern int64_t gbl_temptable_spills;
 
+extern int64_t gbl_newsql_row_blocks;
+extern int64_t gbl_newsql_row_block_bytes_saved;
+extern int64_t gbl_newsql_row_block_compress_us;
+
+extern int64_t gbl_osql_apply_prefault_ops;
+extern int64_t gbl_osql_insert_batches;
+
 extern int gbl_disable_tpsc_tblvers;
 
 extern int gbl_osql_odh_blob;
@@ -84,6 +84,11 @@ struct comdb2_metrics_store {
     int64_t temptable_created;
     int64_t temptable_create_reqs;
     int64_t temptable_spills;
+    int64_t newsql_row_blocks;
+    int64_t newsql_row_block_bytes_saved;
+    int64_t newsql_row_block_compress_us;
+    int64_t osql_apply_prefault_ops;
+    int64_t osql_insert_batches;
     int64_t net_drops;
     int64_t net_queue_size;
     int64_t rep_deadlocks;
@@ -225,6 +230,24 @@ comdb2_metric gbl_metrics[] = {
      "Number of temporary tables that had to be spilled to disk-backed tables",
      STATISTIC_INTEGER, STATISTIC_COLLECTION_TYPE_CUMULATIVE,
      &stats.temptable_spills, NULL},
+    {"newsql_row_blocks", "Number of compressed row blocks sent to clients",
+     STATISTIC_INTEGER, STATISTIC_COLLECTION_TYPE_CUMULATIVE,
+     &stats.newsql_row_blocks, NULL},
+    {"newsql_row_block_bytes_saved",
+     "Bytes not sent to clients thanks to row block compression",
+     STATISTIC_INTEGER, STATISTIC_COLLECTION_TYPE_CUMULATIVE,
+     &stats.newsql_row_block_bytes_saved, NULL},
+    {"newsql_row_block_compress_us",
+     "Microseconds spent compressing row blocks", STATISTIC_INTEGER,
+     STATISTIC_COLLECTION_TYPE_CUMULATIVE, &stats.newsql_row_block_compress_us,
+     NULL},
+    {"osql_apply_prefault_ops",
+     "Bplog ops handed to the prefault threads ahead of the apply",
+     STATISTIC_INTEGER, STATISTIC_COLLECTION_TYPE_CUMULATIVE,
+     &stats.osql_apply_prefault_ops, NULL},
+    {"osql_insert_batches", "Number of OSQL_INSERT_BATCH bplog ops applied",
+     STATISTIC_INTEGER, STATISTIC_COLLECTION_TYPE_CUMULATIVE,
+     &stats.osql_insert_batches, NULL},
     {"net_drops",
      "Number of packets that didn't fit on network queue and were dropped",
      STATISTIC_INTEGER, STATISTIC_COLLECTION_TYPE_CUMULATIVE, &stats.net_drops,
@@ -444,6 +467,11 @@ int refresh_metrics(void)
     stats.temptable_created = gbl_temptable_created;
     stats.temptable_create_reqs = gbl_temptable_create_reqs;
     stats.temptable_spills = gbl_temptable_spills;
+    stats.newsql_row_blocks = gbl_newsql_row_blocks;
+    stats.newsql_row_block_bytes_saved = gbl_newsql_row_block_bytes_saved;
+    stats.newsql_row_block_compress_us = gbl_newsql_row_block_compress_us;
+    stats.osql_apply_prefault_ops = gbl_osql_apply_prefault_ops;
+    stats.osql_insert_batches = gbl_osql_insert_batches;
 
     struct net_stats net_stats;
     rc = net_get_stats(thedb->handle_sibling, &net_stats);
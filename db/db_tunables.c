@@ -80,8 +80,10 @@ extern int gbl_master_swing_osql_verbose;
 extern int gbl_master_swing_sock_restart_sleep;
 extern int gbl_max_lua_instructions;
 extern int gbl_max_sqlcache;
+extern int gbl_max_sqlcache_mem_mb;
 extern int __gbl_max_mpalloc_sleeptime;
 extern int gbl_mem_nice;
+extern int gbl_mem_slab;
 extern int gbl_netbufsz;
 extern int gbl_net_lmt_upd_incoherent_nodes;
 extern int gbl_net_max_mem;
@@ -145,6 +147,11 @@ extern int gbl_force_serial_on_writelock;
 extern int gbl_processor_thd_poll;
 extern int gbl_time_rep_apply;
 extern int gbl_incoherent_logput_window;
+extern int gbl_rep_pace;
+extern int gbl_rep_pace_target_lag;
+extern int gbl_rep_pace_target_wait_ms;
+extern int gbl_rep_pace_min_pct;
+extern int gbl_rep_pace_trace;
 extern int gbl_dump_full_net_queue;
 extern int gbl_max_clientstats_cache;
 extern int gbl_decoupled_logputs;
@@ -189,6 +196,8 @@ extern int gbl_print_net_queue_size;
 extern int gbl_commit_delay_trace;
 extern int gbl_elect_priority_bias;
 extern int gbl_abort_on_reconstruct_failure;
+extern int gbl_snapshot_undo_cache;
+extern int gbl_snapshot_undo_cache_max_mb;
 extern int gbl_rand_elect_timeout;
 extern uint32_t gbl_rand_elect_min_ms;
 extern int gbl_rand_elect_max_ms;
@@ -211,6 +220,9 @@ extern int gbl_match_on_ckp;
 extern int gbl_verbose_physrep;
 extern int gbl_physrep_exit_on_invalid_logstream;
 extern int gbl_blocking_physrep;
+extern int gbl_physrep_streaming;
+extern int gbl_physrep_stream_queue_bytes;
+extern int gbl_physrep_stream_block_rows;
 extern int gbl_verbose_set_sc_in_progress;
 extern int gbl_send_failed_dispatch_message;
 extern int gbl_physrep_reconnect_penalty;
@@ -267,6 +279,8 @@ extern int gbl_ref_sync_wait_txnlist;
 extern int gbl_ref_sync_iterations;
 extern int gbl_sc_pause_at_end;
 extern int gbl_sc_is_at_end;
+extern int gbl_sc_sorted_key_batch;
+extern int gbl_stag_convert_plans;
 
 extern char *gbl_kafka_topic;
 extern char *gbl_kafka_brokers;
@@ -328,6 +342,12 @@ extern int gbl_abort_irregular_set_durable_lsn;
 extern int gbl_legacy_defaults;
 extern int gbl_legacy_schema;
 extern int gbl_selectv_writelock_on_update;
+extern int gbl_osql_apply_prefault_lookahead;
+extern int gbl_osql_insert_batch_rows;
+extern int gbl_sql_inmem_temptables;
+extern int gbl_lazy_index_keys;
+extern int gbl_newsql_row_block_rows;
+extern int gbl_newsql_row_block_max_ms;
 extern int gbl_selectv_writelock;
 extern int gbl_reorder_idx_writes;
 extern int gbl_perform_full_clean_exit;
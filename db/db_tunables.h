@@ -695,6 +695,12 @@ REGISTER_TUNABLE(
     "max_sqlcache_hints",
     "Maximum number of \"hinted\" query plans to keep (global). (Default: 100)",
     TUNABLE_INTEGER, &gbl_max_sql_hint_cache, READONLY, NULL, NULL, NULL, NULL);
+REGISTER_TUNABLE("max_sqlcache_mem_mb",
+                 "If set, evict cached plans once all sql threads together "
+                 "hold this many megabytes of them, instead of capping each "
+                 "thread at max_sqlcache_per_thread plans. (Default: 0)",
+                 TUNABLE_INTEGER, &gbl_max_sqlcache_mem_mb, 0, NULL, NULL, NULL,
+                 NULL);
 REGISTER_TUNABLE("max_sqlcache_per_thread",
                  "Maximum number of plans to cache per sql thread (statement "
                  "cache is per-thread). (Default: 10)",
@@ -713,6 +719,11 @@ REGISTER_TUNABLE("max_query_fingerprints",
                  NULL, NULL, NULL);
 REGISTER_TUNABLE("memnice", NULL, TUNABLE_INTEGER, &gbl_mem_nice,
                  READONLY | NOARG, NULL, NULL, memnice_update, NULL);
+REGISTER_TUNABLE("memslab",
+                 "Keep small chunks freed by a thread in per-thread caches "
+                 "for the subsystems selected with 'memstat slab'. "
+                 "(Default: on)",
+                 TUNABLE_BOOLEAN, &gbl_mem_slab, 0, NULL, NULL, NULL, NULL);
 REGISTER_TUNABLE("mempget_timeout", NULL, TUNABLE_INTEGER,
                  &__gbl_max_mpalloc_sleeptime, READONLY, NULL, NULL, NULL,
                  NULL);
@@ -766,6 +777,17 @@ REGISTER_TUNABLE("net_portmux_register_interval",
 REGISTER_TUNABLE("net_throttle_percent", NULL, TUNABLE_INTEGER,
                  &gbl_net_throttle_percent, READONLY, NULL, percent_verify,
                  NULL, NULL);
+REGISTER_TUNABLE("newsql_row_block_rows",
+                 "Send rows to clients that support it in LZ4 compressed "
+                 "blocks of this many rows. 0 or 1 disables. (Default: 0)",
+                 TUNABLE_INTEGER, &gbl_newsql_row_block_rows, 0, NULL, NULL,
+                 NULL, NULL);
+REGISTER_TUNABLE("newsql_row_block_max_ms",
+                 "Send a partially filled row block once its oldest row has "
+                 "waited this many ms. Heartbeats also send it while the "
+                 "query stalls. (Default: 100)",
+                 TUNABLE_INTEGER, &gbl_newsql_row_block_max_ms, 0, NULL, NULL,
+                 NULL, NULL);
 REGISTER_TUNABLE("nice", "If set, nice() will be called with this "
                          "value to set the database nice level.",
                  TUNABLE_INTEGER, &gbl_nice, READONLY, NULL, NULL, NULL, NULL);
@@ -904,6 +926,19 @@ REGISTER_TUNABLE("osqlprefaultthreads",
                  "If set, send prefaulting hints to nodes. (Default: 0)",
                  TUNABLE_INTEGER, &gbl_osqlpfault_threads, READONLY, NULL, NULL,
                  NULL, NULL);
+REGISTER_TUNABLE("osql_apply_prefault_lookahead",
+                 "Number of bplog ops the master prefaults ahead of the op "
+                 "being applied, using the osqlprefaultthreads pool. "
+                 "(Default: 0)",
+                 TUNABLE_INTEGER, &gbl_osql_apply_prefault_lookahead, 0, NULL,
+                 NULL, NULL, NULL);
+REGISTER_TUNABLE("osql_insert_batch_rows",
+                 "Replicants ship up to this many blobless inserts of a table "
+                 "in one OSQL_INSERT_BATCH bplog op, if the master acks it in "
+                 "the session request; 0 sends one OSQL_INSERT per row. "
+                 "(Default: 50)",
+                 TUNABLE_INTEGER, &gbl_osql_insert_batch_rows, 0, NULL, NULL,
+                 NULL, NULL);
 REGISTER_TUNABLE("osql_verify_ext_chk",
                  "For block transaction mode only - after this many verify "
                  "errors, check if transaction is non-commitable (see default "
@@ -1132,6 +1167,18 @@ REGISTER_TUNABLE("survive_n_master_swings",
                  "master this many times before giving up. (Default: 600)",
                  TUNABLE_INTEGER, &gbl_allow_bplog_restarts, READONLY, NULL,
                  NULL, NULL, NULL);
+REGISTER_TUNABLE("sql_inmem_temptables",
+                 "SQL temp tables start as in-memory sorted arrays and only "
+                 "spill to a btree past temptable_mem_threshold rows or "
+                 "temptable_cachesz bytes. (Default: off)",
+                 TUNABLE_BOOLEAN, &gbl_sql_inmem_temptables, 0, NULL, NULL,
+                 NULL, NULL);
+REGISTER_TUNABLE("lazy_index_keys",
+                 "Index cursors decode only the key columns a query reads, and "
+                 "build the sqlite record of a key only for comparisons. "
+                 "(Default: on)",
+                 TUNABLE_BOOLEAN, &gbl_lazy_index_keys, 0, NULL, NULL, NULL,
+                 NULL);
 REGISTER_TUNABLE("temptable_limit",
                  "Set the maximum number of temporary tables the database can "
                  "create. (Default: 8192)",
@@ -1410,6 +1457,31 @@ REGISTER_TUNABLE("logput_window",
                  "more than this many bytes behind.  (Default: 0)",
                  TUNABLE_INTEGER, &gbl_incoherent_logput_window,
                  EXPERIMENTAL | INTERNAL, NULL, NULL, NULL, NULL);
+REGISTER_TUNABLE("rep_pace",
+                 "Pace commits on the master so that the slowest coherent "
+                 "replicant stays within rep_pace_target_lag bytes and "
+                 "rep_pace_target_wait_ms.  (Default: off)",
+                 TUNABLE_BOOLEAN, &gbl_rep_pace, 0, NULL, NULL, NULL, NULL);
+REGISTER_TUNABLE("rep_pace_target_lag",
+                 "Commit pacing aims to keep coherent replicants no more "
+                 "than this many bytes behind.  (Default: 1048576)",
+                 TUNABLE_INTEGER, &gbl_rep_pace_target_lag, 0, NULL, NULL,
+                 NULL, NULL);
+REGISTER_TUNABLE("rep_pace_target_wait_ms",
+                 "Commit pacing aims to keep the average time a commit waits "
+                 "for a coherent replicant under this.  0 disables the check. "
+                 " (Default: 50)",
+                 TUNABLE_INTEGER, &gbl_rep_pace_target_wait_ms, 0, NULL, NULL,
+                 NULL, NULL);
+REGISTER_TUNABLE("rep_pace_min_pct",
+                 "Commit pacing never slows the master below this percentage "
+                 "of its current log rate in one step.  (Default: 10)",
+                 TUNABLE_INTEGER, &gbl_rep_pace_min_pct, 0, NULL,
+                 percent_verify, NULL, NULL);
+REGISTER_TUNABLE("rep_pace_trace", "Trace commit pacing decisions.  "
+                                   "(Default: off)",
+                 TUNABLE_BOOLEAN, &gbl_rep_pace_trace, 0, NULL, NULL, NULL,
+                 NULL);
 REGISTER_TUNABLE("dump_full_netqueue", "Dump net-queue on full rcode. "
                                        "(Default: off)",
                  TUNABLE_BOOLEAN, &gbl_dump_full_net_queue,
@@ -1578,6 +1650,17 @@ REGISTER_TUNABLE("abort_on_reconstruct_failure",
                  "(Default: off)",
                  TUNABLE_BOOLEAN, &gbl_abort_on_reconstruct_failure,
                  EXPERIMENTAL | INTERNAL, NULL, NULL, NULL, NULL);
+REGISTER_TUNABLE("snapshot_undo_cache",
+                 "Cache the undo records snapshot transactions read from the "
+                 "log, and the rows they rebuild from them, for other "
+                 "sessions to reuse.  (Default: on)",
+                 TUNABLE_BOOLEAN, &gbl_snapshot_undo_cache, 0, NULL, NULL,
+                 NULL, NULL);
+REGISTER_TUNABLE("snapshot_undo_cache_max_mb",
+                 "Memory limit, in megabytes, of the snapshot undo cache.  "
+                 "(Default: 64)",
+                 TUNABLE_INTEGER, &gbl_snapshot_undo_cache_max_mb, 0, NULL,
+                 NULL, NULL, NULL);
 
 REGISTER_TUNABLE("netconndumptime",
                  "Dump connection statistics to ctrace this often.",
@@ -1749,6 +1832,25 @@ REGISTER_TUNABLE("blocking_physrep",
                  TUNABLE_BOOLEAN, &gbl_blocking_physrep, 0, NULL, NULL, NULL,
                  NULL);
 
+REGISTER_TUNABLE("physrep_streaming",
+                 "Physical replicant streams the log from its source with "
+                 "a blocking, compressed query and applies it on a separate "
+                 "thread.  (Default: off)",
+                 TUNABLE_BOOLEAN, &gbl_physrep_streaming, 0, NULL, NULL, NULL,
+                 NULL);
+
+REGISTER_TUNABLE("physrep_stream_queue_bytes",
+                 "Log bytes a streaming physical replicant may have received "
+                 "but not yet applied.  (Default: 16MB)",
+                 TUNABLE_INTEGER, &gbl_physrep_stream_queue_bytes, 0, NULL,
+                 NULL, NULL, NULL);
+
+REGISTER_TUNABLE("physrep_stream_block_rows",
+                 "Log records per compressed row block for a streaming "
+                 "physical replicant.  (Default: 100)",
+                 TUNABLE_INTEGER, &gbl_physrep_stream_block_rows, 0, NULL,
+                 NULL, NULL, NULL);
+
 REGISTER_TUNABLE("logdelete_lock_trace",
                  "Print trace getting and releasing the logdelete lock.  "
                  "(Default: off)",
@@ -1980,6 +2082,19 @@ REGISTER_TUNABLE("sc_pause_at_end",
                  TUNABLE_BOOLEAN, &gbl_sc_pause_at_end, EXPERIMENTAL | INTERNAL,
                  NULL, NULL, NULL, NULL);
 
+REGISTER_TUNABLE("sc_sorted_key_batch",
+                 "Schema change converts this many records per transaction and "
+                 "adds their new index keys in sorted order; 0 disables.  "
+                 "(Default: 0)",
+                 TUNABLE_INTEGER, &gbl_sc_sorted_key_batch, 0, NULL, NULL, NULL,
+                 NULL);
+
+REGISTER_TUNABLE("stag_convert_plans",
+                 "Convert records between server schemas with a plan cached "
+                 "per schema pair instead of field by field.  (Default: on)",
+                 TUNABLE_BOOLEAN, &gbl_stag_convert_plans, 0, NULL, NULL, NULL,
+                 NULL);
+
 REGISTER_TUNABLE("sc_is_at_end",
                  "Schema-change has converted all records.  "
                  "(Default: off)",
@@ -395,6 +395,51 @@ static void node_free(dohsql_node_t **pnode, sqlite3 *db)
     *pnode = NULL;
 }
 
+/* true if the WHERE clause has an AND-ed comparison between two integer
+   literals that is false; this is what a time partition shard window
+   predicate folds into for shards outside the queried window */
+static int _where_is_false(Expr *p)
+{
+    int a, b;
+
+    if (!p)
+        return 0;
+
+    if (p->op == TK_AND)
+        return _where_is_false(p->pLeft) || _where_is_false(p->pRight);
+
+    switch (p->op) {
+    case TK_LT:
+    case TK_LE:
+    case TK_GT:
+    case TK_GE:
+    case TK_EQ:
+    case TK_NE:
+        break;
+    default:
+        return 0;
+    }
+
+    if (!sqlite3ExprIsInteger(p->pLeft, &a) ||
+        !sqlite3ExprIsInteger(p->pRight, &b))
+        return 0;
+
+    switch (p->op) {
+    case TK_LT:
+        return !(a < b);
+    case TK_LE:
+        return !(a <= b);
+    case TK_GT:
+        return !(a > b);
+    case TK_GE:
+        return !(a >= b);
+    case TK_EQ:
+        return !(a == b);
+    default:
+        return !(a != b);
+    }
+}
+
 static dohsql_node_t *gen_union(Vdbe *v, Select *p, int span)
 {
     dohsql_node_t *node;
@@ -455,6 +500,16 @@ static dohsql_node_t *gen_union(Vdbe *v, Select *p, int span)
 
     /* generate queries */
     while (crt) {
+        /* an arm that cannot return rows does not need a thread; the head
+           is always kept since it carries the offset */
+        if (psub != node->nodes && _where_is_false(crt->pWhere)) {
+            if (gbl_dohast_verbose)
+                logmsg(LOGMSG_USER, "%p pruned union arm %p\n",
+                       (void *)pthread_self(), crt);
+            node->nnodes--;
+            crt = crt->pNext;
+            continue;
+        }
         assert(crt == p || !crt->pOrderBy); /* can "restore" to NULL? */
         crt->pOrderBy = p->pOrderBy;
         *psub = gen_oneselect(v, crt, pOffset, &node->order_size,
@@ -482,6 +537,9 @@ static dohsql_node_t *gen_union(Vdbe *v, Select *p, int span)
         crt = crt->pNext;
         psub++;
     }
+    /* everything but the head was pruned, run it serially */
+    if (node && node->nnodes == 1)
+        node_free(&node, v->db);
 done:
     crt = p;
     while (crt) {
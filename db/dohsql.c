@@ -61,7 +61,10 @@ struct dohsql_connector {
     queue_type *que_free; /* de-queued rows come here to be freed */
     bool selected;        /* true if a row from this engine is being used by
                              coordinator */
+    bool held;            /* true if coordinator holds a row from this engine
+                             as its ordered merge head */
     pthread_mutex_t mtx;  /* mutex for queueing operations and related counts */
+    pthread_cond_t cond;  /* signalled when rows are queued or released */
     char *thr_where;      /* cached where status */
     my_col_t *cols;       /* cached cols values */
     int ncols;            /* number of columns */
@@ -108,11 +111,10 @@ struct dohsql {
     /* OFFSET support */
     int offset;  /* any offset */
     int skipped; /* how many rows where skipped so far */
-    /* ORDER BY support */
-    int filling;
-    int active;
-    int *order;
-    int top_idx;
+    /* ORDER BY support: loser tree over the head row of each engine */
+    int *tree;      /* tree[0] is the winner, tree[1..nconns-1] the losers */
+    row_t **heads;  /* current head row per engine, NULL once it is done */
+    int last;       /* engine whose head was returned last, -1 if none */
     int order_size;
     int *order_dir;
     int nparams;
@@ -184,6 +186,7 @@ void handle_child_error(struct sqlclntstate *clnt, int errcode)
     if (conn) {
         Pthread_mutex_lock(&conn->mtx);
         conn->rc = -1;
+        Pthread_cond_broadcast(&conn->cond);
         Pthread_mutex_unlock(&conn->mtx);
     }
 }
@@ -307,6 +310,18 @@ static void trimQue(dohsql_connector_t *conn, sqlite3_stmt *stmt,
     }
 }
 
+/* conn is locked; wait for the other side to queue or release rows */
+static void _conn_wait(dohsql_connector_t *conn)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_nsec += (long)gbl_dohsql_full_queue_poll_msec * 1000000;
+    ts.tv_sec += ts.tv_nsec / 1000000000;
+    ts.tv_nsec %= 1000000000;
+    pthread_cond_timedwait(&conn->cond, &conn->mtx, &ts);
+}
+
 /* locked */
 static void _track_que_free(dohsql_connector_t *conn)
 {
@@ -343,8 +358,9 @@ static void _que_limiter(dohsql_connector_t *conn, sqlite3_stmt *stmt,
         if (conn->queue_size > gbl_dohsql_max_queued_kb_highwm * 1000) {
             if ((conn->queue_size > gbl_dohsql_max_queued_kb_lowwm * 1000) &&
                 conn->status != DOH_MASTER_DONE) {
+                /* the coordinator wakes us up as soon as it releases rows */
+                _conn_wait(conn);
                 Pthread_mutex_unlock(&conn->mtx);
-                poll(NULL, 0, gbl_dohsql_full_queue_poll_msec);
                 if (bdb_lock_desired(thedb->bdb_env)) {
                     rc = recover_deadlock_simple(thedb->bdb_env);
                     if (rc) {
@@ -387,6 +403,7 @@ static int inner_error(struct sqlclntstate *clnt, int rc, char *errstr)
     clnt->saved_rc = rc;
     clnt->saved_errstr = strdup(errstr);
     conn->rc = rc;
+    Pthread_cond_broadcast(&conn->cond);
     Pthread_mutex_unlock(&conn->mtx);
 
     return 0;
@@ -443,6 +460,7 @@ static int inner_row(struct sqlclntstate *clnt, struct response_data *resp,
     conn->rc = SQLITE_ROW;
     if (queue_add(conn->que, row))
         abort();
+    Pthread_cond_broadcast(&conn->cond);
 
     if (gbl_dohsql_verbose)
         logmsg(LOGMSG_USER,
@@ -462,6 +480,7 @@ static int inner_row_last(struct sqlclntstate *clnt)
 
     Pthread_mutex_lock(&conn->mtx);
     conn->rc = SQLITE_DONE;
+    Pthread_cond_broadcast(&conn->cond);
     Pthread_mutex_unlock(&conn->mtx);
 
     return SHARD_NOERR;
@@ -585,6 +604,7 @@ static void donate_current_row(dohsql_t *conns, int locked)
         if (queue_add(conns->conns[conns->row_src].que_free, conns->row))
             abort();
         conns->conns[conns->row_src].selected = 0;
+        Pthread_cond_broadcast(&conns->conns[conns->row_src].cond);
         if (!locked)
             Q_UNLOCK(conns->row_src);
         conns->row = NULL;
@@ -610,6 +630,19 @@ static void add_row(dohsql_t *conns, int i, row_t *row)
     (conns->conns[(kid)].rc != SQLITE_ROW &&                                   \
      conns->conns[(kid)].rc != SQLITE_DONE)
 
+/* give back the ordered merge head held from child, if any; child is locked */
+static void _release_head(dohsql_t *conns, int child)
+{
+    if (!conns->heads || !conns->heads[child])
+        return;
+
+    if (queue_add(conns->conns[child].que_free, conns->heads[child]))
+        abort();
+    conns->conns[child].held = 0;
+    conns->heads[child] = NULL;
+    Pthread_cond_broadcast(&conns->conns[child].cond);
+}
+
 static void _signal_children_master_is_done(dohsql_t *conns)
 {
     int child_num;
@@ -621,6 +654,7 @@ static void _signal_children_master_is_done(dohsql_t *conns)
         if (conns->row && conns->row_src == child_num) {
             donate_current_row(conns, 1);
         }
+        _release_head(conns, child_num);
 
         if (conns->conns[child_num].status != DOH_CLIENT_DONE) {
             if (gbl_dohsql_verbose)
@@ -1013,6 +1047,7 @@ static int _shard_connect(struct sqlclntstate *clnt, dohsql_connector_t *conn,
         return SHARD_ERR_MALLOC;
     }
     Pthread_mutex_init(&conn->mtx, NULL);
+    Pthread_cond_init(&conn->cond, NULL);
 
     comdb2uuid(conn->clnt->osql.uuid);
     conn->clnt->appsock_id = getarchtid();
@@ -1053,6 +1088,7 @@ static void _shard_disconnect(dohsql_connector_t *conn)
 
     queue_free(conn->que);
     queue_free(conn->que_free);
+    Pthread_cond_destroy(&conn->cond);
     if (conn->cols)
         free(conn->cols);
 
@@ -1070,8 +1106,8 @@ static void _master_clnt_set(struct sqlclntstate *clnt)
     clnt->conns->backup = clnt->plugin;
 
     clnt->plugin.column_count = dohsql_dist_column_count;
-    clnt->plugin.next_row = (clnt->conns->order) ? dohsql_dist_next_row_ordered
-                                                 : dohsql_dist_next_row;
+    clnt->plugin.next_row = (clnt->conns->tree) ? dohsql_dist_next_row_ordered
+                                                : dohsql_dist_next_row;
     clnt->plugin.column_type = dohsql_dist_column_type;
     clnt->plugin.column_int64 = dohsql_dist_column_int64;
     clnt->plugin.column_double = dohsql_dist_column_double;
@@ -1257,6 +1293,7 @@ int dohsql_end_distribute(struct sqlclntstate *clnt, struct reqlogger *logger)
 
     for (i = 1; i < conns->nconns; i++) {
         Pthread_mutex_lock(&conns->conns[i].mtx);
+        _release_head(conns, i);
         while (conns->conns[i].status != DOH_CLIENT_DONE) {
             Pthread_mutex_unlock(&conns->conns[i].mtx);
             poll(NULL, 0, 10);
@@ -1322,8 +1359,9 @@ int dohsql_end_distribute(struct sqlclntstate *clnt, struct reqlogger *logger)
             conns->stats.max_free_queue_len, conns->stats.max_queue_bytes);
     }
 
-    if (conns->order) {
-        free(conns->order);
+    if (conns->tree) {
+        free(conns->tree);
+        free(conns->heads);
         free(conns->order_dir);
     }
     _master_clnt_reset(clnt);
@@ -1359,9 +1397,9 @@ void dohsql_wait_for_master(sqlite3_stmt *stmt, struct sqlclntstate *clnt)
     /* wait if run ended ok, master is not done, and there are cached rows */
     if (!clnt->query_rc) {
         while (conn->status == DOH_RUNNING &&
-               (conn->selected || (queue_count(conn->que) > 0))) {
+               (conn->selected || conn->held || (queue_count(conn->que) > 0))) {
+            _conn_wait(conn);
             Pthread_mutex_unlock(&conn->mtx);
-            poll(NULL, 0, 10);
             if (bdb_lock_desired(thedb->bdb_env)) {
                 rc = recover_deadlock_simple(thedb->bdb_env);
                 if (rc) {
@@ -1479,348 +1517,243 @@ void comdb2_handle_limit(Vdbe *v, Mem *m)
     }
 }
 
-static int _cmp(dohsql_t *conns, int idx_a, int idx_b)
+/* true if engine a's head row sorts before engine b's; done engines sort
+   last and ties go to the lower engine so the merge is stable */
+static int _merge_before(dohsql_t *conns, int a, int b)
 {
-    int *order = conns->order;
-    row_t *a, *b;
+    row_t *ra = conns->heads[a];
+    row_t *rb = conns->heads[b];
     int i;
-    int ret = 0;
-    int qc_a, qc_b;
+    int ret;
 
-    if (idx_a == idx_b)
+    if (!ra)
         return 0;
+    if (!rb)
+        return 1;
 
-    /* note idx_a is the referrence, and it is locked here */
-    Q_LOCK(order[idx_b]);
-
-    qc_a = queue_count(conns->conns[order[idx_a]].que);
-    qc_b = queue_count(conns->conns[order[idx_b]].que);
-    if (qc_a == 0) {
-        if (qc_b == 0) {
-            ret = 0;
-        } else {
-            ret = -1;
+    for (i = 0; i < conns->order_size; i++) {
+        int orderby_idx = (conns->order_dir[i] > 0) ? conns->order_dir[i]
+                                                    : (-conns->order_dir[i]);
+        assert(orderby_idx > 0);
+        orderby_idx--;
+        if (gbl_dohsql_verbose) {
+            logmsg(LOGMSG_USER, "%p COMPARE %s <> %s\n", (void *)pthread_self(),
+                   print_mem(&ra[orderby_idx]), print_mem(&rb[orderby_idx]));
         }
-    } else if (qc_b == 0) {
-        ret = 1;
-    } else {
-        a = conns->conns[order[idx_a]].que->lst.top->obj;
-        b = conns->conns[order[idx_b]].que->lst.top->obj;
-
-        for (i = 0; i < conns->order_size /*conns->ncols*/; i++) {
-            int orderby_idx = (conns->order_dir[i] > 0)
-                                  ? conns->order_dir[i]
-                                  : (-conns->order_dir[i]);
-            assert(orderby_idx > 0);
-            orderby_idx--;
-            if (gbl_dohsql_verbose) {
-                logmsg(LOGMSG_USER, "%p COMPARE %s <> %s\n", (void *)pthread_self(), print_mem(&a[orderby_idx]),
-                       print_mem(&b[orderby_idx]));
-            }
 
-            ret = sqlite3MemCompare(&a[orderby_idx], &b[orderby_idx], NULL);
-            if (ret) {
-                if (conns->order_dir[i] < 0)
-                    ret = -ret;
-                break;
-            }
+        ret = sqlite3MemCompare(&ra[orderby_idx], &rb[orderby_idx], NULL);
+        if (ret) {
+            if (conns->order_dir[i] < 0)
+                ret = -ret;
+            return ret < 0;
         }
     }
 
-    Q_UNLOCK(order[idx_b]);
-
-    return ret;
+    return a < b;
 }
 
-int _pos(dohsql_t *conns, int index)
+/* play every engine's head against the others; each internal node keeps
+   the loser of its match, the overall winner lands in tree[0] */
+static void _merge_build(dohsql_t *conns)
 {
-    int left;
-    int right;
-    int pivot;
-    /*
-        if (conns->filling == 0)
-            return conns->top_idx;
-    */
-    left = conns->top_idx;
-    right = (conns->top_idx + conns->filling /*-1*/) % conns->nconns;
-
-    if (left > right) {
-        if (_cmp(conns, index, conns->nconns - 1) < 0) {
-            right = conns->nconns - 1;
-        } else {
-            left = 0;
-        }
-    }
+    int *tree = conns->tree;
+    int winner, tmp;
+    int i, p;
 
-    while (left < right) {
-        pivot = left + (right - left) / 2;
-        if (_cmp(conns, index, pivot) < 0) {
-            right = pivot;
-            continue;
+    for (p = 1; p < conns->nconns; p++)
+        tree[p] = -1;
+
+    for (i = 0; i < conns->nconns; i++) {
+        winner = i;
+        for (p = (i + conns->nconns) / 2; p > 0; p /= 2) {
+            if (tree[p] < 0) {
+                /* first arrival waits for its opponent */
+                tree[p] = winner;
+                winner = -1;
+                break;
+            }
+            if (_merge_before(conns, tree[p], winner)) {
+                tmp = tree[p];
+                tree[p] = winner;
+                winner = tmp;
+            }
         }
-        left = pivot + 1;
+        if (winner >= 0)
+            tree[0] = winner;
     }
-
-    return left;
 }
 
-static void _print_order_info(dohsql_t *conns, const char *label)
+/* engine idx has a new head; replay its path to the root, which only
+   compares against the losers along that path */
+static void _merge_replay(dohsql_t *conns, int idx)
 {
-    int *order = conns->order;
-    int i;
+    int *tree = conns->tree;
+    int winner = idx;
+    int tmp;
+    int p;
 
-    if (!gbl_dohsql_verbose)
-        return;
-
-    logmsg(LOGMSG_USER,
-           "%p Order %s: top_idx=%d filling=%d active=%d nconns=%d\n[",
-           (void *)pthread_self(), label, conns->top_idx, conns->filling,
-           conns->active, conns->nconns);
-    for (i = 0; i < conns->nconns; i++) {
-        logmsg(LOGMSG_USER, "(%d, %d, %d) ", order[i],
-               (order[i] >= 0) ? conns->conns[order[i]].rc : -1,
-               (order[i] >= 0) ? queue_count(conns->conns[order[i]].que) : -1);
+    for (p = (idx + conns->nconns) / 2; p > 0; p /= 2) {
+        if (_merge_before(conns, tree[p], winner)) {
+            tmp = tree[p];
+            tree[p] = winner;
+            winner = tmp;
+        }
     }
-    logmsg(LOGMSG_USER, "]\n");
+    tree[0] = winner;
 }
 
-static int q_top(dohsql_t *conns)
+/* fetch the next head row for engine idx, waiting until the engine either
+   produces one or is done; a done engine is left with a NULL head */
+static int _merge_fill(struct sqlclntstate *clnt, sqlite3_stmt *stmt, int idx)
 {
-    int *order = conns->order;
-    int ret = conns->top_idx;
-    int ret_val = order[ret];
-    int last;
-
-    assert(conns->filling > 0);
-
-    conns->top_idx = (conns->top_idx + 1) % conns->nconns;
-    conns->filling--;
-
-    if (conns->active < conns->nconns) {
-        last = (conns->top_idx + conns->active - 1) % conns->nconns;
-        order[last] = order[ret];
-        order[ret] = -1;
-    }
-    if (gbl_dohsql_verbose)
-        _print_order_info(conns, "retrieved_ordered_row");
+    dohsql_t *conns = clnt->conns;
+    dohsql_connector_t *conn = &conns->conns[idx];
+    int rc;
 
-    return ret_val;
-}
+    conns->heads[idx] = NULL;
 
-static int q_insert(dohsql_t *conns, int indx)
-{
-    int *order = conns->order;
-    int pos = _pos(conns, indx);
-    int last = (conns->top_idx + conns->filling) % conns->nconns;
-    int saved = order[indx];
-
-    if (pos > last) {
-        if (last > 0) {
-            memmove(&order[1], &order[0], sizeof(order[0]) * last);
+    if (idx == 0) {
+        if (conn->rc == SQLITE_DONE)
+            return SQLITE_OK;
+        rc = init_next_row(clnt, stmt);
+        if (rc == SQLITE_ROW) {
+            /* the local row stays in the engine until it steps again */
+            conns->heads[0] = ((Vdbe *)stmt)->pResultSet;
+            return SQLITE_OK;
         }
-        last = conns->nconns - 1;
-        order[0] = order[last];
+        return (rc == SQLITE_DONE) ? SQLITE_OK : rc;
     }
-    if (pos < last) {
-        memmove(&order[pos + 1], &order[pos], sizeof(order[0]) * (last - pos));
-    }
-    conns->order[pos] = saved;
-    conns->filling++;
-
-    return SHARD_NOERR;
-}
 
-static void _move_client_done(dohsql_t *conns, int idx)
-{
-    int *order = conns->order;
-    int last;
-
-    last = (conns->top_idx + conns->active - 1) % conns->nconns;
-    if (gbl_dohsql_verbose)
-        logmsg(LOGMSG_USER, "%p %s: client %d done\n", (void *)pthread_self(),
-               __func__, order[idx]);
-    if (last != idx)
-        order[idx] = order[last];
-    order[last] = -1;
-    conns->active--;
+    Q_LOCK(idx);
+    while (1) {
+        if (CHILD_ERROR(idx)) {
+            rc = conn->rc;
+            conns->child_err = idx;
+            if (gbl_dohsql_verbose)
+                logmsg(LOGMSG_USER, "%s Child %d return error %d!\n",
+                       __func__, idx, rc);
+            Q_UNLOCK(idx);
+            _signal_children_master_is_done(conns);
+            /* we cannot reset stmt here since caller will need that to
+               send back columns, if this is the first row; send proper
+               rc so we reset stmt in caller */
+            return SQLITE_EARLYSTOP_DOHSQL;
+        }
+        conns->heads[idx] = queue_next(conn->que);
+        if (conns->heads[idx]) {
+            conn->held = 1;
+            break;
+        }
+        if (conn->rc == SQLITE_DONE)
+            break;
 
-    if (gbl_dohsql_verbose)
-        _print_order_info(conns, "client_done");
-}
+        _conn_wait(conn);
 
-static void _move_client_row(dohsql_t *conns, int idx)
-{
-    int *order = conns->order;
-    int last, tmp;
-    /* flip to the non-ready pole-position */
-    last = (conns->top_idx + conns->filling) % conns->nconns;
-    if (last != idx) {
-        tmp = order[idx];
-        order[idx] = order[last];
-        order[last] = tmp;
-        idx = last;
-    }
-    q_insert(conns, idx);
+        /* we have the bdb read lock here, check if we need to run
+           recovery_deadlock */
+        if (bdb_lock_desired(thedb->bdb_env)) {
+            Q_UNLOCK(idx);
+            rc = recover_deadlock_simple(thedb->bdb_env);
+            if (rc) {
+                logmsg(LOGMSG_ERROR, "%s: failed recover_deadlock rc=%d\n",
+                       __func__, rc);
+                return rc;
+            }
+            Q_LOCK(idx);
+        }
+    }
+    Q_UNLOCK(idx);
 
     if (gbl_dohsql_verbose)
-        _print_order_info(conns, "insert_new_row");
-}
-
-static int _local_step(struct sqlclntstate *clnt, sqlite3_stmt *stmt,
-                       int crt_idx)
-{
-    dohsql_t *conns = clnt->conns;
-
-    conns->conns[0].rc = init_next_row(clnt, stmt);
-    if (conns->conns[0].rc == SQLITE_ROW) {
-        if (gbl_dohsql_verbose)
-            logmsg(LOGMSG_USER, "%p XXX: %s added local new row\n",
-                   (void *)pthread_self(), __func__);
+        logmsg(LOGMSG_USER, "%p XXX: %s engine %d head %p\n",
+               (void *)pthread_self(), __func__, idx, conns->heads[idx]);
 
-        if (queue_add(conns->conns[0].que, ((Vdbe *)stmt)->pResultSet))
-            abort();
-        _move_client_row(conns, crt_idx);
-    } else if (conns->conns[0].rc == SQLITE_DONE) {
-        _move_client_done(conns, crt_idx);
-    } else {
-        return conns->conns[0].rc;
-    }
     return SQLITE_OK;
 }
 
+/**
+ * this is an ordered k-way merge of N engine outputs; every engine is
+ * already sorted, so only the head rows are compared and each row costs
+ * log2(N) comparisons without touching the engines' queues
+ *
+ */
 static int dohsql_dist_next_row_ordered(struct sqlclntstate *clnt,
                                         sqlite3_stmt *stmt)
 {
     dohsql_t *conns = clnt->conns;
-    int *order = conns->order;
-    int i;
-    int idx;
     int found;
-    row_t *ret_row;
-    int rc = SQLITE_OK;
-    int que_idx;
+    int i;
+    int rc;
 
     if (gbl_dohsql_verbose)
         logmsg(LOGMSG_USER, "%p %s: start\n", (void *)pthread_self(), __func__);
-    if (conns->nrows == 0) {
-        rc = _local_step(clnt, stmt, 0);
+
+next_row:
+    if (conns->last < 0) {
+        /* prime the merge with the first row of every engine */
+        for (i = 0; i < conns->nconns; i++) {
+            rc = _merge_fill(clnt, stmt, i);
+            if (rc != SQLITE_OK)
+                return rc;
+        }
+        _merge_build(conns);
+    } else {
+        /* only the previous winner needs a new row */
+        rc = _merge_fill(clnt, stmt, conns->last);
         if (rc != SQLITE_OK)
             return rc;
+        _merge_replay(conns, conns->last);
     }
 
-    /* fast path: all channels ready, get the top; if there is
-       another row ready, order that, return */
-retry_row:
-    if (conns->active == 0)
+    found = conns->tree[0];
+    if (!conns->heads[found]) {
+        /* every engine is done */
+        donate_current_row(conns, 0);
         return SQLITE_DONE;
+    }
 
-    if (conns->filling == conns->active) {
-        /* merge-sort primed */
-        rc = _check_limit(stmt, conns);
-        if (rc != SQLITE_OK)
-            return rc;
+    rc = _check_limit(stmt, conns);
+    if (rc != SQLITE_OK)
+        return rc;
 
-        /* get the top */
-        found = q_top(conns);
+    if (gbl_dohsql_verbose)
+        logmsg(LOGMSG_USER, "%p XXXX %s Retrieved client %d row %p\n",
+               (void *)pthread_self(), __func__, found, conns->heads[found]);
 
+    if (found) {
         Q_LOCK(found);
-        ret_row = queue_next(conns->conns[found].que);
-
-        if (gbl_dohsql_verbose)
-            logmsg(LOGMSG_USER, "%p XXXX %s Retrieved client %d row %p\n",
-                   (void *)pthread_self(), __func__, found, ret_row);
-
-        add_row(conns, found, ret_row);
+        add_row(conns, found, conns->heads[found]);
+        conns->conns[found].held = 0;
         Q_UNLOCK(found);
+    } else {
+        add_row(conns, 0, NULL);
+    }
+    conns->heads[found] = NULL;
+    conns->last = found;
 
-        rc = _check_offset(conns);
-        if (rc != SQLITE_ROW) {
-            goto retry_row;
-        }
+    rc = _check_offset(conns);
+    if (rc != SQLITE_ROW)
+        goto next_row;
 
-        conns->nrows++;
-
-        return SQLITE_ROW;
-    }
-
-    /* slow path: go through all the channels, if some are not ready,
-       check to see if they have rows ready or done, if rows,
-       order them */
-    assert(conns->active > conns->filling);
-
-    int unready = conns->active - conns->filling;
-    int unready_start = conns->filling;
-
-    for (i = 0; i < unready && rc == SQLITE_OK; i++) {
-        idx = (conns->top_idx + unready_start + i) % conns->nconns;
-        que_idx = order[idx];
-        assert(que_idx >= 0);
-
-        if (que_idx) {
-            Q_LOCK(que_idx);
-            if (queue_count(conns->conns[que_idx].que) > 0) {
-                _move_client_row(conns, idx);
-            } else {
-                if (conns->conns[que_idx].rc == SQLITE_DONE) {
-                    _move_client_done(conns, idx);
-                    /* above moves the location of done client at the end,
-                    i points to the next row*/
-                    i--;
-                    unready--;
-                } else if (conns->conns[que_idx].rc != SQLITE_ROW) {
-                    /* detected an error from a child, stop processing */
-                    rc = conns->conns[que_idx].rc;
-                    if (gbl_dohsql_verbose)
-                        logmsg(LOGMSG_USER, "%s Child %d return error %d!\n",
-                               __func__, conns->child_err, rc);
-                    Q_UNLOCK(que_idx);
-                    _signal_children_master_is_done(conns);
-                    /* we cannot reset stmt here since caller will need that to
-                       send back columns, if this is the first row; send proper
-                       rc so we reset stmt in caller */
-                    return SQLITE_EARLYSTOP_DOHSQL;
-                }
-            }
-            Q_UNLOCK(que_idx);
-        } else {
-            rc = _local_step(clnt, stmt, idx);
-            if (rc != SQLITE_OK) {
-                continue;
-            }
-        }
-    }
-    if (rc != SQLITE_OK)
-        return rc;
-    /* we look at all contributing children, and need to wait;
-       since we have the bdb read lock here, check if we need
-       to run recovery_deadlock */
-    if (bdb_lock_desired(thedb->bdb_env)) {
-        rc = recover_deadlock_simple(thedb->bdb_env);
-        if (rc) {
-            logmsg(LOGMSG_ERROR, "%s: failed recover_deadlock rc=%d\n",
-                   __func__, rc);
-            return rc;
-        }
-    }
+    conns->nrows++;
 
-    goto retry_row;
+    return SQLITE_ROW;
 }
 
 int order_init(dohsql_t *conns, dohsql_node_t *node)
 {
-    int i;
-    conns->order = (int *)calloc(sizeof(int), conns->nconns);
+    conns->tree = (int *)calloc(sizeof(int), conns->nconns);
+    conns->heads = (row_t **)calloc(sizeof(row_t *), conns->nconns);
 
-    if (!conns->order)
+    if (!conns->tree || !conns->heads) {
+        free(conns->tree);
+        free(conns->heads);
+        conns->tree = NULL;
+        conns->heads = NULL;
         return SHARD_ERR_MALLOC;
-
-    conns->active = conns->nconns;
-    conns->filling = 0;
-    conns->top_idx = 0;
-    for (i = 0; i < conns->active; i++) {
-        conns->order[i] = i;
     }
 
+    conns->last = -1;
     conns->order_size = node->order_size;
     conns->order_dir = node->order_dir;
     node->order_size = 0;
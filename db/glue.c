@@ -5344,6 +5344,81 @@ done:
     return rc;
 }
 
+/* dbq_get for up to max items.  Falls back to a single dbq_get for queues
+ * that can't be read in batches. */
+int dbq_get_batch(struct ireq *iq, int consumer, const struct bdb_queue_cursor *prev, int max,
+                  struct bdb_queue_found **fnds, struct bdb_queue_cursor *fndcursors, long long *seqs, int *nfnd,
+                  uint32_t lockid)
+{
+    int bdberr;
+    uint32_t savedlid;
+    void *bdb_handle;
+    int retries = 0;
+    int rc;
+
+    *nfnd = 0;
+    bdb_handle = get_bdb_handle_ireq(iq, AUXDB_NONE);
+    if (!bdb_handle)
+        return ERR_NO_AUXDB;
+    if (bdb_get_type(bdb_handle) != BDBTYPE_QUEUEDB || max <= 1) {
+        rc = dbq_get(iq, consumer, prev, &fnds[0], NULL, NULL, &fndcursors[0], seqs, lockid);
+        if (rc == 0)
+            *nfnd = 1;
+        return rc;
+    }
+
+    tran_type *tran = NULL;
+retry:
+    rc = trans_start(iq, NULL, (void *)&tran);
+    if (rc) {
+        logmsg(LOGMSG_ERROR, "%s: trans_start rc %d\n", __func__, rc);
+        goto done;
+    }
+
+    /* See dbq_get: the queue lock is owned by the cursor's locker */
+    if (lockid) {
+        bdb_get_tran_lockerid(tran, &savedlid);
+        bdb_set_tran_lockerid(tran, lockid);
+    }
+
+    iq->gluewhere = "bdb_queue_get_batch";
+    rc = bdb_queue_get_batch(bdb_handle, tran, consumer, prev, max, fnds, fndcursors, seqs, nfnd, &bdberr);
+    iq->gluewhere = "bdb_queue_get_batch done";
+    if (rc != 0) {
+        if (bdberr == BDBERR_DEADLOCK) {
+            iq->retries++;
+            if (++retries < gbl_maxretries && !lockid) {
+                n_retries++;
+                poll(0, 0, (rand() % 500 + 10));
+                bdb_tran_abort(bdb_handle, tran, &bdberr);
+                goto retry;
+            }
+            if (!lockid) {
+                logmsg(LOGMSG_ERROR, "*ERROR* bdb_queue_get_batch too much contention %d count %d\n", bdberr,
+                       retries);
+            }
+            rc = lockid ? IX_NOTFND : ERR_INTERNAL;
+            goto done;
+        } else if (bdberr == BDBERR_FETCH_DTA || bdberr == BDBERR_LOCK_DESIRED) {
+            rc = IX_NOTFND;
+            goto done;
+        }
+        rc = map_unhandled_bdb_rcode("bdb_queue_get_batch", bdberr, 0);
+        goto done;
+    }
+done:
+    if (tran) {
+        if (lockid) {
+            bdb_set_tran_lockerid(tran, savedlid);
+        }
+        if (bdb_tran_abort(bdb_handle, tran, &bdberr)) {
+            logmsg(LOGMSG_FATAL, "%s:%d failed to abort transaction: %d\n", __FILE__, __LINE__, bdberr);
+            exit(1);
+        }
+    }
+    return rc;
+}
+
 unsigned long long dbq_item_genid(const struct bdb_queue_found *dta)
 {
     return bdb_queue_item_genid(dta);
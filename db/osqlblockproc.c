@@ -39,6 +39,7 @@
 #include <unistd.h>
 
 #include "comdb2.h"
+#include "comdb2_atomic.h"
 #include "osqlblockproc.h"
 #include "block_internal.h"
 #include "osqlsession.h"
@@ -55,6 +56,9 @@
 #include "sc_global.h"
 #include "schemachange.h"
 
+#include <mem_osql.h>
+#include <mem_override.h>
+
 extern int gbl_reorder_idx_writes;
 
 
@@ -102,6 +106,23 @@ typedef struct {
 } selectv_genid_t;
 
 int gbl_selectv_writelock_on_update = 1;
+int gbl_osql_apply_prefault_lookahead = 0;
+int64_t gbl_osql_apply_prefault_ops;
+
+/* While the block processor applies a bplog, a second set of cursors can run
+ * ahead of it and hand the upcoming ops to the osql prefault thread pool.
+ * The data and index pages touched by a large transaction are then read in
+ * by several threads, and the single apply thread finds them in cache.
+ */
+typedef struct apply_lookahead {
+    struct temp_cursor *cur;     /* runs ahead of the apply cursor */
+    struct temp_cursor *cur_ins; /* runs ahead of the INS apply cursor */
+    struct dbtable *last_db;
+    int ahead;     /* ops enqueued for prefault but not yet applied */
+    int ahead_ins; /* same, for the INS temp table */
+    bool done;
+    bool done_ins;
+} apply_lookahead_t;
 
 static int apply_changes(struct ireq *iq, blocksql_tran_t *tran, void *iq_tran,
                          int *nops, struct block_err *err,
@@ -421,7 +442,7 @@ void osql_bplog_close(blocksql_tran_t **ptran)
 
 static void setup_reorder_key(blocksql_tran_t *tran, int type,
                               osql_sess_t *sess, unsigned long long rqid,
-                              char *rpl, oplog_key_t *key)
+                              char *rpl, int rplen, oplog_key_t *key)
 {
     char *tablename = tran->tablename;
 
@@ -446,10 +467,12 @@ static void setup_reorder_key(blocksql_tran_t *tran, int type,
     case OSQL_UPDREC:
     case OSQL_DELREC:
     case OSQL_INSERT:
+    case OSQL_INSERT_BATCH:
     case OSQL_INSREC: {
         enum { OSQLCOMM_UUID_RPL_TYPE_LEN = 4 + 4 + 16 };
         unsigned long long genid = 0;
-        if (type == OSQL_INSERT || type == OSQL_INSREC) {
+        if (type == OSQL_INSERT || type == OSQL_INSREC ||
+            type == OSQL_INSERT_BATCH) {
             genid = ++tran->ins_seq;
 #if DEBUG_REORDER
             logmsg(LOGMSG_DEBUG, "REORDER: INS genid (seq) 0x%llx\n", genid);
@@ -505,6 +528,10 @@ static void setup_reorder_key(blocksql_tran_t *tran, int type,
         tran->last_is_ins = 1;
         sess->tran_rows++;
         break;
+    case OSQL_INSERT_BATCH:
+        tran->last_is_ins = 1;
+        sess->tran_rows += osql_insert_batch_nrows(rpl, rplen);
+        break;
     default:
         tran->last_is_ins = 0;
         break;
@@ -584,7 +611,7 @@ int osql_bplog_saveop(osql_sess_t *sess, blocksql_tran_t *tran, char *rpl,
 
     struct temp_table *tmptbl = tran->db;
     if (tran->is_reorder_on) {
-        setup_reorder_key(tran, type, sess, sess->rqid, rpl, &key);
+        setup_reorder_key(tran, type, sess, sess->rqid, rpl, rplen, &key);
         if (tran->last_is_ins && tran->db_ins) { // insert into ins temp table
             tmptbl = tran->db_ins;
         }
@@ -601,12 +628,14 @@ int osql_bplog_saveop(osql_sess_t *sess, blocksql_tran_t *tran, char *rpl,
         logmsg(LOGMSG_ERROR, "%s: fail to put oplog seq=%u rc=%d bdberr=%d\n",
                __func__, tran->seq, rc, bdberr);
     } else {
-        tran->seq++;
+        /* prefault with the seq of the key just saved: the step slot, which
+         * the apply lookahead reuses, is only allocated for the first op */
         if (gbl_osqlpfault_threads) {
             osql_page_prefault(rpl, rplen, &(tran->last_db),
                                &sess->iq->osql_step_ix, sess->rqid, sess->uuid,
-                               tran->seq);
+                               key.seq);
         }
+        tran->seq++;
     }
 
     Pthread_mutex_unlock(&tran->store_mtx);
@@ -882,9 +911,60 @@ get_next_merge_tmps(struct temp_cursor *dbc, struct temp_cursor *dbc_ins,
 #define DEBUG_PRINT_TMPBL_READ()
 #endif
 
+/* Advance a lookahead cursor until it is gbl_osql_apply_prefault_lookahead
+ * ops ahead of the apply cursor, enqueuing a prefault for each op it passes.
+ */
+static void apply_lookahead_fill(struct ireq *iq, osql_sess_t *sess,
+                                 apply_lookahead_t *la, struct temp_cursor *cur,
+                                 int *ahead, bool *done)
+{
+    int bdberr = 0;
+
+    while (!*done && *ahead < gbl_osql_apply_prefault_lookahead) {
+        int rc = bdb_temp_table_next(thedb->bdb_env, cur, &bdberr);
+        if (rc) {
+            *done = true;
+            break;
+        }
+
+        oplog_key_t *key = (oplog_key_t *)bdb_temp_table_key(cur);
+        /* with reordering the INS temp table holds no OSQL_USEDB ops, use
+         * the table index of the key instead */
+        if (key->tbl_idx > 0 && key->tbl_idx <= thedb->num_dbs)
+            la->last_db = thedb->dbs[key->tbl_idx - 1];
+
+        osql_page_prefault_step(bdb_temp_table_data(cur),
+                                bdb_temp_table_datasize(cur), &la->last_db,
+                                *(iq->osql_step_ix), sess->rqid, sess->uuid,
+                                key->seq);
+        ATOMIC_ADD64(gbl_osql_apply_prefault_ops, 1);
+        (*ahead)++;
+    }
+}
+
+static void apply_lookahead_step(struct ireq *iq, osql_sess_t *sess,
+                                 apply_lookahead_t *la, bool applied_ins)
+{
+    if (!la)
+        return;
+
+    if (applied_ins) {
+        if (la->ahead_ins > 0)
+            la->ahead_ins--;
+    } else if (la->ahead > 0) {
+        la->ahead--;
+    }
+
+    apply_lookahead_fill(iq, sess, la, la->cur, &la->ahead, &la->done);
+    if (la->cur_ins)
+        apply_lookahead_fill(iq, sess, la, la->cur_ins, &la->ahead_ins,
+                             &la->done_ins);
+}
+
 static int process_this_session(
     struct ireq *iq, void *iq_tran, osql_sess_t *sess, int *bdberr, int *nops,
     struct block_err *err, struct temp_cursor *dbc, struct temp_cursor *dbc_ins,
+    apply_lookahead_t *la,
     int (*func)(struct ireq *, unsigned long long, uuid_t, void *, char **, int,
                 int *, int **, blob_buffer_t blobs[MAXBLOBS], int,
                 struct block_err *, int *))
@@ -952,6 +1032,14 @@ static int process_this_session(
     if (sess->tran_rows > 1 && gbl_reorder_idx_writes)
         iq->osql_flags |= OSQL_FLAGS_REORDER_IDX_ON;
 
+    /* prime the lookahead before the first op is applied */
+    if (la) {
+        apply_lookahead_fill(iq, sess, la, la->cur, &la->ahead, &la->done);
+        if (la->cur_ins)
+            apply_lookahead_fill(iq, sess, la, la->cur_ins, &la->ahead_ins,
+                                 &la->done_ins);
+    }
+
     while (!rc && !rc_out) {
         char *data = NULL;
         int datalen = 0;
@@ -990,6 +1078,7 @@ static int process_this_session(
         }
 
         step++;
+        apply_lookahead_step(iq, sess, la, drain_adds);
         rc = get_next_merge_tmps(dbc, dbc_ins, &opkey, &opkey_ins, &drain_adds,
                                  bdberr, add_stripe);
     }
@@ -1036,6 +1125,8 @@ static int apply_changes(struct ireq *iq, blocksql_tran_t *tran, void *iq_tran,
     int bdberr = 0;
     struct temp_cursor *dbc = NULL;
     struct temp_cursor *dbc_ins = NULL;
+    apply_lookahead_t lookahead = {0};
+    apply_lookahead_t *la = NULL;
 
     /* lock the table (it should get no more access anway) */
     Pthread_mutex_lock(&tran->store_mtx);
@@ -1077,14 +1168,33 @@ static int apply_changes(struct ireq *iq, blocksql_tran_t *tran, void *iq_tran,
         }
     }
 
+    /* the lookahead reuses the prefault step slot allocated in saveop; it
+     * is a best effort, so run without it if a cursor cannot be had */
+    if (gbl_osql_apply_prefault_lookahead > 0 && gbl_osqlpfault_threads &&
+        iq->osql_step_ix) {
+        lookahead.cur =
+            bdb_temp_table_cursor(thedb->bdb_env, tran->db, NULL, &bdberr);
+        if (lookahead.cur && tran->db_ins)
+            lookahead.cur_ins = bdb_temp_table_cursor(
+                thedb->bdb_env, tran->db_ins, NULL, &bdberr);
+        if (lookahead.cur && (!tran->db_ins || lookahead.cur_ins))
+            la = &lookahead;
+        bdberr = 0;
+    }
+
     listc_init(&iq->bpfunc_lst, offsetof(bpfunc_lstnode_t, linkct));
 
     /* go through the complete list and apply all the changes */
     out_rc = process_this_session(iq, iq_tran, iq->sorese, &bdberr, nops, err,
-                                  dbc, dbc_ins, func);
+                                  dbc, dbc_ins, la, func);
 
     Pthread_mutex_unlock(&tran->store_mtx);
 
+    if (lookahead.cur)
+        bdb_temp_table_close_cursor(thedb->bdb_env, lookahead.cur, &bdberr);
+    if (lookahead.cur_ins)
+        bdb_temp_table_close_cursor(thedb->bdb_env, lookahead.cur_ins, &bdberr);
+
     /* close the cursor */
     rc = bdb_temp_table_close_cursor(thedb->bdb_env, dbc, &bdberr);
     if (rc != 0) {
@@ -607,6 +607,7 @@ int osql_checkboard_update_status(unsigned long long rqid, uuid_t uuid,
     Pthread_mutex_unlock(&checkboard->mtx);
 
     entry->status = status;
+    entry->master_caps |= status;
     entry->timestamp = timestamp;
     entry->last_updated = comdb2_time_epochms();
 
@@ -615,6 +616,31 @@ int osql_checkboard_update_status(unsigned long long rqid, uuid_t uuid,
     return 0;
 }
 
+/**
+ * Return the OSQL_MASTER_CAP_* bits the master acked for this session
+ *
+ */
+int osql_chkboard_master_caps(unsigned long long rqid, uuid_t uuid)
+{
+    int caps = 0;
+
+    if (!checkboard)
+        return 0;
+
+    Pthread_mutex_lock(&checkboard->mtx);
+
+    osql_sqlthr_t *entry = osql_chkboard_fetch_entry(rqid, uuid, false);
+    if (entry) {
+        Pthread_mutex_lock(&entry->mtx);
+        caps = entry->master_caps;
+        Pthread_mutex_unlock(&entry->mtx);
+    }
+
+    Pthread_mutex_unlock(&checkboard->mtx);
+
+    return caps;
+}
+
 /**
  * Reset fields when a session is retried
  * we're interested in things like master_changed
@@ -646,6 +672,7 @@ int osql_reuse_sqlthr(struct sqlclntstate *clnt, const char *master)
         comdb2_time_epochms(); /* reset these time */
     entry->done = 0;
     entry->master_changed = 0;
+    entry->master_caps = 0; /* the new session request is acked again */
     entry->master =
         master ? master : gbl_myhostname; /* master changed, store it here */
     bzero(&entry->err, sizeof(entry->err));
@@ -33,6 +33,10 @@
 struct errstat;
 struct sqlclntstate;
 
+/* capability bits a master returns in the status of an OSQL_EXISTS reply to
+ * the session request; they stick for the lifetime of the session */
+enum { OSQL_MASTER_CAP_INSERT_BATCH = 0x00000001 };
+
 struct osql_sqlthr {
     struct errstat err;  /* valid if done = 1 */
     pthread_cond_t cond;
@@ -55,6 +59,7 @@ struct osql_sqlthr {
     int last_updated; /* poking support: when was the last time I got info, 0 is
                          never */
     int last_checked; /* poking support: when was the loast poke sent */
+    int master_caps;  /* OSQL_MASTER_CAP_* acked by the master */
 };
 typedef struct osql_sqlthr osql_sqlthr_t;
 
@@ -122,6 +127,12 @@ int osql_chkboard_wait_commitrc(unsigned long long rqid, uuid_t uuid,
  */
 int osql_checkboard_update_status(unsigned long long rqid, uuid_t uuid,
                                   int status, int timestamp);
+
+/**
+ * Return the OSQL_MASTER_CAP_* bits the master acked for this session
+ *
+ */
+int osql_chkboard_master_caps(unsigned long long rqid, uuid_t uuid);
 /**
  * Reset fields when a session is retried
  * we're interested in things like master_changed
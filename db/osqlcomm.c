@@ -24,6 +24,7 @@
 #include "osqlcheckboard.h"
 #include "osqlrepository.h"
 #include "osqlblockproc.h"
+#include "comdb2_atomic.h"
 #include <compile_time_assert.h>
 #include <netinet/in.h>
 #include <endian_core.h>
@@ -54,6 +55,9 @@
 #include "osqlsqlsocket.h"
 #include "sc_global.h"
 
+#include <mem_osql.h>
+#include <mem_override.h>
+
 
 #define MAX_CLUSTER 16
 
@@ -70,6 +74,7 @@ extern int gbl_goslow;
 extern int gbl_partial_indexes;
 
 int gbl_master_sends_query_effects = 1;
+int64_t gbl_osql_insert_batches;
 int gbl_toblock_random_deadlock_trans;
 int gbl_selectv_writelock = 0;
 
@@ -1959,6 +1964,81 @@ osqlcomm_ins_uuid_rpl_type_put(const osql_ins_uuid_rpl_t *p_osql_ins_uuid_rpl,
     return p_buf;
 }
 
+/* OSQL_INSERT_BATCH carries "nrows" fixed width ondisk rows of one table,
+ * stored back to back after a single header; it is only used for rows that
+ * have no blobs, no upsert flags and no replicant generated index keys */
+typedef struct osql_ins_batch {
+    int nrows;
+    int rowlen;
+} osql_ins_batch_t;
+
+enum { OSQLCOMM_INS_BATCH_TYPE_LEN = 4 + 4 };
+
+BB_COMPILE_TIME_ASSERT(osqlcomm_ins_batch_type_len,
+                       sizeof(osql_ins_batch_t) == OSQLCOMM_INS_BATCH_TYPE_LEN);
+
+static uint8_t *osqlcomm_ins_batch_type_put(const osql_ins_batch_t *p_batch,
+                                            uint8_t *p_buf,
+                                            const uint8_t *p_buf_end)
+{
+    if (p_buf_end < p_buf || OSQLCOMM_INS_BATCH_TYPE_LEN > (p_buf_end - p_buf))
+        return NULL;
+
+    p_buf = buf_put(&(p_batch->nrows), sizeof(p_batch->nrows), p_buf,
+                    p_buf_end);
+    p_buf = buf_put(&(p_batch->rowlen), sizeof(p_batch->rowlen), p_buf,
+                    p_buf_end);
+    /* leave p_buf pointing at the rows */
+
+    return p_buf;
+}
+
+static const uint8_t *osqlcomm_ins_batch_type_get(osql_ins_batch_t *p_batch,
+                                                  const uint8_t *p_buf,
+                                                  const uint8_t *p_buf_end)
+{
+    if (p_buf_end < p_buf || OSQLCOMM_INS_BATCH_TYPE_LEN > (p_buf_end - p_buf))
+        return NULL;
+
+    p_buf = buf_get(&(p_batch->nrows), sizeof(p_batch->nrows), p_buf,
+                    p_buf_end);
+    p_buf = buf_get(&(p_batch->rowlen), sizeof(p_batch->rowlen), p_buf,
+                    p_buf_end);
+    /* leave p_buf pointing at the rows */
+
+    return p_buf;
+}
+
+typedef struct osql_ins_batch_uuid_rpl {
+    osql_uuid_rpl_t hd;
+    osql_ins_batch_t dt;
+} osql_ins_batch_uuid_rpl_t;
+
+enum {
+    OSQLCOMM_INS_BATCH_UUID_RPL_TYPE_LEN =
+        OSQLCOMM_UUID_RPL_TYPE_LEN + OSQLCOMM_INS_BATCH_TYPE_LEN
+};
+
+static uint8_t *osqlcomm_ins_batch_uuid_rpl_type_put(
+    const osql_ins_batch_uuid_rpl_t *p_rpl, uint8_t *p_buf,
+    const uint8_t *p_buf_end)
+{
+    p_buf = osqlcomm_uuid_rpl_type_put(&(p_rpl->hd), p_buf, p_buf_end);
+    p_buf = osqlcomm_ins_batch_type_put(&(p_rpl->dt), p_buf, p_buf_end);
+    return p_buf;
+}
+
+int osql_insert_batch_nrows(const char *rpl, int rplen)
+{
+    osql_ins_batch_t dt = {0};
+    const uint8_t *p_buf = (const uint8_t *)rpl + OSQLCOMM_UUID_RPL_TYPE_LEN;
+    const uint8_t *p_buf_end = (const uint8_t *)rpl + rplen;
+
+    if (!osqlcomm_ins_batch_type_get(&dt, p_buf, p_buf_end))
+        return 0;
+    return dt.nrows;
+}
+
 typedef struct osql_updstat {
     unsigned long long seq;
     int padding1;
@@ -3220,6 +3300,7 @@ int osql_comm_is_done(osql_sess_t *sess, int type, char *rpl, int rpllen,
     case OSQL_USEDB:
     case OSQL_INSREC:
     case OSQL_INSERT:
+    case OSQL_INSERT_BATCH:
     case OSQL_INSIDX:
     case OSQL_DELIDX:
     case OSQL_QBLOB:
@@ -4131,6 +4212,54 @@ int osql_send_insrec(osql_target_t *target, unsigned long long rqid,
                         (nData > sent) ? nData - sent : 0);
 }
 
+/**
+ * Send INSERT_BATCH op
+ * It handles remote/local connectivity
+ *
+ */
+int osql_send_insrec_batch(osql_target_t *target, unsigned long long rqid,
+                           uuid_t uuid, char *rows, int nrows, int rowlen,
+                           int type)
+{
+    uint8_t buf[OSQLCOMM_INS_BATCH_UUID_RPL_TYPE_LEN];
+    uint8_t *p_buf = buf;
+    uint8_t *p_buf_end = p_buf + sizeof(buf);
+    osql_ins_batch_uuid_rpl_t rpl = {{0}};
+
+    /* batches are only understood in uuid mode */
+    if (rqid != OSQL_RQID_USE_UUID) {
+        logmsg(LOGMSG_ERROR, "%s: insert batch not supported in legacy mode\n",
+               __func__);
+        return -1;
+    }
+
+    if (check_master(target))
+        return OSQL_SEND_ERROR_WRONGMASTER;
+
+    rpl.hd.type = OSQL_INSERT_BATCH;
+    comdb2uuidcpy(rpl.hd.uuid, uuid);
+    rpl.dt.nrows = nrows;
+    rpl.dt.rowlen = rowlen;
+
+    if (!(p_buf = osqlcomm_ins_batch_uuid_rpl_type_put(&rpl, p_buf,
+                                                       p_buf_end))) {
+        logmsg(LOGMSG_ERROR, "%s:%s returns NULL\n", __func__,
+               "osqlcomm_ins_batch_uuid_rpl_type_put");
+        return -1;
+    }
+
+    if (gbl_enable_osql_logging) {
+        uuidstr_t us;
+        logmsg(LOGMSG_DEBUG, "[%llx %s] send OSQL_INSERT_BATCH %d rows\n",
+               rqid, comdb2uuidstr(uuid, us), nrows);
+    }
+
+    type = osql_net_type_to_net_uuid_type(NET_OSQL_SOCK_RPL);
+
+    return target->send(target, type, buf, sizeof(buf), 0, rows,
+                        nrows * rowlen);
+}
+
 int osql_send_dbq_consume(osql_target_t *target, unsigned long long rqid,
                           uuid_t uuid, genid_t genid, int type)
 {
@@ -5701,6 +5830,7 @@ static inline int is_write_request(int type)
     case OSQL_UPDSTAT:
     case OSQL_INSREC:
     case OSQL_INSERT:
+    case OSQL_INSERT_BATCH:
     case OSQL_UPDREC:
     case OSQL_UPDATE:
         return 1;
@@ -6314,6 +6444,84 @@ int osql_process_packet(struct ireq *iq, unsigned long long rqid, uuid_t uuid,
         }
         (*receivedrows)++;
     } break;
+    case OSQL_INSERT_BATCH: {
+        osql_ins_batch_t dt = {0};
+        const uint8_t *p_buf_end = (const uint8_t *)msg + msglen;
+        unsigned char *pData;
+        int rrn = 0;
+        unsigned long long newgenid = 0;
+
+        pData = (uint8_t *)osqlcomm_ins_batch_type_get(&dt, p_buf, p_buf_end);
+        if (!pData || dt.nrows <= 0 || dt.rowlen <= 0 ||
+            (p_buf_end - pData) / dt.rowlen < dt.nrows) {
+            logmsg(LOGMSG_ERROR, "%s: malformed OSQL_INSERT_BATCH\n",
+                   __func__);
+            return ERR_BADREQ;
+        }
+
+        if (gbl_enable_osql_logging) {
+            uuidstr_t us;
+            logmsg(LOGMSG_DEBUG, "[%llu %s] OSQL_INSERT_BATCH %d rows of %d\n",
+                   rqid, comdb2uuidstr(uuid, us), dt.nrows, dt.rowlen);
+        }
+
+        int addflags = RECFLAGS_DYNSCHEMA_NULLS_ONLY | RECFLAGS_DONT_LOCK_TBL;
+        if (!iq->sorese->is_delayed && iq->usedb->n_constraints == 0 &&
+            gbl_goslow == 0) {
+            addflags |= RECFLAGS_NO_CONSTRAINTS;
+        } else {
+            iq->sorese->is_delayed = true;
+        }
+
+        /* same as nrows back to back OSQL_INSERTs with no blobs, no
+         * upsert flags and all keys */
+        for (int i = 0; i < dt.nrows; i++, pData += dt.rowlen) {
+            rc = add_record(iq, trans, tag_name_ondisk,
+                            tag_name_ondisk + tag_name_ondisk_len, /*tag*/
+                            pData, pData + dt.rowlen,              /*dta*/
+                            NULL, blobs, MAXBLOBS, &err->errcode, &err->ixnum,
+                            &rrn, &newgenid, -1ULL, BLOCK2_ADDKL, step,
+                            addflags, 0);
+            if (iq->idxInsert || iq->idxDelete) {
+                free_cached_idx(iq->idxInsert);
+                free_cached_idx(iq->idxDelete);
+                free(iq->idxInsert);
+                free(iq->idxDelete);
+                iq->idxInsert = iq->idxDelete = NULL;
+            }
+
+            if (rc != 0) {
+                if (err->errcode == OP_FAILED_UNIQ) {
+                    reqerrstr(iq, COMDB2_CSTRT_RC_DUP, "add key constraint "
+                                                       "duplicate key '%s' on "
+                                                       "table '%s' index %d",
+                              get_keynm_from_db_idx(iq->usedb, err->ixnum),
+                              iq->usedb->tablename, err->ixnum);
+                } else if (rc != RC_INTERNAL_RETRY) {
+                    errstat_cat_strf(&iq->errstat,
+                                     " unable to add record rc = %d", rc);
+                }
+
+                if (gbl_enable_osql_logging)
+                    logmsg(LOGMSG_DEBUG,
+                           "Added batch record %d failed, rrn = %d\n", i,
+                           rrn);
+
+                return rc; /*this is blkproc rc */
+            }
+
+            if (gbl_enable_osql_logging)
+                logmsg(LOGMSG_DEBUG,
+                       "Added new record rrn = %d, newgenid=%llx\n", rrn,
+                       bdb_genid_to_host_order(newgenid));
+
+            if (likely(gbl_master_sends_query_effects) && IQ_HAS_SNAPINFO(iq)) {
+                IQ_SNAPINFO(iq)->effects.num_inserted++;
+            }
+            (*receivedrows)++;
+        }
+        ATOMIC_ADD64(gbl_osql_insert_batches, 1);
+    } break;
     case OSQL_STARTGEN: {
         osql_startgen_t dt = {0};
         uint32_t cur_gen;
@@ -6780,6 +6988,37 @@ void signal_replicant_error(osql_target_t *target, unsigned long long rqid,
     }
 }
 
+/* Answer a session request with the OSQL_MASTER_CAP_* bits this master
+ * supports, in the status of an unsolicited OSQL_EXISTS reply; replicants
+ * that did not ask never get one */
+static void osql_ack_master_caps(char *fromhost, uuid_t uuid, int caps)
+{
+    if (fromhost == gbl_myhostname) {
+        osql_checkboard_update_status(OSQL_RQID_USE_UUID, uuid, caps,
+                                      comdb2_time_epoch());
+        return;
+    }
+
+    uint8_t buf[OSQLCOMM_EXISTS_UUID_RPL_TYPE_LEN];
+    osql_exists_uuid_rpl_t rpl = {{0}};
+
+    rpl.hd.type = OSQL_EXISTS;
+    comdb2uuidcpy(rpl.hd.uuid, uuid);
+    rpl.dt.status = caps;
+    rpl.dt.timestamp = comdb2_time_epoch();
+
+    if (!osqlcomm_exists_uuid_rpl_type_put(&rpl, buf, buf + sizeof(buf)))
+        abort();
+
+    int rc = offload_net_send(fromhost, NET_OSQL_MASTER_CHECKED_UUID, buf,
+                              sizeof(buf), 1, NULL, 0);
+    if (rc) {
+        /* the replicant just doesn't batch */
+        logmsg(LOGMSG_DEBUG, "%s: failed to ack %s rc=%d\n", __func__,
+               fromhost, rc);
+    }
+}
+
 static int sorese_rcvreq(char *fromhost, void *dtap, int dtalen, int type,
                          int nettype)
 {
@@ -6859,8 +7098,13 @@ done:
          */
 
         rc = osql_repository_put(sess);
-        if (!rc)
+        if (!rc) {
+            if ((flags & OSQL_FLAGS_INSERT_BATCH) &&
+                rqid == OSQL_RQID_USE_UUID)
+                osql_ack_master_caps(fromhost, uuid,
+                                     OSQL_MASTER_CAP_INSERT_BATCH);
             return 0;
+        }
         /* if put noticed a termination flag, fall-through */
         send_rc = 1;
     }
@@ -109,6 +109,21 @@ int osql_send_insrec(osql_target_t *target, unsigned long long rqid,
                      unsigned long long dirty_keys, char *pData, int nData,
                      int type, int upsert_flags);
 
+/**
+ * Send INSERT_BATCH op: "nrows" ondisk rows of "rowlen" bytes each,
+ * stored back to back in "rows", for the table of the last usedb
+ *
+ */
+int osql_send_insrec_batch(osql_target_t *target, unsigned long long rqid,
+                           uuid_t uuid, char *rows, int nrows, int rowlen,
+                           int type);
+
+/**
+ * Return the number of rows carried by an INSERT_BATCH op
+ *
+ */
+int osql_insert_batch_nrows(const char *rpl, int rplen);
+
 /**
  * Send DELREC op
  * It handles remote/local connectivity
@@ -376,6 +391,10 @@ int osql_page_prefault(char *rpl, int rplen, struct dbtable **last_db,
                        int **iq_step_ix, unsigned long long rqid, uuid_t uuid,
                        unsigned long long seq);
 
+int osql_page_prefault_step(char *rpl, int rplen, struct dbtable **last_db,
+                            int last_step_idex, unsigned long long rqid,
+                            uuid_t uuid, unsigned long long seq);
+
 int osql_set_usedb(struct ireq *iq, const char *tablename, int tableversion,
                    int step, struct block_err *err);
 
@@ -562,30 +562,70 @@ static void osqlpfault_do_work_pp(struct thdpool *pool, void *work,
     free(req);
 }
 
+/* The step slot belongs to the session's ireq, `*iq_step_ix', from its
+ * first bplog op until osql_page_prefault_release().  If all slots are
+ * taken the session goes without prefaulting. */
 int osql_page_prefault(char *rpl, int rplen, struct dbtable **last_db,
                        int **iq_step_ix, unsigned long long rqid, uuid_t uuid,
                        unsigned long long seq)
 {
-    static int last_step_idex = 0;
     int *ii;
-    osql_rpl_t rpl_op;
-    uint8_t *p_buf = (uint8_t *)rpl;
-    uint8_t *p_buf_end = p_buf + rplen;
-    osqlcomm_rpl_type_get(&rpl_op, p_buf, p_buf_end);
 
-    if (seq == 0) {
+    if (seq == 0 && *iq_step_ix == NULL) {
         Pthread_mutex_lock(&osqlpf_mutex);
         ii = queue_next(gbl_osqlpf_stepq);
         Pthread_mutex_unlock(&osqlpf_mutex);
         if (ii == NULL) {
-            logmsg(LOGMSG_ERROR, "osql io prefault got a BUG!\n");
-            exit(1);
+            static int lastpr = 0;
+            int now = comdb2_time_epoch();
+            if (now != lastpr) {
+                logmsg(LOGMSG_WARN,
+                       "%s: no free prefault step slot, not prefaulting\n",
+                       __func__);
+                lastpr = now;
+            }
+            return 0;
         }
-        last_step_idex = *ii;
+        gbl_osqlpf_step[*ii].rqid = rqid;
+        comdb2uuidcpy(gbl_osqlpf_step[*ii].uuid, uuid);
         *iq_step_ix = ii;
-        gbl_osqlpf_step[last_step_idex].rqid = rqid;
-        comdb2uuidcpy(gbl_osqlpf_step[last_step_idex].uuid, uuid);
     }
+    if (*iq_step_ix == NULL)
+        return 0;
+
+    return osql_page_prefault_step(rpl, rplen, last_db, **iq_step_ix, rqid,
+                                   uuid, seq);
+}
+
+/* Give the session's step slot back, whichever way the session ends */
+void osql_page_prefault_release(int **iq_step_ix)
+{
+    int *ii = *iq_step_ix;
+
+    if (ii == NULL)
+        return;
+    gbl_osqlpf_step[*ii].rqid = 0;
+    gbl_osqlpf_step[*ii].step = 0;
+    Pthread_mutex_lock(&osqlpf_mutex);
+    queue_add(gbl_osqlpf_stepq, ii);
+    Pthread_mutex_unlock(&osqlpf_mutex);
+    *iq_step_ix = NULL;
+}
+
+/* enqueue prefault requests for a single bplog op, accounted against an
+ * already allocated step slot; used both when the op is saved and by the
+ * apply lookahead in osqlblockproc.c */
+int osql_page_prefault_step(char *rpl, int rplen, struct dbtable **last_db,
+                            int last_step_idex, unsigned long long rqid,
+                            uuid_t uuid, unsigned long long seq)
+{
+    osql_rpl_t rpl_op;
+    uint8_t *p_buf = (uint8_t *)rpl;
+    uint8_t *p_buf_end = p_buf + rplen;
+    osqlcomm_rpl_type_get(&rpl_op, p_buf, p_buf_end);
+
+    if (rpl_op.type != OSQL_USEDB && *last_db == NULL)
+        return 0;
 
     switch (rpl_op.type) {
     case OSQL_USEDB: {
@@ -624,6 +664,18 @@ int osql_page_prefault(char *rpl, int rplen, struct dbtable **last_db,
         enque_osqlpfault_newdata_newkeys(*last_db, pData, dt.nData,
                                          last_step_idex, rqid, uuid, seq);
     } break;
+    case OSQL_INSERT_BATCH: {
+        osql_ins_batch_t dt = {0};
+        unsigned char *pData;
+        p_buf = (uint8_t *)rpl + OSQLCOMM_UUID_RPL_TYPE_LEN;
+        pData = (uint8_t *)osqlcomm_ins_batch_type_get(&dt, p_buf, p_buf_end);
+        if (!pData || dt.rowlen <= 0)
+            break;
+        for (int i = 0; i < dt.nrows && (p_buf_end - pData) >= dt.rowlen;
+             i++, pData += dt.rowlen)
+            enque_osqlpfault_newdata_newkeys(*last_db, pData, dt.rowlen,
+                                             last_step_idex, rqid, uuid, seq);
+    } break;
     case OSQL_UPDREC:
     case OSQL_UPDATE: {
         osql_upd_t dt;
@@ -51,14 +51,15 @@ XMACRO_OSQL_RPL_TYPES( OSQL_INSIDX,            25, "OSQL_INSIDX" ) /* for indexe
 XMACRO_OSQL_RPL_TYPES( OSQL_DBQ_CONSUME_UUID,  26, "OSQL_DBQ_CONSUME_UUID" ) /* not in use */                                \
 XMACRO_OSQL_RPL_TYPES( OSQL_STARTGEN,          27, "OSQL_STARTGEN" )                                                         \
 XMACRO_OSQL_RPL_TYPES( OSQL_DONE_WITH_EFFECTS, 28, "OSQL_DONE_WITH_EFFECTS" )                                                \
-XMACRO_OSQL_RPL_TYPES( MAX_OSQL_TYPES,         29, "OSQL_MAX")
+XMACRO_OSQL_RPL_TYPES( OSQL_INSERT_BATCH,      29, "OSQL_INSERT_BATCH" ) /* many blobless rows of one table */               \
+XMACRO_OSQL_RPL_TYPES( MAX_OSQL_TYPES,         30, "OSQL_MAX")
 
 // clang-format on
 
 #ifdef XMACRO_OSQL_RPL_TYPES
 #   undef XMACRO_OSQL_RPL_TYPES
 #endif
-// the following will expand to enum OSQL_RPL_TYPE { OSQL_RPLINV = 0, OSQL_DONE = 1, ..., MAX_OSQL_TYPES = 29, };
+// the following will expand to enum OSQL_RPL_TYPE { OSQL_RPLINV = 0, OSQL_DONE = 1, ..., MAX_OSQL_TYPES = 30, };
 #define XMACRO_OSQL_RPL_TYPES(a, b, c) a = b,
 enum OSQL_RPL_TYPE { OSQL_RPL_TYPES };
 #undef XMACRO_OSQL_RPL_TYPES
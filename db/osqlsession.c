@@ -36,6 +36,9 @@
 #include "reqlog.h"
 #include "osqlsqlnet.h"
 
+#include <mem_osql.h>
+#include <mem_override.h>
+
 struct sess_impl {
     int clients; /* number of threads using the session */
 
@@ -140,6 +143,10 @@ int osql_sess_close(osql_sess_t **psess, bool is_linked)
     if (sess->tran)
         osql_bplog_close(&sess->tran);
 
+    /* a session that ends without committing still holds its slot */
+    if (sess->iq)
+        osql_page_prefault_release(&sess->iq->osql_step_ix);
+
     _destroy_session(psess);
 
     return 0;
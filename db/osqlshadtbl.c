@@ -20,6 +20,7 @@
 #include "osqlshadtbl.h"
 #include "osqlcomm.h"
 #include "sqloffload.h"
+#include "osqlcheckboard.h"
 #include "bdb_osqlcur.h"
 #include <assert.h>
 #include <list.h>
@@ -36,10 +37,21 @@
 
 #include <dbinc/queue.h>
 
+#include <mem_osql.h>
+#include <mem_override.h>
+
 extern int g_osql_max_trans;
 extern int gbl_partial_indexes;
 extern int gbl_expressions_indexes;
 
+/* max rows shipped in one OSQL_INSERT_BATCH; 0 or 1 sends one OSQL_INSERT per
+ * row. Batches are only sent to a master that acked OSQL_FLAGS_INSERT_BATCH
+ * in the session request, so mixed version clusters fall back to per row */
+int gbl_osql_insert_batch_rows = 50;
+
+/* cap on the row payload of a single OSQL_INSERT_BATCH */
+#define OSQL_INSERT_BATCH_MAX_BYTES (1024 * 1024)
+
 typedef struct blob_key {
     unsigned long long seq; /* tbl->seq identifying the owning row */
     unsigned long long id;  /* blob index in the row */
@@ -1916,6 +1928,95 @@ static int process_local_shadtbl_index(struct sqlclntstate *clnt,
     return 0;
 }
 
+typedef struct insert_batch {
+    char *rows;
+    int nrows;
+    int rowlen;
+    int maxrows;
+    int acked; /* the master takes OSQL_INSERT_BATCH */
+} insert_batch_t;
+
+/* rows of this table can be shipped in an OSQL_INSERT_BATCH: the master
+ * acked it, no blobs, no replicant generated index keys and no per-row
+ * dirty keys */
+static int insert_batch_eligible(struct sqlclntstate *clnt, shad_tbl_t *tbl,
+                                 insert_batch_t *batch)
+{
+    return batch->acked && gbl_osql_insert_batch_rows > 1 &&
+           clnt->osql.rqid == OSQL_RQID_USE_UUID && tbl->nblobs == 0 &&
+           !(gbl_expressions_indexes && tbl->ix_expr) &&
+           !(gbl_partial_indexes && tbl->ix_partial);
+}
+
+static int flush_insert_batch(struct sqlclntstate *clnt, insert_batch_t *batch)
+{
+    osqlstate_t *osql = &clnt->osql;
+    int rc;
+
+    if (batch->nrows == 0)
+        return 0;
+
+    if (batch->nrows == 1) {
+        /* not worth a batch header */
+        rc = osql_send_insrec(&osql->target, osql->rqid, osql->uuid, 0, -1ULL,
+                              batch->rows, batch->rowlen,
+                              tran2netrpl(clnt->dbtran.mode), 0);
+    } else {
+        rc = osql_send_insrec_batch(&osql->target, osql->rqid, osql->uuid,
+                                    batch->rows, batch->nrows, batch->rowlen,
+                                    tran2netrpl(clnt->dbtran.mode));
+    }
+    batch->nrows = 0;
+    if (rc) {
+        logmsg(LOGMSG_USER,
+               "%s: error writting record batch to master in offload mode!\n",
+               __func__);
+        return SQLITE_INTERNAL;
+    }
+    return 0;
+}
+
+/* returns 1 if the row was queued, 0 if it has to be sent by itself, or an
+ * error if flushing a full batch failed */
+static int add_to_insert_batch(struct sqlclntstate *clnt, shad_tbl_t *tbl,
+                               insert_batch_t *batch, unsigned long long key,
+                               char *data, int ldata)
+{
+    int rc;
+
+    if (!insert_batch_eligible(clnt, tbl, batch) ||
+        get_rec_flags(clnt, tbl, key, 1) != 0 ||
+        (batch->nrows && ldata != batch->rowlen))
+        goto single;
+
+    if (!batch->rows) {
+        batch->maxrows = OSQL_INSERT_BATCH_MAX_BYTES / ldata;
+        if (batch->maxrows > gbl_osql_insert_batch_rows)
+            batch->maxrows = gbl_osql_insert_batch_rows;
+        if (batch->maxrows < 2)
+            goto single;
+        batch->rows = malloc((size_t)batch->maxrows * ldata);
+        if (!batch->rows)
+            goto single;
+        batch->rowlen = ldata;
+    }
+    if (ldata != batch->rowlen)
+        goto single;
+
+    memcpy(batch->rows + (size_t)batch->nrows * ldata, data, ldata);
+    batch->nrows++;
+    if (batch->nrows >= batch->maxrows) {
+        rc = flush_insert_batch(clnt, batch);
+        if (rc)
+            return rc;
+    }
+    return 1;
+
+single:
+    /* preserve op order */
+    return flush_insert_batch(clnt, batch);
+}
+
 static int process_local_shadtbl_add(struct sqlclntstate *clnt, shad_tbl_t *tbl,
                                      int *bdberr, int crt_nops)
 {
@@ -1923,10 +2024,17 @@ static int process_local_shadtbl_add(struct sqlclntstate *clnt, shad_tbl_t *tbl,
     osqlstate_t *osql = &clnt->osql;
     int rc = 0;
     int osql_nettype = tran2netrpl(clnt->dbtran.mode);
+    insert_batch_t batch = {0};
 
     rc = bdb_temp_table_first(tbl->env->bdb_env, tbl->add_cur, bdberr);
     if (rc == IX_EMPTY)
         return 0;
+
+    /* the ack to the session request normally beats the commit; if it does
+     * not, or the master is older, the rows go one OSQL_INSERT at a time */
+    if (gbl_osql_insert_batch_rows > 1)
+        batch.acked = osql_chkboard_master_caps(osql->rqid, osql->uuid) &
+                      OSQL_MASTER_CAP_INSERT_BATCH;
     if (rc) {
         logmsg(LOGMSG_ERROR, "%s: bdb_temp_table_first failed rc=%d bdberr=%d\n",
                 __func__, rc, *bdberr);
@@ -1951,10 +2059,29 @@ static int process_local_shadtbl_add(struct sqlclntstate *clnt, shad_tbl_t *tbl,
                                        sizeof(key), bdberr);
 
         if (rc < 0)
-            return rc;
+            goto done;
         else if (rc == IX_FND)
             goto next;
 
+        int batched = add_to_insert_batch(clnt, tbl, &batch, key, data, ldata);
+        if (batched < 0 || batched > 1) {
+            rc = batched;
+            goto done;
+        }
+
+        if (batched) {
+            /* no index or blob ops to ship for this row */
+            tbl->nops++;
+            if (clnt->osql_max_trans &&
+                ((tbl->nops + crt_nops) > clnt->osql_max_trans)) {
+                rc = SQLITE_TOOBIG;
+                goto done;
+            }
+            osql->replicant_numops++;
+            DEBUG_PRINT_NUMOPS();
+            goto next;
+        }
+
         if (osql->is_reorder_on) {
             rc = osql_send_insrec(&osql->target, osql->rqid, osql->uuid, key,
                                   (gbl_partial_indexes && tbl->ix_partial)
@@ -1967,7 +2094,8 @@ static int process_local_shadtbl_add(struct sqlclntstate *clnt, shad_tbl_t *tbl,
                 logmsg(LOGMSG_USER,
                        "%s: error writting record to master in offload mode!\n",
                        __func__);
-                return SQLITE_INTERNAL;
+                rc = SQLITE_INTERNAL;
+                goto done;
             }
         }
         rc = process_local_shadtbl_index(clnt, tbl, bdberr, key, 0);
@@ -1988,7 +2116,8 @@ static int process_local_shadtbl_add(struct sqlclntstate *clnt, shad_tbl_t *tbl,
 
         if (clnt->osql_max_trans &&
             ((tbl->nops + crt_nops) > clnt->osql_max_trans)) {
-            return SQLITE_TOOBIG;
+            rc = SQLITE_TOOBIG;
+            goto done;
         }
 
         if (!osql->is_reorder_on) {
@@ -2003,7 +2132,8 @@ static int process_local_shadtbl_add(struct sqlclntstate *clnt, shad_tbl_t *tbl,
                 logmsg(LOGMSG_USER,
                        "%s: error writting record to master in offload mode!\n",
                        __func__);
-                return SQLITE_INTERNAL;
+                rc = SQLITE_INTERNAL;
+                goto done;
             }
         }
         osql->replicant_numops++;
@@ -2013,7 +2143,7 @@ static int process_local_shadtbl_add(struct sqlclntstate *clnt, shad_tbl_t *tbl,
     }
 
     if (rc == IX_PASTEOF || rc == IX_EMPTY) {
-        rc = 0;
+        rc = flush_insert_batch(clnt, &batch);
     } else {
         logmsg(LOGMSG_ERROR,
                "%s:%d bdb_temp_table_next failed rc=%d bdberr=%d\n", __func__,
@@ -2021,6 +2151,8 @@ static int process_local_shadtbl_add(struct sqlclntstate *clnt, shad_tbl_t *tbl,
         /* fall-through */
     }
 
+done:
+    free(batch.rows);
     return rc;
 }
 
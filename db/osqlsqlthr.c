@@ -56,9 +56,13 @@
 #include "schemachange.h"
 #include "db_access.h"
 
+#include <mem_osql.h>
+#include <mem_override.h>
+
 extern int gbl_partial_indexes;
 extern int gbl_expressions_indexes;
 extern int gbl_reorder_socksql_no_deadlock;
+extern int gbl_osql_insert_batch_rows;
 
 int gbl_allow_bplog_restarts = 600;
 int gbl_master_retry_poll_ms = 100;
@@ -299,6 +303,11 @@ retry:
     if (osql->is_reorder_on)
         flags |= OSQL_FLAGS_REORDER_ON;
 
+    /* ask the master whether it takes OSQL_INSERT_BATCH; inserts are only
+     * batched once it acks, see osql_chkboard_master_caps() */
+    if (gbl_osql_insert_batch_rows > 1 && osql->rqid == OSQL_RQID_USE_UUID)
+        flags |= OSQL_FLAGS_INSERT_BATCH;
+
     /* send request to blockprocessor */
     rc = osql_comm_send_socksqlreq(&osql->target, clnt->sql,
                                    strlen(clnt->sql) + 1, osql->rqid,
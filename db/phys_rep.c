@@ -44,6 +44,9 @@ static DB_Connection *get_connect(char *hostname);
 static int insert_connect(char *hostname, char *dbname, size_t tier);
 static void delete_connect(DB_Connection *cnct);
 static LOG_INFO handle_record(LOG_INFO prev_info);
+static LOG_INFO apply_record(LOG_INFO prev_info, unsigned int file,
+                             unsigned int offset, int64_t *timestamp,
+                             void *blob, int blob_len, int *rcout);
 static int find_new_repl_db(void);
 static DB_Connection *get_rand_connect(size_t tier);
 static void *keep_in_sync(void *args);
@@ -59,6 +62,40 @@ static DB_Connection *curr_cnct = NULL;
 
 static volatile int do_repl;
 
+/* Streaming mode: the sync thread receives log records into a bounded
+ * queue and a second thread applies them.  A full queue stops the sync
+ * thread from reading, which in turn stalls the source. */
+int gbl_physrep_streaming = 0;
+int gbl_physrep_stream_queue_bytes = 16 * 1024 * 1024;
+int gbl_physrep_stream_block_rows = 100;
+
+struct physrep_rec {
+    struct physrep_rec *next;
+    unsigned int file;
+    unsigned int offset;
+    int has_timestamp;
+    int64_t timestamp;
+    int len;
+    char blob[1];
+};
+
+static struct {
+    pthread_mutex_t lk;
+    pthread_cond_t cond;
+    pthread_t tid;
+    int started;
+    int stop;
+    int busy;   /* apply thread is applying a record */
+    int failed; /* a record did not apply */
+    struct physrep_rec *head;
+    struct physrep_rec *tail;
+    int64_t bytes;
+    LOG_INFO prev_info; /* last record applied */
+} stream = {PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER};
+
+static int repl_db_streaming = 0;   /* set rowblocks sent on repl_db */
+static time_t stream_fallback_time; /* when we last fell back to pull */
+
 int gbl_deferred_phys_flag = 0;
 unsigned int gbl_deferred_phys_update;
 
@@ -112,6 +149,7 @@ void close_repl_connection(void)
     curr_cnct->is_up = 0;
     cdb2_close(repl_db);
     repl_db_connected = 0;
+    repl_db_streaming = 0;
     if (gbl_verbose_physrep) {
         logmsg(LOGMSG_USER, "%s closed handle\n", __func__);
     }
@@ -121,6 +159,157 @@ int gbl_physrep_register_interval = 3600;
 static int last_register;
 int gbl_blocking_physrep = 0;
 
+static void *stream_apply_thread(void *args)
+{
+    struct physrep_rec *rec;
+    int rc;
+
+    backend_thread_event(thedb, COMDB2_THR_EVENT_START_RDWR);
+
+    Pthread_mutex_lock(&stream.lk);
+    while (!stream.stop) {
+        if ((rec = stream.head) == NULL) {
+            Pthread_cond_wait(&stream.cond, &stream.lk);
+            continue;
+        }
+        if ((stream.head = rec->next) == NULL)
+            stream.tail = NULL;
+        stream.busy = 1;
+        Pthread_mutex_unlock(&stream.lk);
+
+        rc = 0;
+        if (!stream.failed) {
+            stream.prev_info = apply_record(
+                stream.prev_info, rec->file, rec->offset,
+                rec->has_timestamp ? &rec->timestamp : NULL, rec->blob,
+                rec->len, &rc);
+        }
+
+        Pthread_mutex_lock(&stream.lk);
+        if (rc)
+            stream.failed = 1;
+        stream.bytes -= rec->len;
+        stream.busy = 0;
+        free(rec);
+        Pthread_cond_broadcast(&stream.cond);
+    }
+    Pthread_mutex_unlock(&stream.lk);
+
+    backend_thread_event(thedb, COMDB2_THR_EVENT_DONE_RDWR);
+    return NULL;
+}
+
+/* Start a stream at prev_info: nothing may be queued or applying */
+static int stream_start(LOG_INFO prev_info)
+{
+    if (!stream.started) {
+        stream.stop = 0;
+        if (pthread_create(&stream.tid, NULL, stream_apply_thread, NULL)) {
+            logmsg(LOGMSG_ERROR, "%s: couldn't create apply thread\n",
+                   __func__);
+            return -1;
+        }
+        stream.started = 1;
+    }
+    Pthread_mutex_lock(&stream.lk);
+    stream.prev_info = prev_info;
+    stream.failed = 0;
+    Pthread_mutex_unlock(&stream.lk);
+    return 0;
+}
+
+/* Wait for everything received to be applied.  Returns nonzero (once) if
+ * a record failed to apply. */
+static int stream_drain(void)
+{
+    int failed;
+    if (!stream.started)
+        return 0;
+    Pthread_mutex_lock(&stream.lk);
+    while (stream.head || stream.busy)
+        Pthread_cond_wait(&stream.cond, &stream.lk);
+    failed = stream.failed;
+    stream.failed = 0;
+    Pthread_mutex_unlock(&stream.lk);
+    return failed;
+}
+
+static void stream_stop(void)
+{
+    if (!stream.started)
+        return;
+    stream_drain();
+    Pthread_mutex_lock(&stream.lk);
+    stream.stop = 1;
+    Pthread_cond_broadcast(&stream.cond);
+    Pthread_mutex_unlock(&stream.lk);
+    pthread_join(stream.tid, NULL);
+    stream.started = 0;
+}
+
+/* Copy the current row of repl_db onto the apply queue, waiting for room
+ * if the queue is full.  Returns nonzero if the apply thread has failed. */
+static int stream_enqueue(void)
+{
+    char *lsn = (char *)cdb2_column_value(repl_db, 0);
+    int64_t *timestamp = (int64_t *)cdb2_column_value(repl_db, 3);
+    void *blob = cdb2_column_value(repl_db, 4);
+    int blob_len = cdb2_column_size(repl_db, 4);
+    struct physrep_rec *rec;
+    int failed;
+
+    if ((rec = malloc(offsetof(struct physrep_rec, blob) + blob_len)) ==
+        NULL) {
+        logmsg(LOGMSG_ERROR, "%s: out of memory queueing %d bytes\n",
+               __func__, blob_len);
+        return -1;
+    }
+    rec->next = NULL;
+    if (char_to_lsn(lsn, &rec->file, &rec->offset) != 0) {
+        logmsg(LOGMSG_ERROR, "Could not parse lsn:%s\n", lsn);
+    }
+    rec->has_timestamp = (timestamp != NULL);
+    rec->timestamp = timestamp ? *timestamp : 0;
+    rec->len = blob_len;
+    if (blob_len > 0)
+        memcpy(rec->blob, blob, blob_len);
+
+    Pthread_mutex_lock(&stream.lk);
+    /* flow control: always admit one record so a large one can't wedge */
+    while (!stream.failed && stream.bytes > 0 &&
+           stream.bytes + blob_len > gbl_physrep_stream_queue_bytes)
+        Pthread_cond_wait(&stream.cond, &stream.lk);
+    if ((failed = stream.failed) == 0) {
+        if (stream.tail)
+            stream.tail->next = rec;
+        else
+            stream.head = rec;
+        stream.tail = rec;
+        stream.bytes += blob_len;
+        Pthread_cond_broadcast(&stream.cond);
+    }
+    Pthread_mutex_unlock(&stream.lk);
+    if (failed)
+        free(rec);
+    return failed;
+}
+
+/* Stream unless we fell back to the pull protocol recently */
+static int use_streaming(void)
+{
+    if (!gbl_physrep_streaming)
+        return 0;
+    return (time(NULL) - stream_fallback_time) > gbl_physrep_register_interval;
+}
+
+static void stream_fallback(const char *why)
+{
+    logmsg(LOGMSG_WARN,
+           "physrep: %s, falling back to pulling the log for %d seconds\n",
+           why, gbl_physrep_register_interval);
+    stream_fallback_time = time(NULL);
+}
+
 static void *keep_in_sync(void *args)
 {
     /* vars for syncing */
@@ -129,6 +318,7 @@ static void *keep_in_sync(void *args)
     size_t sql_cmd_len = 150;
     char sql_cmd[sql_cmd_len];
     int do_truncate = 0;
+    int streaming;
     int now;
     LOG_INFO info;
     LOG_INFO prev_info;
@@ -143,6 +333,13 @@ static void *keep_in_sync(void *args)
 
 repl_loop:
     while (do_repl) {
+        /* Everything received has to be applied before we look at our log */
+        if (stream_drain()) {
+            stream_fallback("streamed log did not apply");
+            if (repl_db_connected)
+                close_repl_connection();
+        }
+
         if (repl_db_connected && ((now = time(NULL)) - last_register) >
                                      gbl_physrep_register_interval) {
             close_repl_connection();
@@ -187,15 +384,36 @@ repl_loop:
 
         prev_info = info;
 
+        /* Streaming asks the source for a blocking query, with rows
+         * batched into compressed row blocks */
+        streaming = use_streaming();
+        if (streaming && !repl_db_streaming) {
+            snprintf(sql_cmd, sql_cmd_len, "set rowblocks %d",
+                     gbl_physrep_stream_block_rows);
+            if (cdb2_run_statement(repl_db, sql_cmd) != CDB2_OK) {
+                close_repl_connection();
+                continue;
+            }
+            repl_db_streaming = 1;
+        } else if (!streaming && repl_db_streaming) {
+            /* the set would be replayed on every query: start over */
+            close_repl_connection();
+            continue;
+        }
+
         rc = snprintf(sql_cmd, sql_cmd_len,
                       "select * from comdb2_transaction_logs('{%u:%u}'%s)",
                       info.file, info.offset,
-                      (gbl_blocking_physrep ? ", NULL, 1" : ""));
+                      ((streaming || gbl_blocking_physrep) ? ", NULL, 1"
+                                                           : ""));
         if (rc < 0 || rc >= sql_cmd_len)
             logmsg(LOGMSG_ERROR, "sql_cmd buffer is not long enough!\n");
 
         if ((rc = cdb2_run_statement(repl_db, sql_cmd)) != CDB2_OK) {
             logmsg(LOGMSG_ERROR, "Couldn't query the database, retrying\n");
+            /* an older source doesn't know about row blocks */
+            if (streaming && strstr(cdb2_errstr(repl_db), "set command"))
+                stream_fallback("source rejected the log stream");
             close_repl_connection();
             continue;
         }
@@ -208,6 +426,12 @@ repl_loop:
             continue;
         }
 
+        if (streaming && stream_start(prev_info) != 0) {
+            stream_fallback("couldn't start the apply thread");
+            close_repl_connection();
+            continue;
+        }
+
         /* our log matches, so apply each record log received */
         while (do_repl && !do_truncate &&
                (rc = cdb2_next_record(repl_db)) == CDB2_OK) {
@@ -228,7 +452,13 @@ repl_loop:
                 highest_gen = new_gen;
                 goto repl_loop;
             }
-            prev_info = handle_record(prev_info);
+            if (!streaming) {
+                prev_info = handle_record(prev_info);
+            } else if (stream_enqueue() != 0) {
+                /* drained and handled at the top of the loop */
+                do_truncate = 1;
+                goto repl_loop;
+            }
         }
 
         if (rc != CDB2_OK_DONE || do_truncate) {
@@ -238,6 +468,7 @@ repl_loop:
         sleep(1);
     }
 
+    stream_stop();
     close_repl_connection();
     backend_thread_event(thedb, COMDB2_THR_EVENT_DONE_RDWR);
 
@@ -299,6 +530,16 @@ static LOG_INFO handle_record(LOG_INFO prev_info)
         logmsg(LOGMSG_ERROR, "Could not parse lsn:%s\n", lsn);
     }
 
+    return apply_record(prev_info, file, offset, timestamp, blob, blob_len,
+                        &rc);
+}
+
+static LOG_INFO apply_record(LOG_INFO prev_info, unsigned int file,
+                             unsigned int offset, int64_t *timestamp,
+                             void *blob, int blob_len, int *rcout)
+{
+    int rc;
+
     if (gbl_deferred_phys_flag && timestamp) {
         time_t curr_time = time(NULL);
         /* Change this to sleep only once a second to test the
@@ -334,6 +575,7 @@ static LOG_INFO handle_record(LOG_INFO prev_info)
     if (rc != 0) {
         logmsg(LOGMSG_ERROR, "Something went wrong with applying the logs\n");
     }
+    *rcout = rc;
 
     LOG_INFO next_info;
     next_info.file = file;
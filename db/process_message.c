@@ -301,6 +301,8 @@ static const char *HELP_MEMSTAT[] = {
     "Caution should be used when setting the frequency. Performance issues may "
     "result "
     "if auto reporting too frequently.",
+    "memstat slab [on|off name] - show or change the subsystems whose small "
+    "chunks are cached per thread. 'name' may be '*' for all subsystems.",
     "", "Examples",
     "memstat hr - display memstats on all subsystems in human readable format",
     "memstat total_asc - display memstats on all subsystems sorted by memory "
@@ -601,6 +603,7 @@ void bdb_print_logfile_pglogs_stat();
 void bdb_clear_logfile_pglogs_stat();
 #endif
 void bdb_osql_trn_clients_status();
+void bdb_osql_undo_stat(void);
 void bdb_newsi_mempool_stat();
 
 static pthread_mutex_t exiting_lock = PTHREAD_MUTEX_INITIALIZER;
@@ -934,6 +937,7 @@ clipper_usage:
                gbl_new_snapisol_logging ? "ENABLED" : "DISABLED",
                gbl_new_snapisol_asof ? "ENABLED" : "DISABLED");
         bdb_osql_trn_clients_status();
+        bdb_osql_undo_stat();
         logmsg(LOGMSG_USER, "Release locks on snapisol lockwait count: %llu\n",
                release_locks_on_si_lockwait_cnt);
         if (gbl_new_snapisol) {
@@ -1016,6 +1020,27 @@ clipper_usage:
             }
             tok = segtok(line, lline, &st, &ltok);
         }
+    } else if (tokcmp(tok, ltok, "keycmpbench") == 0) {
+        /* time memcmp against comdb2_keycmp on the table's index pages */
+        char table[MAXTABLELEN];
+        struct dbtable *db;
+        int iterations = 0;
+
+        tok = segtok(line, lline, &st, &ltok);
+        if (ltok == 0) {
+            logmsg(LOGMSG_ERROR, "Usage: keycmpbench <table> [iterations]\n");
+            return -1;
+        }
+        tokcpy0(tok, ltok, table, sizeof(table));
+        db = get_dbtable_by_name(table);
+        if (!db) {
+            logmsg(LOGMSG_ERROR, "unknown table '%s'\n", table);
+            return -1;
+        }
+        tok = segtok(line, lline, &st, &ltok);
+        if (ltok > 0)
+            iterations = toknum(tok, ltok);
+        bdb_keycmp_bench(db->handle, iterations);
     } else if (tokcmp(tok, ltok, "pfrmtof") == 0) {
         if (!gbl_pfaultrmt) {
            logmsg(LOGMSG_USER, "remote pfault already switched off for dtastripe\n");
@@ -4717,7 +4742,15 @@ clipper_usage:
             bdb_blkseq_dumpall(thedb->bdb_env);
         } else if (tokcmp(tok, ltok, "logdel") == 0) {
             bdb_blkseq_dumplogs(thedb->bdb_env);
+        } else if (tokcmp(tok, ltok, "stat") == 0) {
+            bdb_blkseq_filter_stats(thedb->bdb_env);
         }
+    } else if (tokcmp(tok, ltok, "serial_index") == 0) {
+        tok = segtok(line, lline, &st, &ltok);
+        if (ltok == 0)
+            return 0;
+        if (tokcmp(tok, ltok, "stat") == 0)
+            bdb_serial_index_stats(thedb->bdb_env);
     } else if (tokcmp(tok, ltok, "panic") == 0) {
         bdb_panic(thedb->bdb_env);
     } else if (tokcmp(tok, ltok, "debug_logreq") == 0) {
@@ -4759,6 +4792,31 @@ clipper_usage:
             if (ltok != 0)
                 gbl_memstat_freq = toknum(tok, ltok);
            logmsg(LOGMSG_USER, "auto report memstat every %d seconds\n", gbl_memstat_freq);
+        } else if (tokcmp(tok, ltok, "slab") == 0) {
+            char *name;
+            int on;
+            tok = segtok(line, lline, &st, &ltok);
+            if (ltok <= 0) {
+                comdb2ma_slab_show_config();
+                return 0;
+            }
+            if (tokcmp(tok, ltok, "on") == 0)
+                on = 1;
+            else if (tokcmp(tok, ltok, "off") == 0)
+                on = 0;
+            else {
+                logmsg(LOGMSG_ERROR, "Expected on or off.\n");
+                return 1;
+            }
+            tok = segtok(line, lline, &st, &ltok);
+            if (ltok <= 0) {
+                logmsg(LOGMSG_ERROR, "Requires an argument.\n");
+                return 1;
+            }
+            name = tokdup(tok, ltok);
+            if ((on ? comdb2ma_slab_on(name) : comdb2ma_slab_off(name)) != 0)
+                logmsg(LOGMSG_ERROR, "Unknown subsystem %s.\n", name);
+            free(name);
 #ifndef COMDB2MA_OMIT_DEBUG
         } else if (tokcmp(tok, ltok, "debug") == 0) {
             tok = segtok(line, lline, &st, &ltok);
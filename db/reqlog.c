@@ -2089,6 +2089,7 @@ void reqlog_end_request(struct reqlogger *logger, int rc, const char *callfunc,
             osql_bplog_time_done(&logger->iq->timings);
 
         /* here, closing the session doesn't destroy iq*/
+        osql_page_prefault_release(&logger->iq->osql_step_ix);
         logger->iq->sorese->iq = NULL;
         osql_sess_close(&logger->iq->sorese, true);
     }
@@ -860,6 +860,11 @@ struct sqlclntstate {
     int8_t rowbuffer;
     /* 1 if client has requested flat column values. */
     int flat_col_vals;
+    /* 1 if client can unpack rows batched into ROW_BLOCK responses. */
+    int row_blocks;
+    /* rows per ROW_BLOCK for this connection (SET ROWBLOCKS); 0 uses the
+       newsql_row_block_rows tunable */
+    int row_block_rows;
 };
 
 /* Query stats. */
@@ -950,6 +955,7 @@ struct BtCursor {
     int dtabuflen;
     void *keybuf;
     int keybuflen;
+    uint8_t keybuf_stale; /* keybuf not yet rebuilt from lastkey */
 
     int dtabuf_alloc;
     int keybuf_alloc;
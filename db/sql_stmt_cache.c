@@ -19,9 +19,15 @@
 #include "sql.h"
 #include "lrucache.h"
 #include "dohsql.h" // dohsql_wait_for_master()
+#include "comdb2_atomic.h"
 
 int gbl_max_sqlcache = 10;
 int gbl_enable_sql_stmt_caching = STMT_CACHE_ALL;
+/* If set, evict cached statements once all sql threads together hold this
+ * many megabytes of them, instead of capping each thread's entry count. */
+int gbl_max_sqlcache_mem_mb = 0;
+
+static struct stmt_cache_stats stmt_cache_stats;
 
 extern int gbl_debug_temptables;
 static int stmt_cache_finalize_entry(stmt_cache_entry_t *entry);
@@ -134,6 +140,10 @@ static int stmt_cache_requeue_entry(stmt_cache_t *stmt_cache,
 
 static void stmt_cache_free_entry(stmt_cache_entry_t *entry)
 {
+    if (entry->mem) {
+        ATOMIC_ADD64(stmt_cache_stats.mem, -entry->mem);
+        ATOMIC_ADD64(stmt_cache_stats.entries, -1);
+    }
     if (entry->query && gbl_debug_temptables) {
         free(entry->query);
         entry->query = NULL;
@@ -162,9 +172,38 @@ static int stmt_cache_delete_last_entry(stmt_cache_t *stmt_cache, void *list)
                __func__, __LINE__, rc);
     }
     stmt_cache_finalize_entry(entry);
+    ATOMIC_ADD64(stmt_cache_stats.evictions, 1);
     return rc;
 }
 
+/* Make room for a statement using `mem' bytes. Memory is accounted across all
+ * sql threads, but each thread only evicts from its own cache, oldest
+ * statements without parameters first as those are the least likely to be
+ * run again. Returns non zero if the statement would still not fit, which is
+ * the case once other threads hold the whole budget: it must not be cached. */
+static int stmt_cache_make_room(stmt_cache_t *stmt_cache, void *list, int mem)
+{
+    if (gbl_max_sqlcache_mem_mb <= 0) {
+        if (gbl_max_sqlcache <= listc_size(list)) {
+            stmt_cache_delete_last_entry(stmt_cache, list);
+        }
+        return 0;
+    }
+    int64_t limit = (int64_t)gbl_max_sqlcache_mem_mb * 1024 * 1024;
+    while (ATOMIC_LOAD64(stmt_cache_stats.mem) + mem > limit) {
+        if (listc_size(&stmt_cache->noparam_stmt_list) > 0) {
+            stmt_cache_delete_last_entry(stmt_cache,
+                                         &stmt_cache->noparam_stmt_list);
+        } else if (listc_size(&stmt_cache->param_stmt_list) > 0) {
+            stmt_cache_delete_last_entry(stmt_cache,
+                                         &stmt_cache->param_stmt_list);
+        } else {
+            return -1;
+        }
+    }
+    return 0;
+}
+
 /* Remove from queue and stmt_cache->hash this entry so that subsequent finds of
  * the same sql will not find it but rather create a new stmt (to avoid having
  * stmt vdbe used by two sql at the same time). */
@@ -209,15 +248,18 @@ int stmt_cache_add_entry(stmt_cache_t *stmt_cache, const char *sql,
     }
 
     void *list = GET_STMT_LIST(stmt_cache, stmt);
+    int mem = sizeof(stmt_cache_entry_t) +
+              sqlite3_stmt_status(stmt, SQLITE_STMTSTATUS_MEMUSED, 0);
 
     /* remove older entries to make room for new ones */
-    if (gbl_max_sqlcache <= listc_size(list)) {
-        stmt_cache_delete_last_entry(stmt_cache, list);
+    if (stmt_cache_make_room(stmt_cache, list, mem)) {
+        return -1;
     }
 
     stmt_cache_entry_t *entry = sqlite3_malloc(sizeof(stmt_cache_entry_t));
     strncpy(entry->sql, sql, MAX_HASH_SQL_LENGTH - 1);
     entry->stmt = stmt;
+    entry->mem = 0;
 
     query_data_func(clnt, &entry->stmt_data, &entry->stmt_data_sz,
                     QUERY_STMT_DATA, QUERY_DATA_GET);
@@ -230,7 +272,14 @@ int stmt_cache_add_entry(stmt_cache_t *stmt_cache, const char *sql,
     else
         entry->query = NULL;
 
-    return stmt_cache_requeue_entry(stmt_cache, entry);
+    if (stmt_cache_requeue_entry(stmt_cache, entry)) {
+        return -1;
+    }
+    entry->mem = mem;
+    ATOMIC_ADD64(stmt_cache_stats.mem, mem);
+    ATOMIC_ADD64(stmt_cache_stats.entries, 1);
+    ATOMIC_ADD64(stmt_cache_stats.adds, 1);
+    return 0;
 }
 
 int stmt_cache_find_entry(stmt_cache_t *stmt_cache, const char *sql,
@@ -244,14 +293,37 @@ int stmt_cache_find_entry(stmt_cache_t *stmt_cache, const char *sql,
 
     *entry = hash_find(stmt_cache->hash, sql);
 
-    if (*entry == NULL)
+    if (*entry == NULL) {
+        ATOMIC_ADD64(stmt_cache_stats.misses, 1);
         return -1;
+    }
+    ATOMIC_ADD64(stmt_cache_stats.hits, 1);
 
     stmt_cache_remove_entry(stmt_cache, *entry, 0); // will add again when done
 
     return 0;
 }
 
+/* Put back an entry taken out by stmt_cache_find_entry(); it is finalized if
+ * that fails. */
+void stmt_cache_return_entry(stmt_cache_t *stmt_cache,
+                             stmt_cache_entry_t *entry)
+{
+    if (stmt_cache_requeue_entry(stmt_cache, entry)) {
+        stmt_cache_finalize_entry(entry);
+    }
+}
+
+void stmt_cache_get_stats(struct stmt_cache_stats *stats)
+{
+    stats->entries = ATOMIC_LOAD64(stmt_cache_stats.entries);
+    stats->mem = ATOMIC_LOAD64(stmt_cache_stats.mem);
+    stats->hits = ATOMIC_LOAD64(stmt_cache_stats.hits);
+    stats->misses = ATOMIC_LOAD64(stmt_cache_stats.misses);
+    stats->adds = ATOMIC_LOAD64(stmt_cache_stats.adds);
+    stats->evictions = ATOMIC_LOAD64(stmt_cache_stats.evictions);
+}
+
 int stmt_cache_reset(stmt_cache_t *stmt_cache)
 {
     if (!stmt_cache)
@@ -64,6 +64,8 @@ typedef struct stmt_cache_entry {
 
     plugin_query_data_func *qd_func; /* Pointer to the current client info */
 
+    int mem; /* bytes charged against max_sqlcache_mem_mb */
+
     LINKC_T(struct stmt_cache_entry) lnk;
 } stmt_cache_entry_t;
 
@@ -85,6 +87,16 @@ struct sql_state {
     int prepFlags;                  /* flags to get_prepared_stmt_int */
 };
 
+/* Process-wide statement cache counters (comdb2_sql_stmt_cache) */
+struct stmt_cache_stats {
+    int64_t entries;   /* statements held by all sql thread caches */
+    int64_t mem;       /* bytes used by those statements */
+    int64_t hits;
+    int64_t misses;
+    int64_t adds;
+    int64_t evictions;
+};
+
 stmt_cache_t *stmt_cache_new(stmt_cache_t *);
 int stmt_cache_delete(stmt_cache_t *);
 int stmt_cache_reset(stmt_cache_t *);
@@ -99,5 +111,8 @@ int stmt_cache_find_entry(stmt_cache_t *stmt_cache, const char *sql,
 int stmt_cache_add_entry(stmt_cache_t *stmt_cache, const char *sql,
                          const char *actual_sql, sqlite3_stmt *stmt,
                          struct sqlclntstate *clnt);
+void stmt_cache_return_entry(stmt_cache_t *stmt_cache,
+                             stmt_cache_entry_t *entry);
+void stmt_cache_get_stats(struct stmt_cache_stats *);
 
 #endif /* !__INCLUDED_SQL_STMT_CACHE_H */
@@ -108,6 +108,11 @@
 
 int gbl_delay_sql_lock_release_sec = 5;
 
+/* sql temp tables start as in-memory sorted arrays, and only build a berkdb
+ * btree once they outgrow temptable_mem_threshold / temptable_cachesz */
+int gbl_sql_inmem_temptables = 0;
+int gbl_lazy_index_keys = 1;
+
 unsigned long long get_id(bdb_state_type *);
 static void unlock_bdb_cursors(struct sql_thread *thd, bdb_cursor_ifn_t *bdbcur,
                                int *bdberr);
@@ -2530,6 +2535,24 @@ static int cursor_move_table(BtCursor *pCur, int *pRes, int how)
     return outrc;
 }
 
+/* Convert the index key the cursor points to into keybuf */
+static int cook_lastkey(BtCursor *pCur)
+{
+    int rc;
+
+    pCur->keybuf_stale = 0;
+    rc = ondisk_to_sqlite_tz(pCur->db, pCur->sc, pCur->lastkey /* in */,
+                             pCur->rrn, pCur->genid, pCur->keybuf /* out */,
+                             pCur->keybuf_alloc, 0, NULL, NULL, NULL,
+                             &pCur->keybuflen, pCur->clnt->tzname, pCur);
+    if (rc) {
+        /* keys are always fixed length, so -2 should be impossible */
+        logmsg(LOGMSG_ERROR, "%s: ondisk_to_sqlite_tz error rc = %d\n",
+               __func__, rc);
+    }
+    return rc;
+}
+
 static int cursor_move_index(BtCursor *pCur, int *pRes, int how)
 {
     struct sql_thread *thd = pCur->thd;
@@ -2654,15 +2677,11 @@ static int cursor_move_index(BtCursor *pCur, int *pRes, int how)
         if (unlikely(pCur->is_btree_count))
             return outrc;
 
-        /* if this cursor is on a key, convert key */
-        rc = ondisk_to_sqlite_tz(pCur->db, pCur->sc, pCur->lastkey /* in */,
-                                 pCur->rrn, pCur->genid, pCur->keybuf /* out */,
-                                 pCur->keybuf_alloc, 0, NULL, NULL, NULL,
-                                 &pCur->keybuflen, clnt->tzname, pCur);
-
-        if (rc) {
-            /* keys are always fixed length, so -2 should be impossible */
-           logmsg(LOGMSG_ERROR, "%s: ondisk_to_sqlite_tz error rc = %d\n", __func__, rc);
+        /* OP_Column reads the key columns straight from lastkey; the sqlite
+         * record is only built if a comparison asks for it */
+        if (gbl_lazy_index_keys) {
+            pCur->keybuf_stale = 1;
+        } else if (cook_lastkey(pCur)) {
             outrc = SQLITE_INTERNAL;
         }
     } else if (rc == IX_ACCESS) {
@@ -4170,6 +4189,8 @@ int sqlite3BtreeKey(BtCursor *pCur, u32 offset, u32 amt, void *pBuf)
         /* this is genid */
         assert(amt == sizeof(pCur->genid));
         memcpy(pBuf, &pCur->genid, sizeof(pCur->genid));
+    } else if (pCur->keybuf_stale && cook_lastkey(pCur)) {
+        rc = SQLITE_INTERNAL;
     } else {
         memcpy(pBuf, ((char *)pCur->keybuf) + offset, amt);
     }
@@ -4327,6 +4348,8 @@ i64 sqlite3BtreeIntegerKey(BtCursor *pCur)
             memcpy(&size, &pCur->genid, sizeof(unsigned long long));
         else
             size = pCur->rrn;
+    } else if (pCur->keybuf_stale && cook_lastkey(pCur)) {
+        rc = SQLITE_INTERNAL;
     } else {
         size = pCur->keybuflen;
     }
@@ -5155,7 +5178,9 @@ int sqlite3BtreeCreateTable(Btree *pBt, int *piTable, int flags)
         pNewTbl->tbl = tmptbl_clone->tbl;
         pNewTbl->owner = tmptbl_clone->owner;
     } else {
-        pNewTbl->tbl = bdb_temp_table_create(thedb->bdb_env, &bdberr);
+        pNewTbl->tbl = bdb_temp_table_create_flags(
+            thedb->bdb_env,
+            gbl_sql_inmem_temptables ? BDB_TEMP_TABLE_USE_INMEM : 0, &bdberr);
         if (pNewTbl->tbl != NULL) ATOMIC_ADD32(gbl_sql_temptable_count, 1);
     }
     if (pNewTbl->tbl == NULL) {
@@ -5925,6 +5950,7 @@ int sqlite3BtreeMovetoUnpacked(BtCursor *pCur, /* The cursor to be moved */
 #endif
             pCur->eof = 0;
             pCur->lastkey = pCur->fndkey;
+            pCur->keybuf_stale = 0;
             rc = ondisk_to_sqlite_tz(pCur->db, pCur->sc, pCur->fndkey,
                                      pCur->rrn, pCur->genid, pCur->keybuf,
                                      pCur->keybuf_alloc, 0, NULL, NULL, NULL,
@@ -6056,6 +6082,10 @@ const void *sqlite3BtreeKeyFetch(BtCursor *pCur, u32 *pAmt)
         *pAmt = bdb_temp_table_keysize(pCur->tmptable->cursor);
         goto done;
     }
+    if (pCur->keybuf_stale && cook_lastkey(pCur)) {
+        *pAmt = 0;
+        goto done;
+    }
     out = pCur->keybuf;
     *pAmt = pCur->keybuflen;
 done:
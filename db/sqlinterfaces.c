@@ -4361,6 +4361,21 @@ static void sqlengine_work_lua_thread(void *thddata, void *work)
 int gbl_debug_sqlthd_failures;
 int gbl_enable_internal_sql_stmt_caching = 1;
 
+/* Cache the verify indexes statement, or put back the entry it came from. */
+static void verify_indexes_put_stmt(struct sqlthdstate *thd,
+                                    struct sqlclntstate *clnt,
+                                    sqlite3_stmt *stmt,
+                                    stmt_cache_entry_t *cached_entry)
+{
+    if (cached_entry) {
+        stmt_cache_return_entry(thd->stmt_cache, cached_entry);
+    } else if (!gbl_enable_internal_sql_stmt_caching ||
+               stmt_cache_add_entry(thd->stmt_cache, clnt->sql, 0, stmt,
+                                    clnt)) {
+        sqlite3_finalize(stmt);
+    }
+}
+
 static int execute_verify_indexes(struct sqlthdstate *thd,
                                   struct sqlclntstate *clnt)
 {
@@ -4380,6 +4395,7 @@ static int execute_verify_indexes(struct sqlthdstate *thd,
     }
 
     sqlite3_stmt *stmt = NULL;
+    stmt_cache_entry_t *cached_entry = NULL;
     const char *tail;
 
     if (gbl_enable_internal_sql_stmt_caching) {
@@ -4387,10 +4403,11 @@ static int execute_verify_indexes(struct sqlthdstate *thd,
             thd->stmt_cache = stmt_cache_new(NULL);
         }
 
-        stmt_cache_entry_t *cached_entry;
         if ((stmt_cache_find_entry(thd->stmt_cache, clnt->sql,
                                    &cached_entry)) == 0) {
             stmt = cached_entry->stmt;
+        } else {
+            cached_entry = NULL;
         }
     }
 
@@ -4407,19 +4424,11 @@ static int execute_verify_indexes(struct sqlthdstate *thd,
     if ((clnt->step_rc = rc = sqlite3_step(stmt)) == SQLITE_ROW) {
         clnt->has_sqliterow = 1;
         rc = verify_indexes_column_value(stmt, clnt->schema_mems);
-        if (gbl_enable_internal_sql_stmt_caching) {
-            stmt_cache_add_entry(thd->stmt_cache, clnt->sql, 0, stmt, clnt);
-        } else {
-            sqlite3_finalize(stmt);
-        }
+        verify_indexes_put_stmt(thd, clnt, stmt, cached_entry);
         return rc;
     }
 
-    if (gbl_enable_internal_sql_stmt_caching) {
-        stmt_cache_add_entry(thd->stmt_cache, clnt->sql, 0, stmt, clnt);
-    } else {
-        sqlite3_finalize(stmt);
-    }
+    verify_indexes_put_stmt(thd, clnt, stmt, cached_entry);
 
     clnt->has_sqliterow = 0;
     if (rc == SQLITE_DONE) {
@@ -5219,6 +5228,8 @@ void reset_clnt(struct sqlclntstate *clnt, int initial)
     clnt->sqltick = 0;
     clnt->rowbuffer = 1;
     clnt->flat_col_vals = 0;
+    clnt->row_blocks = 0;
+    clnt->row_block_rows = 0;
     if (gbl_sockbplog) {
         init_bplog_socket(clnt);
     }
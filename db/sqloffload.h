@@ -49,6 +49,8 @@ enum {
     OSQL_FLAGS_REORDER_ON = 0x00000080,
     /* indicates if index reordering is turned on */
     OSQL_FLAGS_REORDER_IDX_ON = 0x00000100,
+    /* replicant can ship OSQL_INSERT_BATCH ops if the master acks it */
+    OSQL_FLAGS_INSERT_BATCH = 0x00000200,
 };
 
 int osql_open(struct dbenv *dbenv);
@@ -60,6 +60,7 @@
 #include "debug_switches.h"
 #include "logmsg.h"
 #include "schemachange.h" /* sc_errf() */
+#include <comdb2_atomic.h>
 
 extern struct dbenv *thedb;
 extern pthread_mutex_t csc2_subsystem_mtx;
@@ -3768,6 +3769,301 @@ int stag_set_key_null(const char *table, const char *tag, const char *inkey, con
     return 0;
 }
 
+/*
+ * Conversion plans.  Converting a record between two server schemas goes
+ * through SERVER_to_SERVER for every field of every row, even though for
+ * most fields of most schema changes the answer is a memcpy.  A plan
+ * says what to do per (from, to) schema pair: runs of fields whose bytes
+ * carry over unchanged become one copy, integers that only get wider are
+ * sign extended in place, and every other field goes through
+ * stag_to_stag_field as before.
+ *
+ * Plans are never shared.  Each thread keeps its CONVPLAN_CACHE_SIZE most
+ * recently used plans, keyed by the serials of both schemas, and drops the
+ * least recently used one to make room.  Nothing invalidates a plan
+ * explicitly: a schema change always makes new schemas, which get new
+ * serials, so the old plans stop matching and age out.  A thread's plans
+ * are freed when it exits.
+ */
+int gbl_stag_convert_plans = 1;
+
+#define CONVPLAN_CACHE_SIZE 16
+
+enum {
+    CONVPLAN_COPY,      /* memcpy len bytes */
+    CONVPLAN_WIDEN_INT, /* SERVER_BINT to a wider SERVER_BINT */
+    CONVPLAN_NOTNULL,   /* fail if the source field is null */
+    CONVPLAN_FIELD      /* stag_to_stag_field */
+};
+
+struct convplan_op {
+    int type;
+    int field;     /* target field */
+    int field_idx; /* source field, -1 if none */
+    int from_off;
+    int to_off;
+    int from_len;
+    int to_len;
+};
+
+struct convplan {
+    int64_t from_serial;
+    int64_t to_serial;
+    int nops;
+    struct convplan_op ops[1];
+};
+
+/* a thread's plans, most recently used first */
+struct convplan_cache {
+    int nplans;
+    struct convplan *plans[CONVPLAN_CACHE_SIZE];
+};
+
+static pthread_once_t convplan_once = PTHREAD_ONCE_INIT;
+static pthread_key_t convplan_key; /* frees a thread's plans on exit */
+static __thread struct convplan_cache *convplan_cache;
+
+static int64_t schema_serial;
+
+static int64_t get_schema_serial(struct schema *sc)
+{
+    int64_t serial = ATOMIC_LOAD64(sc->serial);
+    if (serial == 0) {
+        int64_t zero = 0;
+        serial = ATOMIC_ADD64(schema_serial, 1);
+        if (!CAS64(sc->serial, zero, serial))
+            serial = zero;
+    }
+    return serial;
+}
+
+static void free_convplan_cache(void *arg)
+{
+    struct convplan_cache *cache = arg;
+    for (int i = 0; i < cache->nplans; i++)
+        free(cache->plans[i]);
+    free(cache);
+}
+
+static void init_convplan_key(void)
+{
+    Pthread_key_create(&convplan_key, free_convplan_cache);
+}
+
+/* Can this field pair skip stag_to_stag_field?  Returns the op type, or
+ * CONVPLAN_FIELD if not. */
+static int convplan_field_type(struct schema *fromsch, struct field *from_field,
+                               struct schema *tosch, struct field *to_field)
+{
+    if (from_field == NULL || from_field->blob_index >= 0 ||
+        to_field->blob_index >= 0)
+        return CONVPLAN_FIELD;
+    if ((tosch->flags & SCHEMA_INDEX) && to_field->isExpr)
+        return CONVPLAN_FIELD;
+    if ((from_field->flags & INDEX_DESCEND) || (to_field->flags & INDEX_DESCEND))
+        return CONVPLAN_FIELD;
+    if (from_field->type != to_field->type)
+        return CONVPLAN_FIELD;
+
+    switch (to_field->type) {
+    case SERVER_BINT:
+        if (from_field->len == to_field->len)
+            return CONVPLAN_COPY;
+        if (from_field->len < to_field->len &&
+            from_field->convopts.flags == 0 && to_field->convopts.flags == 0)
+            return CONVPLAN_WIDEN_INT;
+        break;
+    case SERVER_BREAL:
+        /* SERVER_BREAL_to_SERVER_BREAL is a memcpy for equal lengths */
+        if (from_field->len == to_field->len)
+            return CONVPLAN_COPY;
+        break;
+    }
+    return CONVPLAN_FIELD;
+}
+
+static struct convplan *build_convplan(struct schema *fromsch,
+                                       struct schema *tosch)
+{
+    struct convplan *plan, *shrunk;
+    struct convplan_op *op, *last = NULL;
+    int field;
+
+    /* at most two ops per field */
+    plan = malloc(sizeof(struct convplan) +
+                  2 * tosch->nmembers * sizeof(struct convplan_op));
+    if (plan == NULL)
+        return NULL;
+    plan->from_serial = get_schema_serial(fromsch);
+    plan->to_serial = get_schema_serial(tosch);
+    plan->nops = 0;
+
+    for (field = 0; field < tosch->nmembers; field++) {
+        struct field *to_field = &tosch->member[field];
+        struct field *from_field = NULL;
+        int field_idx, type;
+
+        if (fromsch == tosch)
+            field_idx = field;
+        else
+            field_idx = find_field_idx_in_tag(fromsch, to_field->name);
+        if (field_idx != -1)
+            from_field = &fromsch->member[field_idx];
+        type = convplan_field_type(fromsch, from_field, tosch, to_field);
+
+        if (type != CONVPLAN_FIELD && (to_field->flags & NO_NULL)) {
+            op = &plan->ops[plan->nops++];
+            op->type = CONVPLAN_NOTNULL;
+            op->field = field;
+            op->field_idx = field_idx;
+            op->from_off = from_field->offset;
+            last = NULL;
+        }
+
+        /* extend the previous copy if both sides are adjacent */
+        if (type == CONVPLAN_COPY && last && last->type == CONVPLAN_COPY &&
+            last->from_off + last->from_len == from_field->offset &&
+            last->to_off + last->to_len == to_field->offset) {
+            last->from_len += from_field->len;
+            last->to_len += to_field->len;
+            continue;
+        }
+
+        op = &plan->ops[plan->nops++];
+        op->type = type;
+        op->field = field;
+        op->field_idx = field_idx;
+        op->from_off = from_field ? from_field->offset : 0;
+        op->from_len = from_field ? from_field->len : 0;
+        op->to_off = to_field->offset;
+        op->to_len = to_field->len;
+        last = op;
+    }
+
+    /* copies usually coalesce into far fewer ops than the worst case */
+    shrunk = realloc(plan, sizeof(struct convplan) +
+                               plan->nops * sizeof(struct convplan_op));
+    return shrunk ? shrunk : plan;
+}
+
+/* Find or build the plan for converting fromsch records to tosch.  Returns
+ * NULL if records should be converted field by field. */
+static struct convplan *get_convplan(struct schema *fromsch,
+                                     struct schema *tosch)
+{
+    struct convplan_cache *cache = convplan_cache;
+    struct convplan *plan;
+    int64_t from_serial, to_serial;
+    int i;
+
+    /* comdb2_seqno gets generated, not converted */
+    if (!gbl_stag_convert_plans || gbl_replicate_local)
+        return NULL;
+
+    if (cache == NULL) {
+        Pthread_once(&convplan_once, init_convplan_key);
+        if ((cache = calloc(1, sizeof(struct convplan_cache))) == NULL)
+            return NULL;
+        Pthread_setspecific(convplan_key, cache);
+        convplan_cache = cache;
+    }
+
+    from_serial = get_schema_serial(fromsch);
+    to_serial = get_schema_serial(tosch);
+    for (i = 0; i < cache->nplans; i++) {
+        plan = cache->plans[i];
+        if (plan->from_serial == from_serial && plan->to_serial == to_serial)
+            break;
+    }
+
+    if (i == cache->nplans) {
+        if ((plan = build_convplan(fromsch, tosch)) == NULL)
+            return NULL;
+        /* the least recently used plan makes room */
+        if (i == CONVPLAN_CACHE_SIZE)
+            free(cache->plans[--i]);
+        else
+            cache->nplans++;
+    }
+
+    memmove(&cache->plans[1], &cache->plans[0], i * sizeof(struct convplan *));
+    cache->plans[0] = plan;
+    return plan;
+}
+
+static void widen_server_int(const uint8_t *in, int inlen, uint8_t *out,
+                             int outlen)
+{
+    uint64_t bits = 0;
+    int64_t val;
+    int8b val8b;
+    int i, shift;
+
+    if (stype_is_null(in)) {
+        set_null(out, outlen);
+        return;
+    }
+    /* undo the sign flip, sign extend, flip again */
+    for (i = 1; i < inlen; i++)
+        bits = (bits << 8) | in[i];
+    shift = 64 - 8 * (inlen - 1);
+    val = (int64_t)((bits ^ (1ULL << (63 - shift))) << shift) >> shift;
+    if (outlen == sizeof(int8b) + 1) {
+        int8_to_int8b(val, &val8b);
+        val8b = flibc_htonll(val8b);
+        set_data(out, &val8b, outlen);
+    } else {
+        /* an int4 from an int2 */
+        int4b val4b;
+        int4_to_int4b((comdb2_int4)val, &val4b);
+        val4b = htonl(val4b);
+        set_data(out, &val4b, outlen);
+    }
+}
+
+static int run_convplan(struct convplan *plan, struct schema *fromsch,
+                        struct schema *tosch, const char *inbuf, char *outbuf,
+                        int flags, struct convert_failure *fail_reason,
+                        blob_buffer_t *inblobs, blob_buffer_t *outblobs,
+                        int maxblobs, const char *tzname)
+{
+    struct convplan_op *op = plan->ops;
+    struct convplan_op *end = op + plan->nops;
+    int rc;
+
+    for (; op < end; op++) {
+        switch (op->type) {
+        case CONVPLAN_COPY:
+            memcpy(outbuf + op->to_off, inbuf + op->from_off, op->to_len);
+            break;
+        case CONVPLAN_WIDEN_INT:
+            widen_server_int((const uint8_t *)inbuf + op->from_off,
+                             op->from_len, (uint8_t *)outbuf + op->to_off,
+                             op->to_len);
+            break;
+        case CONVPLAN_NOTNULL:
+            if (stype_is_null(inbuf + op->from_off)) {
+                if (fail_reason) {
+                    fail_reason->target_field_idx = op->field;
+                    fail_reason->source_field_idx = -1;
+                    fail_reason->reason =
+                        CONVERT_FAILED_NULL_CONSTRAINT_VIOLATION;
+                }
+                return -1;
+            }
+            break;
+        default:
+            rc = stag_to_stag_field(inbuf, outbuf, flags, fail_reason, inblobs,
+                                    outblobs, maxblobs, tzname, op->field_idx,
+                                    op->field, fromsch, tosch);
+            if (rc)
+                return rc;
+            break;
+        }
+    }
+    return 0;
+}
+
 /*
  * On success only outblobs will be valid, there is no need to free up inblobs.
  * On failure the caller should free inblobs and outblobs.
@@ -3790,6 +4086,11 @@ static int _stag_to_stag_buf_flags_blobs(struct schema *fromsch, struct schema *
         fail_reason->target_schema = tosch;
     }
 
+    struct convplan *plan = get_convplan(fromsch, tosch);
+    if (plan)
+        return run_convplan(plan, fromsch, tosch, inbuf, outbuf, flags,
+                            fail_reason, inblobs, outblobs, maxblobs, tzname);
+
     for (int field = 0; field < tosch->nmembers; field++) {
         int field_idx;
 
@@ -3870,13 +4171,20 @@ int stag_to_stag_buf_cachedmap(int tagmap[], struct schema *from,
         maxblobs = 0;
     }
 
-    for (int field = 0; field < to->nmembers; field++) {
-        rc = stag_to_stag_field(inbuf, outbuf, flags, fail_reason, inblobs,
-                                p_newblobs, maxblobs, NULL, tagmap[field],
-                                field, from, to);
+    /* the plan maps fields the same way get_tag_mapping() does */
+    struct convplan *plan = get_convplan(from, to);
+    if (plan) {
+        rc = run_convplan(plan, from, to, inbuf, outbuf, flags, fail_reason,
+                          inblobs, p_newblobs, maxblobs, NULL);
+    } else {
+        for (int field = 0; field < to->nmembers; field++) {
+            rc = stag_to_stag_field(inbuf, outbuf, flags, fail_reason, inblobs,
+                                    p_newblobs, maxblobs, NULL, tagmap[field],
+                                    field, from, to);
 
-        if (rc)
-            break;
+            if (rc)
+                break;
+        }
     }
 
     if (inblobs) /* if we were given blobs */
@@ -75,6 +75,9 @@ struct schema {
     char *sqlitetag;
     int *datacopy;
     char *where;
+    /* identifies the schema to the conversion plan caches; assigned on
+     * first use, never reused */
+    int64_t serial;
 #if defined STACK_TAG_SCHEMA
     int frames;
     void *buf[MAX_TAG_STACK_FRAMES];
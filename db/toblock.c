@@ -4837,14 +4837,7 @@ static int toblock_main_int(struct javasp_trans_state *javasp_trans_handle,
         }
         send_prefault_udp = 0;
 
-        if (iq->osql_step_ix) {
-            gbl_osqlpf_step[*(iq->osql_step_ix)].rqid = 0;
-            gbl_osqlpf_step[*(iq->osql_step_ix)].step = 0;
-            Pthread_mutex_lock(&osqlpf_mutex);
-            queue_add(gbl_osqlpf_stepq, iq->osql_step_ix);
-            Pthread_mutex_unlock(&osqlpf_mutex);
-            iq->osql_step_ix = NULL;
-        }
+        osql_page_prefault_release(&iq->osql_step_ix);
 
         delayed = iq->sorese->is_delayed ? 1 : 0;
 
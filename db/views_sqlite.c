@@ -204,13 +204,20 @@ static char *_views_create_view_query(timepart_view_t *view, sqlite3 *db,
         goto malloc;
     }
 
-    /* generate the select union for shards */
-    /* TODO: put conditions for shards */
+    /* generate the select union for shards; each shard also exposes its
+       rollout window [low, high) as hidden constant columns, so that a
+       predicate on them folds into a constant per shard and lets the
+       planner skip the shards that cannot match; pruning is opt-in, as
+       rows land in shards by insert time and a predicate on a user column
+       says nothing about which shards hold the rows */
     select_str = sqlite3_mprintf("");
     for (i = 0; i < view->nshards; i++) {
-        tmp_str = sqlite3_mprintf("%s%sSELECT %s FROM \"%w\"", select_str,
-                                  (i > 0) ? " UNION ALL " : "", cols_str,
-                                  view->shards[i].tblname);
+        tmp_str = sqlite3_mprintf(
+            "%s%sSELECT %s, %d AS __hidden__shard_start, %d AS "
+            "__hidden__shard_end FROM \"%w\"",
+            select_str, (i > 0) ? " UNION ALL " : "", cols_str,
+            view->shards[i].low, view->shards[i].high,
+            view->shards[i].tblname);
         sqlite3_free(select_str);
         if (!tmp_str) {
             sqlite3_free(cols_str);
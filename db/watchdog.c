@@ -368,6 +368,9 @@ static void *watchdog_thread(void *arg)
             }
         }
 
+        /* give back chunks freed by threads which went idle */
+        comdb2ma_slab_flush_remote();
+
         /* we use counter to downsample the run events for lower frequence
            tasks, like deadlock detector */
         counter++;
@@ -169,6 +169,11 @@ struct dbconsumer_t {
     time_t registration_time;
     char name[MAXTABLELEN];
 
+    /* next_batch(): items wanted, and genids of the items handed out */
+    int batch_max;
+    int nbatch;
+    genid_t *batch;
+
     /* signaling from libdb on qdb insert */
     pthread_mutex_t *lock;
     pthread_cond_t *cond;
@@ -718,6 +723,65 @@ static int grab_qdb_table_read_lock(struct sqlclntstate *clnt,
 }
 
 static const int dbq_delay = 1000; // ms
+static const int dbq_max_batch = 1000;
+
+// Reads up to q->batch_max items and pushes them as a Lua array.
+// Same return codes as dbq_poll_int. Call with q->lock held.
+static int dbq_poll_batch_int(Lua L, dbconsumer_t *q, uint32_t lockid)
+{
+    SP sp = getsp(L);
+    int max = q->batch_max;
+    struct bdb_queue_found **items = calloc(max, sizeof(*items));
+    struct bdb_queue_cursor *cursors = calloc(max, sizeof(*cursors));
+    long long *seqs = calloc(max, sizeof(*seqs));
+    genid_t *batch = realloc(q->batch, max * sizeof(genid_t));
+    int rc, n = 0;
+    if (items == NULL || cursors == NULL || seqs == NULL || batch == NULL) {
+        Pthread_mutex_unlock(q->lock);
+        free(items);
+        free(cursors);
+        free(seqs);
+        if (batch)
+            q->batch = batch;
+        return -1;
+    }
+    q->batch = batch;
+    rc = dbq_get_batch(&q->iq, 0, &q->last, max, items, cursors, seqs, &n,
+                       lockid);
+    Pthread_mutex_unlock(q->lock);
+    comdb2_sql_tick();
+    sp->num_instructions = 0;
+    if (rc == 0) {
+        char *err = NULL;
+        lua_createtable(L, n, 0);
+        for (int i = 0; i < n; ++i) {
+            struct qfound f = {.item = items[i], .seq = seqs[i]};
+            q->fnd = cursors[i];
+            if ((rc = push_trigger_args_int(L, q, &f, &err)) != 1)
+                break;
+            lua_rawseti(L, -2, i + 1);
+            q->batch[i] = q->genid;
+        }
+        if (rc == 1) {
+            q->nbatch = n;
+            /* consume() is for get/poll; a batch goes via consume_batch() */
+            q->genid = 0;
+        } else {
+            luabb_error(L, sp, err);
+            free(err);
+        }
+    } else if (rc == IX_NOTFND) {
+        rc = 0;
+    } else {
+        rc = -1;
+    }
+    for (int i = 0; i < n; ++i)
+        free(items[i]);
+    free(items);
+    free(cursors);
+    free(seqs);
+    return rc;
+}
 // Call with q->lock held.
 // Unlocks q->lock on return.
 // Returns  -2:stopped -1:error  0:IX_NOTFND  1:IX_FND
@@ -734,6 +798,10 @@ static int dbq_poll_int(Lua L, dbconsumer_t *q)
         Pthread_mutex_unlock(q->lock);
         return rc == -2 ? 0 : -1;
     }
+    if (q->batch_max > 0) {
+        return dbq_poll_batch_int(
+            L, q, bdb_get_lid_from_cursortran(clnt->dbtran.cursor_tran));
+    }
     rc = dbq_get(&q->iq, 0, &q->last, &f.item, NULL, NULL, &q->fnd,
                  &f.seq, bdb_get_lid_from_cursortran(clnt->dbtran.cursor_tran));
     Pthread_mutex_unlock(q->lock);
@@ -857,15 +925,40 @@ static int dbconsumer_get(Lua L)
 {
     dbconsumer_t *q = luaL_checkudata(L, 1, dbtypes.dbconsumer);
     int rc;
+    if (q->nbatch) {
+        return luaL_error(L, "get: consume the previous batch first");
+    }
     if ((rc = dbconsumer_get_int(L, q)) > 0) return rc;
     return luaL_error(L, getsp(L)->error);
 }
 
+static int dbconsumer_next_batch(Lua L)
+{
+    dbconsumer_t *q = luaL_checkudata(L, 1, dbtypes.dbconsumer);
+    lua_Integer max = luaL_checkinteger(L, 2);
+    int rc;
+    if (max < 1 || max > dbq_max_batch) {
+        return luaL_error(L, "next_batch: count must be between 1 and %d",
+                          dbq_max_batch);
+    }
+    if (q->nbatch) {
+        return luaL_error(L, "next_batch: consume the previous batch first");
+    }
+    q->batch_max = max;
+    rc = dbconsumer_get_int(L, q);
+    q->batch_max = 0;
+    if (rc > 0) return rc;
+    return luaL_error(L, getsp(L)->error);
+}
+
 static int dbconsumer_poll(Lua L)
 {
     dbconsumer_t *q = luaL_checkudata(L, 1, dbtypes.dbconsumer);
     lua_Number arg = luaL_checknumber(L, 2);
     lua_Integer delay; // ms
+    if (q->nbatch) {
+        return luaL_error(L, "poll: consume the previous batch first");
+    }
     lua_number2integer(delay, arg);
     if (delay >= 0) {
         // we poll in multiples of dbq_delay
@@ -898,6 +991,22 @@ static int in_parent_trans(SP sp)
     return (sp->in_parent_trans || !sp->make_parent_trans);
 }
 
+/* The batch from next_batch(), or the single item from get/poll */
+static int dbq_consume_logic(struct sqlclntstate *clnt, dbconsumer_t *q)
+{
+    int rc;
+    if (q->nbatch == 0) {
+        return osql_dbq_consume_logic(clnt, q->info.spname, q->genid);
+    }
+    for (int i = 0; i < q->nbatch; ++i) {
+        if ((rc = osql_dbq_consume_logic(clnt, q->info.spname,
+                                         q->batch[i])) != 0) {
+            return rc;
+        }
+    }
+    return 0;
+}
+
 static int lua_trigger_impl(Lua L, dbconsumer_t *q)
 {
     int rc;
@@ -914,7 +1023,7 @@ static int lua_trigger_impl(Lua L, dbconsumer_t *q)
     if (rc != 0) {
         return rc;
     }
-    return osql_dbq_consume_logic(clnt, q->info.spname, q->genid);
+    return dbq_consume_logic(clnt, q);
 }
 
 // _int variants don't modify lua stack, just return success/error code
@@ -954,7 +1063,7 @@ static int lua_consumer_impl(Lua L, dbconsumer_t *q)
     if ((rc = grab_qdb_table_read_lock(clnt, q->name, &q->iq.usedb, &q->info, 0, NULL)) != 0) {
         luaL_error(L, "%s: grab_qdb_table_read_lock rc:%d\n", __func__, rc);
     }
-    if ((rc = osql_dbq_consume_logic(clnt, q->info.spname, q->genid)) != 0) {
+    if ((rc = dbq_consume_logic(clnt, q)) != 0) {
         if (implicit_txn) {
             err = db_rollback_int(L, &rc);
             if (err || rc || clnt->intrans) {
@@ -978,13 +1087,14 @@ static void reset_consumer_cursor(struct dbconsumer_t *q)
 {
     if (!q) return;
     q->genid = 0;
+    q->nbatch = 0;
     memset(&q->fnd, 0, sizeof(q->fnd));
     memset(&q->last, 0, sizeof(q->last));
 }
 
 static int dbconsumer_consume_int(Lua L, dbconsumer_t *q)
 {
-    if (q->genid == 0) {
+    if (q->genid == 0 && q->nbatch == 0) {
         return -1;
     }
     enum consumer_t type = dbqueue_consumer_type(q->consumer);
@@ -997,6 +1107,19 @@ static int dbconsumer_consume_int(Lua L, dbconsumer_t *q)
 static int dbconsumer_consume(Lua L)
 {
     dbconsumer_t *q = luaL_checkudata(L, 1, dbtypes.dbconsumer);
+    if (q->nbatch) {
+        return luaL_error(L, "consume: use consume_batch() after next_batch()");
+    }
+    return push_and_return(L, dbconsumer_consume_int(L, q));
+}
+
+// Consume every item from the last next_batch() in one transaction
+static int dbconsumer_consume_batch(Lua L)
+{
+    dbconsumer_t *q = luaL_checkudata(L, 1, dbtypes.dbconsumer);
+    if (q->nbatch == 0) {
+        return push_and_return(L, -1);
+    }
     return push_and_return(L, dbconsumer_consume_int(L, q));
 }
 
@@ -1060,6 +1183,8 @@ static int dbconsumer_free(Lua L)
     ctrace("consumer:%s %016" PRIx64 " unregister req\n", q->info.spname, q->info.trigger_cookie);
     luabb_trigger_unregister(L, q);
     ctrace("consumer:%s %016" PRIx64 " unregister done\n", q->info.spname, q->info.trigger_cookie);
+    free(q->batch);
+    q->batch = NULL;
     return 0;
 }
 
@@ -5124,6 +5249,8 @@ static const struct luaL_Reg dbconsumer_funcs[] = {
     {"get", dbconsumer_get},
     {"poll", dbconsumer_poll},
     {"consume", dbconsumer_consume},
+    {"next_batch", dbconsumer_next_batch},
+    {"consume_batch", dbconsumer_consume_batch},
     {"next", dbconsumer_next},
     {"emit", dbconsumer_emit},
     {"emit_timeout", dbconsumer_emit_timeout},
@@ -7186,6 +7313,7 @@ void *exec_trigger(trigger_reg_t *reg)
             luabb_trigger_unregister(L, q);
             ctrace("trigger:%s %016" PRIx64 " unregister done\n", q->info.spname, q->info.trigger_cookie);
         }
+        free(q->batch);
         free(q);
     } else {
         force_unregister(L, reg);
@@ -165,6 +165,9 @@ struct comdb2mspace {
                              we do not write it to name because an allocator
                              may be reused by another type of thread later on */
     unsigned int debug : 1; /* Debugging flag. */
+    unsigned int slab : 1;    /* size-class cache enabled */
+    unsigned int slab_ok : 1; /* size-class cache allowed (see slab_free) */
+    uint64_t slab_id;         /* unique id, for matching thread caches */
 
     size_t len;   /* length of name */
     char name[1]; /* name of the mspace */
@@ -205,6 +208,42 @@ static pthread_key_t privileged;
 #define PRIO_YES ((void *)1)
 #define PRIO_NO ((void *)-1)
 
+/* size-class cache */
+#define SLAB_NCLASSES 16
+#define SLAB_MAX_SIZE 1024
+#define SLAB_NCACHES 4      /* allocators cached per thread */
+#define SLAB_MAG_BYTES 8192 /* bytes cached per size class */
+#define SLAB_MAG_MIN 8      /* but at least this many chunks */
+#define SLAB_MAG_MAX 64     /* and at most this many */
+#define SLAB_REMOTE_MAX 64  /* chunks queued for other allocators */
+#define SLAB_IDX(n) (((n) + 15) >> 4)
+
+struct slab_mag {
+    void *head; /* free chunks, linked through their first word */
+    int count;
+};
+
+struct slab_cache {
+    comdb2ma cm;
+    uint64_t id;  /* cm->slab_id, in case cm's address is reused */
+    size_t bytes; /* bytes held by the magazines */
+    struct slab_mag mags[SLAB_NCLASSES];
+};
+
+struct slab_thread {
+    LINKC_T(struct slab_thread) lnk;
+    int registered;
+    int dead; /* thread is exiting */
+    unsigned victim;
+    struct slab_cache caches[SLAB_NCACHES];
+    void *remote; /* chunks of allocators this thread has no cache for */
+    int nremote;
+    int nremote_seen; /* nremote at the last sweep */
+    /* Protects `remote' and the cache slots against other threads. The owner
+       takes it only when it queues a remote chunk or (re)assigns a slot. */
+    pthread_mutex_t lk;
+};
+
 /* for sorting */
 typedef struct pair {
     comdb2ma cm;
@@ -240,6 +279,10 @@ static struct {
                      always set to 1. */
     int mmap_thresh; /* user defined MMAP_THRESHOLD */
     int nice; /* mem niceness */
+    pthread_key_t slab_key; /* flushes thread caches on exit */
+    pthread_mutex_t slab_lock; /* protects `slabs' */
+    LISTC_T(struct slab_thread) slabs; /* threads with caches */
+    uint64_t slab_ids;
 #ifdef PER_THREAD_MALLOC
     pthread_t main_thr_id;
     pthread_key_t zone;
@@ -254,9 +297,11 @@ static struct {
           .use_lock = COMDB2MA_MT_SAFE,
           .lock = PTHREAD_MUTEX_INITIALIZER,
           .mmap_thresh = 0,
-          .nice = 0};
+          .nice = 0,
+          .slab_lock = PTHREAD_MUTEX_INITIALIZER};
 
 int gbl_mem_nice = 0;
+int gbl_mem_slab = 1;
 
 /* internal comdb2ma creation */
 static comdb2ma comdb2ma_create_int(void *base, size_t init_sz, size_t max_cap,
@@ -377,6 +422,21 @@ static int find_switch_index(const char *name);
 static int debug_started = 0;
 static unsigned char debug_master_switch = 0;
 static unsigned char debug_switches[COMDB2MA_COUNT] = {0};
+
+/* size-class cache */
+static unsigned char slab_switches[COMDB2MA_COUNT] = {
+    [COMDB2MA_STATIC_SQLITE] = 1, [COMDB2MA_STATIC_OSQL] = 1};
+static __thread struct slab_thread t_slab;
+static void slab_init(void);
+static void *slab_malloc(comdb2ma cm, size_t size);
+static int slab_free(comdb2ma cm, void **p);
+static void slab_forget(comdb2ma cm);
+static void slab_flush_thread(void);
+static void slab_thread_exit(void *);
+static size_t slab_cached(comdb2ma cm);
+
+/* free a chain of `n' chunks linked through their first word */
+static void comdb2_free_chain_int(comdb2ma cm, void *chain, size_t n);
 // static variables and function prototypes$
 
 //^root
@@ -425,6 +485,7 @@ int comdb2ma_init(size_t init_sz, size_t max_cap)
 
             listc_init(&(root.list), offsetof(struct comdb2mspace, lnk));
             listc_init(&(root.blist), offsetof(struct comdb2bmspace, lnk));
+            slab_init();
 
 #ifdef PER_THREAD_MALLOC
             /* create freelists for threaded allocators */
@@ -459,6 +520,8 @@ int comdb2ma_init(size_t init_sz, size_t max_cap)
                     root.m = NULL;
                     break;
                 }
+                COMDB2_STATIC_MAS[i]->slab_ok = 1;
+                COMDB2_STATIC_MAS[i]->slab = slab_switches[i];
             }
 #endif /* !USE_SYS_ALLOC */
         }
@@ -674,6 +737,10 @@ int comdb2ma_destroy(comdb2ma cm)
 {
     int rc;
 
+    /* before any allocator lock (see slab_forget) */
+    if (cm->slab_ok)
+        slab_forget(cm);
+
     rc = COMDB2MA_LOCK(&root);
     if (rc != 0)
         return rc;
@@ -754,6 +821,10 @@ void *comdb2_malloc(comdb2ma cm, size_t size)
     int d = debug_started;
     char *fp;
 
+    if (cm->slab && size <= SLAB_MAX_SIZE && !(d && cm->debug) &&
+        gbl_mem_slab && (out = slab_malloc(cm, size)) != NULL)
+        return (void *)out;
+
     if (size > COMDB2MA_MAX_MEM) {
         // force failure if integer overflow
         errno = ENOMEM;
@@ -802,6 +873,10 @@ void *comdb2_calloc(comdb2ma cm, size_t n, size_t size)
     if (n && size && COMDB2MA_MAX_MEM / n < size) {
         // force failure if integer overflow
         errno = ENOMEM;
+    } else if (cm->slab && (nb = n * size) <= SLAB_MAX_SIZE &&
+               !(d && cm->debug) && gbl_mem_slab &&
+               (out = slab_malloc(cm, nb)) != NULL) {
+        memset(out, 0, nb);
     } else if (COMDB2MA_LOCK(cm) == 0) {
         nb = n * size;
         if (!COMDB2MA_FULL(cm))
@@ -939,14 +1014,17 @@ void *comdb2_resize(comdb2ma cm, void *ptr, size_t n)
     return (void *)out;
 }
 
-static void comdb2_free_int(comdb2ma cm, void *ptr)
+static void comdb2_free_chain_int(comdb2ma cm, void *chain, size_t n)
 {
-    void **p = (void **)ptr;
+    void **p;
 
     if (COMDB2MA_LOCK(cm) == 0) {
-        mspace_free(cm->m, p + COMDB2MA_SENTINEL_OFS);
+        while ((p = (void **)chain) != NULL) {
+            chain = p[0];
+            mspace_free(cm->m, p + COMDB2MA_SENTINEL_OFS);
+        }
 #ifdef PER_THREAD_MALLOC
-        --cm->refs;
+        cm->refs -= n;
 
         /*
          * We must use (cm->nthds == 0) instead of (cm->nthds == 1) because
@@ -991,6 +1069,12 @@ static void comdb2_free_int(comdb2ma cm, void *ptr)
     }
 }
 
+static void comdb2_free_int(comdb2ma cm, void *ptr)
+{
+    *(void **)ptr = NULL;
+    comdb2_free_chain_int(cm, ptr, 1);
+}
+
 void comdb2_free(void *ptr)
 {
     comdb2ma cm;
@@ -1006,10 +1090,10 @@ void comdb2_free(void *ptr)
         } else {
             cm = COMDB2MA_ALLOCATOR(p);
 
-            if (cm->bm == NULL)
-                comdb2_free_int(cm, ptr);
-            else
+            if (cm->bm != NULL)
                 comdb2_bfree(cm->bm, ptr);
+            else if (!slab_free(cm, p))
+                comdb2_free_int(cm, ptr);
         }
     }
 }
@@ -1166,6 +1250,474 @@ void os_free(void *ptr) { free(ptr); }
 char *os_strdup(const char *s) { return strdup(s); }
 // os$
 
+//^slab
+/*
+** Size-class cache in front of the mspaces.
+**
+** For every allocator it allocates from, a thread keeps a magazine of free
+** chunks per size class. Small allocations pop a chunk from the magazine
+** and free() pushes it back, without taking the allocator lock or calling
+** into dlmalloc. An empty magazine is refilled, and a full one gives half
+** of its chunks back, under a single acquisition of the allocator lock.
+**
+** Cached chunks remain allocated as far as the mspace is concerned: they
+** keep the allocator referenced, and the statistics report them as free
+** fastbin space of their allocator.
+**
+** A thread which frees a chunk of a locked allocator it does not cache
+** queues the chunk on its remote-free queue, and gives the queued chunks
+** back SLAB_REMOTE_MAX at a time, one lock acquisition per allocator.
+** A queue which has not changed between two comdb2ma_slab_flush_remote()
+** sweeps is given back by the sweeper, so an idle thread does not pin its
+** chunks.
+**
+** Lockless allocators are never cached by a thread other than the one
+** using them, but a cache can outlive a hand-off to another thread.
+** comdb2ma_destroy() therefore invalidates the caches of all threads.
+*/
+static const size_t slab_sizes[SLAB_NCLASSES] = {
+    16, 32, 48, 64, 96, 128, 160, 192, 256, 320, 384, 512, 640, 768, 896, 1024};
+/* smallest class a request fits in, indexed by SLAB_IDX(size) */
+static signed char slab_ceil[SLAB_IDX(SLAB_MAX_SIZE) + 1];
+/* largest class a chunk can hold, indexed by usable size >> 4 */
+static signed char slab_floor[SLAB_IDX(SLAB_MAX_SIZE) + 2];
+/* chunks per magazine */
+static int slab_cap[SLAB_NCLASSES];
+
+static void slab_init(void)
+{
+    int i, c;
+
+    for (i = 0, c = 0; i != sizeof(slab_ceil); ++i) {
+        while (slab_sizes[c] < (size_t)i << 4)
+            ++c;
+        slab_ceil[i] = c;
+    }
+
+    for (i = 0, c = -1; i != sizeof(slab_floor); ++i) {
+        while (c + 1 < SLAB_NCLASSES && slab_sizes[c + 1] <= (size_t)i << 4)
+            ++c;
+        slab_floor[i] = c;
+    }
+
+    for (c = 0; c != SLAB_NCLASSES; ++c) {
+        slab_cap[c] = SLAB_MAG_BYTES / slab_sizes[c];
+        if (slab_cap[c] < SLAB_MAG_MIN)
+            slab_cap[c] = SLAB_MAG_MIN;
+        else if (slab_cap[c] > SLAB_MAG_MAX)
+            slab_cap[c] = SLAB_MAG_MAX;
+    }
+
+    listc_init(&root.slabs, offsetof(struct slab_thread, lnk));
+    Pthread_key_create(&root.slab_key, slab_thread_exit);
+}
+
+static int slab_register(void)
+{
+    if (t_slab.dead)
+        return 0;
+    if (!t_slab.registered) {
+        Pthread_mutex_init(&t_slab.lk, NULL);
+        Pthread_mutex_lock(&root.slab_lock);
+        listc_abl(&root.slabs, &t_slab);
+        Pthread_mutex_unlock(&root.slab_lock);
+        Pthread_setspecific(root.slab_key, &t_slab);
+        t_slab.registered = 1;
+    }
+    return 1;
+}
+
+static inline struct slab_cache *slab_find(comdb2ma cm)
+{
+    struct slab_cache *c = t_slab.caches;
+    for (int i = 0; i != SLAB_NCACHES; ++i, ++c) {
+        if (c->cm == cm && c->id == cm->slab_id)
+            return c;
+    }
+    return NULL;
+}
+
+/* give all chunks of `c' back to its allocator */
+static void slab_detach(struct slab_cache *c)
+{
+    comdb2ma cm = c->cm;
+    void *chain = NULL, **p;
+    size_t n = 0;
+
+    for (int i = 0; i != SLAB_NCLASSES; ++i) {
+        while ((p = c->mags[i].head) != NULL) {
+            c->mags[i].head = p[0];
+            p[0] = chain;
+            chain = p;
+            ++n;
+        }
+    }
+    memset(c, 0, sizeof(struct slab_cache));
+
+    if (n != 0)
+        comdb2_free_chain_int(cm, chain, n);
+}
+
+/* Empty the slot `c', with `lk' held. Returns 1 if the chunks were moved
+   to `out' instead, for the caller to slab_detach() after dropping `lk':
+   giving chunks to a locked allocator takes its lock, and possibly the root
+   lock, which may be held by a thread waiting for `slab_lock'. Chunks of a
+   lockless allocator are given back right away: no lock is needed, and
+   only `lk' keeps slab_forget() from letting the allocator go meanwhile. */
+static int slab_evict(struct slab_cache *c, struct slab_cache *out)
+{
+    if (c->bytes == 0 || !c->cm->use_lock) {
+        slab_detach(c);
+        return 0;
+    }
+    *out = *c;
+    memset(c, 0, sizeof(struct slab_cache));
+    return 1;
+}
+
+static struct slab_cache *slab_attach(comdb2ma cm)
+{
+    struct slab_cache *c, victim;
+    int i, detach = 0;
+
+    if (!slab_register())
+        return NULL;
+
+    Pthread_mutex_lock(&t_slab.lk);
+    for (i = 0, c = t_slab.caches; i != SLAB_NCACHES; ++i, ++c) {
+        if (c->cm == NULL)
+            break;
+    }
+
+    if (i == SLAB_NCACHES) {
+        c = &t_slab.caches[t_slab.victim++ % SLAB_NCACHES];
+        detach = slab_evict(c, &victim);
+    }
+
+    c->cm = cm;
+    c->id = cm->slab_id;
+    Pthread_mutex_unlock(&t_slab.lk);
+
+    if (detach)
+        slab_detach(&victim);
+    return c;
+}
+
+static int slab_refill(struct slab_cache *c, int cls)
+{
+    comdb2ma cm = c->cm;
+    struct slab_mag *mag = &c->mags[cls];
+    size_t sz = slab_sizes[cls];
+    void **out;
+    int n = 0;
+
+    if (COMDB2MA_LOCK(cm) != 0)
+        return 0;
+
+    while (n < slab_cap[cls] / 2 && !COMDB2MA_FULL(cm) &&
+           (out = mspace_malloc(cm->m, sz + COMDB2MA_OVERHEAD(0))) != NULL) {
+        out[0] = COMDB2MA_SENTINEL(out, cm);
+        out[1] = (void *)cm;
+        out -= COMDB2MA_SENTINEL_OFS;
+        out[0] = mag->head;
+        mag->head = out;
+        ++n;
+    }
+#ifdef PER_THREAD_MALLOC
+    cm->refs += n;
+#endif
+    COMDB2MA_UNLOCK(cm);
+
+    mag->count += n;
+    c->bytes += n * sz;
+    return n;
+}
+
+static void slab_flush_mag(struct slab_cache *c, int cls, int n)
+{
+    struct slab_mag *mag = &c->mags[cls];
+    void *chain = NULL, **p;
+
+    for (int i = 0; i != n; ++i) {
+        p = mag->head;
+        mag->head = p[0];
+        p[0] = chain;
+        chain = p;
+    }
+    mag->count -= n;
+    c->bytes -= n * slab_sizes[cls];
+    comdb2_free_chain_int(c->cm, chain, n);
+}
+
+/* give a list of remote chunks back, one lock acquisition per allocator */
+static void slab_free_remote(void *remote)
+{
+    comdb2ma cm;
+    void *chain, **p, **pp;
+    size_t n;
+
+    while (remote != NULL) {
+        cm = COMDB2MA_ALLOCATOR((void **)remote);
+        chain = NULL;
+        n = 0;
+        /* pull all chunks of `cm' off the list */
+        for (pp = (void **)&remote; (p = *pp) != NULL;) {
+            if (COMDB2MA_ALLOCATOR(p) == cm) {
+                *pp = p[0];
+                p[0] = chain;
+                chain = p;
+                ++n;
+            } else {
+                pp = &p[0];
+            }
+        }
+        comdb2_free_chain_int(cm, chain, n);
+    }
+}
+
+static void slab_flush_remote(void)
+{
+    void *remote;
+
+    Pthread_mutex_lock(&t_slab.lk);
+    remote = t_slab.remote;
+    t_slab.remote = NULL;
+    t_slab.nremote = 0;
+    Pthread_mutex_unlock(&t_slab.lk);
+
+    slab_free_remote(remote);
+}
+
+static void *slab_malloc(comdb2ma cm, size_t size)
+{
+    struct slab_cache *c;
+    struct slab_mag *mag;
+    void **p;
+    int cls = slab_ceil[SLAB_IDX(size)];
+
+    if ((c = slab_find(cm)) == NULL && (c = slab_attach(cm)) == NULL)
+        return NULL;
+
+    mag = &c->mags[cls];
+    if (mag->head == NULL && slab_refill(c, cls) == 0)
+        return NULL;
+
+    p = mag->head;
+    mag->head = p[0];
+    --mag->count;
+    c->bytes -= slab_sizes[cls];
+    return p;
+}
+
+/* return 1 if the chunk was taken by the cache */
+static int slab_free(comdb2ma cm, void **p)
+{
+    struct slab_cache *c;
+    struct slab_mag *mag;
+    size_t idx;
+    int cls, nremote;
+
+    if (!cm->slab || COMDB2MA_ISDEBUG(p))
+        return 0;
+
+    idx = comdb2_malloc_usable_size(p) >> 4;
+    if (idx >= sizeof(slab_floor) || (cls = slab_floor[idx]) < 0)
+        return 0;
+
+    if ((c = slab_find(cm)) == NULL) {
+        if (!cm->use_lock || !slab_register())
+            return 0;
+        Pthread_mutex_lock(&t_slab.lk);
+        p[0] = t_slab.remote;
+        t_slab.remote = p;
+        nremote = ++t_slab.nremote;
+        Pthread_mutex_unlock(&t_slab.lk);
+        if (nremote >= SLAB_REMOTE_MAX)
+            slab_flush_remote();
+        return 1;
+    }
+
+    mag = &c->mags[cls];
+    if (mag->count >= slab_cap[cls])
+        slab_flush_mag(c, cls, slab_cap[cls] / 2);
+    p[0] = mag->head;
+    mag->head = p;
+    ++mag->count;
+    c->bytes += slab_sizes[cls];
+    return 1;
+}
+
+/* `cm' is being destroyed along with whatever any thread caches of it.
+   Its chunks cannot be on a remote queue: only chunks of locked allocators
+   are queued, static ones live until exit, and per-thread ones are destroyed
+   only once all their chunks are freed. */
+static void slab_forget(comdb2ma cm)
+{
+    struct slab_thread *t;
+    struct slab_cache *c;
+
+    Pthread_mutex_lock(&root.slab_lock);
+    LISTC_FOR_EACH(&root.slabs, t, lnk)
+    {
+        Pthread_mutex_lock(&t->lk);
+        for (c = t->caches; c != t->caches + SLAB_NCACHES; ++c) {
+            if (c->cm == cm && c->id == cm->slab_id)
+                memset(c, 0, sizeof(struct slab_cache));
+        }
+        Pthread_mutex_unlock(&t->lk);
+    }
+    Pthread_mutex_unlock(&root.slab_lock);
+}
+
+static void slab_flush_thread(void)
+{
+    struct slab_cache victims[SLAB_NCACHES];
+    int i, detach[SLAB_NCACHES] = {0};
+
+    Pthread_mutex_lock(&t_slab.lk);
+    for (i = 0; i != SLAB_NCACHES; ++i) {
+        if (t_slab.caches[i].cm != NULL)
+            detach[i] = slab_evict(&t_slab.caches[i], &victims[i]);
+    }
+    Pthread_mutex_unlock(&t_slab.lk);
+
+    for (i = 0; i != SLAB_NCACHES; ++i) {
+        if (detach[i])
+            slab_detach(&victims[i]);
+    }
+    slab_flush_remote();
+}
+
+static void slab_thread_exit(void *arg)
+{
+    slab_flush_thread();
+    t_slab.dead = 1;
+    Pthread_mutex_lock(&root.slab_lock);
+    listc_rfl(&root.slabs, &t_slab);
+    Pthread_mutex_unlock(&root.slab_lock);
+    Pthread_mutex_destroy(&t_slab.lk);
+}
+
+static size_t slab_cached(comdb2ma cm)
+{
+    struct slab_thread *t;
+    size_t bytes = 0;
+
+    Pthread_mutex_lock(&root.slab_lock);
+    LISTC_FOR_EACH(&root.slabs, t, lnk)
+    {
+        for (int i = 0; i != SLAB_NCACHES; ++i) {
+            if (t->caches[i].cm == cm && t->caches[i].id == cm->slab_id)
+                bytes += t->caches[i].bytes;
+        }
+    }
+    Pthread_mutex_unlock(&root.slab_lock);
+    return bytes;
+}
+
+static int slab_on_off(const char *name, unsigned char on)
+{
+    int rc, indx;
+    comdb2ma curpos;
+
+    if (strcmp(name, "*") == 0) {
+        for (indx = 0; indx != COMDB2MA_COUNT; ++indx)
+            slab_switches[indx] = on;
+    } else if ((indx = find_switch_index(name)) != 0) {
+        slab_switches[indx] = on;
+    } else {
+        return EINVAL;
+    }
+
+    rc = COMDB2MA_LOCK(&root);
+    if (rc != 0)
+        return rc;
+
+    if (root.m == NULL)
+        rc = EPERM;
+    else {
+        LISTC_FOR_EACH(&(root.list), curpos, lnk) {
+            if (curpos->slab_ok && (strcasecmp(curpos->name, name) == 0 ||
+                                    strcmp(name, "*") == 0))
+                curpos->slab = on;
+        }
+    }
+
+    if (rc != 0)
+        COMDB2MA_UNLOCK(&root);
+    else
+        rc = COMDB2MA_UNLOCK(&root);
+
+    return rc;
+}
+
+int comdb2ma_slab_on(const char *name)
+{
+    return slab_on_off(name, 1);
+}
+
+int comdb2ma_slab_off(const char *name)
+{
+    return slab_on_off(name, 0);
+}
+
+void comdb2ma_slab_flush_remote(void)
+{
+    struct slab_thread *t;
+    void *remote = NULL, **p;
+
+    Pthread_mutex_lock(&root.slab_lock);
+    LISTC_FOR_EACH(&root.slabs, t, lnk)
+    {
+        Pthread_mutex_lock(&t->lk);
+        if (t->nremote != 0 && t->nremote == t->nremote_seen) {
+            while ((p = t->remote) != NULL) {
+                t->remote = p[0];
+                p[0] = remote;
+                remote = p;
+            }
+            t->nremote = 0;
+        }
+        t->nremote_seen = t->nremote;
+        Pthread_mutex_unlock(&t->lk);
+    }
+    Pthread_mutex_unlock(&root.slab_lock);
+
+    /* freeing may destroy a per-thread allocator, which takes the root lock:
+       do it without holding `slab_lock' */
+    slab_free_remote(remote);
+}
+
+void comdb2ma_slab_show_config(void)
+{
+    struct slab_thread *t;
+    size_t bytes = 0;
+    int i, none, nthds = 0;
+
+    logmsg(LOGMSG_USER, "Size-class cache: %s\n",
+           gbl_mem_slab ? "ENABLED" : "disabled");
+    logmsg(LOGMSG_USER, "Size-class cache is enabled for:");
+    for (i = 1, none = 1; i != COMDB2MA_COUNT; ++i)
+        if (slab_switches[i]) {
+            logmsg(LOGMSG_USER, " %s", COMDB2_STATIC_MA_METAS[i].name);
+            none = 0;
+        }
+    if (none)
+        logmsg(LOGMSG_USER, " none");
+    logmsg(LOGMSG_USER, "\n");
+
+    Pthread_mutex_lock(&root.slab_lock);
+    LISTC_FOR_EACH(&root.slabs, t, lnk)
+    {
+        ++nthds;
+        for (i = 0; i != SLAB_NCACHES; ++i)
+            bytes += t->caches[i].bytes;
+    }
+    Pthread_mutex_unlock(&root.slab_lock);
+    logmsg(LOGMSG_USER, "%zu bytes cached by %d threads\n", bytes, nthds);
+}
+// slab$
+
 //^static functions
 static comdb2ma comdb2ma_create_int(void *base, size_t init_sz, size_t max_cap,
                                     const char *name, const char *scope,
@@ -1223,6 +1775,13 @@ static comdb2ma comdb2ma_create_int(void *base, size_t init_sz, size_t max_cap,
 
     out->debug = (debug_master_switch | debug_switches[find_switch_index(name)]);
 
+    /* A lockless allocator belongs to the thread that created it, so only
+       that thread ever caches its chunks. Static and per-thread allocators
+       are enabled by their creators. */
+    out->slab_ok = (lock == COMDB2MA_MT_UNSAFE);
+    out->slab = out->slab_ok && slab_switches[find_switch_index(name)];
+    out->slab_id = ++root.slab_ids;
+
 #ifdef PER_THREAD_MALLOC
     out->refs = 0;
     out->onfreelist = 0;
@@ -1320,6 +1879,8 @@ static comdb2ma get_area(int indx)
                         __FILE__, __func__, __LINE__);
                     zone[indx]->onfreelist = indx;
                     zone[indx]->debug = (debug_master_switch | debug_switches[indx]);
+                    zone[indx]->slab_ok = 1;
+                    zone[indx]->slab = slab_switches[indx];
                     listc_abl(&root.busylist[indx], zone[indx]);
                 } else {
                     /* Reached the limit. Grab one from busylist. */
@@ -1366,6 +1927,10 @@ static void destroy_zone(void *arg)
     size_t i;
     static const char *onfreelist = "freelist";
 
+    /* Give the chunks cached by this thread back first, so that
+       the allocators which are no longer referenced can be destroyed. */
+    slab_flush_thread();
+
     zone = (comdb2ma *)arg;
     if (COMDB2MA_LOCK(&root) == 0) {
         for (i = 0; i != COMDB2MA_COUNT; ++i)
@@ -1675,6 +2240,14 @@ static struct mallinfo ma_mallinfo(const comdb2ma cm)
             COMDB2MA_UNLOCK(curpos);
         }
     }
+
+    /* chunks sitting in thread caches are free memory */
+    if (cm->slab_ok) {
+        size_t cached = slab_cached(cm);
+        ret.uordblks -= cached;
+        ret.fordblks += cached;
+        ret.fsmblks += cached;
+    }
     return ret;
 }
 
@@ -41,6 +41,7 @@ XMACRO_COMDB2MA(COMDB2MA_STATIC_DFP_DECNUMBER,  "dfp_decNumber",    0, 0) \
 XMACRO_COMDB2MA(COMDB2MA_STATIC_PROTOBUF,       "protobuf",         0, 0) \
 XMACRO_COMDB2MA(COMDB2MA_STATIC_SCHEMACHANGE,   "schemachange",     0, 0) \
 XMACRO_COMDB2MA(COMDB2MA_STATIC_LUA,            "lua",              0, 0) \
+XMACRO_COMDB2MA(COMDB2MA_STATIC_OSQL,           "osql",             0, 0) \
 XMACRO_COMDB2MA(COMDB2MA_COUNT,                 NULL,               0, 0)
 
 #define XMACRO_COMDB2MA(idx, name, size, cap) idx,
@@ -710,6 +711,22 @@ int comdb2bma_mark_unlocked(comdb2bma ma);
 
 #endif /* COMDB2_OMIT_BMEM */
 
+/*
+** Size-class cache. Small chunks freed by a thread are kept in per-thread
+** magazines and handed out again without locking the allocator.
+** Enabled for the sqlite and osql allocators by default.
+*/
+extern int gbl_mem_slab;
+/* Turn on the cache for the specified allocators ("*" for all). */
+int comdb2ma_slab_on(const char *);
+/* Turn off the cache for the specified allocators ("*" for all). */
+int comdb2ma_slab_off(const char *);
+/* Print cache config. */
+void comdb2ma_slab_show_config(void);
+/* Give back chunks queued for other allocators by threads which have not
+   freed any since the previous call. Meant to be called periodically. */
+void comdb2ma_slab_flush_remote(void);
+
 #ifndef COMDB2MA_OMIT_DEBUG
 /* Dump the specified allocators. When `unsafe' is set to true,
    also dump those thread-unsafe allocators. */
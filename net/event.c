@@ -750,6 +750,10 @@ static void net_msg_free(struct net_msg *msg)
     free(msg);
 }
 
+/* Payloads this size or larger are shared by all destinations by reference;
+ * anything smaller is cheaper to copy next to its headers */
+#define ADDREF_CUTOFF 256
+
 static struct net_msg *net_msg_new(netinfo_type *netinfo_ptr, int n, void **buf,
                                    int *len, int *type, int *flags)
 {
@@ -761,12 +765,15 @@ static struct net_msg *net_msg_new(netinfo_type *netinfo_ptr, int n, void **buf,
     msg->netinfo_ptr = netinfo_ptr;
     msg->num = n;
     for (int i = 0; i < n; ++i) {
+        msg->flags |= flags[i];
+        if (len[i] < ADDREF_CUTOFF) {
+            continue;
+        }
         msg->data[i] = net_msg_data_new(buf[i], len[i], type[i]);
         if (msg->data[i] == NULL) {
             net_msg_free(msg);
             return NULL;
         }
-        msg->flags |= flags[i];
     }
     return msg;
 }
@@ -2572,49 +2579,57 @@ static inline int skip_send(struct event_info *e, int nodrop, int check_hello)
            (check_hello && !e->got_hello);
 }
 
-static void net_send_memcpy(struct event_info *e, int sz, int n, void **buf, int *len, int *type)
+/* Queue n messages on e. Headers and small payloads are copied into one
+ * segment of wr_buf so that runs of them go out in a single iovec; payloads
+ * in msg (if any) are referenced, which leaves just the per-host wire header
+ * to copy in front of them. */
+static int net_send_vec(struct event_info *e, int n, void **buf, int *len,
+                        int *type, struct net_msg *msg)
 {
-    if (!e->wr_buf) {
-        return;
-    }
-    sz += n * (e->wirehdr_len + sizeof(net_send_message_header));
-    struct iovec v[1];
-    const int nv = evbuffer_reserve_space(e->wr_buf, sz, v, 1);
-    if (nv != 1) {
-        abort();
+    struct evbuffer *wr_buf = e->wr_buf;
+    if (!wr_buf) {
+        return 0;
     }
-    uint8_t *b = v[0].iov_base;
-    v[0].iov_len = sz;
     net_send_message_header hdr = {0};
-    for (int i = 0; i < n; ++i) {
-        hdr.usertype = type[i];
-        hdr.datalen = len[i];
-        b = memcpy(b, e->wirehdr[WIRE_HEADER_USER_MSG], e->wirehdr_len) + e->wirehdr_len;
-        b = net_send_message_header_put(&hdr, b, b + sizeof(net_send_message_header));
-        b = memcpy(b, buf[i], len[i]) + len[i];
-    }
-    evbuffer_commit_space(e->wr_buf, v, 1);
-}
-
-static void net_send_addref(struct event_info *e, struct net_msg *msg)
-{
-    struct evbuffer *buf = e->wr_buf;
-    if (!buf) {
-        return;
-    }
-    int rc = 0;
-    for (int i = 0; i < msg->num; ++i) {
-        struct net_msg_data *data = msg->data[i];
-        rc = evbuffer_add_reference(buf, e->wirehdr[WIRE_HEADER_USER_MSG], e->wirehdr_len, NULL, NULL);
-        if (rc) break;
-        rc = evbuffer_add_reference(buf, &data->msghdr, data->sz, net_msg_data_free, data);
-        if (rc) break;
+    int i = 0;
+    while (i < n) {
+        int j, sz = 0;
+        for (j = i; j < n && !(msg && msg->data[j]); ++j) {
+            sz += e->wirehdr_len + NET_SEND_MESSAGE_HEADER_LEN + len[j];
+        }
+        if (j < n) {
+            sz += e->wirehdr_len;
+        }
+        struct iovec v[1];
+        if (evbuffer_reserve_space(wr_buf, sz, v, 1) != 1) {
+            return -1;
+        }
+        uint8_t *b = v[0].iov_base;
+        v[0].iov_len = sz;
+        for (; i < j; ++i) {
+            hdr.usertype = type[i];
+            hdr.datalen = len[i];
+            b = memcpy(b, e->wirehdr[WIRE_HEADER_USER_MSG], e->wirehdr_len) + e->wirehdr_len;
+            b = net_send_message_header_put(&hdr, b, b + NET_SEND_MESSAGE_HEADER_LEN);
+            b = memcpy(b, buf[i], len[i]) + len[i];
+        }
+        if (j < n) {
+            memcpy(b, e->wirehdr[WIRE_HEADER_USER_MSG], e->wirehdr_len);
+        }
+        if (evbuffer_commit_space(wr_buf, v, 1) != 0) {
+            return -1;
+        }
+        if (j == n) {
+            break;
+        }
+        struct net_msg_data *data = msg->data[j];
+        if (evbuffer_add_reference(wr_buf, &data->msghdr, data->sz, net_msg_data_free, data) != 0) {
+            return -1;
+        }
         net_msg_data_add_ref(data);
+        i = j + 1;
     }
-    if (rc != 0) {
-        hprintf("Failed to add ref #msgs:%d rc:%d\n", msg->num, rc);
-        reconnect(e);
-    }
+    return 0;
 }
 
 static void setup_base(void)
@@ -2788,70 +2803,57 @@ int write_list_evbuffer(host_node_type *host_node_ptr, int type,
     int nodrop = flags & WRITE_MSG_NOLIMIT;
     int nodelay = flags & WRITE_MSG_NODELAY;
     struct event_info *e = host_node_ptr->event_info;
-    struct evbuffer *buf = evbuffer_new();
-    if (buf == NULL) {
-        rc = -1;
-        goto out;
+    if (skip_send(e, nodrop, 0)) {
+        return -2;
     }
     int sz = e->wirehdr_len;
     for (int i = 0; i < n; ++i) {
         sz += iov[i].iov_len;
     }
+    Pthread_mutex_lock(&e->wr_lk);
+    struct evbuffer *buf = e->wr_buf;
     struct iovec v[1];
-    const int nv = evbuffer_reserve_space(buf, sz, v, 1);
-    if (nv != 1) {
+    if (buf == NULL) {
+        rc = -3;
+    } else if (evbuffer_reserve_space(buf, sz, v, 1) != 1) {
         rc = -1;
-        goto out;
-    }
-    v[0].iov_len = sz;
-    uint8_t *b = v[0].iov_base;
-    b = memcpy(b, e->wirehdr[type], e->wirehdr_len) + e->wirehdr_len;
-    for (int i = 0; i < n; ++i) {
-        b = memcpy(b, iov[i].iov_base, iov[i].iov_len) + iov[i].iov_len;
-    }
-    evbuffer_commit_space(buf, v, nv);
-    if (skip_send(e, nodrop, 0)) {
-        rc = -2;
-        goto out;
-    }
-    Pthread_mutex_lock(&e->wr_lk);
-    if (e->wr_buf) {
-        rc = evbuffer_add_buffer(e->wr_buf, buf);
-        if (rc != 0) {
-            rc = -1;
-        } else {
+    } else {
+        /* Copy straight into wr_buf: consecutive small messages share a
+         * segment and go out in a single iovec */
+        v[0].iov_len = sz;
+        uint8_t *b = v[0].iov_base;
+        b = memcpy(b, e->wirehdr[type], e->wirehdr_len) + e->wirehdr_len;
+        for (int i = 0; i < n; ++i) {
+            b = memcpy(b, iov[i].iov_base, iov[i].iov_len) + iov[i].iov_len;
+        }
+        rc = evbuffer_commit_space(buf, v, 1) ? -1 : 0;
+        if (rc == 0) {
             if (nodelay) {
                 flush_evbuffer(e);
             }
             check_wr_full(e);
         }
-    } else {
-        rc = -3;
     }
     Pthread_mutex_unlock(&e->wr_lk);
-out:if (buf) {
-        evbuffer_free(buf);
-    }
     return rc;
 }
 
 int net_send_all_evbuffer(netinfo_type *netinfo_ptr, int n, void **buf,
                           int *len, int *type, int *flags)
 {
-#   define ADDREF_CUTOFF 256
     if (net_stop) {
         return 0;
     }
-    int sz = 0;
+    int shared = 0;
     int nodrop = 0;
     int nodelay = 0;
     struct net_msg *msg = NULL;
     for (int i = 0; i < n; ++i) {
-        sz += len[i];
+        shared |= len[i] >= ADDREF_CUTOFF;
         nodrop |= flags[i] & NET_SEND_NODROP;
         nodelay |= flags[i] & NET_SEND_NODELAY;
     }
-    if (sz >= ADDREF_CUTOFF) {
+    if (shared) {
         msg = net_msg_new(netinfo_ptr, n, buf, len, type, flags);
         if (msg == NULL) {
             return NET_SEND_FAIL_MALLOC_FAIL;
@@ -2865,12 +2867,10 @@ int net_send_all_evbuffer(netinfo_type *netinfo_ptr, int n, void **buf,
         }
         Pthread_mutex_lock(&e->wr_lk);
         if (e->wr_buf) {
-            if (msg) {
-                net_send_addref(e, msg);
-            } else {
-                net_send_memcpy(e, sz, n, buf, len, type);
-            }
-            if (nodelay) {
+            if (net_send_vec(e, n, buf, len, type, msg) != 0) {
+                hprintf("Failed to queue #msgs:%d\n", n);
+                reconnect(e);
+            } else if (nodelay) {
                 flush_evbuffer(e);
             }
         }
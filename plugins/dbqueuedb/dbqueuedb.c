@@ -578,6 +578,8 @@ static void stat_thread_int(struct dbtable *db, int fullstat, int walk_queue)
         logmsg(LOGMSG_USER, "  geese consumed  %u\n", db->num_goose_consumes);
         logmsg(LOGMSG_USER, "  bdb get bdbstats   %u log %u phys\n",
                bdbstats->n_logical_gets, bdbstats->n_physical_gets);
+        logmsg(LOGMSG_USER, "  bdb batch gets  %u (%u items)\n",
+               bdbstats->n_batch_gets, bdbstats->n_batch_items);
         logmsg(LOGMSG_USER, "  bdb deadlocks   add %u get %u con %u\n",
                bdbstats->n_add_deadlocks, bdbstats->n_get_deadlocks,
                bdbstats->n_consume_deadlocks);
@@ -16,6 +16,7 @@
 
 #include <pthread.h>
 #include <stdlib.h>
+#include <lz4.h>
 
 #include "newsql.h"
 #include "comdb2_plugin.h"
@@ -30,6 +31,17 @@
 #include "osqlsqlsocket.h"
 #include "sqlquery.pb-c.h"
 #include "sqlresponse.pb-c.h"
+#include "epochlib.h"
+
+#if LZ4_VERSION_NUMBER < 10701
+#define LZ4_compress_default LZ4_compress_limitedOutput
+#endif
+
+extern int gbl_newsql_row_block_rows;
+extern int gbl_newsql_row_block_max_ms;
+
+/* Don't let a block of wide rows grow without bound */
+#define NEWSQL_ROW_BLOCK_MAX_BYTES (1024 * 1024)
 
 static int newsql_clr_snapshot(struct sqlclntstate *);
 static int newsql_has_high_availability(struct sqlclntstate *);
@@ -307,9 +319,145 @@ static inline int newsql_to_client_type(int newsql_type)
         return -1;
     }
 }
+static inline int newsql_row_block_rows(struct sqlclntstate *clnt)
+{
+    return clnt->row_block_rows ? clnt->row_block_rows
+                                : gbl_newsql_row_block_rows;
+}
+
+/* Called with blk->lk held */
+static int newsql_send_row_block_int(struct sqlclntstate *clnt,
+                                     struct newsql_row_block *blk, int flush)
+{
+    struct newsql_appdata *appdata = clnt->appdata;
+    if (blk->nrows == 0) {
+        return 0;
+    }
+    int bound = LZ4_compressBound(blk->len);
+    if (blk->outcap < bound) {
+        uint8_t *out = realloc(blk->out, bound);
+        if (out == NULL) {
+            return -1;
+        }
+        blk->out = out;
+        blk->outcap = bound;
+    }
+    int64_t start = comdb2_time_epochus();
+    int zlen = LZ4_compress_default((const char *)blk->raw, (char *)blk->out,
+                                    blk->len, bound);
+    ATOMIC_ADD64(gbl_newsql_row_block_compress_us,
+                 comdb2_time_epochus() - start);
+
+    CDB2SQLRESPONSE r = CDB2__SQLRESPONSE__INIT;
+    r.response_type = RESPONSE_TYPE__ROW_BLOCK;
+    r.has_row_block = 1;
+    r.has_row_block_nrows = 1;
+    r.row_block_nrows = blk->nrows;
+    r.has_row_block_rawlen = 1;
+    r.row_block_rawlen = blk->len;
+    r.has_row_block_codec = 1;
+    if (zlen > 0 && zlen < blk->len) {
+        r.row_block_codec = CDB2_ROW_BLOCK_CODEC__ROW_BLOCK_LZ4;
+        r.row_block.data = blk->out;
+        r.row_block.len = zlen;
+        ATOMIC_ADD64(gbl_newsql_row_block_bytes_saved, blk->len - zlen);
+    } else {
+        /* incompressible; ship it as is */
+        r.row_block_codec = CDB2_ROW_BLOCK_CODEC__ROW_BLOCK_RAW;
+        r.row_block.data = blk->raw;
+        r.row_block.len = blk->len;
+    }
+    ATOMIC_ADD64(gbl_newsql_row_blocks, 1);
+    blk->nrows = 0;
+    blk->len = 0;
+    return appdata->write_impl(clnt, RESPONSE_HEADER__SQL_RESPONSE, 0, &r,
+                               flush);
+}
+
+static int newsql_send_row_block(struct sqlclntstate *clnt, int flush)
+{
+    struct newsql_appdata *appdata = clnt->appdata;
+    struct newsql_row_block *blk = appdata->row_block;
+    if (blk == NULL) {
+        return 0;
+    }
+    Pthread_mutex_lock(&blk->lk);
+    int rc = newsql_send_row_block_int(clnt, blk, flush);
+    Pthread_mutex_unlock(&blk->lk);
+    return rc;
+}
+
+/* Heartbeat side of the above: the sql thread holding the block is about to
+ * send it anyway, so never wait on it from the appsock thread. */
+static int newsql_try_send_row_block(struct sqlclntstate *clnt)
+{
+    struct newsql_appdata *appdata = clnt->appdata;
+    struct newsql_row_block *blk = appdata->row_block;
+    if (blk == NULL || pthread_mutex_trylock(&blk->lk) != 0) {
+        return 0;
+    }
+    int rc = newsql_send_row_block_int(clnt, blk, 1);
+    Pthread_mutex_unlock(&blk->lk);
+    return rc;
+}
+
+static int newsql_add_row_block(struct sqlclntstate *clnt,
+                                const CDB2SQLRESPONSE *r)
+{
+    struct newsql_appdata *appdata = clnt->appdata;
+    struct newsql_row_block *blk = appdata->row_block;
+    int rc = 0;
+    size_t len = cdb2__sqlresponse__get_packed_size(r);
+    Pthread_mutex_lock(&blk->lk);
+    size_t need = blk->len + sizeof(uint32_t) + len;
+    if (blk->cap < need) {
+        size_t cap = blk->cap ? blk->cap : 4096;
+        while (cap < need)
+            cap *= 2;
+        uint8_t *raw = realloc(blk->raw, cap);
+        if (raw == NULL) {
+            rc = -1;
+            goto out;
+        }
+        blk->raw = raw;
+        blk->cap = cap;
+    }
+    uint32_t nlen = htonl(len);
+    memcpy(blk->raw + blk->len, &nlen, sizeof(nlen));
+    cdb2__sqlresponse__pack(r, blk->raw + blk->len + sizeof(nlen));
+    blk->len = need;
+    int64_t now = comdb2_time_epochus();
+    if (blk->nrows++ == 0) {
+        blk->first_us = now;
+    }
+    /* a slow query should not sit on a partial block */
+    if (blk->nrows >= newsql_row_block_rows(clnt) ||
+        blk->len >= NEWSQL_ROW_BLOCK_MAX_BYTES ||
+        now - blk->first_us >= gbl_newsql_row_block_max_ms * 1000LL) {
+        rc = newsql_send_row_block_int(clnt, blk, 0);
+    }
+out:
+    Pthread_mutex_unlock(&blk->lk);
+    return rc;
+}
+
 static int newsql_response_int(struct sqlclntstate *clnt, const CDB2SQLRESPONSE *r, int h, int flush)
 {
     struct newsql_appdata *appdata = clnt->appdata;
+    /* Batch rows unless the client asked for each one as it is produced
+       (SET ROWBUFFER OFF) */
+    if (clnt->row_blocks && appdata->row_block &&
+        newsql_row_block_rows(clnt) > 1 && !flush &&
+        h == RESPONSE_HEADER__SQL_RESPONSE &&
+        r->response_type == RESPONSE_TYPE__COLUMN_VALUES &&
+        r->error_code == 0) {
+        return newsql_add_row_block(clnt, r);
+    }
+    /* Anything else must not overtake rows still waiting in a block */
+    int rc = newsql_send_row_block(clnt, 0);
+    if (rc) {
+        return rc;
+    }
     return appdata->write_impl(clnt, h, 0, r, flush);
 }
 
@@ -497,6 +645,10 @@ static int newsql_error(struct sqlclntstate *c, char *r, int e)
 static int newsql_flush(struct sqlclntstate *clnt)
 {
     struct newsql_appdata *appdata = clnt->appdata;
+    int rc = newsql_send_row_block(clnt, 0);
+    if (rc) {
+        return rc;
+    }
     return appdata->flush_impl(clnt);
 }
 
@@ -519,6 +671,10 @@ static int newsql_save_postponed_row(struct sqlclntstate *clnt,
 static int newsql_send_postponed_row(struct sqlclntstate *clnt)
 {
     struct newsql_appdata *appdata = clnt->appdata;
+    int rc = newsql_send_row_block(clnt, 0);
+    if (rc) {
+        return rc;
+    }
     return appdata->write_postponed_impl(clnt);
 }
 
@@ -1825,6 +1981,18 @@ int process_set_commands(struct sqlclntstate *clnt, CDB2SQLQUERY *sql_query)
                 sqlstr += 9;
                 sqlstr = skipws(sqlstr);
                 clnt->rowbuffer = (strncasecmp(sqlstr, "on", 2) == 0);
+            } else if (strncasecmp(sqlstr, "rowblocks", 9) == 0) {
+                sqlstr += 9;
+                sqlstr = skipws(sqlstr);
+                int rows = atoi(sqlstr);
+                if (rows < 0 || rows > 100000) {
+                    snprintf(err, sizeof(err),
+                             "set rowblocks: need a row count between 0 and "
+                             "100000");
+                    rc = ii + 1;
+                } else {
+                    clnt->row_block_rows = rows;
+                }
             } else if (strncasecmp(sqlstr, "sockbplog", 10) == 0) {
                 init_bplog_socket(clnt);
                 rc = 0;
@@ -1860,10 +2028,25 @@ int newsql_heartbeat(struct sqlclntstate *clnt)
         clnt->sqltick_last_seen = clnt->sqltick;
     }
 
+    /* Rows of a query that stalled mid block should not wait for it */
+    int rc = newsql_try_send_row_block(clnt);
+    if (rc) {
+        return rc;
+    }
+
     return newsql_send_hdr(clnt, RESPONSE_HEADER__SQL_RESPONSE_HEARTBEAT, state);
 }
 
 void setup_newsql_clnt(struct sqlclntstate *clnt)
 {
+    struct newsql_appdata *appdata = clnt->appdata;
+    /* Allocated before any query runs, since the heartbeat thread may flush
+       it; without one rows are sent one at a time */
+    if (appdata->row_block == NULL) {
+        appdata->row_block = calloc(1, sizeof(struct newsql_row_block));
+        if (appdata->row_block) {
+            Pthread_mutex_init(&appdata->row_block->lk, NULL);
+        }
+    }
     plugin_set_callbacks(clnt, newsql);
 }
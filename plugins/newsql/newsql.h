@@ -17,6 +17,7 @@
 #ifndef INCLUDED_NEWSQL_H
 #define INCLUDED_NEWSQL_H
 
+#include <pthread.h>
 #include <sqlquery.pb-c.h>
 #include <sqlresponse.pb-c.h>
 
@@ -47,6 +48,18 @@ struct newsql_postponed_data {
     uint8_t *row;
 };
 
+/* COLUMN_VALUES responses waiting to go out together as one ROW_BLOCK */
+struct newsql_row_block {
+    int nrows;
+    size_t len;     /* bytes used in raw */
+    size_t cap;     /* bytes allocated for raw */
+    uint8_t *raw;   /* [length][packed response] ... */
+    size_t outcap;  /* bytes allocated for out */
+    uint8_t *out;   /* compression scratch */
+    int64_t first_us;   /* when the oldest buffered row was added */
+    pthread_mutex_t lk; /* heartbeats flush a block while the query runs */
+};
+
 struct newsql_appdata {
     int (*close_impl)(struct sqlclntstate *);
     int (*flush_impl)(struct sqlclntstate *);
@@ -68,6 +81,7 @@ struct newsql_appdata {
     CDB2SQLQUERY *sqlquery;
     int8_t send_intrans_response;
     struct newsql_postponed_data *postponed;
+    struct newsql_row_block *row_block;
     struct NewsqlProtobufCAllocator newsql_protobuf_allocator;
 
     /* columns */
@@ -605,6 +605,13 @@ static void free_newsql_appdata(struct sqlclntstate *clnt)
         free(appdata->postponed);
         appdata->postponed = NULL;
     }
+    if (appdata->row_block) {
+        Pthread_mutex_destroy(&appdata->row_block->lk);
+        free(appdata->row_block->raw);
+        free(appdata->row_block->out);
+        free(appdata->row_block);
+        appdata->row_block = NULL;
+    }
     newsql_protobuf_destroy(&appdata->newsql_protobuf_allocator);
     free(appdata);
     clnt->appdata = NULL;
@@ -717,10 +724,10 @@ static int handle_newsql_request(comdb2_appsock_arg_t *arg)
     CDB2SQLQUERY *sql_query = query->sqlquery;
 
     for (int ii = 0; ii < sql_query->n_features; ++ii) {
-        if (CDB2_CLIENT_FEATURES__FLAT_COL_VALS == sql_query->features[ii]) {
+        if (CDB2_CLIENT_FEATURES__FLAT_COL_VALS == sql_query->features[ii])
             clnt.flat_col_vals = 1;
-            break;
-        }
+        else if (CDB2_CLIENT_FEATURES__ROW_BLOCKS == sql_query->features[ii])
+            clnt.row_blocks = 1;
     }
 
     if (!clnt.admin && do_query_on_master_check(dbenv, &clnt, sql_query))
@@ -35,6 +35,7 @@
 #include "reqlog.h"
 #include "logmsg.h"
 #include "debug_switches.h"
+#include "block_internal.h"
 
 int gbl_logical_live_sc = 0;
 
@@ -611,6 +612,90 @@ static void increment_sc_logbytes(u_int64_t bytes)
     Pthread_mutex_unlock(&sc_bps_lk);
 }
 
+/* Converter threads can keep their transaction open across this many records
+ * and queue the keys of the new table in the thread's deferred index table
+ * instead of adding them record by record.  The deferred table keeps the keys
+ * sorted and spills to a temp btree when it outgrows memory, so each batch
+ * reaches the new btrees in key order: consecutive keys go to the same leaf,
+ * and keys past the end of a btree take the last-page fast path and the
+ * sorted-append split, which leaves the pages it fills full. */
+int gbl_sc_sorted_key_batch = 0;
+
+static int sorted_batch_size(struct convert_record_data *data)
+{
+    if (gbl_sc_sorted_key_batch <= 1 || data->to->nix == 0)
+        return 0;
+    if (data->scanmode != SCAN_PARALLEL && data->scanmode != SCAN_PAGEORDER)
+        return 0;
+    /* logical live sc checks every key against the redo thread's work, and a
+     * resumed rebuild expects to skip keys that are already there */
+    if (data->s->logical_livesc || data->s->resume ||
+        data->s->schema_change == SC_CONSTRAINT_CHANGE)
+        return 0;
+    return gbl_sc_sorted_key_batch;
+}
+
+/* Forget the records of a batch whose transaction is about to be aborted, so
+ * that the next transaction reads them again.  Called before the abort: the
+ * batch's row locks keep live writers from acting on the rewound genid. */
+static void sorted_batch_rewind(struct convert_record_data *data)
+{
+    if (!data->sorted_batch)
+        return;
+    truncate_defered_index_tbl();
+    if (data->nbatch == 0)
+        return;
+    data->nrecs -= data->nbatch;
+    data->sc_genids[data->stripe] = data->batch_genid;
+    data->nbatch = 0;
+}
+
+/* Add the queued keys of the open batch to the new btrees.
+ * ret code:   0 keys added, the transaction can be committed
+ *             1 the transaction was aborted and the batch will be retried
+ *             -2 failure
+ */
+static int sorted_batch_flush(struct convert_record_data *data)
+{
+    int blkpos = 0, ixout = -1, errout = 0;
+    u_int64_t logbytes;
+    int rc;
+
+    data->iq.usedb = data->to;
+    rc = process_defered_table(&data->iq, data->trans, &blkpos, &ixout,
+                               &errout);
+    data->iq.usedb = data->to;
+    if (rc == 0) {
+        ATOMIC_ADD64(data->from->sc_nrecs, data->nbatch);
+        data->nbatch = 0;
+        return 0;
+    }
+
+    if (rc == RC_INTERNAL_RETRY) {
+        logbytes = bdb_tran_logbytes(data->trans);
+        increment_sc_logbytes(logbytes);
+        sorted_batch_rewind(data);
+        trans_abort(&data->iq, data->trans);
+        data->trans = NULL;
+        data->num_retry_errors++;
+        data->totnretries++;
+        if (data->cmembers->is_decrease_thrds)
+            decrease_max_threads(&data->cmembers->maxthreads);
+        else
+            poll(0, 0, (rand() % 500 + 10));
+        return 1;
+    }
+
+    if (rc == IX_DUP)
+        sc_client_error(data->s, "Could not add duplicate entry in index %d",
+                        ixout);
+    else
+        sc_client_error(data->s,
+                        "Error adding sorted keys rcode %d ixfailnum %d stripe %d",
+                        rc, ixout, data->stripe);
+    return -2;
+}
+
 /* converts a single record and prepares for the next one
  * should be called from a while loop
  * param data: pointer to all the state information
@@ -652,6 +737,8 @@ static int convert_record(struct convert_record_data *data)
             sc_errf(data->s, "Error %d starting transaction\n", rc);
             return -2;
         }
+        if (data->sorted_batch)
+            data->batch_genid = data->sc_genids[data->stripe];
     }
 
     data->iq.debug = debug_this_request(gbl_debug_until);
@@ -713,6 +800,10 @@ static int convert_record(struct convert_record_data *data)
                 }
             }
         } else if (rc == 1) {
+            /* the last batch is committed along with the end of the stripe */
+            if (data->nbatch > 0 && (rc = sorted_batch_flush(data)) != 0)
+                return rc;
+
             /* we have finished all the records in our stripe
              * set pointer to -1 so all insert/update/deletes will be
              * the the left of SC pointer. This works because we now hold
@@ -759,6 +850,7 @@ static int convert_record(struct convert_record_data *data)
                       data->sc_genids[data->stripe], rc);
             return rc;
         } else if (rc == RC_INTERNAL_RETRY) {
+            sorted_batch_rewind(data);
             trans_abort(&data->iq, data->trans);
             data->trans = NULL;
 
@@ -868,6 +960,7 @@ static int convert_record(struct convert_record_data *data)
             data->blobix, data->blb.bloblens, data->blb.bloboffs,
             (void **)data->blb.blobptrs, &args, &bdberr);
         if (blobrc != 0 && bdberr == BDBERR_DEADLOCK) {
+            sorted_batch_rewind(data);
             trans_abort(&data->iq, data->trans);
             data->trans = NULL;
             data->totnretries++;
@@ -954,6 +1047,9 @@ static int convert_record(struct convert_record_data *data)
 
     if (data->to->plan && gbl_use_plan) addflags |= RECFLAGS_NO_BLOBS;
 
+    if (data->sorted_batch)
+        addflags |= RECFLAGS_DEFER_KEYS;
+
     char *tagname = ".NEW..ONDISK";
     uint8_t *p_tagname_buf = (uint8_t *)tagname;
     uint8_t *p_tagname_buf_end = p_tagname_buf + 12;
@@ -1039,6 +1135,7 @@ err:
         (data->s->iq && data->s->iq->sc_should_abort)) {
         logbytes = bdb_tran_logbytes(data->trans);
         increment_sc_logbytes(logbytes);
+        sorted_batch_rewind(data);
         trans_abort(&data->iq, data->trans);
         data->trans = NULL;
         return -1;
@@ -1048,6 +1145,7 @@ err:
     if (rc == RC_INTERNAL_RETRY) {
         logbytes = bdb_tran_logbytes(data->trans);
         increment_sc_logbytes(logbytes);
+        sorted_batch_rewind(data);
         trans_abort(&data->iq, data->trans);
         data->trans = NULL;
         data->num_retry_errors++;
@@ -1067,6 +1165,7 @@ err:
 
             sc_errf(data->s, "Skipping duplicate entry in index %d rrn %d genid 0x%llx\n",
                     ixfailnum, rrn, genid);
+            sorted_batch_rewind(data);
             data->sc_genids[data->stripe] = genid;
             logbytes = bdb_tran_logbytes(data->trans);
             increment_sc_logbytes(logbytes);
@@ -1097,6 +1196,15 @@ err:
         data->sc_genids[data->stripe] = genid;
     }
 
+    if (data->sorted_batch) {
+        /* hold the transaction, and the locks on the rows read so far,
+         * until the batch is full */
+        if (++data->nbatch < data->sorted_batch)
+            return 1;
+        if ((rc = sorted_batch_flush(data)) != 0)
+            return rc;
+    }
+
     // now do the commit
     db_seqnum_type ss;
     if (data->live) {
@@ -1117,7 +1225,8 @@ err:
     if (data->live)
         delay_sc_if_needed(data, &ss);
 
-    ATOMIC_ADD64(data->from->sc_nrecs, 1);
+    if (!data->sorted_batch)
+        ATOMIC_ADD64(data->from->sc_nrecs, 1);
 
     int now = comdb2_time_epoch();
     if ((rc = report_sc_progress(data, now))) return rc;
@@ -1177,6 +1286,7 @@ void *convert_records_thd(struct convert_record_data *data)
 
     data->num_records_per_trans = gbl_num_record_converts;
     data->num_retry_errors = 0;
+    data->sorted_batch = sorted_batch_size(data);
 
     if (gbl_pg_compact_thresh > 0) {
         /* Disable page compaction only if page compaction is enabled. */
@@ -1274,6 +1384,8 @@ cleanup:
     }
 
 cleanup_no_msg:
+    if (data->sorted_batch)
+        delete_defered_index_tbl();
     convert_record_data_cleanup(data);
     if (data->isThread) backend_thread_event(thedb, COMDB2_THR_EVENT_DONE_RDWR);
 
@@ -77,6 +77,10 @@ struct convert_record_data {
                            converting the records */
     unsigned long long cv_genid; /* the genid of the record that we get
                                     constraint violation on */
+    int sorted_batch; /* records per transaction whose new index keys are
+                         sorted before insertion, 0 if disabled */
+    int nbatch;       /* records converted in the open transaction */
+    unsigned long long batch_genid; /* stripe genid when the batch started */
 };
 
 int convert_all_records(struct dbtable *from, struct dbtable *to,
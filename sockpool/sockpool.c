@@ -673,6 +673,86 @@ int socket_pool_get_ext_hints(
                                   context, hint);
 }
 
+int socket_pool_get_batch(const char *typestr, int dbnum, int *fds, int nfds)
+{
+    int n = 0;
+    struct sockpool_msg_vers0 msg = {.request = SOCKPOOL_REQUEST_BATCH,
+                                     .dbnum = dbnum};
+
+    if (nfds > SOCKPOOL_MAX_BATCH)
+        nfds = SOCKPOOL_MAX_BATCH;
+    if (nfds <= 0 || !sockpool_enabled || !SOCKPOOL_ENABLED() ||
+        strlen(typestr) >= sizeof(msg.typestr))
+        return 0;
+    msg.padding[1] = nfds;
+    strncpy(msg.typestr, typestr, sizeof(msg.typestr) - 1);
+
+    Pthread_mutex_lock(&sockpool_lk);
+    hold_sigpipe_ll(1);
+    if (sockpool_fd == -1)
+        sockpool_fd = open_sockpool_ll();
+    if (sockpool_fd != -1) {
+        int rc, fd;
+        errno = 0;
+        rc = send_fd(sockpool_fd, &msg, sizeof(msg), -1);
+        /* One reply per socket, ending early with one that carries none. */
+        while (rc == PASSFD_SUCCESS && n < nfds) {
+            fd = -1;
+            rc = recv_fd(sockpool_fd, &msg, sizeof(msg), &fd);
+            if (rc != PASSFD_SUCCESS || fd == -1)
+                break;
+            fds[n++] = fd;
+        }
+        if (rc != PASSFD_SUCCESS) {
+            fprintf(stderr, "%s: rc %d errno %d %s\n", __func__, rc, errno,
+                    strerror(errno));
+            close(sockpool_fd);
+            sockpool_fd = -1;
+        }
+        DBG(("%s: received %d of %d fds from sockpool for %s\n", __func__, n,
+             nfds, typestr));
+    }
+    hold_sigpipe_ll(0);
+    Pthread_mutex_unlock(&sockpool_lk);
+    return n;
+}
+
+void socket_pool_donate_batch(const char *typestr, const int *fds, int nfds,
+                              int timeout_secs, int dbnum)
+{
+    int i = 0;
+    struct sockpool_msg_vers0 msg = {
+        .request = SOCKPOOL_DONATE, .dbnum = dbnum, .timeout = timeout_secs};
+
+    strncpy(msg.typestr, typestr, sizeof(msg.typestr) - 1);
+    msg.typestr[sizeof(msg.typestr) - 1] = 0;
+
+    Pthread_mutex_lock(&sockpool_lk);
+    if (sockpool_enabled && SOCKPOOL_ENABLED() &&
+        strlen(typestr) < sizeof(msg.typestr)) {
+        hold_sigpipe_ll(1);
+        if (sockpool_fd == -1)
+            sockpool_fd = open_sockpool_ll();
+        for (; sockpool_fd != -1 && i < nfds; i++) {
+            int rc;
+            errno = 0;
+            rc = send_fd(sockpool_fd, &msg, sizeof(msg), fds[i]);
+            if (rc != PASSFD_SUCCESS) {
+                fprintf(stderr, "%s: send_fd rc %d errno %d %s\n", __func__,
+                        rc, errno, strerror(errno));
+                close(sockpool_fd);
+                sockpool_fd = -1;
+            }
+        }
+        hold_sigpipe_ll(0);
+    }
+    Pthread_mutex_unlock(&sockpool_lk);
+
+    /* Our copies are closed whether or not sockpool got them. */
+    for (i = 0; i < nfds; i++)
+        close(fds[i]);
+}
+
 void socket_pool_donate(const char *typestr, int fd, int timeout_secs)
 {
     socket_pool_donate_ext(typestr, fd, timeout_secs, 0, 0, NULL, NULL);
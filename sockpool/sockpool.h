@@ -121,6 +121,15 @@ int socket_pool_get_ext_hints(
     socket_pool_try_global_callback_t try_global_callback, void *context,
     int *hint);
 
+/* Batch versions for the global socket pool, for clients with many threads
+ * opening and closing connections to the same place at once.  A batch get
+ * asks sockpool for up to nfds sockets in one round trip and returns how
+ * many it put in fds.  A batch donate hands all of fds to sockpool over one
+ * connection and, like socket_pool_donate_ext, takes ownership of them. */
+int socket_pool_get_batch(const char *typestr, int dbnum, int *fds, int nfds);
+void socket_pool_donate_batch(const char *typestr, const int *fds, int nfds,
+                              int timeout_secs, int dbnum);
+
 /* Close all sockets in the pool. */
 void socket_pool_close_all(void);
 void socket_pool_close_all_(void);
@@ -20,7 +20,22 @@
 
 #define SOCKPOOL_SOCKET_NAME "/tmp/sockpool.socket"
 
-enum { SOCKPOOL_DONATE = 0, SOCKPOOL_REQUEST = 1, SOCKPOOL_FORGET_PORT = 2 };
+enum {
+    SOCKPOOL_DONATE = 0,
+    SOCKPOOL_REQUEST = 1,
+    SOCKPOOL_FORGET_PORT = 2,
+    SOCKPOOL_REQUEST_BATCH = 3
+};
+
+/* Flags sent in padding[0] of a request.  SOCKPOOL_REQ_CLAIMED means the
+ * client has already claimed the descriptors it is asking for in the shared
+ * memory table, and the server should release the claim once it answers.
+ * A SOCKPOOL_REQUEST_BATCH asks for up to padding[1] descriptors; the server
+ * answers with one message per descriptor, followed by a message without a
+ * descriptor if it ran out before the count was reached. */
+enum { SOCKPOOL_REQ_CLAIMED = 1 };
+
+#define SOCKPOOL_MAX_BATCH 32
 
 /* Clients should send one of these to the sql proxy after making a new
  * unix domain socket connection.  If the sqlproxy doesn't like what it gets
@@ -48,4 +63,49 @@ struct sockpool_msg_vers1 {
     int typestrlen;  /* length of type string */
 };
 
+/* The server advertises what it holds in a file mapped by local clients.
+ * It lives in a directory of its own, named after the unix socket with
+ * SOCKPOOL_SHM_DIR_SUFFIX appended, which must belong to the server's user
+ * and be writable by no one else.  The file is SOCKPOOL_SHM_NAME in there,
+ * mode 0600, so only clients running as the server's user (or root) map
+ * it; everyone else just asks the server.  Neither side follows symlinks.
+ * Clients look their type string up here before talking to the server: if
+ * nothing is idle they skip the round trip entirely, otherwise they claim a
+ * descriptor with a compare-and-swap so that concurrent clients don't all
+ * queue on the server for the same one.  The descriptors themselves still
+ * travel over the unix socket; a file descriptor can't be handed across
+ * processes any other way. */
+#define SOCKPOOL_SHM_DIR_SUFFIX ".d"
+#define SOCKPOOL_SHM_NAME "/shm"
+#define SOCKPOOL_SHM_MAGIC 0x53504d31 /* SPM1 */
+#define SOCKPOOL_SHM_SLOTS 1024
+#define SOCKPOOL_SHM_PROBES 16
+#define SOCKPOOL_SHM_TYPESTR 64
+#define SOCKPOOL_SHM_HEARTBEAT_SECS 5
+#define SOCKPOOL_SHM_CLAIM_SECS 2
+
+struct sockpool_shm_slot {
+    char typestr[SOCKPOOL_SHM_TYPESTR]; /* written once, before inuse */
+    int inuse;
+    int idle;       /* descriptors pooled by the server for typestr */
+    int claimed;    /* of those, promised to clients on their way */
+    int claim_time; /* epoch time of the last claim */
+};
+
+struct sockpool_shm {
+    unsigned magic;  /* SOCKPOOL_SHM_MAGIC while the server is up */
+    unsigned nslots;
+    int heartbeat;   /* epoch time, refreshed by the server every second */
+    int overflow;    /* set if some type string found no slot */
+    struct sockpool_shm_slot slots[SOCKPOOL_SHM_SLOTS];
+};
+
+static inline unsigned sockpool_shm_hash(const char *typestr)
+{
+    unsigned h = 2166136261u;
+    while (*typestr)
+        h = (h ^ (unsigned char)*typestr++) * 16777619u;
+    return h;
+}
+
 #endif
@@ -62,6 +62,9 @@ extern sqlite3_module systblTimepartPermissionsModule;
 int systblTypeSamplesInit(sqlite3 *db);
 int systblRepNetQueueStatInit(sqlite3 *db);
 int systblSqlpoolQueueInit(sqlite3 *db);
+int systblPhysrepStreamsInit(sqlite3 *db);
+int systblReplPacingInit(sqlite3 *db);
+int systblSqlStmtCacheInit(sqlite3 *db);
 int systblActivelocksInit(sqlite3 *db);
 int systblNetUserfuncsInit(sqlite3 *db);
 int systblClusterInit(sqlite3 *db);
@@ -0,0 +1,59 @@
+/*
+   Copyright 2021 Bloomberg Finance L.P.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+
+#include "comdb2.h"
+#include "comdb2systblInt.h"
+#include "ezsystables.h"
+#include "tranlog.h"
+
+/* One row per physical replicant streaming the log from this node. */
+static int get_physrep_streams(void **data, int *num_points)
+{
+    return tranlog_stream_stats((struct tranlog_stream_stats **)data,
+                                num_points);
+}
+
+static void free_physrep_streams(void *data, int num_points)
+{
+    tranlog_stream_stats_free(data, num_points);
+}
+
+sqlite3_module systblPhysrepStreamsModule = {
+    .access_flag = CDB2_ALLOW_USER,
+};
+
+int systblPhysrepStreamsInit(sqlite3 *db)
+{
+    return create_system_table(
+        db, "comdb2_physrep_streams", &systblPhysrepStreamsModule,
+        get_physrep_streams, free_physrep_streams,
+        sizeof(struct tranlog_stream_stats),
+        CDB2_CSTRING, "host", -1, offsetof(struct tranlog_stream_stats, host),
+        CDB2_CSTRING, "lsn", -1, offsetof(struct tranlog_stream_stats, lsn),
+        CDB2_INTEGER, "lag_bytes", -1,
+        offsetof(struct tranlog_stream_stats, lag_bytes),
+        CDB2_INTEGER, "lag_seconds", -1,
+        offsetof(struct tranlog_stream_stats, lag_seconds),
+        CDB2_INTEGER, "records", -1,
+        offsetof(struct tranlog_stream_stats, records),
+        CDB2_INTEGER, "bytes", -1,
+        offsetof(struct tranlog_stream_stats, bytes),
+        SYSTABLE_END_OF_FIELDS);
+}
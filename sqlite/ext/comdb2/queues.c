@@ -65,6 +65,8 @@ struct systbl_queues_cursor {
   int           is_last;
   unsigned long long     tot_enqueued;
   unsigned long long     tot_dequeued;
+  unsigned long long     batch_gets;
+  unsigned long long     batch_items;
 };
 
 /* Column numbers */
@@ -74,6 +76,8 @@ struct systbl_queues_cursor {
 #define STQUEUE_DEPTH        3
 #define STQUEUE_TOT_ENQUEUED 4
 #define STQUEUE_TOT_DEQUEUED 5
+#define STQUEUE_BATCH_GETS   6
+#define STQUEUE_BATCH_ITEMS  7
 
 static int systblQueuesConnect(
   sqlite3 *db,
@@ -88,7 +92,7 @@ static int systblQueuesConnect(
 
   rc = sqlite3_declare_vtab(db,
      "CREATE TABLE comdb2_queues(queuename, spname, head_age, depth, "
-     "total_enqueued, total_dequeued)");
+     "total_enqueued, total_dequeued, batch_gets, batch_items)");
   if( rc==SQLITE_OK ){
     pNew = *ppVtab = sqlite3_malloc( sizeof(*pNew) );
     if( pNew==0 ) return SQLITE_NOMEM;
@@ -138,6 +142,9 @@ static int get_stats(struct systbl_queues_cursor *pCur) {
       pCur->age  = 0;
   pCur->tot_enqueued = bdb_get_qdb_adds(qdb->handle);
   pCur->tot_dequeued = bdb_get_qdb_cons(qdb->handle);
+  const struct bdb_queue_stats *qstats = bdb_queue_get_stats(qdb->handle);
+  pCur->batch_gets = qstats ? qstats->n_batch_gets : 0;
+  pCur->batch_items = qstats ? qstats->n_batch_items : 0;
   return 0;
 }
 
@@ -218,6 +225,14 @@ static int systblQueuesColumn(
       sqlite3_result_int64(ctx, (sqlite3_int64)pCur->tot_dequeued);
       break;
     }
+    case STQUEUE_BATCH_GETS: {
+      sqlite3_result_int64(ctx, (sqlite3_int64)pCur->batch_gets);
+      break;
+    }
+    case STQUEUE_BATCH_ITEMS: {
+      sqlite3_result_int64(ctx, (sqlite3_int64)pCur->batch_items);
+      break;
+    }
     case STQUEUE_HEADTIME: {
       sqlite3_result_int64(ctx, (sqlite3_int64)pCur->age);
       break;
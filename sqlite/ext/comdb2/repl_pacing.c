@@ -0,0 +1,62 @@
+/*
+   Copyright 2021 Bloomberg Finance L.P.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+
+#include "comdb2.h"
+#include "comdb2systblInt.h"
+#include "ezsystables.h"
+#include "bdb_api.h"
+
+/* One row per replicant the master's commit pacer is watching. */
+static int get_repl_pacing(void **data, int *num_points)
+{
+    return bdb_rep_pace_stats((rep_pace_stat_t **)data, num_points);
+}
+
+static void free_repl_pacing(void *data, int num_points)
+{
+    bdb_rep_pace_stats_free(data, num_points);
+}
+
+sqlite3_module systblReplPacingModule = {
+    .access_flag = CDB2_ALLOW_USER,
+};
+
+int systblReplPacingInit(sqlite3 *db)
+{
+    return create_system_table(
+        db, "comdb2_repl_pacing", &systblReplPacingModule, get_repl_pacing,
+        free_repl_pacing, sizeof(rep_pace_stat_t),
+        CDB2_CSTRING, "host", -1, offsetof(rep_pace_stat_t, host),
+        CDB2_CSTRING, "lsn", -1, offsetof(rep_pace_stat_t, lsn),
+        CDB2_CSTRING, "state", -1, offsetof(rep_pace_stat_t, state),
+        CDB2_INTEGER, "lag_bytes", -1, offsetof(rep_pace_stat_t, lag_bytes),
+        CDB2_REAL, "apply_rate", -1, offsetof(rep_pace_stat_t, apply_rate),
+        CDB2_REAL, "wait_ms", -1, offsetof(rep_pace_stat_t, wait_ms),
+        CDB2_REAL, "allowed_rate", -1,
+        offsetof(rep_pace_stat_t, allowed_rate),
+        CDB2_INTEGER, "limiting", -1, offsetof(rep_pace_stat_t, limiting),
+        CDB2_REAL, "master_rate", -1, offsetof(rep_pace_stat_t, master_rate),
+        CDB2_INTEGER, "commit_interval_us", -1,
+        offsetof(rep_pace_stat_t, commit_interval_us),
+        CDB2_INTEGER, "paced_commits", -1,
+        offsetof(rep_pace_stat_t, paced_commits),
+        CDB2_CSTRING, "decision", -1, offsetof(rep_pace_stat_t, decision),
+        SYSTABLE_END_OF_FIELDS);
+}
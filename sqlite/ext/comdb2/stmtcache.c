@@ -0,0 +1,61 @@
+/*
+   Copyright 2021 Bloomberg Finance L.P.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+
+#include "comdb2.h"
+#include "comdb2systblInt.h"
+#include "sql.h"
+#include "ezsystables.h"
+
+/* One row of process-wide counters for the per-thread statement caches. */
+static int get_stmt_cache_stats(void **data, int *num_points)
+{
+    struct stmt_cache_stats *stats = malloc(sizeof(struct stmt_cache_stats));
+    if (stats == NULL)
+        return ENOMEM;
+    stmt_cache_get_stats(stats);
+    *data = stats;
+    *num_points = 1;
+    return 0;
+}
+
+static void free_stmt_cache_stats(void *data, int num_points)
+{
+    free(data);
+}
+
+sqlite3_module systblSqlStmtCacheModule = {
+    .access_flag = CDB2_ALLOW_USER,
+};
+
+int systblSqlStmtCacheInit(sqlite3 *db)
+{
+    return create_system_table(
+        db, "comdb2_sql_stmt_cache", &systblSqlStmtCacheModule,
+        get_stmt_cache_stats, free_stmt_cache_stats,
+        sizeof(struct stmt_cache_stats),
+        CDB2_INTEGER, "entries", -1, offsetof(struct stmt_cache_stats, entries),
+        CDB2_INTEGER, "bytes", -1, offsetof(struct stmt_cache_stats, mem),
+        CDB2_INTEGER, "hits", -1, offsetof(struct stmt_cache_stats, hits),
+        CDB2_INTEGER, "misses", -1, offsetof(struct stmt_cache_stats, misses),
+        CDB2_INTEGER, "adds", -1, offsetof(struct stmt_cache_stats, adds),
+        CDB2_INTEGER, "evictions", -1,
+        offsetof(struct stmt_cache_stats, evictions),
+        SYSTABLE_END_OF_FIELDS);
+}
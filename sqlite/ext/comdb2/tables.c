@@ -285,6 +285,12 @@ int comdb2SystblInit(
     rc = systblActivelocksInit(db);
   if (rc == SQLITE_OK)
     rc = systblSqlpoolQueueInit(db);
+  if (rc == SQLITE_OK)
+    rc = systblPhysrepStreamsInit(db);
+  if (rc == SQLITE_OK)
+    rc = systblReplPacingInit(db);
+  if (rc == SQLITE_OK)
+    rc = systblSqlStmtCacheInit(db);
   if (rc == SQLITE_OK)
     rc = systblNetUserfuncsInit(db);
   if (rc == SQLITE_OK)
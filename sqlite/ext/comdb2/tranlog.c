@@ -25,6 +25,7 @@
 #include "dbinc_auto/txn_auto.h"
 #include "comdb2systbl.h"
 #include "parse_lsn.h"
+#include "sql.h"
 
 /* Column numbers */
 #define TRANLOG_COLUMN_START        0
@@ -55,8 +56,79 @@ struct tranlog_cursor {
   int openCursor;
   DB_LOGC *logc;             /* Log Cursor */
   DBT data;
+  struct tranlog_stream *stream; /* Set for blocking, ascending cursors */
 };
 
+/*
+** A blocking, ascending cursor never ends on its own: it is how physical
+** replicants stream the log.  Keep those on a list so that how far each
+** one is behind can be reported (comdb2_physrep_streams).
+*/
+struct tranlog_stream {
+  char host[64];
+  DB_LSN lsn;                /* Last lsn handed out */
+  int64_t records;
+  int64_t bytes;
+  int64_t commit_ts;         /* Timestamp of the last commit handed out */
+  int caught_up;             /* Waiting for new log */
+  struct tranlog_stream *prev;
+  struct tranlog_stream *next;
+};
+
+static pthread_mutex_t tranlog_streams_lk = PTHREAD_MUTEX_INITIALIZER;
+static struct tranlog_stream *tranlog_streams;
+
+static void tranlog_stream_add(tranlog_cursor *pCur)
+{
+  struct sql_thread *thd = pthread_getspecific(query_info_key);
+  struct tranlog_stream *s = calloc(1, sizeof(*s));
+  if (s == NULL)
+      return;
+  snprintf(s->host, sizeof(s->host), "%s",
+           (thd && thd->clnt && thd->clnt->origin) ? thd->clnt->origin
+                                                   : "localhost");
+  Pthread_mutex_lock(&tranlog_streams_lk);
+  s->next = tranlog_streams;
+  if (tranlog_streams)
+      tranlog_streams->prev = s;
+  tranlog_streams = s;
+  Pthread_mutex_unlock(&tranlog_streams_lk);
+  pCur->stream = s;
+}
+
+static void tranlog_stream_remove(tranlog_cursor *pCur)
+{
+  struct tranlog_stream *s = pCur->stream;
+  if (s == NULL)
+      return;
+  Pthread_mutex_lock(&tranlog_streams_lk);
+  if (s->prev)
+      s->prev->next = s->next;
+  else
+      tranlog_streams = s->next;
+  if (s->next)
+      s->next->prev = s->prev;
+  Pthread_mutex_unlock(&tranlog_streams_lk);
+  free(s);
+  pCur->stream = NULL;
+}
+
+static void tranlog_stream_update(tranlog_cursor *pCur)
+{
+  struct tranlog_stream *s = pCur->stream;
+  u_int32_t rectype = 0;
+  if (s == NULL || pCur->data.data == NULL)
+      return;
+  s->lsn = pCur->curLsn;
+  s->records++;
+  s->bytes += pCur->data.size;
+  LOGCOPY_32(&rectype, pCur->data.data);
+  if (rectype == DB___txn_regop_gen || rectype == DB___txn_regop_rowlocks ||
+      rectype == DB___txn_regop) {
+      s->commit_ts = get_timestamp_from_matchable_record(pCur->data.data);
+  }
+}
+
 static int tranlogConnect(
   sqlite3 *db,
   void *pAux,
@@ -107,6 +179,7 @@ static int tranlogClose(sqlite3_vtab_cursor *cur){
       sqlite3_free(pCur->maxLsnStr);
   if (pCur->curLsnStr)
       sqlite3_free(pCur->curLsnStr);
+  tranlog_stream_remove(pCur);
   sqlite3_free(pCur);
   return SQLITE_OK;
 }
@@ -118,6 +191,68 @@ extern pthread_mutex_t gbl_durable_lsn_lk;
 extern pthread_cond_t gbl_durable_lsn_cond;
 extern int comdb2_sql_tick();
 
+/*
+** Push out what has been produced so far before going to sleep.  Rows may
+** be sitting in a partially filled row block, and a replicant should not
+** have to wait for more log to see them.
+*/
+static void tranlog_flush_pending(struct sql_thread **pthd)
+{
+  if (*pthd == NULL)
+      *pthd = pthread_getspecific(query_info_key);
+  if (*pthd && (*pthd)->clnt)
+      write_response((*pthd)->clnt, RESPONSE_FLUSH, NULL, 0);
+}
+
+int tranlog_stream_stats(struct tranlog_stream_stats **out, int *nout)
+{
+  bdb_state_type *bdb_state = thedb->bdb_env;
+  struct tranlog_stream_stats *stats = NULL;
+  struct tranlog_stream *s;
+  DB_LSN end;
+  int n = 0, i = 0;
+  int64_t now = comdb2_time_epoch();
+
+  /* Lag is measured against the last commit */
+  bdb_get_current_lsn(bdb_state, &end.file, &end.offset);
+
+  Pthread_mutex_lock(&tranlog_streams_lk);
+  for (s = tranlog_streams; s; s = s->next)
+      n++;
+  if (n > 0 && (stats = calloc(n, sizeof(*stats))) == NULL) {
+      Pthread_mutex_unlock(&tranlog_streams_lk);
+      return ENOMEM;
+  }
+  for (s = tranlog_streams; s; s = s->next, i++) {
+      DB_LSN lsn = s->lsn;
+      char lsnstr[32];
+      snprintf(lsnstr, sizeof(lsnstr), "{%u:%u}", lsn.file, lsn.offset);
+      stats[i].host = strdup(s->host);
+      stats[i].lsn = strdup(lsnstr);
+      stats[i].records = s->records;
+      stats[i].bytes = s->bytes;
+      if (lsn.file > 0 && log_compare(&end, &lsn) > 0) {
+          stats[i].lag_bytes = subtract_lsn(bdb_state, &end, &lsn);
+          if (!s->caught_up && s->commit_ts > 0 && now > s->commit_ts)
+              stats[i].lag_seconds = now - s->commit_ts;
+      }
+  }
+  Pthread_mutex_unlock(&tranlog_streams_lk);
+
+  *out = stats;
+  *nout = n;
+  return 0;
+}
+
+void tranlog_stream_stats_free(struct tranlog_stream_stats *stats, int n)
+{
+  for (int i = 0; i < n; i++) {
+      free(stats[i].host);
+      free(stats[i].lsn);
+  }
+  free(stats);
+}
+
 /*
 ** Advance a tranlog cursor to the next log entry
 */
@@ -142,6 +277,10 @@ static int tranlogNext(sqlite3_vtab_cursor *cur){
       pCur->openCursor = 1;
       pCur->data.flags = DB_DBT_REALLOC;
 
+      if ((pCur->flags & TRANLOG_FLAGS_BLOCK) &&
+          !(pCur->flags & TRANLOG_FLAGS_DESCENDING))
+          tranlog_stream_add(pCur);
+
       if (pCur->minLsn.file == 0) {
           getflags = DB_FIRST;
       } else {
@@ -191,6 +330,7 @@ static int tranlogNext(sqlite3_vtab_cursor *cur){
           }
 
           /* Wait on a condition variable */
+          tranlog_flush_pending(&thd);
           clock_gettime(CLOCK_REALTIME, &ts);
           ts.tv_nsec += (200 * 1000000);
           Pthread_mutex_lock(&gbl_durable_lsn_lk);
@@ -207,6 +347,9 @@ static int tranlogNext(sqlite3_vtab_cursor *cur){
 
       if (pCur->flags & TRANLOG_FLAGS_BLOCK &&
               !(pCur->flags & TRANLOG_FLAGS_DESCENDING)) {
+          tranlog_flush_pending(&thd);
+          if (pCur->stream)
+              pCur->stream->caught_up = 1;
           do {
               /* Tick up. Return an error if sql_tick() fails
                  (peer dropped connection, max query time reached, etc.) */
@@ -233,11 +376,14 @@ static int tranlogNext(sqlite3_vtab_cursor *cur){
           } while ((rc = pCur->logc->get(pCur->logc, &pCur->curLsn, &pCur->data, DB_NEXT)));
           rc = pCur->logc->get(pCur->logc, &pCur->curLsn,
                   &pCur->data, DB_NEXT) != 0;
+          if (pCur->stream)
+              pCur->stream->caught_up = 0;
       } else {
           pCur->hitLast = 1;
       }
   }
 
+  tranlog_stream_update(pCur);
   pCur->iRowid++;
   return SQLITE_OK;
 }
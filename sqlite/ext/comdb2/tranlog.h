@@ -28,4 +28,17 @@ enum {
 
 u_int64_t get_timestamp_from_matchable_record(char *data);
 
+/* One row per blocking transaction log cursor (physical replicant) */
+struct tranlog_stream_stats {
+    char *host;
+    char *lsn;           /* Last lsn sent */
+    int64_t lag_bytes;   /* Log written but not yet sent */
+    int64_t lag_seconds; /* Age of the last commit sent, while behind */
+    int64_t records;
+    int64_t bytes;
+};
+
+int tranlog_stream_stats(struct tranlog_stream_stats **stats, int *nstats);
+void tranlog_stream_stats_free(struct tranlog_stream_stats *stats, int nstats);
+
 #endif
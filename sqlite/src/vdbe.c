@@ -40,6 +40,7 @@ extern void comdb2_handle_limit(Vdbe*,Mem*);
 extern void sqlite3BtreeCursorSetFieldUsed(BtCursor *, unsigned long long);
 extern i64 sqlite3BtreeNewRowid(BtCursor *pCur);
 extern int sqlite3MakeRecordForComdb2(BtCursor *pCur, Mem *m, int nf, int *optimized);
+extern int gbl_lazy_index_keys;
 
 #define cur_is_raw(pCur)                               \
     (pCur ?                                            \
@@ -3072,7 +3073,9 @@ case OP_Column: {
       datacopy = p2;
       if( is_datacopy(pCrsr, &datacopy) ){
         rc = get_datacopy(pCrsr, datacopy, pDest);
-      }else if(pC->nCookFields>=0 && p2>=pC->nCookFields){
+      }else if( (pC->nCookFields>=0 && p2>=pC->nCookFields)
+             || (gbl_lazy_index_keys && p2<pCrsr->sc->nmembers) ){
+        /* decode only this key column, from the ondisk key */
         zData = (u8 *)get_lastkey(pCrsr);
         rc = get_data(pCrsr, pCrsr->sc, (u8 *) zData, p2, pDest, 0, pCrsr->clnt->tzname);
       }else{
@@ -0,0 +1,20 @@
+drop table if exists t
+create table t(i int)$$
+create procedure batch version 'sptest' {
+local function main()
+    local c = db:consumer()
+    local total = 0
+    while total < 20 do
+        local batch = c:next_batch(7)
+        for _, e in ipairs(batch) do
+            c:emit(e.new.i)
+        end
+        total = total + #batch
+        c:consume_batch()
+    end
+end
+}$$
+create lua consumer batch on (table t for insert)
+insert into t select value from generate_series(1, 20)
+exec procedure batch()
+select queuename, depth from comdb2_queues where queuename = '__qbatch'
@@ -0,0 +1,220 @@
+/*
+   Copyright 2021 Bloomberg Finance L.P.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+/*
+ * Times btree page searches with memcmp and with comdb2_keycmp.  Index keys
+ * of each width are built in the ondisk format (a field header byte, then a
+ * sign-flipped big-endian int or a zero-padded cstring), sorted and cut into
+ * pages holding as many keys as a leaf page of the given size would.  Every
+ * key of a page is then looked up among the keys of its page, the way
+ * __bam_search does.
+ */
+
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <keycmp.h>
+
+typedef int (*keycmp_fn)(const void *, const void *, size_t);
+
+struct bench_key {
+    const uint8_t *data;
+    size_t len;
+};
+
+static int libc_memcmp(const void *a, const void *b, size_t len)
+{
+    return memcmp(a, b, len);
+}
+
+static int64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/* Same search as __bam_search: find each page key among the page keys. */
+static int64_t search_page(const struct bench_key *keys, int nkeys,
+                           keycmp_fn cmpf, int64_t *probes)
+{
+    int i, base, lim, indx, cmp;
+    size_t len;
+    int64_t found = 0;
+
+    for (i = 0; i < nkeys; ++i) {
+        for (base = 0, lim = nkeys; lim != 0; lim >>= 1) {
+            indx = base + (lim >> 1);
+            ++(*probes);
+            len = keys[i].len < keys[indx].len ? keys[i].len
+                                               : keys[indx].len;
+            cmp = cmpf(keys[i].data, keys[indx].data, len);
+            if (cmp == 0)
+                cmp = (long)keys[i].len - (long)keys[indx].len;
+            if (cmp == 0) {
+                found += indx;
+                break;
+            }
+            if (cmp > 0) {
+                base = indx + 1;
+                --lim;
+            }
+        }
+    }
+    return found;
+}
+
+/* ondisk key `i' of an index on an int (width 4) or a cstring(width) */
+static void make_key(uint8_t *key, int width, int i)
+{
+    uint32_t v;
+
+    key[0] = 0x08; /* field header: not null */
+    if (width == 4) {
+        v = (uint32_t)i ^ 0x80000000U;
+        key[1] = v >> 24;
+        key[2] = v >> 16;
+        key[3] = v >> 8;
+        key[4] = v;
+    } else if (width == 64) {
+        /* a long prefix shared by all keys */
+        snprintf((char *)key + 1, width, "prefix-shared-by-all-keys-%037d", i);
+    } else {
+        snprintf((char *)key + 1, width, "%0*d", width - 1, i);
+    }
+}
+
+static int bench_width(int width, int nrecs, int pgsize, int iterations)
+{
+    size_t keylen = width + 1;
+    uint8_t *arena;
+    struct bench_key *keys;
+    int64_t start, memcmp_ns = 0, keycmp_ns = 0, probes = 0, sink = 0;
+    int i, it, perpage, npages = 0;
+
+    /* leaf entry: aligned key item, aligned 8-byte genid item, 2 indices */
+    perpage = (pgsize - 26) / (((keylen + 3 + 3) & ~3) + 12 + 4);
+    if (perpage < 2) {
+        fprintf(stderr, "width %d does not fit a %d byte page\n", width,
+                pgsize);
+        return -1;
+    }
+
+    arena = malloc(keylen * nrecs);
+    keys = malloc(sizeof(struct bench_key) * nrecs);
+    if (arena == NULL || keys == NULL) {
+        free(arena);
+        free(keys);
+        return -1;
+    }
+    memset(arena, 0, keylen * nrecs);
+    for (i = 0; i != nrecs; ++i) {
+        make_key(arena + i * keylen, width, i);
+        keys[i].data = arena + i * keylen;
+        keys[i].len = keylen;
+    }
+
+    for (i = 0; i < nrecs; i += perpage) {
+        int nkeys = nrecs - i < perpage ? nrecs - i : perpage;
+        int64_t n = 0;
+
+        start = now_ns();
+        for (it = 0; it < iterations; ++it)
+            sink += search_page(keys + i, nkeys, libc_memcmp, &probes);
+        memcmp_ns += now_ns() - start;
+
+        start = now_ns();
+        for (it = 0; it < iterations; ++it)
+            sink -= search_page(keys + i, nkeys, comdb2_keycmp, &n);
+        keycmp_ns += now_ns() - start;
+        ++npages;
+    }
+
+    free(keys);
+    free(arena);
+
+    /* Both passes have to land on the same entries. */
+    if (sink != 0) {
+        fprintf(stderr, "width %d: memcmp and comdb2_keycmp disagree\n",
+                width);
+        return -1;
+    }
+
+    printf("%8d %8d %10d %12" PRId64 " %12.2f %12.2f %7.2fx\n", width, npages,
+           nrecs, probes, (double)memcmp_ns / probes,
+           (double)keycmp_ns / probes,
+           keycmp_ns > 0 ? (double)memcmp_ns / keycmp_ns : 0);
+    return 0;
+}
+
+static int usage(void)
+{
+    fprintf(stderr,
+            "usage: cdb2_keycmp_bench [-i iterations] [-n keys] [-p pgsize] "
+            "[-w widths]\n"
+            "  -i       searches per page per comparator (default 100)\n"
+            "  -n       keys per width (default 200000)\n"
+            "  -p       page size (default 4096)\n"
+            "  -w       comma separated key widths (default 4,16,64,200)\n");
+    return EXIT_FAILURE;
+}
+
+int main(int argc, char *argv[])
+{
+    char *widths = "4,16,64,200", *tok, *lasts;
+    int ch, width, iterations = 100, nrecs = 200000, pgsize = 4096;
+    int exitval = EXIT_SUCCESS;
+
+    while ((ch = getopt(argc, argv, "i:n:p:w:")) != EOF) {
+        switch (ch) {
+        case 'i':
+            iterations = atoi(optarg);
+            break;
+        case 'n':
+            nrecs = atoi(optarg);
+            break;
+        case 'p':
+            pgsize = atoi(optarg);
+            break;
+        case 'w':
+            widths = optarg;
+            break;
+        default:
+            return usage();
+        }
+    }
+
+    if (iterations <= 0 || nrecs <= 0 || pgsize <= 0)
+        return usage();
+
+    printf("%8s %8s %10s %12s %12s %12s %8s\n", "width", "pages", "keys",
+           "probes", "memcmp-ns", "keycmp-ns", "speedup");
+    widths = strdup(widths);
+    for (tok = strtok_r(widths, ",", &lasts); tok != NULL;
+         tok = strtok_r(NULL, ",", &lasts)) {
+        if ((width = atoi(tok)) <= 0)
+            continue;
+        if (bench_width(width, nrecs, pgsize, iterations) != 0)
+            exitval = EXIT_FAILURE;
+    }
+    free(widths);
+    return exitval;
+}
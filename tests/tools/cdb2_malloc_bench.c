@@ -0,0 +1,261 @@
+/*
+   Copyright 2021 Bloomberg Finance L.P.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+/*
+ * Hammers one static comdb2 allocator from 1, 8 and 64 threads, once with
+ * the size-class cache off and once with it on, and reports the time per
+ * malloc/free pair.  Every thread keeps a window of live chunks of mixed
+ * small sizes and replaces one of them per iteration; a share of the
+ * chunks is handed to the next thread and freed there.
+ */
+
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <mem.h>
+
+#define XMACRO_COMDB2MA(idx, name, size, cap) {name, idx},
+static struct {
+    const char *name;
+    int indx;
+} scopes[] = {COMDB2MA_SPACES};
+#undef XMACRO_COMDB2MA
+
+#define WINDOW 256
+#define HANDOFF 64
+
+struct bench_thd {
+    pthread_t tid;
+    int id;
+    struct bench_thd *next; /* receives our handed off chunks */
+    pthread_mutex_t lk;
+    void *handoff[HANDOFF];
+    int nhandoff;
+};
+
+static int indx;
+static int niters = 1000000;
+static int zones;
+static int remote_pct = 10;
+
+static int64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static inline uint32_t xorshift(uint32_t *s)
+{
+    uint32_t x = *s;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *s = x;
+}
+
+/* mostly tiny chunks, like sqlite's Mem and parse tree nodes */
+static inline size_t pick_size(uint32_t r)
+{
+    switch (r & 7) {
+    case 0:
+    case 1:
+    case 2:
+        return 8 + (r >> 8) % 56;
+    case 3:
+    case 4:
+        return 64 + (r >> 8) % 64;
+    case 5:
+        return 128 + (r >> 8) % 128;
+    case 6:
+        return 256 + (r >> 8) % 256;
+    default:
+        return 512 + (r >> 8) % 512;
+    }
+}
+
+static void handoff(struct bench_thd *to, void *p)
+{
+    void *batch[HANDOFF];
+    int n = 0;
+
+    pthread_mutex_lock(&to->lk);
+    if (to->nhandoff == HANDOFF) {
+        memcpy(batch, to->handoff, sizeof(batch));
+        n = to->nhandoff;
+        to->nhandoff = 0;
+    }
+    to->handoff[to->nhandoff++] = p;
+    pthread_mutex_unlock(&to->lk);
+
+    /* whoever fills the slot frees the batch; with one thread that is us */
+    for (int i = 0; i != n; ++i)
+        comdb2_free(batch[i]);
+}
+
+static void *bench_thd(void *arg)
+{
+    struct bench_thd *thd = arg;
+    void *live[WINDOW] = {0};
+    uint32_t seed = 2463534242U + thd->id * 7919;
+    uint32_t r;
+    size_t sz;
+    int i, slot;
+
+    if (zones)
+        ENABLE_PER_THREAD_MALLOC("bench");
+
+    for (i = 0; i != niters; ++i) {
+        r = xorshift(&seed);
+        slot = r % WINDOW;
+        if (live[slot] != NULL) {
+            if ((r >> 24) % 100 < remote_pct)
+                handoff(thd->next, live[slot]);
+            else
+                comdb2_free(live[slot]);
+        }
+        sz = pick_size(xorshift(&seed));
+        live[slot] = comdb2_malloc_static(indx, sz);
+        if (live[slot] == NULL) {
+            fprintf(stderr, "out of memory\n");
+            abort();
+        }
+        ((char *)live[slot])[sz - 1] = (char)i;
+    }
+
+    for (i = 0; i != WINDOW; ++i)
+        comdb2_free(live[i]);
+    return NULL;
+}
+
+/* return the wall clock time of the run in ns */
+static int64_t bench_run(int nthds)
+{
+    struct bench_thd *thds;
+    int64_t start, elapsed;
+    int i;
+
+    thds = calloc(nthds, sizeof(struct bench_thd));
+    for (i = 0; i != nthds; ++i) {
+        thds[i].id = i;
+        thds[i].next = &thds[(i + 1) % nthds];
+        pthread_mutex_init(&thds[i].lk, NULL);
+    }
+
+    start = now_ns();
+    for (i = 0; i != nthds; ++i)
+        pthread_create(&thds[i].tid, NULL, bench_thd, &thds[i]);
+    for (i = 0; i != nthds; ++i)
+        pthread_join(thds[i].tid, NULL);
+    elapsed = now_ns() - start;
+
+    for (i = 0; i != nthds; ++i) {
+        while (thds[i].nhandoff > 0)
+            comdb2_free(thds[i].handoff[--thds[i].nhandoff]);
+        pthread_mutex_destroy(&thds[i].lk);
+    }
+    free(thds);
+    return elapsed;
+}
+
+static int cdb2_malloc_bench_usage(void)
+{
+    fprintf(stderr,
+            "usage: cdb2_malloc_bench [-a allocator] [-i iterations] "
+            "[-r remote%%] [-t threads,...] [-z]\n"
+            "  -a       static allocator to use (default sqlite)\n"
+            "  -i       malloc/free pairs per thread (default 1000000)\n"
+            "  -r       percentage of chunks freed by another thread "
+            "(default 10)\n"
+            "  -t       thread counts to run (default 1,8,64)\n"
+            "  -z       give each thread its own allocator\n");
+    return EXIT_FAILURE;
+}
+
+int main(int argc, char *argv[])
+{
+    extern char *optarg;
+    extern int optind;
+    const char *name = "sqlite";
+    char *threads = "1,8,64", *tok, *lasts;
+    int64_t off, on;
+    int ch, i, n;
+
+    while ((ch = getopt(argc, argv, "a:i:r:t:z")) != EOF) {
+        switch (ch) {
+        case 'a':
+            name = optarg;
+            break;
+        case 'i':
+            niters = atoi(optarg);
+            break;
+        case 'r':
+            remote_pct = atoi(optarg);
+            break;
+        case 't':
+            threads = optarg;
+            break;
+        case 'z':
+            zones = 1;
+            break;
+        default:
+            return cdb2_malloc_bench_usage();
+        }
+    }
+
+    if (niters <= 0 || remote_pct < 0 || remote_pct > 100)
+        return cdb2_malloc_bench_usage();
+
+    for (i = 1, indx = 0; scopes[i].name != NULL; ++i) {
+        if (strcasecmp(scopes[i].name, name) == 0)
+            indx = scopes[i].indx;
+    }
+    if (indx == 0) {
+        fprintf(stderr, "unknown allocator %s\n", name);
+        return EXIT_FAILURE;
+    }
+
+    comdb2ma_init(0, 0);
+
+    printf("%8s %12s %12s %12s %8s\n", "threads", "pairs", "off-ns",
+           "on-ns", "speedup");
+    threads = strdup(threads);
+    for (tok = strtok_r(threads, ",", &lasts); tok != NULL;
+         tok = strtok_r(NULL, ",", &lasts)) {
+        if ((n = atoi(tok)) <= 0)
+            continue;
+
+        comdb2ma_slab_off(name);
+        off = bench_run(n);
+        comdb2ma_slab_on(name);
+        on = bench_run(n);
+
+        /* ns per pair, per thread */
+        printf("%8d %12" PRId64 " %12.2f %12.2f %7.2fx\n", n,
+               (int64_t)n * niters, (double)off / niters,
+               (double)on / niters, on > 0 ? (double)off / on : 0);
+    }
+    free(threads);
+
+    comdb2ma_slab_show_config();
+    return EXIT_SUCCESS;
+}
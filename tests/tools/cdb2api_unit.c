@@ -21,6 +21,9 @@
 #undef NDEBUG
 
 #include <assert.h>
+#include <poll.h>
+#include <sys/un.h>
+#include <sys/wait.h>
 #include <bb_oscompat.h>
 #include <cdb2api.c>
 
@@ -269,6 +272,295 @@ void test_get_config_file()
     assert(strcmp(filename, "myroot/etc/cdb2/config.d/mydb.cfg") == 0);
 }
 
+/* A stand-in for cdb2sockpool: hands out /dev/null for every socket asked
+ * for, and counts requests and donations. */
+static struct {
+    char dir[64];
+    char path[108];
+    char shm_path[128];
+    int listenfd;
+    int nrequests;
+    int nbatch;
+    int ndonated;
+} fake_sp;
+
+static void *fake_sockpool_conn(void *arg)
+{
+    int conn = (intptr_t)arg;
+    struct sockpool_hello hello;
+    struct sockpool_msg_vers0 msg;
+    int fd, i, n, rc;
+
+    if (read(conn, &hello, sizeof(hello)) != sizeof(hello))
+        goto out;
+    while (recv_fd(conn, &msg, sizeof(msg), &fd) == PASSFD_SUCCESS) {
+        if (msg.request == SOCKPOOL_DONATE) {
+            if (fd != -1) {
+                close(fd);
+                __sync_add_and_fetch(&fake_sp.ndonated, 1);
+            }
+            continue;
+        }
+        __sync_add_and_fetch(&fake_sp.nrequests, 1);
+        n = 1;
+        if (msg.request == SOCKPOOL_REQUEST_BATCH) {
+            __sync_add_and_fetch(&fake_sp.nbatch, 1);
+            n = msg.padding[1];
+        }
+        for (i = 0; i < n; i++) {
+            fd = open("/dev/null", O_RDONLY);
+            rc = send_fd(conn, &msg, sizeof(msg), fd);
+            close(fd);
+            if (rc != PASSFD_SUCCESS)
+                goto out;
+        }
+    }
+out:
+    close(conn);
+    return NULL;
+}
+
+static void *fake_sockpool_listen(void *arg)
+{
+    pthread_t tid;
+    pthread_attr_t attr;
+    int conn;
+
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    while ((conn = accept(fake_sp.listenfd, NULL, NULL)) != -1)
+        pthread_create(&tid, &attr, fake_sockpool_conn, (void *)(intptr_t)conn);
+    return NULL;
+}
+
+static void fake_sockpool_start()
+{
+    struct sockaddr_un addr = {0};
+    pthread_t tid;
+
+    strcpy(fake_sp.dir, "/tmp/cdb2api_unit.XXXXXX");
+    assert(mkdtemp(fake_sp.dir) != NULL);
+    snprintf(fake_sp.path, sizeof(fake_sp.path), "%s/sockpool.socket",
+             fake_sp.dir);
+    snprintf(fake_sp.shm_path, sizeof(fake_sp.shm_path), "%s%s%s",
+             fake_sp.path, SOCKPOOL_SHM_DIR_SUFFIX, SOCKPOOL_SHM_NAME);
+
+    fake_sp.listenfd = socket(AF_UNIX, SOCK_STREAM, 0);
+    assert(fake_sp.listenfd != -1);
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, fake_sp.path, sizeof(addr.sun_path) - 1);
+    assert(bind(fake_sp.listenfd, (struct sockaddr *)&addr, sizeof(addr)) == 0);
+    assert(listen(fake_sp.listenfd, 16) == 0);
+    assert(pthread_create(&tid, NULL, fake_sockpool_listen, NULL) == 0);
+    pthread_detach(tid);
+
+    cdb2_set_sockpool(fake_sp.path);
+    cdb2_enable_sockpool();
+}
+
+static void fake_sockpool_cleanup()
+{
+    char dir[128];
+    snprintf(dir, sizeof(dir), "%s%s", fake_sp.path, SOCKPOOL_SHM_DIR_SUFFIX);
+    unlink(fake_sp.shm_path);
+    rmdir(dir);
+    unlink(fake_sp.path);
+    rmdir(fake_sp.dir);
+}
+
+static void wait_for_donations(int n)
+{
+    for (int i = 0; i < 500 && fake_sp.ndonated < n; i++)
+        poll(NULL, 0, 10);
+    assert(fake_sp.ndonated == n);
+}
+
+/* Forget whatever table cdb2api has mapped so the next lookup rereads it */
+static struct sockpool_shm *reread_shm_table()
+{
+    struct sockpool_shm *shm;
+    pthread_mutex_lock(&cdb2_sockpool_mutex);
+    sockpool_shm = NULL;
+    sockpool_shm_ino = 0;
+    sockpool_shm_check_time = 0;
+    shm = sockpool_shm_get();
+    pthread_mutex_unlock(&cdb2_sockpool_mutex);
+    return shm;
+}
+
+/* Write a table the way cdb2sockpool does */
+static struct sockpool_shm *make_shm_table(int overflow)
+{
+    char dir[128];
+    struct sockpool_shm *shm;
+    int fd;
+
+    snprintf(dir, sizeof(dir), "%s%s", fake_sp.path, SOCKPOOL_SHM_DIR_SUFFIX);
+    mkdir(dir, 0700);
+    fd = open(fake_sp.shm_path, O_RDWR | O_CREAT | O_TRUNC, 0600);
+    assert(fd != -1);
+    assert(ftruncate(fd, sizeof(struct sockpool_shm)) == 0);
+    shm = mmap(NULL, sizeof(struct sockpool_shm), PROT_READ | PROT_WRITE,
+               MAP_SHARED, fd, 0);
+    close(fd);
+    assert(shm != MAP_FAILED);
+    shm->magic = SOCKPOOL_SHM_MAGIC;
+    shm->nslots = SOCKPOOL_SHM_SLOTS;
+    shm->heartbeat = time(NULL);
+    shm->overflow = overflow;
+    return shm;
+}
+
+static struct sockpool_shm_slot *add_shm_slot(struct sockpool_shm *shm,
+                                              const char *typestr, int idle)
+{
+    struct sockpool_shm_slot *slot;
+    unsigned h = 2166136261u;
+    for (const char *c = typestr; *c; c++)
+        h = (h ^ (unsigned char)*c) * 16777619u;
+    slot = &shm->slots[h % SOCKPOOL_SHM_SLOTS];
+    strcpy(slot->typestr, typestr);
+    slot->inuse = 1;
+    slot->idle = idle;
+    slot->claimed = 0;
+    return slot;
+}
+
+void test_sockpool_shm_missing()
+{
+    int fd, nreq = fake_sp.nrequests;
+
+    /* No table: ask sockpool as before */
+    assert(reread_shm_table() == NULL);
+    fd = cdb2_socket_pool_get_ll("comdb2/unit/missing", 0, NULL);
+    assert(fd != -1);
+    close(fd);
+    assert(fake_sp.nrequests == nreq + 1);
+    assert(fake_sp.nbatch == 0);
+}
+
+void test_sockpool_shm_full()
+{
+    struct sockpool_shm *shm = make_shm_table(1);
+    struct sockpool_shm_slot *slot;
+    int fd, nreq;
+
+    /* A full table can't tell: ask sockpool */
+    assert(reread_shm_table() != NULL);
+    nreq = fake_sp.nrequests;
+    fd = cdb2_socket_pool_get_ll("comdb2/unit/full", 0, NULL);
+    assert(fd != -1);
+    close(fd);
+    assert(fake_sp.nrequests == nreq + 1);
+
+    /* Otherwise a type string without a slot has nothing pooled */
+    shm->overflow = 0;
+    nreq = fake_sp.nrequests;
+    assert(cdb2_socket_pool_get_ll("comdb2/unit/full", 0, NULL) == -1);
+    assert(fake_sp.nrequests == nreq);
+
+    /* and neither does one whose sockets are all claimed */
+    slot = add_shm_slot(shm, "comdb2/unit/claimed", 1);
+    slot->claimed = 1;
+    assert(cdb2_socket_pool_get_ll("comdb2/unit/claimed", 0, NULL) == -1);
+    assert(fake_sp.nrequests == nreq);
+    memset(slot, 0, sizeof(*slot));
+
+    /* Tables others can write to, or that nobody keeps up, are ignored */
+    assert(chmod(fake_sp.shm_path, 0666) == 0);
+    assert(reread_shm_table() == NULL);
+    assert(chmod(fake_sp.shm_path, 0600) == 0);
+    shm->heartbeat = time(NULL) - SOCKPOOL_SHM_HEARTBEAT_SECS - 1;
+    assert(reread_shm_table() == NULL);
+    shm->heartbeat = time(NULL);
+    assert(reread_shm_table() != NULL);
+}
+
+void test_sockpool_batch_and_stash()
+{
+    struct sockpool_shm *shm = reread_shm_table();
+    struct sockpool_shm_slot *slot;
+    int fd, nreq, ndonated = fake_sp.ndonated;
+
+    assert(shm != NULL);
+    slot = add_shm_slot(shm, "comdb2/unit/batch", 4);
+
+    /* With 3 other threads waiting, claim and ask for 4 at once */
+    sockpool_inflight = 3;
+    fd = cdb2_socket_pool_get_ll("comdb2/unit/batch", 0, NULL);
+    sockpool_inflight = 0;
+    assert(fd != -1);
+    close(fd);
+    assert(fake_sp.nbatch == 1);
+    assert(slot->claimed == 4);
+    assert(sockpool_stash_count == 3);
+
+    /* The rest are picked up without asking sockpool */
+    nreq = fake_sp.nrequests;
+    fd = cdb2_socket_pool_get_ll("comdb2/unit/batch", 0, NULL);
+    assert(fd != -1);
+    close(fd);
+    assert(fake_sp.nrequests == nreq);
+    assert(sockpool_stash_count == 2);
+
+    /* or given back once they have sat there for too long */
+    for (int i = 0; i < sockpool_stash_count; i++)
+        sockpool_stash[i].stash_time = time(NULL) - SOCKPOOL_STASH_SECS;
+    assert(cdb2_socket_pool_get_ll("comdb2/unit/other", 0, NULL) == -1);
+    assert(sockpool_stash_count == 0);
+    wait_for_donations(ndonated + 2);
+    assert(fake_sp.nrequests == nreq);
+    memset(slot, 0, sizeof(*slot));
+}
+
+void test_sockpool_fork_exec()
+{
+    struct sockpool_shm *shm = reread_shm_table();
+    struct sockpool_shm_slot *slot;
+    char cmd[256];
+    int status;
+    pid_t pid;
+
+    assert(shm != NULL);
+    slot = add_shm_slot(shm, "comdb2/unit/fork", 2);
+    sockpool_stash_pid = getpid();
+    strcpy(sockpool_stash[0].typestr, "comdb2/unit/fork");
+    sockpool_stash[0].fd = open("/dev/null", O_RDONLY);
+    sockpool_stash[0].stash_time = time(NULL);
+    sockpool_stash_count = 1;
+
+    /* A child shares the parent's claims, but not its stash */
+    if ((pid = fork()) == 0) {
+        struct sockpool_stash_ent out[SOCKPOOL_STASH_MAX];
+        pthread_mutex_lock(&cdb2_sockpool_mutex);
+        if (sockpool_stash_expire(out) != 0 || sockpool_stash_count != 0)
+            _exit(1);
+        if (sockpool_shm_claim(slot, 1) != 1)
+            _exit(2);
+        _exit(0);
+    }
+    assert(waitpid(pid, &status, 0) == pid);
+    assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    assert(slot->claimed == 1);
+    assert(sockpool_stash_count == 1);
+
+    /* The table is mapped without keeping it open, so nothing of it
+     * survives an exec */
+    snprintf(cmd, sizeof(cmd), "ls -l /proc/$$/fd | grep -q %s && exit 1; "
+                               "exit 0",
+             fake_sp.shm_path);
+    if ((pid = fork()) == 0) {
+        execl("/bin/sh", "sh", "-c", cmd, (char *)NULL);
+        _exit(3);
+    }
+    assert(waitpid(pid, &status, 0) == pid);
+    assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+    close(sockpool_stash[0].fd);
+    sockpool_stash_count = 0;
+    memset(slot, 0, sizeof(*slot));
+}
+
 int main(int argc, char *argv[])
 {
     int rc = 0;
@@ -289,6 +581,13 @@ int main(int argc, char *argv[])
     test_read_comdb2db_cfg();
     test_get_config_file();
 
+    fake_sockpool_start();
+    test_sockpool_shm_missing();
+    test_sockpool_shm_full();
+    test_sockpool_batch_and_stash();
+    test_sockpool_fork_exec();
+    fake_sockpool_cleanup();
+
     printf("finished succesfully\n");
     return rc;
 }
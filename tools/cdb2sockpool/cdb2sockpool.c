@@ -24,6 +24,7 @@
 #include <sys/socket.h>
 #include <sys/socketvar.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
 #include <sys/un.h>
 #include <fcntl.h>
 #include <poll.h>
@@ -38,6 +39,7 @@
 #include <signal.h>
 #include <utime.h>
 #include <syslog.h>
+#include <time.h>
 
 #include <passfd.h>
 #include <sockpool.h>
@@ -65,6 +67,8 @@ struct stats {
     unsigned fds_requested; /* number of fds requested from the pool */
     unsigned fds_returned;  /* number of fds actually returned to
                                requestor */
+    unsigned fds_claimed;   /* requests that were claimed in shared memory */
+    unsigned batches;       /* batch requests */
 };
 
 struct db_number_info {
@@ -166,6 +170,161 @@ static int pthread_create_attrs(pthread_t *tid, int detachstate,
     return 0;
 }
 
+/* Shared memory table advertising what we hold; see sockpool_p.h. */
+static struct sockpool_shm *shm = NULL;
+static char shm_dir[sizeof(unix_bind_path) + sizeof(SOCKPOOL_SHM_DIR_SUFFIX)];
+static char shm_path[sizeof(shm_dir) + sizeof(SOCKPOOL_SHM_NAME)];
+static pthread_mutex_t shm_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* Create our directory for the table, or make sure that an existing one is
+ * ours and that no one else can swap files in it. */
+static int shm_mkdir(void)
+{
+    struct stat st;
+
+    if (mkdir(shm_dir, 0755) == -1 && errno != EEXIST) {
+        syslog(LOG_NOTICE, "Error creating '%s': %d %s\n", shm_dir, errno,
+               strerror(errno));
+        return -1;
+    }
+    if (lstat(shm_dir, &st) == -1) {
+        syslog(LOG_NOTICE, "Error checking '%s': %d %s\n", shm_dir, errno,
+               strerror(errno));
+        return -1;
+    }
+    if (!S_ISDIR(st.st_mode) || st.st_uid != geteuid() ||
+        (st.st_mode & (S_IWGRP | S_IWOTH))) {
+        syslog(LOG_NOTICE,
+               "Not advertising pooled sockets: '%s' is not a directory "
+               "owned and only writable by us\n",
+               shm_dir);
+        return -1;
+    }
+    return 0;
+}
+
+static void shm_init(void)
+{
+    void *p;
+    int fd;
+
+    snprintf(shm_dir, sizeof(shm_dir), "%s%s", unix_bind_path,
+             SOCKPOOL_SHM_DIR_SUFFIX);
+    snprintf(shm_path, sizeof(shm_path), "%s%s", shm_dir, SOCKPOOL_SHM_NAME);
+    if (shm_mkdir() != 0)
+        return;
+    if (unlink(shm_path) == -1 && errno != ENOENT) {
+        syslog(LOG_NOTICE, "Error unlinking '%s': %d %s\n", shm_path, errno,
+               strerror(errno));
+    }
+    fd = open(shm_path, O_RDWR | O_CREAT | O_EXCL | O_NOFOLLOW, 0600);
+    if (fd == -1) {
+        syslog(LOG_NOTICE, "Error creating '%s': %d %s\n", shm_path, errno,
+               strerror(errno));
+        return;
+    }
+    if (ftruncate(fd, sizeof(struct sockpool_shm)) == -1) {
+        syslog(LOG_NOTICE, "Error sizing '%s': %d %s\n", shm_path, errno,
+               strerror(errno));
+        close(fd);
+        unlink(shm_path);
+        return;
+    }
+    p = mmap(NULL, sizeof(struct sockpool_shm), PROT_READ | PROT_WRITE,
+             MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) {
+        syslog(LOG_NOTICE, "Error mapping '%s': %d %s\n", shm_path, errno,
+               strerror(errno));
+        unlink(shm_path);
+        return;
+    }
+    shm = p;
+    shm->nslots = SOCKPOOL_SHM_SLOTS;
+    shm->heartbeat = time(NULL);
+    __sync_synchronize();
+    shm->magic = SOCKPOOL_SHM_MAGIC;
+    syslog(LOG_INFO, "Advertising pooled sockets in %s\n", shm_path);
+}
+
+/* Find the slot for typestr, optionally creating it.  Slots are never freed,
+ * so a probe sequence stays valid for the life of the server. */
+static struct sockpool_shm_slot *shm_slot(const char *typestr, int create)
+{
+    struct sockpool_shm_slot *slot;
+    unsigned h, i;
+
+    if (shm == NULL || strlen(typestr) >= SOCKPOOL_SHM_TYPESTR)
+        return NULL;
+
+    h = sockpool_shm_hash(typestr);
+    for (i = 0; i < SOCKPOOL_SHM_PROBES; i++) {
+        slot = &shm->slots[(h + i) % SOCKPOOL_SHM_SLOTS];
+        if (!slot->inuse) {
+            if (!create)
+                return NULL;
+            LOCK(&shm_lock)
+            {
+                if (!slot->inuse) {
+                    strcpy(slot->typestr, typestr);
+                    __sync_synchronize();
+                    slot->inuse = 1;
+                }
+            }
+            UNLOCK(&shm_lock);
+        }
+        if (strncmp(slot->typestr, typestr, SOCKPOOL_SHM_TYPESTR) == 0)
+            return slot;
+    }
+    if (create)
+        shm->overflow = 1;
+    return NULL;
+}
+
+static void shm_idle_add(const char *typestr, int delta)
+{
+    struct sockpool_shm_slot *slot = shm_slot(typestr, delta > 0);
+    if (slot)
+        __sync_add_and_fetch(&slot->idle, delta);
+}
+
+/* Release up to n claims made by a client whose request we just served. */
+static void shm_unclaim(const char *typestr, int n)
+{
+    struct sockpool_shm_slot *slot = shm_slot(typestr, 0);
+    int claimed;
+
+    if (slot == NULL)
+        return;
+    do {
+        claimed = slot->claimed;
+        if (claimed <= 0)
+            return;
+    } while (!__sync_bool_compare_and_swap(&slot->claimed, claimed,
+                                           claimed > n ? claimed - n : 0));
+}
+
+/* Called every second: tell clients we're alive and drop claims whose
+ * requests never arrived (the client died or gave up). */
+static void shm_tick(void)
+{
+    struct sockpool_shm_slot *slot;
+    int i, now, claimed;
+
+    if (shm == NULL)
+        return;
+    now = time(NULL);
+    shm->heartbeat = now;
+    for (i = 0; i < SOCKPOOL_SHM_SLOTS; i++) {
+        slot = &shm->slots[i];
+        if (!slot->inuse)
+            continue;
+        claimed = slot->claimed;
+        if (claimed > 0 && now - slot->claim_time > SOCKPOOL_SHM_CLAIM_SECS)
+            __sync_bool_compare_and_swap(&slot->claimed, claimed, 0);
+    }
+}
+
 static int get_num_clients()
 {
     int num_clients;
@@ -200,6 +359,7 @@ static void fd_destructor(enum socket_pool_event event, const char *typestr,
     }
 
     pooled_socket_count--;
+    shm_idle_add(typestr, -1);
     if (dbnum > 0) {
         struct db_number_info *dbs_info;
         dbs_info = hash_find(dbs_info_hash, &dbnum);
@@ -432,6 +592,8 @@ void *client_thd(void *voidarg)
         char *typestr = 0;
         int dbnum;
         int timeout = 0;
+        int reqflags = 0;
+        int count = 0;
         void *msg;
         int msglen;
 
@@ -486,6 +648,8 @@ void *client_thd(void *voidarg)
             typestr = msg0.typestr;
             dbnum = msg0.dbnum;
             timeout = msg0.timeout;
+            reqflags = (unsigned char)msg0.padding[0];
+            count = (unsigned char)msg0.padding[1];
         } else if (hello.protocol_version == 1) {
             if (msg1.typestrlen < 0 || msg1.typestrlen > MAX_TYPESTR_LEN) {
                 syslog(LOG_NOTICE, "%s: invalid typestr len %d\n", prefix,
@@ -522,6 +686,8 @@ void *client_thd(void *voidarg)
             typestr = typestrbuf;
             dbnum = 0;
             timeout = msg1.timeout;
+            reqflags = (unsigned char)msg1.padding[0];
+            count = (unsigned char)msg1.padding[1];
         }
 
         if (request == SOCKPOOL_DONATE) {
@@ -545,6 +711,7 @@ void *client_thd(void *voidarg)
             Pthread_mutex_lock(&sockpool_lk);
             {
                 pooled_socket_count++;
+                shm_idle_add(typestr, 1);
                 if (dbnum > 0) {
                     struct db_number_info *dbs_info;
                     dbs_info = hash_find(dbs_info_hash, &dbnum);
@@ -594,6 +761,11 @@ void *client_thd(void *voidarg)
             }
 
             newfd = socket_pool_get(typestr);
+            if (reqflags & SOCKPOOL_REQ_CLAIMED) {
+                shm_unclaim(typestr, 1);
+                clnt.stats.fds_claimed++;
+                gbl_stats.fds_claimed++;
+            }
 
             request = SOCKPOOL_DONATE;
 
@@ -662,6 +834,61 @@ void *client_thd(void *voidarg)
                        typestrbuf, newfd);
             }
 
+        } else if (request == SOCKPOOL_REQUEST_BATCH) {
+            int i;
+
+            if (newfd != -1) {
+                syslog(LOG_NOTICE, "%s: unexpectedly received a socket\n",
+                       prefix);
+                close(newfd);
+                break;
+            }
+            if (count > SOCKPOOL_MAX_BATCH)
+                count = SOCKPOOL_MAX_BATCH;
+
+            /* One reply per descriptor; the client stops reading at the
+             * first reply that carries none. */
+            memset(&msg0, 0, sizeof(msg0));
+            msg0.request = SOCKPOOL_DONATE;
+            rc = PASSFD_SUCCESS;
+            for (i = 0; i < count; i++) {
+                newfd = socket_pool_get(typestr);
+                if (newfd == -1)
+                    break;
+                errno = 0;
+                rc = send_fd(fd, &msg0, sizeof(msg0), newfd);
+                if (close(newfd) == -1) {
+                    syslog(LOG_NOTICE, "%s: close fd %d: %d %s\n", prefix,
+                           newfd, errno, strerror(errno));
+                }
+                if (rc != PASSFD_SUCCESS)
+                    break;
+                clnt.stats.fds_returned++;
+                gbl_stats.fds_returned++;
+            }
+            if (rc == PASSFD_SUCCESS && i < count)
+                rc = send_fd(fd, &msg0, sizeof(msg0), -1);
+
+            if (reqflags & SOCKPOOL_REQ_CLAIMED) {
+                shm_unclaim(typestr, count);
+                clnt.stats.fds_claimed++;
+                gbl_stats.fds_claimed++;
+            }
+            clnt.stats.fds_requested += count;
+            gbl_stats.fds_requested += count;
+            clnt.stats.batches++;
+            gbl_stats.batches++;
+
+            if (VERBOSE) {
+                syslog(LOG_DEBUG, "%s: batch of %d for %s - returned %d\n",
+                       prefix, count, typestr, i);
+            }
+            if (rc != PASSFD_SUCCESS) {
+                syslog(LOG_NOTICE, "%s: send_fd rc %d errno %d %s\n", prefix,
+                       rc, errno, strerror(errno));
+                goto disconnect;
+            }
+
         } else if (request == SOCKPOOL_FORGET_PORT) {
             LOCK(&gbl_port_hints_lock)
             {
@@ -768,6 +995,11 @@ static void cleanexit(void)
     }
     UNLOCK(&gbl_port_hints_lock);
 
+    if (shm) {
+        shm->magic = 0;
+        unlink(shm_path);
+    }
+
     socket_pool_close_all();
     exit(0);
 }
@@ -833,6 +1065,17 @@ static void do_stat(void)
            gbl_stats.fds_requested);
     syslog(LOG_INFO, "fds returned to clients   : %u\n",
            gbl_stats.fds_returned);
+    syslog(LOG_INFO, "claimed requests          : %u\n",
+           gbl_stats.fds_claimed);
+    syslog(LOG_INFO, "batch requests            : %u\n", gbl_stats.batches);
+    if (shm) {
+        int i, inuse = 0;
+        for (i = 0; i < SOCKPOOL_SHM_SLOTS; i++)
+            inuse += shm->slots[i].inuse;
+        syslog(LOG_INFO, "shared memory table       : %s, %d/%d slots%s\n",
+               shm_path, inuse, SOCKPOOL_SHM_SLOTS,
+               shm->overflow ? " (overflowed)" : "");
+    }
     syslog(LOG_INFO, "---\n");
     socket_pool_dump_stats_ex(stdout, 0, 1, 0);
     syslog(LOG_INFO, "---\n");
@@ -1104,6 +1347,7 @@ static int cdb2_waitft()
         } else {
             socket_pool_timeout();
         }
+        shm_tick();
         close(fd);
     }
 }
@@ -1208,6 +1452,8 @@ int main(int argc, char *argv[])
         bb_daemon();
     }
 
+    shm_init();
+
     if (pthread_create_attrs(NULL, PTHREAD_CREATE_DETACHED, 64 * 1024,
                              accept_thd, (void *)(intptr_t)listenfd) != 0) {
         syslog(LOG_ERR, "Could not create unix domain socket accept thread\n");